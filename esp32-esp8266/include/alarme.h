@@ -0,0 +1,52 @@
+#pragma once
+
+#include "hal.h"
+#include "filtro_distancia.h"
+#include "botao.h"
+#include "maquina_alarme.h"
+#include "sensores.h"
+
+// ========================================================
+// ESTADO DO ALARME
+// ========================================================
+// Um único std::atomic em maquinaAlarme (maquina_alarme.h). Não há
+// mutex: qualquer tarefa lê o estado sem bloquear e muda o estado
+// com alarmeEntrada().
+extern MaquinaAlarme maquinaAlarme;
+
+inline EstadoAlarme alarmeEstado() { return maquinaAlarme.estado(); }
+
+// Aplica a entrada à máquina e, se houve transição, leva LEDs,
+// buzzer e o estado publicado para o estado resultante. Se outra
+// tarefa mudar o estado no meio, as saídas convergem para o mais
+// recente.
+TransicaoAlarme alarmeEntrada(EntradaAlarme entrada);
+
+// Boot: volta à pausa salva na NVS (partida.h). Como alarmeEntrada(),
+// mas sem o bipe: ninguém apertou nada agora.
+void alarmeRestaurarPausa();
+
+// ========================================================
+// FUNÇÕES DE HARDWARE DO ALARME
+// ========================================================
+void ligarAlerta();
+void desligarAlerta();
+void mostrarAlarmePausado();
+// Bipes: padraoTocar(PADRAO_BEEP_TRIPLO) em padroes.h (não bloqueia)
+
+// Filtro entre cada sensor e a decisão do alarme (ver
+// filtro_distancia.h), com o limite da linha dele em SENSORES
+FiltroDistancia& filtroSensor(uint8_t sensor);
+
+// Decisão do alarme para uma leitura do ultrassônico: passa a
+// leitura pelo filtro do sensor, dispara quando a presença é
+// confirmada e leva a presença à zona (zonas.h). ecoUs é o fim do
+// eco desta leitura (micros()): um disparo abre com ele o rastro de
+// latência (latencia.h). O filtro tem estado: chamar sempre da
+// mesma tarefa (a do sensor).
+FiltroSaida avaliarSensor(uint8_t sensor, float distancia, uint32_t ecoUs);
+
+// Ação do alarme para um gesto do botão (ver botao.h): a primeira
+// pressão de uma sequência silencia o alerta; BOTAO_MAX_CLIQUES
+// cliques ou um toque longo alternam a pausa.
+void tratarGestoBotao(const EventoBotao& ev);
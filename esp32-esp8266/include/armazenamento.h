@@ -0,0 +1,20 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// ========================================================
+// BLOBS NA NVS
+// ========================================================
+// Só no ESP32 (armazenamento_esp32.cpp, pelo Preferences): cada módulo
+// que guarda estado entre boots (partida, energia, regras, sessão TLS)
+// tem um namespace com uma chave só. Os drivers *_native.cpp guardam
+// em RAM e não passam por aqui.
+
+// Retorna o tamanho lido; 0 se a chave não existe (primeiro boot) ou
+// não cabe em tamanho
+size_t nvsLerBlob(const char* ns, const char* chave, uint8_t* buf, size_t tamanho);
+
+bool nvsGravarBlob(const char* ns, const char* chave, const uint8_t* buf, size_t tamanho);
+
+bool nvsApagarBlob(const char* ns, const char* chave);
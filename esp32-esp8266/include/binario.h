@@ -0,0 +1,50 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// ========================================================
+// QUADROS BINÁRIOS (LITTLE-ENDIAN)
+// ========================================================
+// Escrita e leitura dos quadros publicados e gravados na NVS
+// (métricas, energia, latência). O Escritor não passa do fim do
+// buffer: quem codifica confere "cabe" no final. u16 satura em
+// 0xFFFF em vez de dar a volta. O Leitor confia no tamanho que quem
+// chama já validou.
+
+struct Escritor {
+    uint8_t* buf;
+    size_t tamanho;
+    size_t pos;
+    bool cabe;
+
+    void u8(uint8_t v) {
+        if (pos + 1 > tamanho) { cabe = false; return; }
+        buf[pos++] = v;
+    }
+    void u16(uint32_t v) {
+        if (v > 0xFFFF) v = 0xFFFF;
+        u8(v & 0xFF);
+        u8(v >> 8);
+    }
+    void u32(uint32_t v) {
+        u16(v & 0xFFFF);
+        u16(v >> 16);
+    }
+};
+
+struct Leitor {
+    const uint8_t* buf;
+    size_t pos;
+
+    uint8_t u8() { return buf[pos++]; }
+    uint16_t u16() {
+        uint16_t v = buf[pos] | (buf[pos + 1] << 8);
+        pos += 2;
+        return v;
+    }
+    uint32_t u32() {
+        uint32_t v = u16();
+        return v | ((uint32_t)u16() << 16);
+    }
+};
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <stdint.h>
+
+// ========================================================
+// BOTÃO: INTERRUPÇÃO, DEBOUNCE E GESTOS
+// ========================================================
+// A ISR só marca o instante da borda e (re)arma um timer de
+// debounce; quando a linha fica quieta por BOTAO_DEBOUNCE_MS o timer
+// lê o nível estável e alimenta o ReconhecedorGestos, que classifica
+// a sequência e põe eventos numa fila. Nenhuma tarefa faz polling.
+
+#ifndef BOTAO_DEBOUNCE_MS
+#define BOTAO_DEBOUNCE_MS 25
+#endif
+// Silêncio depois de soltar que encerra uma sequência de cliques
+#define BOTAO_JANELA_CLIQUES_MS 1000
+// Segurar por tanto tempo vira GESTO_LONGO (emitido ainda segurando)
+#define BOTAO_LONGO_MS 2000
+// Cliques que fecham a sequência na hora, sem esperar a janela
+#define BOTAO_MAX_CLIQUES 10
+
+enum GestoBotao : uint8_t {
+    GESTO_PRESSAO = 0,  // borda de descida confirmada (latência = debounce)
+    GESTO_CLIQUE,       // 1 clique e a janela fechou
+    GESTO_DUPLO,        // 2 cliques
+    GESTO_MULTIPLO,     // 3 ou mais (até BOTAO_MAX_CLIQUES)
+    GESTO_LONGO,        // segurou BOTAO_LONGO_MS
+};
+
+struct EventoBotao {
+    GestoBotao gesto;
+    uint8_t cliques;     // cliques já contados na sequência (PRESSAO: antes desta)
+    uint32_t instanteMs; // borda que originou o evento
+};
+
+const char* nomeGesto(GestoBotao gesto);
+
+// Máquina de gestos sobre o nível já sem repique. Não conhece timers
+// nem filas: quem a usa chama expirar() quando prazoMs() vencer.
+class ReconhecedorGestos {
+public:
+    ReconhecedorGestos();
+
+    // Novo nível estável; retorna true se gerou evento (PRESSAO ao
+    // apertar, MULTIPLO ao soltar o clique BOTAO_MAX_CLIQUES)
+    bool mudanca(bool pressionado, uint32_t agoraMs, EventoBotao& ev);
+
+    // Chamado em prazoMs() ou depois; retorna true se gerou evento
+    bool expirar(uint32_t agoraMs, EventoBotao& ev);
+
+    bool temPrazo() const { return temPrazo_; }
+    uint32_t prazoMs() const { return prazo_; }
+
+private:
+    bool pressionado_;
+    bool longoEmitido_;
+    uint8_t cliques_;
+    uint32_t inicioPressao_;
+    uint32_t ultimaSoltura_;
+    bool temPrazo_;
+    uint32_t prazo_;
+};
+
+// ---------------- Driver (por plataforma) ----------------
+// botao_esp32.cpp: ISR em CHANGE + dois esp_timer (debounce e prazo
+// de gesto) + fila do FreeRTOS. No native não há botão.
+void botaoIniciar();
+
+// Bloqueia até o próximo gesto ou timeoutMs (UINT32_MAX = sem limite)
+bool botaoProximoGesto(EventoBotao& ev, uint32_t timeoutMs);
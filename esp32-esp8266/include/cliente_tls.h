@@ -0,0 +1,85 @@
+#pragma once
+
+#include <Client.h>
+#include <IPAddress.h>
+
+#include "mbedtls/ctr_drbg.h"
+#include "mbedtls/entropy.h"
+#include "mbedtls/ssl.h"
+#include "mbedtls/x509_crt.h"
+
+#include "tls.h"
+
+// ========================================================
+// CLIENTE TLS COM RETOMADA DE SESSÃO (SÓ ESP32)
+// ========================================================
+// Substitui o WiFiClientSecure por baixo do PubSubClient. Ver tls.h
+// para o porquê. Roda inteiro na taskMQTT; fd() também é lido pela
+// taskSocket, só para o select().
+//
+// A sessão guardada é oferecida até o broker recusá-la (ticket
+// vencido, broker reiniciado sem a chave dos tickets): aí o handshake
+// é completo e a sessão nova substitui a velha. Um handshake que cai
+// por timeout ou reset não a descarta; só certificado recusado ou
+// alerta fatal do broker. Com TLS_SESSAO_NVS
+// ela também vai para a NVS e sobrevive a um reboot. Atenção: a
+// sessão contém o segredo mestre da conexão; em produção, ligue a
+// criptografia da NVS ou desligue a opção.
+
+#ifndef TLS_SESSAO_NVS
+#define TLS_SESSAO_NVS 1
+#endif
+#define TLS_SESSAO_MAX_BYTES 2048  // sessão serializada (pode incluir o certificado do broker)
+
+class ClienteTls : public Client {
+public:
+    ClienteTls();
+
+    // Decodifica a CA e prepara o mbedtls uma vez; restaura a sessão da NVS
+    bool iniciar(const char* caPem);
+
+    // Limite de cada operação bloqueante (connect, handshake, leitura)
+    // (não é o setTimeout() do Stream, que é em ms e só vale para readBytes)
+    void definirTimeout(uint32_t segundos) { timeoutS_ = segundos; }
+
+    int connect(IPAddress ip, uint16_t port) override;
+    int connect(const char* host, uint16_t port) override;
+    size_t write(uint8_t b) override;
+    size_t write(const uint8_t* buf, size_t size) override;
+    int available() override;
+    int read() override;
+    int read(uint8_t* buf, size_t size) override;
+    int peek() override;
+    void flush() override {}
+    void stop() override;
+    uint8_t connected() override;
+    operator bool() override { return connected(); }
+
+    int fd() const { return fd_.load(std::memory_order_relaxed); }
+
+    // Esquece a sessão guardada (RAM e NVS)
+    void esquecerSessao();
+
+private:
+    bool abrirSocket(const char* host, uint16_t port);
+    int handshake(MedidorHeap& heap, bool& retomado);
+    void guardarSessao();
+    void fechar(bool avisar);
+
+    static int enviarBio(void* ctx, const unsigned char* buf, size_t len);
+    static int receberBio(void* ctx, unsigned char* buf, size_t len);
+
+    mbedtls_entropy_context entropia_;
+    mbedtls_ctr_drbg_context drbg_;
+    mbedtls_x509_crt ca_;
+    mbedtls_ssl_config conf_;
+    mbedtls_ssl_context ssl_;
+    mbedtls_ssl_session sessao_;
+
+    bool pronto_;
+    bool temSessao_;
+    bool conectado_;
+    std::atomic<int> fd_;
+    int espiado_;        // byte lido por peek(), -1 se nenhum
+    uint32_t timeoutS_;
+};
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "hal.h"
+#include "comodos.h"
+#include "maquina_alarme.h"
+
+// Cliente MQTT global (definido em main.cpp no ESP32 e em
+// hal_native.cpp no ambiente native)
+extern PubSubClient mqttClient;
+
+// Converte "R,G,B" (sem '\0', direto do buffer do PubSubClient) em
+// três componentes 0..255, sem alocar. Valores fora da faixa são
+// limitados; campos não numéricos ou sobrando invalidam o payload.
+bool parseRGB(const char* payload, size_t tamanho, uint8_t &r, uint8_t &g, uint8_t &b);
+
+// Payload das luzes: "R,G,B" ou "R,G,B,ms", com a duração da transição
+// em ms (limitada a TRANSICAO_MAX_MS; sem ela vale TRANSICAO_PADRAO_MS)
+bool parseCorLuz(const char* payload, size_t tamanho, uint8_t &r, uint8_t &g, uint8_t &b,
+                 uint32_t &duracaoMs);
+
+// Cena (TOPICO_CENA): várias luzes e o modo do alarme numa mensagem,
+// aplicada inteira ou recusada inteira.
+//   <alvo>=<valor>;<alvo>=<valor>;...
+//   alvo = nome do cômodo: valor "R,G,B[,ms]" como em led/<nome>
+//   alvo = "alarme": valor STOP, PAUSE ou RESUME
+// Ex.: "sala=255,180,90,800;quarto=0,0,0,800;alarme=PAUSE"
+// Num alvo repetido vale o último. As luzes mudam juntas no mesmo
+// período do PWM (aplicarCoresComodos); se alguma delas ainda está no
+// fade de um comando anterior, todas esperam o fim desse fade e mudam
+// juntas então (até TRANSICAO_MAX_MS depois, ver transicao.h). O
+// alarme muda na hora, e uma única confirmação sai em
+// TOPICO_CENA_ESTADO com o estado já pedido:
+//   "OK,<alvos>,<estado do alarme>,<ON|OFF de cada cômodo>"
+//   ou "INVALIDA,<nº do alvo>" (nada é aplicado)
+// As luzes da cena não publicam led/<nome>/estado (o ON/OFF está na
+// confirmação; o diário registra cada uma). Se o alarme mudar, saem
+// também TOPICO_ESTADO e zona/<nome>/estado das zonas que mudaram:
+// são retidos e seguem toda transição, venha de onde vier, senão o
+// retido ficaria com o estado antigo. Uma cena publica então 1
+// mensagem, ou 2 + zonas mudadas quando mexe no alarme.
+#define CENA_ALVO_ALARME "alarme"
+
+struct Cena {
+    CorComodo cores[NUM_COMODOS];
+    uint8_t numCores;
+    bool mudaAlarme;
+    EntradaAlarme entradaAlarme;
+};
+
+// Retorna -1 se a cena for válida, ou o nº do primeiro alvo inválido
+int parseCena(const char* payload, size_t tamanho, Cena& cena);
+
+// Callback registrado no PubSubClient para os tópicos assinados.
+// Despacha por tabela de tópicos e não aloca heap.
+void mqttCallback(char* topic, byte* payload, unsigned int length);
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "pinos.h"
+#include "topicos.h"
+#include "transicao.h"
+
+// ========================================================
+// TABELA DE CÔMODOS (LUZES RGB)
+// ========================================================
+// Cada cômodo é uma linha desta tabela: nome (usado no tópico
+// projeto/home-security/led/<nome>), pinos e canais LEDC de R, G e B.
+// Configuração do LEDC, despacho MQTT e estado ON/OFF são gerados a
+// partir dela; para adicionar um cômodo basta uma linha nova.
+// Conflitos de pino/canal são pegos em tempo de compilação.
+
+struct Comodo {
+    const char* nome;
+    const char* topicoCmd;        // led/<nome>
+    const char* topicoEstado;     // led/<nome>/estado
+    const char* topicoEnergia;    // led/<nome>/energia
+    const char* topicoHistorico;  // led/<nome>/energia/historico
+    uint8_t pinos[3];             // R, G, B
+    uint8_t canais[3];            // canais LEDC de R, G, B
+};
+
+#define COMODO(nome, pr, pg, pb, cr, cg, cb) \
+    { nome, TOPICO_LED_PREFIXO nome, TOPICO_LED_PREFIXO nome "/estado",                 \
+      TOPICO_LED_PREFIXO nome "/energia", TOPICO_LED_PREFIXO nome "/energia/historico",  \
+      {pr, pg, pb}, {cr, cg, cb} }
+
+constexpr Comodo COMODOS[] = {
+    COMODO("sala",   4,  2,  15, 1, 2, 3),
+    COMODO("quarto", 23, 22, 5,  4, 5, 6),
+};
+
+constexpr size_t NUM_COMODOS = sizeof(COMODOS) / sizeof(COMODOS[0]);
+
+// ---------------- Verificações em tempo de compilação ----------------
+#define LEDC_NUM_CANAIS 16
+
+namespace comodos_detalhe {
+
+// Pinos já usados pelo resto do hardware
+constexpr uint8_t PINOS_RESERVADOS[] = {
+    TRIG_PIN, ECHO_PIN, LED_RED, LED_GREEN, LED_BLUE, BUZZER_PIN, BUTTON_PIN,
+};
+
+constexpr bool pinoReservado(uint8_t pino) {
+    for (uint8_t p : PINOS_RESERVADOS) {
+        if (p == pino) return true;
+    }
+    return false;
+}
+
+// Compara todos os pares (cômodo, cor) entre si
+template <typename Campo>
+constexpr bool semRepeticao(Campo campo) {
+    for (size_t i = 0; i < NUM_COMODOS * 3; ++i) {
+        for (size_t j = i + 1; j < NUM_COMODOS * 3; ++j) {
+            if (campo(COMODOS[i / 3], i % 3) == campo(COMODOS[j / 3], j % 3)) return false;
+        }
+    }
+    return true;
+}
+
+struct PinoDe {
+    constexpr uint8_t operator()(const Comodo& c, size_t cor) const { return c.pinos[cor]; }
+};
+
+struct CanalDe {
+    constexpr uint8_t operator()(const Comodo& c, size_t cor) const { return c.canais[cor]; }
+};
+
+constexpr bool pinosLivres() {
+    for (const Comodo& c : COMODOS) {
+        for (uint8_t p : c.pinos) {
+            if (pinoReservado(p)) return false;
+        }
+    }
+    return true;
+}
+
+constexpr bool canaisValidos() {
+    for (const Comodo& c : COMODOS) {
+        for (uint8_t ch : c.canais) {
+            if (ch == BUZZER_CHANNEL || ch >= LEDC_NUM_CANAIS) return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace comodos_detalhe
+
+static_assert(NUM_COMODOS * 3 <= LEDC_NUM_CANAIS - 1,
+              "canais LEDC insuficientes para tantos cômodos (o buzzer usa um)");
+static_assert(comodos_detalhe::semRepeticao(comodos_detalhe::PinoDe()),
+              "pino repetido na tabela de cômodos");
+static_assert(comodos_detalhe::semRepeticao(comodos_detalhe::CanalDe()),
+              "canal LEDC repetido na tabela de cômodos");
+static_assert(comodos_detalhe::pinosLivres(),
+              "pino de cômodo conflita com sensor, LED de alarme, buzzer ou botão");
+static_assert(comodos_detalhe::canaisValidos(),
+              "canal de cômodo inválido ou igual ao do buzzer");
+
+// ---------------- Estado e operações ----------------
+struct EstadoComodo {
+    bool ligado;
+    unsigned long ligadoDesde;  // millis() de quando acendeu
+    uint8_t r, g, b;
+};
+
+extern EstadoComodo estadosComodos[NUM_COMODOS];
+
+// Configura pinos e canais LEDC de todos os cômodos e apaga as luzes
+void comodosIniciar();
+
+// Índice do cômodo pelo nome (sem '\0'), ou -1
+int buscarComodo(const char* nome, size_t tamanho);
+
+// Cores em 8 bits; o duty real passa pela tabela de gama e chega
+// ao alvo por um fade de duracaoMs (0 = imediato). Ver transicao.h.
+// Se o lote ficar esperando um fade anterior, energia (energia.h) e
+// estadosComodos só mudam quando ele dispara, em comodosServicar().
+void definirCorComodo(size_t indice, uint8_t r, uint8_t g, uint8_t b,
+                      uint32_t duracaoMs = TRANSICAO_PADRAO_MS);
+
+// Aplica a cor e publica ON/OFF + duração em led/<nome>/estado
+// quando a luz muda de apagada para acesa ou vice-versa
+void aplicarCorComodo(size_t indice, uint8_t r, uint8_t g, uint8_t b,
+                      uint32_t duracaoMs = TRANSICAO_PADRAO_MS);
+
+// Várias luzes de uma vez (cena): os canais de todos os cômodos mudam
+// juntos, num só transicaoCanais() (que espera um fade em andamento
+// acabar); cada cômodo registra ON/OFF e vai para o diário como em
+// aplicarCorComodo() quando o lote dispara, mas sem publicar
+// led/<nome>/estado: quem chama confirma tudo numa mensagem só
+struct CorComodo {
+    uint8_t indice;
+    uint8_t r, g, b;
+    uint32_t duracaoMs;
+};
+
+void aplicarCoresComodos(const CorComodo* cores, size_t quantidade);
+
+// taskMQTT: dispara os lotes que esperavam o fade anterior
+// (transicaoServicar) e registra a cor, a energia e o ON/OFF dos
+// cômodos deles com o instante do disparo
+void comodosServicar(uint32_t agoraMs);
+
+// ON/OFF contando os pedidos que ainda esperam o lote disparar
+bool comodoLigadoPedido(size_t indice);
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+
+// ========================================================
+// GERENCIADOR DE CONEXÃO WIFI/MQTT
+// ========================================================
+// Nada de laço esperando a rede: os eventos do WiFi só marcam o que
+// aconteceu e acordam a taskMQTT (EVENTO_REDE), que avança esta
+// máquina de estados. Cada falha agenda a próxima tentativa com
+// backoff exponencial com jitter, e quem espera pelo backoff é o
+// eventosEsperar() da taskMQTT, não um delay. Sensor, botão, buzzer e
+// luzes seguem no ritmo normal durante a queda; os produtores
+// consultam publicadorConectado() e publicar() recusa mensagens
+// enquanto o link não está ONLINE.
+//
+// A máquina é pura (o instante vem de quem chama) e roda só na
+// taskMQTT; estado e estatísticas podem ser lidos de qualquer tarefa.
+
+#ifndef CONEXAO_BACKOFF_BASE_MS
+#define CONEXAO_BACKOFF_BASE_MS 500UL
+#endif
+#ifndef CONEXAO_BACKOFF_MAX_MS
+#define CONEXAO_BACKOFF_MAX_MS  60000UL
+#endif
+#define CONEXAO_PRAZO_WIFI_MS   15000UL  // associar ao AP
+#define CONEXAO_PRAZO_IPV6_MS   30000UL  // depois disso tenta o broker mesmo assim
+
+enum EstadoLink : uint8_t {
+    LINK_ESPERA = 0,       // aguardando o backoff para tentar de novo
+    LINK_WIFI_CONECTANDO,  // WiFi.begin() feito, esperando associar
+    LINK_AGUARDANDO_IP,    // associado, esperando o endereço IPv6
+    LINK_MQTT_CONECTANDO,  // rede pronta, falta a sessão com o broker
+    LINK_ONLINE,
+    NUM_ESTADOS_LINK
+};
+
+// O que a taskMQTT precisa fazer agora
+enum AcaoLink : uint8_t {
+    ACAO_NENHUMA = 0,
+    ACAO_INICIAR_WIFI,   // (re)começar a associação
+    ACAO_CONECTAR_MQTT,  // uma tentativa de connect() no broker
+};
+
+const char* nomeEstadoLink(EstadoLink estado);
+
+// ---------------- Backoff ----------------
+// Teto dobra a cada falha (base, 2·base, ... até max); a espera é
+// sorteada entre metade do teto e o teto, para vários dispositivos
+// não voltarem todos no mesmo instante depois de uma queda do AP.
+class Backoff {
+public:
+    Backoff(uint32_t baseMs, uint32_t maxMs, uint32_t semente = 1);
+
+    uint32_t proximo();  // espera da próxima tentativa
+    void reiniciar() { tentativas_ = 0; }
+    void semear(uint32_t semente) { rng_ = semente ? semente : 1; }
+    uint32_t tentativas() const { return tentativas_; }
+
+private:
+    uint32_t baseMs_;
+    uint32_t maxMs_;
+    uint32_t tentativas_;
+    uint32_t rng_;
+};
+
+// ---------------- Máquina de estados ----------------
+struct ConexaoStats {
+    uint32_t tentativasWifi;
+    uint32_t timeoutsWifi;
+    uint32_t tentativasMqtt;
+    uint32_t falhasMqtt;
+    uint32_t quedas;             // saídas de ONLINE
+    uint32_t reconexoes;         // voltas a ONLINE depois de uma queda
+    uint32_t primeiraConexaoMs;  // do iniciar() ao primeiro ONLINE (0 = ainda não)
+    uint32_t ultimaReconexaoMs;  // da queda até voltar a ONLINE
+    uint32_t maxReconexaoMs;
+    uint32_t offlineTotalMs;     // soma das quedas já encerradas
+};
+
+class GerenciadorConexao {
+public:
+    GerenciadorConexao();
+
+    void iniciar(uint32_t agoraMs, uint32_t semente);
+
+    // Eventos do WiFi (já trazidos para a taskMQTT)
+    void wifiAssociado(uint32_t agoraMs);
+    void wifiEnderecoObtido();
+    void wifiCaiu(uint32_t agoraMs);
+
+    // Resultado da tentativa pedida por ACAO_CONECTAR_MQTT
+    void mqttResultado(bool conectou, uint32_t agoraMs);
+    // A sessão caiu com o WiFi de pé
+    void mqttCaiu(uint32_t agoraMs);
+
+    // Vence prazos e diz o que fazer agora
+    AcaoLink servicar(uint32_t agoraMs);
+
+    // Quanto a taskMQTT pode dormir antes do próximo servicar()
+    // (UINT32_MAX = só quando chegar um evento)
+    uint32_t prazoMs(uint32_t agoraMs) const;
+
+    EstadoLink estado() const { return (EstadoLink)estado_.load(std::memory_order_relaxed); }
+    bool online() const { return estado() == LINK_ONLINE; }
+    ConexaoStats estatisticas() const;
+
+private:
+    void mudar(EstadoLink novo);
+    void agendarRetentativa(uint32_t agoraMs);
+    void sairDeOnline(uint32_t agoraMs);
+
+    std::atomic<uint8_t> estado_;
+    Backoff backoff_;
+    bool wifiPronto_;      // associado e com endereço
+    uint32_t prazo_;       // instante em que o estado atual vence
+    uint32_t inicioMs_;    // iniciar()
+    uint32_t quedaMs_;     // saída de ONLINE em andamento
+    bool jaConectou_;
+
+    std::atomic<uint32_t> tentativasWifi_;
+    std::atomic<uint32_t> timeoutsWifi_;
+    std::atomic<uint32_t> tentativasMqtt_;
+    std::atomic<uint32_t> falhasMqtt_;
+    std::atomic<uint32_t> quedas_;
+    std::atomic<uint32_t> reconexoes_;
+    std::atomic<uint32_t> primeiraConexaoMs_;
+    std::atomic<uint32_t> ultimaReconexaoMs_;
+    std::atomic<uint32_t> maxReconexaoMs_;
+    std::atomic<uint32_t> offlineTotalMs_;
+};
+
+extern GerenciadorConexao gerenciadorConexao;
+
+// ---------------- Driver (conexao_esp32.cpp) ----------------
+// Registra os eventos do WiFi e agenda a primeira tentativa; não
+// bloqueia. Chamado pela taskMQTT quando ela começa: o setup() não
+// espera a rede (partida.h).
+void conexaoIniciar();
+
+// Chamado pela taskMQTT a cada despertar: consome os eventos do
+// WiFi, confere se a sessão MQTT caiu, vence prazos e já executa
+// ACAO_INICIAR_WIFI. Retorna ACAO_CONECTAR_MQTT quando é a vez de
+// tentar o broker; a taskMQTT tenta e informa mqttResultado().
+AcaoLink conexaoServicar(bool mqttConectado);
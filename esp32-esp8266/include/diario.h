@@ -0,0 +1,194 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "estado.h"
+#include "fila_lockfree.h"
+
+// ========================================================
+// DIÁRIO DE EVENTOS (STORE-AND-FORWARD NA FLASH)
+// ========================================================
+// Transições do alarme e ON/OFF das luzes não se perdem mais quando
+// o broker está fora: cada evento ganha um id crescente, é gravado
+// num anel de setores da flash (partição "diario", ver
+// particoes.csv) e enviado em TOPICO_EVENTOS na ordem. O consumidor
+// responde em TOPICO_EVENTOS_ACK com o maior id que recebeu sem
+// buracos; só depois disso o evento deixa de ser reenviado.
+//
+// O PubSubClient só publica com QoS 0, então a confirmação é da
+// aplicação (ponta a ponta, não só até o broker): janela de
+// DIARIO_JANELA eventos em voo, volta ao primeiro não confirmado
+// quando o prazo de reenvio vence ou a sessão cai (go-back-N). O
+// consumidor descarta ids repetidos, o que dá entrega única.
+//
+// Mensagem: "<época>,<id>,ALARME,<de>,<para>,<instante ms>"
+//       ou  "<época>,<id>,LUZ,<cômodo>,ON,<instante ms>"
+//       ou  "<época>,<id>,LUZ,<cômodo>,OFF,<duração ms>"
+// Confirmação: "<época>,<id>". A época (4 dígitos hex) é sorteada
+// quando a flash é formatada; id reinicia junto com ela.
+//
+// Layout na flash: setores de DIARIO_SETOR_BYTES escritos em anel,
+// um de cada vez, o que gasta todos por igual. Cada setor começa com
+// um cabeçalho (número de ordem, apagamentos, id e confirmação ao
+// abrir) seguido de registros de 12 bytes com CRC. Escrita cortada
+// por queda de energia vira registro inválido e é pulada na leitura.
+// Um setor só é reaproveitado quando todos os seus eventos foram
+// confirmados; com o anel cheio, eventos novos são descartados e
+// contados (nunca abrem buraco nos ids).
+//
+// Produtores (qualquer tarefa) só enfileiram sem lock; gravar na
+// flash e enviar é trabalho da taskMQTT, dona do socket e da flash.
+//
+// Apagar um setor leva dezenas de ms e desliga o cache da flash nos
+// dois núcleos (ver tarefas.h). Por isso o próximo setor do anel é
+// apagado adiantado, num giro da taskMQTT sem evento para gravar, e
+// não quando o evento que enche o setor atual chega. Só se ele ainda
+// guardava eventos não confirmados o apagamento fica para a hora de
+// abrir.
+
+#define DIARIO_SETOR_BYTES    4096
+#define DIARIO_MAX_SETORES    16
+#define DIARIO_REGISTRO_BYTES 12
+#define DIARIO_CABECALHO_BYTES 20
+#define DIARIO_SLOTS_POR_SETOR ((DIARIO_SETOR_BYTES - DIARIO_CABECALHO_BYTES) / DIARIO_REGISTRO_BYTES)
+
+#define DIARIO_PENDENTES  16    // fila entre produtores e taskMQTT (potência de 2)
+#define DIARIO_JANELA     8     // eventos enviados sem confirmação
+#define DIARIO_REENVIO_MS 5000UL
+#define DIARIO_REENVIO_MAX_MS 60000UL
+
+enum TipoEventoDiario : uint8_t {
+    DIARIO_ALARME = 1,      // a = de, b = para, valor = instante
+    DIARIO_LUZ,             // a = cômodo, b = ligado, valor = instante (ON) ou duração (OFF)
+    DIARIO_CONFIRMACAO,     // interno: valor = maior id confirmado
+};
+
+struct EventoDiario {
+    uint32_t id;
+    TipoEventoDiario tipo;
+    uint8_t a;
+    uint8_t b;
+    uint32_t valor;
+};
+
+struct DiarioStats {
+    uint32_t gravados;         // eventos que chegaram à flash
+    uint32_t enviados;         // publicações de eventos (inclui reenvios)
+    uint32_t reenvios;
+    uint32_t confirmados;      // maior id confirmado
+    uint32_t pendentes;        // na flash esperando confirmação
+    uint32_t descartadosFila;  // fila dos produtores cheia
+    uint32_t descartadosCheio; // anel sem setor livre
+    uint32_t invalidos;        // registros com CRC errado pulados
+    uint32_t apagamentosMax;   // maior contagem de apagamento entre os setores
+    uint32_t apagadosNaHora;   // setores apagados ao abrir, não adiantados
+    uint16_t setores;          // 0 = sem partição, diário desligado
+    uint16_t epoca;
+};
+
+// Texto do evento para TOPICO_EVENTOS. Retorna o tamanho escrito.
+size_t formatarEventoDiario(char* buf, size_t tamanho, uint16_t epoca, const EventoDiario& ev);
+
+class Diario {
+public:
+    Diario();
+
+    // Produtores: não bloqueia e não toca na flash
+    bool registrar(TipoEventoDiario tipo, uint8_t a, uint8_t b, uint32_t valor);
+
+    // ---------------- taskMQTT ----------------
+    // Varre a flash e retoma de onde parou (formata se não achar nada).
+    // A semente sorteia a época quando formata.
+    void iniciar(uint32_t semente);
+
+    // Grava o que os produtores deixaram e, online, (re)envia a janela
+    void servicar(uint32_t agoraMs, bool online);
+
+    // Payload de TOPICO_EVENTOS_ACK; false se ignorada
+    bool confirmar(const char* payload, size_t tamanho);
+
+    // Quanto falta para o próximo reenvio (UINT32_MAX se nada em voo)
+    uint32_t prazoMs(uint32_t agoraMs) const;
+
+    DiarioStats estatisticas() const;
+
+private:
+    // Posições são lógicas: ordem do setor * DIARIO_SLOTS_POR_SETOR +
+    // slot. Crescem sempre, então comparar posições é comparar números
+    // mesmo quando o anel dá a volta.
+    struct Cabecalho {
+        uint16_t magico;
+        uint16_t epoca;
+        uint32_t ordem;        // cresce a cada setor aberto
+        uint32_t apagamentos;
+        uint32_t proximoId;    // id do primeiro evento do setor
+        uint32_t confirmado;   // confirmação vigente ao abrir
+    };
+
+    enum Leitura { VAZIO, INVALIDO, EVENTO, CONFIRMACAO };
+
+    void formatar(uint32_t semente);
+    bool lerCabecalho(uint8_t setor, Cabecalho& c);
+    uint8_t setorDe(uint32_t ordem) const;
+    bool abrirSetor(uint32_t ordem);
+    void apagarProximo();
+    Leitura ler(uint32_t pos, EventoDiario& ev);
+    bool gravar(const EventoDiario& ev);
+    bool setorConfirmado(uint32_t ordem);
+    void avancarBase();
+    void voltarAoConfirmado();
+
+    struct Pendente {
+        TipoEventoDiario tipo;
+        uint8_t a;
+        uint8_t b;
+        uint32_t valor;
+    };
+    FilaLockFree<Pendente, DIARIO_PENDENTES> fila_;
+    std::atomic<uint32_t> descartadosFila_;
+
+    uint8_t setores_;
+    uint16_t epoca_;
+    uint32_t ordem_[DIARIO_MAX_SETORES];        // 0 = setor apagado/sem cabeçalho
+    uint32_t apagamentos_[DIARIO_MAX_SETORES];
+    uint32_t ordemMax_;    // setor aberto mais novo
+    uint8_t setorMax_;     // onde ele está
+    uint32_t cabeca_;      // próxima posição livre
+    uint32_t base_;        // primeiro evento não confirmado (ou cabeca_)
+    uint32_t envio_;       // próximo evento a enviar
+    uint32_t proximoId_;
+    uint32_t confirmado_;
+    uint32_t persistido_;  // confirmação já gravada na flash
+    uint32_t ultimoEnviado_;  // id do último envio nesta passada
+    uint32_t maiorEnviado_;
+    uint32_t ultimoEnvioMs_;
+    uint32_t reenvioMs_;
+    bool proximoApagado_;       // setor de ordemMax_ + 1 já apagado
+    bool proximoOcupado_;       // ...e recusado com esta confirmação
+    uint32_t confirmadoRecusa_;
+
+    std::atomic<uint32_t> gravados_;
+    std::atomic<uint32_t> enviados_;
+    std::atomic<uint32_t> reenvios_;
+    std::atomic<uint32_t> confirmadoPub_;
+    std::atomic<uint32_t> proximoIdPub_;
+    std::atomic<uint32_t> descartadosCheio_;
+    std::atomic<uint32_t> invalidos_;
+    std::atomic<uint32_t> apagamentosMax_;
+    std::atomic<uint32_t> apagadosNaHora_;
+};
+
+extern Diario diario;
+
+// Atalhos para os produtores
+bool diarioRegistrarAlarme(EstadoAlarme de, EstadoAlarme para, uint32_t instanteMs);
+bool diarioRegistrarLuz(uint8_t comodo, bool ligado, uint32_t valorMs);
+
+// ---------------- Driver da flash ----------------
+// diario_esp32.cpp usa a partição "diario"; diario_native.cpp simula
+// uma NOR em RAM (escrita só zera bits, apagar volta tudo a 0xFF).
+uint32_t diarioFlashTamanho();  // bytes; 0 se não há partição
+bool diarioFlashLer(uint32_t endereco, void* dados, size_t tamanho);
+bool diarioFlashEscrever(uint32_t endereco, const void* dados, size_t tamanho);
+bool diarioFlashApagarSetor(uint32_t setor);
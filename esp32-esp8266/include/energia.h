@@ -0,0 +1,202 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+#include "comodos.h"
+#include "fila_lockfree.h"
+#include "publicador.h"
+#include "transicao.h"
+
+// ========================================================
+// CONSUMO DAS LUZES (ENERGIA E TEMPO LIGADO)
+// ========================================================
+// Até aqui o consumidor só via "ON,<ms>"/"OFF,<duração>" em
+// led/<nome>/estado e precisava acompanhar cada evento (o dashboard
+// rodava timers próprios que se perdiam com a página fechada). Agora
+// o próprio dispositivo integra duty × tempo de cada canal (duty
+// depois da gama, que é o que o LED de fato consome), com os fades
+// como rampas lineares, e acumula por cômodo:
+//   - energia estimada: ENERGIA_MW_CANAL com duty máximo, proporcional
+//     ao duty;
+//   - tempo ligado: qualquer canal com alvo diferente de zero.
+//
+// comodos.cpp só enfileira a mudança (sem lock), com o instante em
+// que o lote da transição disparou; a taskMQTT integra com esse
+// instante, fecha baldes de hora e de dia e grava tudo na NVS uma vez
+// por hora (uma queda de energia perde no máximo a hora corrente). A
+// hora vem do SNTP no fuso ENERGIA_FUSO_HORAS; até o relógio acertar,
+// o consumo vai para a hora em que ele acertar. Frações de mWh e de minuto passam para o
+// balde seguinte, então os totais não perdem nada no arredondamento.
+//
+// Publicações, retidas:
+//   led/<nome>/energia, a cada ENERGIA_RESUMO_MS:
+//     "<ON|OFF>,<s ligado desde que acendeu>,<mW agora>,
+//      <s ligado hoje>,<mWh hoje>,<mWh total>"
+//   led/<nome>/energia/historico, ao fechar cada hora e ao conectar:
+//     u8  versão (1)
+//     u32 hora local do balde mais novo (horas desde 1970)
+//     u8  horas, e para cada uma, da mais velha para a mais nova:
+//         u16 mWh, u8 minutos ligado
+//     u8  dias (o último é hoje, ainda aberto), para cada um:
+//         u32 mWh, u16 minutos ligado
+//   (little-endian; hora 0 = relógio ainda não acertado)
+
+#ifndef ENERGIA_MW_CANAL
+#define ENERGIA_MW_CANAL 66  // 20 mA a 3,3 V por cor com duty máximo
+#endif
+
+#ifndef ENERGIA_FUSO_HORAS
+#define ENERGIA_FUSO_HORAS -3
+#endif
+
+#ifndef ENERGIA_RESUMO_MS
+#define ENERGIA_RESUMO_MS 60000UL
+#endif
+
+#define ENERGIA_VERSAO   1
+#define ENERGIA_HORAS    24
+#define ENERGIA_DIAS     7
+#define ENERGIA_EVENTOS  16   // fila entre definirCorComodo() e a taskMQTT
+
+#define ENERGIA_QUADRO_BYTES (1 + 4 + 1 + ENERGIA_HORAS * 3 + 1 + ENERGIA_DIAS * 6)
+#define ENERGIA_NVS_COMODO   (4 + ENERGIA_HORAS * 3 + ENERGIA_DIAS * 6)
+#define ENERGIA_NVS_BYTES    (1 + 1 + 4 + NUM_COMODOS * ENERGIA_NVS_COMODO)
+
+static_assert(ENERGIA_QUADRO_BYTES <= PUBLICADOR_PAYLOAD_MAX,
+              "histórico de energia não cabe numa mensagem do publicador");
+
+// duty·ms·mW que fazem 1 mWh
+#define ENERGIA_UNIDADE_MWH ((uint64_t)TRANSICAO_DUTY_MAX * 3600000ULL)
+
+struct BaldeHora {
+    uint16_t mWh;
+    uint8_t minutos;
+};
+
+struct BaldeDia {
+    uint32_t mWh;
+    uint16_t minutos;
+};
+
+struct ConsumoComodo {
+    bool ligado;
+    uint32_t ligadoHaS;    // desde que acendeu (0 se apagado)
+    uint32_t potenciaMw;   // pelo alvo atual
+    uint32_t hojeS;        // dia aberto + hora corrente
+    uint32_t hojeMwh;
+    uint32_t totalMwh;
+};
+
+struct EnergiaStats {
+    uint32_t eventos;
+    uint32_t descartados;   // fila cheia: o trecho fica com o duty anterior
+    uint32_t horasFechadas;
+    uint32_t gravacoes;
+    uint32_t falhasGravacao;
+    bool relogio;           // SNTP já acertou
+};
+
+class Energia {
+public:
+    Energia();
+
+    // ---------------- Produtores ----------------
+    // Chamado por comodos.cpp, quando o lote dispara, com o duty alvo
+    // de R, G e B
+    void mudou(uint8_t comodo, const uint32_t duty[3], uint32_t duracaoMs, uint32_t agoraMs);
+
+    // ---------------- taskMQTT ----------------
+    // Carrega os baldes da NVS
+    void iniciar();
+
+    // Integra até agora; hora = hora local (0 se o relógio não acertou).
+    // Fecha a hora quando ela muda; retorna true se fechou alguma.
+    bool servicar(uint32_t agoraMs, uint32_t hora);
+
+    ConsumoComodo consumo(uint8_t comodo, uint32_t agoraMs) const;
+
+    // Quadro de led/<nome>/energia/historico. Retorna o tamanho.
+    size_t codificarHistorico(uint8_t comodo, uint8_t* buf, size_t tamanho) const;
+
+    // Baldes e totais no formato da NVS e de volta
+    size_t salvar(uint8_t* buf, size_t tamanho) const;
+    bool carregar(const uint8_t* buf, size_t tamanho);
+
+    uint32_t horaAtual() const { return hora_; }
+    void registrarGravacao(bool ok);
+    EnergiaStats estatisticas() const;
+
+private:
+    struct Mudanca {
+        uint8_t comodo;
+        uint32_t duty[3];
+        uint32_t duracaoMs;
+        uint32_t instanteMs;
+    };
+
+    // Rampa de "de" a "para" a partir de inicioMs; depois, constante
+    struct Trecho {
+        uint32_t inicioMs;
+        uint32_t duracaoMs;
+        uint32_t de;
+        uint32_t para;
+    };
+
+    struct Acumulado {
+        Trecho canal[3];
+        uint32_t ultimoMs;       // integrado até aqui
+        bool ligado;
+        uint32_t ligadoDesdeMs;
+        uint64_t energia;        // duty·ms·mW da hora corrente (+ sobra)
+        uint64_t ligadoMs;       // da hora corrente (+ sobra)
+        uint32_t totalMwh;
+        BaldeHora horas[ENERGIA_HORAS];
+        BaldeDia dias[ENERGIA_DIAS];
+    };
+
+    static uint32_t dutyEm(const Trecho& t, uint32_t instanteMs);
+    static uint64_t integrar(const Trecho& t, uint32_t deMs, uint32_t ateMs);
+    void avancar(Acumulado& c, uint32_t ateMs);
+    void aplicar(const Mudanca& m);
+    void abrirHora(uint32_t hora);
+    void fecharHora(uint32_t novaHora);
+
+    FilaLockFree<Mudanca, ENERGIA_EVENTOS> fila_;
+    Acumulado comodos_[NUM_COMODOS];
+    uint32_t hora_;        // hora local em aberto (0 = desconhecida)
+    bool sincronizado_;    // já viu o relógio neste boot
+
+    std::atomic<uint32_t> eventos_;
+    std::atomic<uint32_t> descartados_;
+    std::atomic<uint32_t> horasFechadas_;
+    std::atomic<uint32_t> gravacoes_;
+    std::atomic<uint32_t> falhasGravacao_;
+    std::atomic<bool> relogio_;
+};
+
+extern Energia energia;
+
+// ---------------- taskMQTT ----------------
+// Integra, fecha a hora, grava na NVS e publica resumo e histórico
+void energiaServicar(uint32_t agoraMs);
+
+// Quanto falta para o próximo resumo
+uint32_t energiaPrazoMs(uint32_t agoraMs);
+
+// "<ON|OFF>,..." de led/<nome>/energia. Retorna o tamanho escrito.
+size_t formatarConsumo(char* buf, size_t tamanho, const ConsumoComodo& c);
+
+// Hora local (horas desde 1970 no fuso) de um instante Unix (s)
+constexpr uint32_t energiaHoraLocal(uint32_t instante) {
+    return (uint32_t)(((int64_t)instante + ENERGIA_FUSO_HORAS * 3600LL) / 3600);
+}
+
+// ---------------- Driver ----------------
+// energia_esp32.cpp: SNTP e armazenamento.h; energia_native.cpp: relógio
+// e NVS controlados pelos testes.
+void energiaIniciarRelogio();           // depois do WiFi iniciar
+uint32_t energiaRelogioUnix();          // 0 enquanto não acertou
+size_t energiaNvsLer(uint8_t* buf, size_t tamanho);
+bool energiaNvsGravar(const uint8_t* buf, size_t tamanho);
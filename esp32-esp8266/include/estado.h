@@ -0,0 +1,35 @@
+#pragma once
+
+#include <stdint.h>
+
+// ========================================================
+// PUBLICAÇÃO DO ESTADO DO ALARME (TOPICO_ESTADO)
+// ========================================================
+// O estado só é publicado quando muda, como mensagem retida, no
+// formato "<ESTADO>,<seq>" (ex.: "ALERTA,17"). O número de sequência
+// cresce a cada publicação e permite ao consumidor perceber perdas.
+// Um heartbeat republica o estado atual em baixa frequência.
+
+#ifndef ESTADO_HEARTBEAT_MS
+#define ESTADO_HEARTBEAT_MS 60000UL  // 0 desliga o heartbeat
+#endif
+
+enum EstadoAlarme : uint8_t {
+    ESTADO_OK = 0,
+    ESTADO_ALERTA,
+    ESTADO_PAUSADO,
+};
+
+const char* nomeEstado(EstadoAlarme estado);
+
+// Publica apenas se o estado for diferente do último publicado
+void estadoAtualizar(EstadoAlarme estado);
+
+// Republica o estado atual se passou ESTADO_HEARTBEAT_MS desde a
+// última publicação. Chamado periodicamente pela taskMQTT.
+void estadoHeartbeat();
+
+// Republica imediatamente (ex.: logo após reconectar ao broker)
+void estadoRepublicar();
+
+uint32_t estadoSequencia();
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <stdint.h>
+
+// ========================================================
+// EVENTOS ENTRE TAREFAS (NO LUGAR DE POLLING)
+// ========================================================
+// As tarefas dormem até que algo que lhes interessa aconteça. Cada
+// bit acorda só quem espera por ele; quem produz o evento sinaliza
+// (de tarefa ou de ISR) e segue. No ESP32 é um event group do
+// FreeRTOS; no native, uma máscara atômica que os testes inspecionam.
+
+enum : uint32_t {
+    EVENTO_PUBLICAR    = 1u << 0,  // mensagem nova na fila do publicador
+    EVENTO_SOCKET      = 1u << 1,  // socket do MQTT com dados para ler
+    EVENTO_SOCKET_LIDO = 1u << 2,  // taskMQTT já leu o que o socket tinha
+    EVENTO_CONECTADO   = 1u << 3,  // sessão MQTT (re)estabelecida
+    EVENTO_REDE        = 1u << 4,  // evento do WiFi para o gerenciador de conexão
+    EVENTO_LOG         = 1u << 5,  // linha nova para a taskLog (log.h)
+    EVENTO_REGRAS      = 1u << 6,  // gatilho novo para o motor de regras (regras.h)
+};
+
+#define EVENTOS_PARA_SEMPRE UINT32_MAX
+
+void eventosIniciar();
+
+// Seguro em tarefa e em ISR
+void eventosSinalizar(uint32_t bits);
+
+// Dorme até algum dos bits chegar ou timeoutMs passar. Retorna os
+// bits que acordaram a tarefa (já limpos), 0 no timeout. Cada bit
+// deve ter uma única tarefa esperando por ele.
+uint32_t eventosEsperar(uint32_t bits, uint32_t timeoutMs);
+
+// ---------------- Despertares por tarefa ----------------
+// Cada tarefa conta quantas vezes saiu do bloqueio; a taxa por
+// segundo mostra quem ainda acorda à toa.
+enum TarefaMonitorada : uint8_t {
+    TAREFA_SENSOR = 0,
+    TAREFA_BOTAO,
+    TAREFA_MQTT,
+    TAREFA_SOCKET,
+    TAREFA_LOG,
+    TAREFA_BUZZER,
+    NUM_TAREFAS_MONITORADAS
+};
+
+void eventosContarDespertar(TarefaMonitorada tarefa);
+uint32_t eventosDespertares(TarefaMonitorada tarefa);
+const char* nomeTarefaMonitorada(TarefaMonitorada tarefa);
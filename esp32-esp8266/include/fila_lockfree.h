@@ -0,0 +1,92 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+
+// ========================================================
+// FILA LIMITADA SEM LOCK (MULTI-PRODUTOR)
+// ========================================================
+// Fila circular de capacidade fixa (potência de 2), sem alocação e
+// sem mutex: cada célula carrega um número de sequência que diz se
+// ela está livre para o produtor ou pronta para o consumidor
+// (algoritmo de D. Vyukov). Nenhuma operação bloqueia, então pode
+// ser usada a partir de tarefas e de ISRs; quando cheia, enfileirar()
+// apenas retorna false.
+template <typename T, uint32_t N>
+class FilaLockFree {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "capacidade deve ser potencia de 2");
+
+public:
+    FilaLockFree() {
+        for (uint32_t i = 0; i < N; ++i) {
+            celulas_[i].seq.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    bool enfileirar(const T& item) {
+        return enfileirarCom([&item](T& celula) { celula = item; });
+    }
+
+    // Reserva a célula e deixa "preencher(T&)" escrever direto nela,
+    // sem um T inteiro na pilha de quem chama. O consumidor só vê o
+    // item depois que preencher() retorna; até lá a fila parece
+    // terminar antes dele. preencher() tem que ser curto e não pode
+    // falhar: a célula já é dele.
+    template <typename F>
+    bool enfileirarCom(F preencher) {
+        Celula* c;
+        uint32_t pos = cabeca_.load(std::memory_order_relaxed);
+        for (;;) {
+            c = &celulas_[pos & (N - 1)];
+            uint32_t seq = c->seq.load(std::memory_order_acquire);
+            int32_t dif = (int32_t)(seq - pos);
+            if (dif == 0) {
+                if (cabeca_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (dif < 0) {
+                return false;  // cheia
+            } else {
+                pos = cabeca_.load(std::memory_order_relaxed);
+            }
+        }
+        preencher(c->item);
+        c->seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool desenfileirar(T& item) {
+        Celula* c;
+        uint32_t pos = cauda_.load(std::memory_order_relaxed);
+        for (;;) {
+            c = &celulas_[pos & (N - 1)];
+            uint32_t seq = c->seq.load(std::memory_order_acquire);
+            int32_t dif = (int32_t)(seq - (pos + 1));
+            if (dif == 0) {
+                if (cauda_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (dif < 0) {
+                return false;  // vazia
+            } else {
+                pos = cauda_.load(std::memory_order_relaxed);
+            }
+        }
+        item = c->item;
+        c->seq.store(pos + N, std::memory_order_release);
+        return true;
+    }
+
+    // Aproximado: só é exato quando ninguém está enfileirando
+    uint32_t ocupacao() const {
+        return cabeca_.load(std::memory_order_relaxed) - cauda_.load(std::memory_order_relaxed);
+    }
+
+    static constexpr uint32_t capacidade() { return N; }
+
+private:
+    struct Celula {
+        std::atomic<uint32_t> seq;
+        T item;
+    };
+
+    Celula celulas_[N];
+    std::atomic<uint32_t> cabeca_{0};
+    std::atomic<uint32_t> cauda_{0};
+};
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <stdint.h>
+
+// ========================================================
+// FILTRO DE DISTÂNCIA (PONTO FIXO, SEM ALOCAÇÃO)
+// ========================================================
+// Fica entre ultrassomMedir() e a decisão do alarme. Estágios,
+// nesta ordem, cada um configurável:
+//   1. Rejeição de outliers: leituras -1 (sem eco) ou fora da faixa
+//      física são descartadas; depois de maxFalhasSeguidas viram
+//      "nada à frente" (maxMm).
+//   2. Mediana móvel sobre um buffer circular de janelaMediana amostras.
+//   3. Média móvel exponencial (EMA) com alpha em Q8 (256 = 1,0).
+//   4. Confirmação N-de-M com histerese: arma quando confirmN das
+//      últimas confirmM amostras ficam <= limiteMm e desarma quando
+//      confirmN delas ficam > limiteMm + histereseMm.
+// Todas as distâncias internas são inteiras em milímetros.
+
+#define FILTRO_JANELA_MAX  9
+#define FILTRO_CONFIRM_MAX 32
+
+struct FiltroConfig {
+    // 1. Outliers
+    uint16_t minMm;
+    uint16_t maxMm;
+    uint8_t maxFalhasSeguidas;
+    // 2. Mediana (janela ímpar, 1 desliga)
+    uint8_t janelaMediana;
+    // 3. EMA (256 desliga)
+    uint16_t alphaQ8;
+    // 4. Confirmação/histerese
+    uint16_t limiteMm;
+    uint16_t histereseMm;
+    uint8_t confirmN;
+    uint8_t confirmM;
+};
+
+enum EstagioFiltro : uint8_t {
+    ESTAGIO_OUTLIER = 0,
+    ESTAGIO_MEDIANA,
+    ESTAGIO_EMA,
+    ESTAGIO_CONFIRMACAO,
+    NUM_ESTAGIOS_FILTRO
+};
+
+struct FiltroSaida {
+    int32_t brutoMm;     // leitura de entrada em mm (-1 = sem eco)
+    int32_t filtradoMm;  // saída da EMA
+    bool valido;         // a amostra passou pelo estágio de outliers
+    bool detectado;      // decisão após confirmação/histerese
+    bool mudou;          // detectado mudou nesta amostra
+};
+
+// Custo de execução de cada estágio, em ciclos de CPU
+struct EstagioStats {
+    uint32_t chamadas;
+    uint32_t ciclosTotal;
+    uint32_t ciclosMax;
+};
+
+// Configuração padrão para o limite de um sensor (SENSORES)
+FiltroConfig filtroConfigPadrao(float limiteCm);
+
+// Atraso, em amostras, que o estágio acrescenta à detecção
+uint32_t filtroLatenciaAmostras(const FiltroConfig& cfg, EstagioFiltro estagio);
+
+class FiltroDistancia {
+public:
+    explicit FiltroDistancia(const FiltroConfig& cfg);
+
+    void configurar(const FiltroConfig& cfg);  // também reinicia o estado
+    void reiniciar();
+
+    FiltroSaida processar(float distanciaCm);
+
+    const FiltroConfig& config() const { return cfg_; }
+    const EstagioStats& estatisticas(EstagioFiltro estagio) const { return stats_[estagio]; }
+
+private:
+    bool rejeitarOutlier(int32_t brutoMm, int32_t& mm);
+    int32_t mediana(int32_t mm);
+    int32_t ema(int32_t mm);
+    bool confirmar(int32_t mm, bool& mudou);
+
+    FiltroConfig cfg_;
+
+    uint8_t falhasSeguidas_;
+
+    int32_t janela_[FILTRO_JANELA_MAX];
+    uint8_t janelaPos_;
+    uint8_t janelaCheia_;
+
+    int32_t emaQ8_;
+    bool emaIniciada_;
+
+    uint32_t historico_;  // bit 1 = amostra "perto" no limiar vigente
+    uint8_t historicoLen_;
+    bool detectado_;
+
+    EstagioStats stats_[NUM_ESTAGIOS_FILTRO];
+};
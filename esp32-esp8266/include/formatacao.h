@@ -0,0 +1,14 @@
+#pragma once
+
+#include <stddef.h>
+
+// ========================================================
+// FORMATAÇÃO DOS PAYLOADS DE ESTADO
+// ========================================================
+// Escrevem em buffers do chamador, sem alocação.
+
+// "NA" para leitura inválida, senão "%.1f" em cm.
+int formatarMedida(char* buf, size_t tamanho, float distancia);
+
+// "ON,<millis>" quando a luz acende ou "OFF,<duração ms>" quando apaga.
+int formatarEstadoLuz(char* buf, size_t tamanho, bool ligada, unsigned long valor);
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "publicador.h"
+
+// ========================================================
+// GRAVAÇÃO DE RASTROS DO SENSOR
+// ========================================================
+// Com a gravação ligada (GRAVACAO:ON em TOPICO_CMD), cada leitura de
+// cada sensor, exatamente como chega a avaliarSensor() (antes do
+// filtro), entra num quadro binário que vai para TOPICO_GRAVACAO
+// quando enche. O rastro gravado alimenta a reprodução no host
+// (reproducao.h), que roda a mesma decisão do alarme sobre ele.
+//
+// Quadro (little-endian):
+//   u8  versão (1)
+//   u8  quantidade de amostras
+//   u16 nº do quadro (um buraco na sequência = quadro perdido)
+//   e para cada amostra:
+//   u8  sensor (índice em SENSORES)
+//   u32 fim do eco em micros() (ou fim da espera, sem eco)
+//   u16 distância em mm, 0xFFFF = sem eco
+// Os quadros se delimitam sozinhos: gravar o tópico num arquivo
+// (mosquitto_sub -N) dá um rastro pronto para reproduzir.
+//
+// A distância vai em mm arredondados como o filtro faz com a leitura
+// (filtro_distancia.h), então a reprodução entrega ao filtro o mesmo
+// valor que ele viu no dispositivo. Sem broker o quadro é perdido
+// (contado) e a numeração segue.
+
+#define GRAVACAO_VERSAO          1
+#define GRAVACAO_CABECALHO       4
+#define GRAVACAO_BYTES_AMOSTRA   7
+#define GRAVACAO_AMOSTRAS \
+    ((PUBLICADOR_PAYLOAD_MAX - GRAVACAO_CABECALHO) / GRAVACAO_BYTES_AMOSTRA)
+#define GRAVACAO_QUADRO_MAX \
+    (GRAVACAO_CABECALHO + GRAVACAO_AMOSTRAS * GRAVACAO_BYTES_AMOSTRA)
+#define GRAVACAO_SEM_ECO         0xFFFF
+
+struct AmostraGravada {
+    uint8_t sensor;
+    uint32_t ecoUs;
+    uint16_t mm;
+};
+
+struct GravacaoStats {
+    uint32_t amostras;  // gravadas
+    uint32_t quadros;   // entregues ao publicador
+    uint32_t perdidos;  // sem broker ou fila cheia
+};
+
+void gravacaoDefinir(bool ligada);
+bool gravacaoLigada();
+
+// Chamado pela tarefa do sensor a cada leitura, com os mesmos
+// argumentos de avaliarSensor() (-1 = sem eco)
+void gravacaoAmostra(uint8_t sensor, float distanciaCm, uint32_t ecoUs);
+
+GravacaoStats gravacaoEstatisticas();
+
+// Conversões entre a leitura e o campo do quadro
+uint16_t gravacaoMm(float distanciaCm);
+float gravacaoCm(uint16_t mm);
+
+// Retorna o tamanho ou 0 se não couber
+size_t gravacaoCodificar(const AmostraGravada* amostras, uint8_t quantidade, uint16_t numero,
+                         uint8_t* buf, size_t tamanho);
+// Lê o quadro do começo de buf. Retorna os bytes consumidos, ou 0 se
+// o quadro for inválido ou estiver incompleto.
+size_t gravacaoDecodificar(const uint8_t* buf, size_t tamanho, AmostraGravada* amostras,
+                           uint8_t& quantidade, uint16_t& numero);
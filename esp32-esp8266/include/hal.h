@@ -0,0 +1,23 @@
+#pragma once
+
+// ========================================================
+// CAMADA DE ABSTRAÇÃO DE HARDWARE (HAL)
+// ========================================================
+// Os módulos portáveis (comandos, alarme, formatação) incluem
+// apenas este arquivo. No ESP32 ele puxa o framework Arduino,
+// o FreeRTOS e o PubSubClient reais; no ambiente "native" do
+// PlatformIO ele usa os mocks de hal_native.h, permitindo rodar
+// testes e benchmarks no Linux sem placa.
+#ifdef ARDUINO
+#include <Arduino.h>
+#include <PubSubClient.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+// Contador de ciclos da CPU, para medir trechos de poucos µs
+inline uint32_t halCiclos() { return ESP.getCycleCount(); }
+inline uint32_t halCiclosPorUs() { return getCpuFrequencyMhz(); }
+#else
+#include "hal_native.h"
+#endif
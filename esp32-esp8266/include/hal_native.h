@@ -0,0 +1,127 @@
+#pragma once
+
+// ========================================================
+// HAL NATIVE - MOCKS DO ARDUINO/FREERTOS/PUBSUBCLIENT
+// ========================================================
+// Implementação mínima, para o ambiente "native" do PlatformIO,
+// das APIs que os módulos portáveis usam. GPIO e LEDC gravam em
+// tabelas que os testes inspecionam; o relógio é simulado e só
+// avança quando alguém chama delay()/vTaskDelay() ou mexe em
+// halNativeRelogioUs; o PubSubClient apenas registra as publicações.
+// Não há String: os módulos portáveis não alocam heap.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <mutex>
+
+typedef uint8_t byte;
+
+#define HIGH   1
+#define LOW    0
+#define INPUT  0x01
+#define OUTPUT 0x03
+#define HEX    16
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+// ---------------- Heap ----------------
+// malloc/realloc/calloc/new do processo passam por contadores, para
+// benchmarks e testes verificarem alocações por chamada. Fora da
+// glibc só o operator new é contado (ver hal_native.cpp).
+extern volatile unsigned long halNativeAlocacoes;
+
+// ---------------- Relógio simulado ----------------
+extern uint64_t halNativeRelogioUs;
+
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+
+// "Ciclos" no host são nanossegundos do relógio monotônico real
+uint32_t halCiclos();
+inline uint32_t halCiclosPorUs() { return 1000; }
+
+// ---------------- GPIO / LEDC ----------------
+#define HAL_NATIVE_NUM_PINOS  40
+#define HAL_NATIVE_NUM_CANAIS 16
+
+extern uint8_t halNativeGpio[HAL_NATIVE_NUM_PINOS];
+extern uint32_t halNativeLedc[HAL_NATIVE_NUM_CANAIS];
+
+void pinMode(uint8_t pino, uint8_t modo);
+void digitalWrite(uint8_t pino, uint8_t nivel);
+int digitalRead(uint8_t pino);
+uint32_t ledcSetup(uint8_t canal, uint32_t freq, uint8_t resolucao);
+void ledcAttachPin(uint8_t pino, uint8_t canal);
+void ledcWrite(uint8_t canal, uint32_t duty);
+
+// ---------------- Serial ----------------
+// Por padrão descarta a saída (o benchmark não deve medir o
+// terminal); halNativeSerialEco = true ecoa em stdout.
+extern bool halNativeSerialEco;
+
+class HalNativeSerial {
+public:
+    void begin(unsigned long) {}
+    size_t print(const char* s);
+    size_t print(char c);
+    size_t print(int v);
+    size_t print(unsigned int v);
+    size_t print(long v);
+    size_t print(unsigned long v);
+    size_t print(double v, int casas = 2);
+    template <typename T> size_t println(const T& v) { size_t n = print(v); return n + print("\n"); }
+    size_t println() { return print("\n"); }
+    size_t printf(const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+};
+
+extern HalNativeSerial Serial;
+
+// ---------------- FreeRTOS ----------------
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+
+#define pdTRUE  1
+#define pdFALSE 0
+#define pdPASS  pdTRUE
+#define portTICK_PERIOD_MS 1
+#define portMAX_DELAY ((TickType_t)0xffffffffUL)
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+
+struct HalNativeMutex {
+    std::timed_mutex m;
+};
+typedef HalNativeMutex* SemaphoreHandle_t;
+
+SemaphoreHandle_t xSemaphoreCreateMutex();
+BaseType_t xSemaphoreTake(SemaphoreHandle_t s, TickType_t espera);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t s);
+
+void vTaskDelay(TickType_t ticks);
+TickType_t xTaskGetTickCount();
+
+// ---------------- PubSubClient ----------------
+class PubSubClient {
+public:
+    bool connected() { return conectado; }
+    bool publish(const char* topico, const char* payload);
+    bool publish(const char* topico, const char* payload, bool retido);
+    bool publish(const char* topico, const uint8_t* payload, unsigned int tamanho, bool retido);
+    bool loop() { return conectado; }
+    int state() { return conectado ? 0 : -1; }
+
+    // Inspeção pelos testes
+    bool conectado = true;
+    unsigned long publicacoes = 0;
+    char ultimoTopico[128] = {0};
+    uint8_t ultimoPayload[256] = {0};
+    unsigned int ultimoTamanho = 0;
+    bool ultimoRetido = false;
+    // Se definido, vê cada publicação (ex.: um broker simulado)
+    void (*espiao)(const char* topico, const uint8_t* payload, unsigned int tamanho) = nullptr;
+};
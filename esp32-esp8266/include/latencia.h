@@ -0,0 +1,110 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+#include "metricas.h"
+
+// ========================================================
+// LATÊNCIA DO ALARME (ECO -> LIMIAR -> SIRENE -> PUBLICADO)
+// ========================================================
+// Cada disparo do alarme por presença vira um rastro com quatro
+// marcas de tempo:
+//   eco       - borda de descida do eco que confirmou a presença
+//               (timestamp da ISR, ultrassom.h);
+//   limiar    - o filtro confirmou e a taskSensor decidiu disparar
+//               (avaliarSensor(), alarme.h);
+//   sirene    - primeiro passo do PADRAO_ALERTA com o buzzer ligado
+//               (taskBuzzer, padroes.h);
+//   publicado - publish() do estado ALERTA aceito pela taskMQTT
+//               (publicador.h).
+// A distância de cada marca até o eco vai para um histograma. O
+// máximo da sirene desde o boot é o pior caso medido de disparo a
+// sirene, com o tráfego MQTT que houve no período. Inclui as
+// paradas do cache quando a taskMQTT escreve ou apaga a flash
+// (tarefas.h): a ISR do eco e as tarefas do alarme esperam a
+// operação acabar, então um eco nesse tempo sai com a marca
+// atrasada e a sirene atrasa junto.
+//
+// As marcas usam o relógio do esp_timer (micros(), 1 µs), não o
+// contador de ciclos: o CCOUNT é por núcleo e a marca de publicado
+// é feita no núcleo da rede (tarefas.h). A mesma base vale para a
+// ISR do eco.
+//
+// Um rastro por vez: só se abre um com o alarme em OK, e o alarme só
+// volta a OK muito depois das marcas do anterior. Marcas repetidas
+// (o padrão de alerta repete, o estado é republicado) e marcas que
+// chegam depois de LATENCIA_JANELA_US são ignoradas; o rastro que
+// não completou é contado como incompleto quando o seguinte abre
+// (ex.: broker fora, o estado não foi publicado).
+//
+// Quadro de TOPICO_LATENCIA (little-endian, cumulativo desde o boot):
+//   u8  versão (1)
+//   u16 rastros, u16 incompletos
+//   u8  etapas (3: limiar, sirene, publicado), e para cada uma:
+//       u8 baldes, u16 por balde, u32 máximo (µs)
+// Tetos dos baldes, em µs desde o eco (o último não tem teto):
+//   200 500 1000 2000 5000 20000 100000 -
+// Contagens saturam em 0xFFFF.
+
+#ifndef LATENCIA_JANELA_US
+#define LATENCIA_JANELA_US 5000000UL
+#endif
+
+#define LATENCIA_VERSAO     1
+#define LATENCIA_BALDES     8
+#define LATENCIA_QUADRO_MAX 80
+
+enum MarcaLatencia : uint8_t {
+    MARCA_ECO = 0,
+    MARCA_LIMIAR,
+    MARCA_SIRENE,
+    MARCA_PUBLICADO,
+    NUM_MARCAS_LATENCIA
+};
+
+const char* nomeMarcaLatencia(MarcaLatencia marca);
+
+class LatenciaAlarme {
+public:
+    LatenciaAlarme();
+
+    // ---------------- taskSensor ----------------
+    // A presença foi confirmada com o alarme em OK: abre o rastro
+    // antes da transição, porque a sirene pode marcar antes de
+    // alarmeEntrada() retornar (taskBuzzer tem prioridade maior).
+    void abrir(uint32_t ecoUs, uint32_t limiarUs);
+    // A transição aconteceu (conta o rastro e registra o limiar) ou
+    // não aconteceu (outra tarefa mudou o estado no meio)
+    void confirmar();
+    void descartar();
+
+    // ---------------- qualquer tarefa ----------------
+    // Registra a marca no rastro aberto, uma vez por rastro
+    void marcar(MarcaLatencia marca, uint32_t agoraUs);
+
+    // ---------------- coletor ----------------
+    // Histograma da marca desde o eco (MARCA_LIMIAR em diante)
+    const Histograma& etapa(MarcaLatencia marca) const { return etapas_[marca]; }
+    uint32_t rastros() const { return rastros_.load(std::memory_order_relaxed); }
+    uint32_t incompletos() const { return incompletos_.load(std::memory_order_relaxed); }
+
+    // Quadro de TOPICO_LATENCIA. Retorna o tamanho ou 0 se não couber.
+    size_t codificar(uint8_t* buf, size_t tamanho) const;
+
+private:
+    // bits 0-7: marcas já feitas; 8-31: id do rastro (0 = nenhum)
+    std::atomic<uint32_t> rastro_{0};
+    std::atomic<uint32_t> instante_[NUM_MARCAS_LATENCIA] = {};
+    uint32_t proximoId_ = 1;  // só a taskSensor abre rastros
+
+    Histograma etapas_[NUM_MARCAS_LATENCIA];  // MARCA_ECO fica vazio
+    std::atomic<uint32_t> rastros_{0};
+    std::atomic<uint32_t> incompletos_{0};
+};
+
+extern LatenciaAlarme latencia;
+
+// Atalho para o aviso de entrega do publicador (publicador.h)
+void latenciaPublicado();
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// ========================================================
+// LOG ASSÍNCRONO
+// ========================================================
+// Serial.print() a 115200 baud segura a tarefa que chama por vários
+// ms (≈87 µs por caractere quando o FIFO da UART enche), o que
+// distorcia o período do sensor e atrasava o callback do MQTT. Agora
+// quem loga só reserva uma célula na fila sem lock (fila_lockfree.h)
+// do núcleo em que está rodando e formata a linha direto nela, sem
+// cópia da linha na própria pilha; uma tarefa de prioridade baixa (taskLog) esvazia as filas
+// e é a única a escrever no Serial. Fila cheia descarta a linha e
+// conta em descartadas: log nunca bloqueia quem loga.
+//
+// Cada linha ganha um número de sequência global; a taskLog junta as
+// filas dos dois núcleos por esse número, então a ordem no terminal é
+// a ordem em que as linhas foram escritas. Cada linha é um registro
+// só (até LOG_LINHA_MAX), então ela entra ou se perde inteira: a
+// taskLog nunca imprime metade de uma linha, mesmo drenando enquanto
+// outra tarefa escreve.
+//
+// Níveis acima de LOG_NIVEL (-DLOG_NIVEL=... no platformio.ini)
+// somem na compilação: a chamada fica atrás de um if (0), então nem
+// o formato nem os argumentos chegam ao binário e nada é avaliado,
+// mas o compilador ainda confere o printf e não acusa variáveis que
+// só o log usava.
+
+#define LOG_NIVEL_NADA  0
+#define LOG_NIVEL_ERRO  1
+#define LOG_NIVEL_AVISO 2
+#define LOG_NIVEL_INFO  3
+#define LOG_NIVEL_DEBUG 4
+
+#ifndef LOG_NIVEL
+#define LOG_NIVEL LOG_NIVEL_INFO
+#endif
+
+#define LOG_NUCLEOS     2     // uma fila por núcleo do ESP32
+#define LOG_CAPACIDADE  32    // linhas por fila (potência de 2)
+#define LOG_LINHA_MAX   256   // texto de uma linha (maior é truncada)
+
+#define LOG_ELIDIDO(...) do { if (0) logEscrever(0, __VA_ARGS__); } while (0)
+
+#if LOG_NIVEL >= LOG_NIVEL_ERRO
+#define LOG_ERRO(...) logEscrever(LOG_NIVEL_ERRO, __VA_ARGS__)
+#else
+#define LOG_ERRO(...) LOG_ELIDIDO(__VA_ARGS__)
+#endif
+
+#if LOG_NIVEL >= LOG_NIVEL_AVISO
+#define LOG_AVISO(...) logEscrever(LOG_NIVEL_AVISO, __VA_ARGS__)
+#else
+#define LOG_AVISO(...) LOG_ELIDIDO(__VA_ARGS__)
+#endif
+
+#if LOG_NIVEL >= LOG_NIVEL_INFO
+#define LOG_INFO(...) logEscrever(LOG_NIVEL_INFO, __VA_ARGS__)
+#else
+#define LOG_INFO(...) LOG_ELIDIDO(__VA_ARGS__)
+#endif
+
+#if LOG_NIVEL >= LOG_NIVEL_DEBUG
+#define LOG_DEBUG(...) logEscrever(LOG_NIVEL_DEBUG, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...) LOG_ELIDIDO(__VA_ARGS__)
+#endif
+
+struct LogStats {
+    uint32_t escritas;      // linhas aceitas
+    uint32_t descartadas;   // linhas perdidas (fila cheia ou formato inválido)
+    uint32_t truncadas;     // maiores que LOG_LINHA_MAX
+    uint32_t picoOcupacao;  // maior ocupação de uma fila
+};
+
+// Use as macros acima. Não bloqueia; não chamar de ISR (vsnprintf).
+// A linha não precisa terminar em '\n': a taskLog põe.
+void logEscrever(uint8_t nivel, const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+
+// Consumidor único: entrega cada linha completa, em ordem, a
+// escrever() ("<ms> <nível> <texto>\n"). Retorna quantas linhas saíram.
+size_t logDrenar(void (*escrever)(const char* linha, size_t tamanho));
+
+LogStats logEstatisticas();
+char letraNivelLog(uint8_t nivel);
+
+// ---------------- Driver ----------------
+// log_esp32.cpp cria a taskLog e escreve no Serial; log_native.cpp
+// não tem tarefa (os testes chamam logDrenar()).
+void logIniciar();
+uint8_t logNucleoAtual();
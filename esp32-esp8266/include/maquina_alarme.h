@@ -0,0 +1,117 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+
+#include "estado.h"
+
+// ========================================================
+// MÁQUINA DE ESTADOS DO ALARME (SEM LOCK)
+// ========================================================
+// Estado e versão ficam numa única palavra atômica:
+//   bits 0..7  EstadoAlarme (OK = armado, ALERTA, PAUSADO)
+//   bits 8..31 versão, +1 a cada transição
+// Transições são CAS sobre a palavra inteira: quem vence faz os
+// efeitos, quem perde relê e recalcula. Leitores fazem um load e
+// nunca bloqueiam. Cada transição vai para um histórico circular
+// (seqlock por posição) e as falhas de CAS são contadas para medir
+// a contenção.
+
+enum EntradaAlarme : uint8_t {
+    ENTRADA_DETECCAO = 0,    // presença confirmada pelo filtro
+    ENTRADA_SILENCIAR,       // botão: desarma o alerta, não mexe na pausa
+    ENTRADA_PARAR,           // STOP: volta a armado de qualquer estado
+    ENTRADA_PAUSAR,
+    ENTRADA_RETOMAR,
+    ENTRADA_ALTERNAR_PAUSA,  // botão: 10 cliques ou toque longo
+    NUM_ENTRADAS_ALARME
+};
+
+const char* nomeEntradaAlarme(EntradaAlarme entrada);
+
+// Tabela de transição pura
+constexpr EstadoAlarme proximoEstadoAlarme(EstadoAlarme atual, EntradaAlarme entrada) {
+    switch (entrada) {
+        case ENTRADA_DETECCAO:       return atual == ESTADO_OK ? ESTADO_ALERTA : atual;
+        case ENTRADA_SILENCIAR:      return atual == ESTADO_ALERTA ? ESTADO_OK : atual;
+        case ENTRADA_PARAR:          return ESTADO_OK;
+        case ENTRADA_PAUSAR:         return ESTADO_PAUSADO;
+        case ENTRADA_RETOMAR:        return atual == ESTADO_PAUSADO ? ESTADO_OK : atual;
+        case ENTRADA_ALTERNAR_PAUSA: return atual == ESTADO_PAUSADO ? ESTADO_OK : ESTADO_PAUSADO;
+        default:                     return atual;
+    }
+}
+
+static_assert(proximoEstadoAlarme(ESTADO_PAUSADO, ENTRADA_DETECCAO) == ESTADO_PAUSADO,
+              "pausado não dispara");
+static_assert(proximoEstadoAlarme(ESTADO_ALERTA, ENTRADA_DETECCAO) == ESTADO_ALERTA,
+              "alerta fica travado até silenciar");
+
+struct TransicaoAlarme {
+    bool mudou;
+    EstadoAlarme de;
+    EstadoAlarme para;
+    uint32_t versao;  // versão resultante (a atual, se não mudou)
+};
+
+struct RegistroTransicao {
+    uint32_t versao;
+    EstadoAlarme de;
+    EstadoAlarme para;
+    EntradaAlarme entrada;
+    uint32_t instanteMs;
+};
+
+struct MaquinaAlarmeStats {
+    uint32_t transicoes;  // CAS vencidos
+    uint32_t ignoradas;   // entrada sem efeito no estado atual
+    uint32_t conflitos;   // CAS perdidos para outra tarefa (contenção)
+    uint32_t maxTentativas;  // pior caso de tentativas numa só entrada
+};
+
+#define MAQUINA_HISTORICO 32  // potência de 2
+
+class MaquinaAlarme {
+public:
+    MaquinaAlarme();
+
+    TransicaoAlarme aplicar(EntradaAlarme entrada, uint32_t agoraMs);
+
+    EstadoAlarme estado() const {
+        return (EstadoAlarme)(palavra_.load(std::memory_order_acquire) & 0xFF);
+    }
+    uint32_t versao() const { return palavra_.load(std::memory_order_acquire) >> 8; }
+
+    // Estado e versão lidos juntos (um único load)
+    EstadoAlarme estado(uint32_t& versao) const {
+        uint32_t p = palavra_.load(std::memory_order_acquire);
+        versao = p >> 8;
+        return (EstadoAlarme)(p & 0xFF);
+    }
+
+    // Copia até "max" transições, da mais antiga para a mais recente;
+    // posições sendo escritas naquele instante são puladas.
+    uint32_t historico(RegistroTransicao* saida, uint32_t max) const;
+
+    MaquinaAlarmeStats estatisticas() const;
+
+    // Volta a OK, versão 0, zera histórico e contadores (boot e testes)
+    void reiniciar();
+
+private:
+    void registrar(uint32_t versao, EstadoAlarme de, EstadoAlarme para,
+                   EntradaAlarme entrada, uint32_t agoraMs);
+
+    std::atomic<uint32_t> palavra_;
+
+    struct Posicao {
+        std::atomic<uint32_t> cabecalho;  // 0 = vazia/sendo escrita
+        std::atomic<uint32_t> instanteMs;
+    };
+    Posicao historico_[MAQUINA_HISTORICO];
+
+    std::atomic<uint32_t> transicoes_;
+    std::atomic<uint32_t> ignoradas_;
+    std::atomic<uint32_t> conflitos_;
+    std::atomic<uint32_t> maxTentativas_;
+};
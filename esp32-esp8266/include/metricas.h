@@ -0,0 +1,180 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+#include "eventos.h"
+
+// ========================================================
+// MÉTRICAS DE SAÚDE DO DISPOSITIVO
+// ========================================================
+// A cada METRICAS_PERIODO_MS o loop() (prioridade mais baixa de
+// todas) fecha uma janela e publica um quadro binário em
+// TOPICO_METRICAS com:
+//   - CPU e folga mínima de pilha de cada tarefa nossa;
+//   - heap livre, mínimo desde o boot e maior bloco contíguo;
+//   - publicações e descartes do publicador, quedas e reconexões;
+//   - histogramas do intervalo entre amostras do sensor e do atraso
+//     com que a taskSensor acorda em relação ao prazo.
+//
+// Coletar não bloqueia ninguém: os caminhos quentes só fazem um
+// fetch_add relaxado num balde do histograma, e o coletor lê
+// contadores cumulativos e subtrai a janela anterior (ninguém zera
+// nada que outra tarefa esteja escrevendo). Do lado do FreeRTOS, o
+// coletor lê cada tarefa com vTaskGetInfo(), sem suspender o
+// escalonador como o uxTaskGetSystemState() fazia.
+//
+// Quadro (little-endian, cabe em PUBLICADOR_PAYLOAD_MAX):
+//   u8  versão (1)
+//   u8  flags (bit 0: CPU por tarefa disponível)
+//   u16 duração da janela (s)
+//   u32 uptime (s)
+//   u32 heap livre, u32 heap mínimo, u32 maior bloco (bytes)
+//   u16 publicadas, u16 descartadas, u16 falhas de envio  (na janela)
+//   u16 quedas, u16 reconexões, u16 falhas de conexão MQTT (desde o boot)
+//   u8  CPU ociosa (% dos dois núcleos, 0xFF = n/d)
+//   u8  quantidade de tarefas, e para cada uma:
+//       u8 id (TarefaMonitorada ou METRICAS_TAREFA_LOOP),
+//       u8 CPU (% de um núcleo, 0xFF = n/d), u16 pilha livre mínima (bytes)
+//   u8  baldes do intervalo, u16 por balde
+//   u8  baldes do atraso,    u16 por balde
+// Tetos dos baldes (o último não tem teto):
+//   intervalo, em % do período do sensor: 95 105 125 150 200 400 -
+//   atraso para acordar, em µs: 250 500 1000 2000 5000 10000 50000 -
+// Contagens da janela saturam em 0xFFFF.
+
+#ifndef METRICAS_PERIODO_MS
+#define METRICAS_PERIODO_MS 30000UL
+#endif
+
+// Relatório detalhado também no Serial (o antigo dump do loop())
+#ifndef METRICAS_SERIAL
+#define METRICAS_SERIAL 0
+#endif
+
+#define METRICAS_VERSAO       1
+#define METRICAS_MAX_TAREFAS  8
+#define METRICAS_MAX_BALDES   8
+#define METRICAS_QUADRO_MAX   128
+#define METRICAS_SEM_DADO     0xFF
+
+#define METRICAS_TAREFA_LOOP  NUM_TAREFAS_MONITORADAS
+
+#define METRICAS_BALDES_INTERVALO 7
+#define METRICAS_BALDES_ATRASO    8
+
+// ---------------- Histograma ----------------
+// Baldes com teto fixo; registrar() é seguro de qualquer tarefa (não
+// de ISR) e não bloqueia. Os contadores só crescem.
+class Histograma {
+public:
+    // limites[i] = maior valor do balde i; o balde n-1 pega o resto
+    void configurar(const uint32_t* limites, uint8_t baldes);
+    void registrar(uint32_t valor);
+
+    uint8_t baldes() const { return baldes_; }
+    uint32_t limite(uint8_t balde) const { return limites_[balde]; }
+    void ler(uint32_t contagens[METRICAS_MAX_BALDES]) const;
+    uint32_t maximo() const { return maximo_.load(std::memory_order_relaxed); }
+
+private:
+    uint32_t limites_[METRICAS_MAX_BALDES] = {};
+    uint8_t baldes_ = 0;
+    std::atomic<uint32_t> contagens_[METRICAS_MAX_BALDES] = {};
+    std::atomic<uint32_t> maximo_{0};
+};
+
+// ---------------- Amostra do sistema ----------------
+// Preenchida por metricasColetarSistema() (driver da plataforma)
+struct AmostraTarefa {
+    uint8_t id;
+    uint32_t execucao;    // contador de tempo de execução do FreeRTOS
+    uint32_t pilhaLivre;  // menor folga de pilha já vista (bytes)
+};
+
+struct AmostraSistema {
+    uint32_t instanteMs;
+    uint32_t heapLivre;
+    uint32_t heapMinimo;
+    uint32_t maiorBloco;
+    bool temExecucao;     // configGENERATE_RUN_TIME_STATS ligado
+    uint32_t relogio;     // contador de tempo de execução global
+    uint32_t ocioso;      // soma das tarefas IDLE
+    uint8_t nucleos;
+    uint8_t tarefas;
+    AmostraTarefa tarefa[METRICAS_MAX_TAREFAS];
+};
+
+// ---------------- Janela fechada ----------------
+struct MetricasTarefa {
+    uint8_t id;
+    uint8_t cpu;          // % de um núcleo, METRICAS_SEM_DADO se n/d
+    uint32_t pilhaLivre;
+};
+
+struct RelatorioMetricas {
+    uint32_t janelaMs;
+    uint32_t uptimeMs;
+    uint32_t heapLivre;
+    uint32_t heapMinimo;
+    uint32_t maiorBloco;
+    uint32_t publicadas;
+    uint32_t descartadas;
+    uint32_t falhasEnvio;
+    uint32_t quedas;
+    uint32_t reconexoes;
+    uint32_t falhasMqtt;
+    uint8_t ocioso;       // % dos núcleos somados, METRICAS_SEM_DADO se n/d
+    uint8_t tarefas;
+    MetricasTarefa tarefa[METRICAS_MAX_TAREFAS];
+    uint32_t intervalo[METRICAS_MAX_BALDES];
+    uint32_t atraso[METRICAS_MAX_BALDES];
+    uint32_t atrasoMaxUs;  // desde o boot
+};
+
+class Metricas {
+public:
+    // Período do sensor: os baldes do intervalo são relativos a ele
+    void iniciar(uint32_t periodoSensorMs);
+
+    // ---------------- taskSensor ----------------
+    void amostraSensor(uint32_t agoraUs);        // a cada amostra lida
+    void despertou(int32_t desvioUs);            // real - previsto
+
+    // ---------------- coletor ----------------
+    // Fecha a janela desde a chamada anterior
+    RelatorioMetricas fechar(const AmostraSistema& atual);
+
+    const Histograma& intervalo() const { return intervalo_; }
+    const Histograma& atraso() const { return atraso_; }
+
+private:
+    Histograma intervalo_;
+    Histograma atraso_;
+    uint32_t periodoSensorMs_ = 0;
+    uint32_t ultimaAmostraUs_ = 0;  // só a taskSensor usa
+    bool temAmostra_ = false;
+
+    // Janela anterior (só o coletor usa)
+    AmostraSistema anterior_ = {};
+    bool temAnterior_ = false;
+    uint32_t publicadas_ = 0;
+    uint32_t descartadas_ = 0;
+    uint32_t falhasEnvio_ = 0;
+    uint32_t intervaloAnt_[METRICAS_MAX_BALDES] = {};
+    uint32_t atrasoAnt_[METRICAS_MAX_BALDES] = {};
+};
+
+extern Metricas metricas;
+
+// % de uso: delta do contador da tarefa sobre o delta do relógio
+uint8_t metricasParcela(uint32_t dExecucao, uint32_t dRelogio);
+
+// Quadro de TOPICO_METRICAS. Retorna o tamanho ou 0 se não couber.
+size_t metricasCodificar(const RelatorioMetricas& r, uint8_t* buf, size_t tamanho);
+
+// ---------------- Driver da plataforma ----------------
+// metricas_esp32.cpp: heap, pilha e tempo de execução do FreeRTOS
+void metricasRegistrarTarefa(uint8_t id, void* tarefa);  // TaskHandle_t
+void metricasColetarSistema(AmostraSistema& amostra);
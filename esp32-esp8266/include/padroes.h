@@ -0,0 +1,46 @@
+#pragma once
+
+#include <stdint.h>
+
+// ========================================================
+// SEQUENCIADOR DE PADRÕES DO BUZZER / LED DE ALERTA
+// ========================================================
+// Toca sequências de bipes e piscadas sem bloquear quem pede: o
+// chamador só enfileira o padrão e retorna. Os passos rodam numa
+// tarefa própria no núcleo do alarme (taskBuzzer, tarefas.h), acima
+// do sensor, então ninguém dorme esperando o buzzer, ninguém segura
+// lock durante o som e o tráfego de rede não atrasa a sirene.
+//
+// Padrões "de fundo" (PADRAO_ALERTA) repetem até padraoParar();
+// padrões avulsos (bipes) têm prioridade e o fundo volta depois.
+// O sequenciador é o único que escreve no canal do buzzer.
+
+enum Padrao : uint8_t {
+    PADRAO_NENHUM = 0,
+    PADRAO_BEEP_CURTO,   // confirmação
+    PADRAO_BEEP_TRIPLO,  // pausa/retomada do alarme
+    PADRAO_ALERTA,       // LED vermelho piscando + buzzer (repete)
+    NUM_PADROES
+};
+
+// Cria a taskBuzzer. Chamar uma vez no setup().
+void padroesIniciar();
+
+// Enfileira um padrão avulso ou liga o padrão de fundo. Não bloqueia;
+// retorna false se a fila de avulsos estiver cheia.
+bool padraoTocar(Padrao padrao);
+
+// Desliga o padrão de fundo (se for este) e silencia o buzzer
+void padraoParar(Padrao padrao);
+
+Padrao padraoDeFundo();
+
+// ---------------- Interface com o driver ----------------
+// Executa o próximo passo e retorna em quantos ms o próximo deve
+// rodar (0 = sequenciador ocioso). Chamado apenas pelo driver (a
+// taskBuzzer no ESP32), nunca em paralelo consigo mesmo.
+uint32_t padroesAvancar();
+
+// Implementado por plataforma (padroes_esp32.cpp / padroes_native.cpp):
+// agenda padroesAvancar() daqui a "ms", cancelando o agendamento atual.
+void padroesAgendar(uint32_t ms);
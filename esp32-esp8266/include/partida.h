@@ -0,0 +1,86 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+#include "comodos.h"
+
+// ========================================================
+// PARTIDA RÁPIDA
+// ========================================================
+// Depois de uma queda de energia a casa não pode ficar desprotegida
+// esperando a rede. O setup() só faz o que é local (pinos, LEDC,
+// estado salvo, tarefas do sensor e do botão) e cria a taskMQTT, que
+// prepara diário, TLS e WiFi já em segundo plano.
+//
+// Estado salvo: pausa do alarme e cor de cada cômodo ficam na NVS e
+// voltam no boot. Quem muda o estado não grava nada; a taskMQTT
+// (dona da flash) compara o estado atual com o gravado e só grava
+// depois de PARTIDA_ESTAVEL_MS sem mudanças, então um fade ou uma
+// rajada de comandos vira uma gravação só.
+//
+// Tempos medidos a partir do boot (millis()):
+//   armado     - primeira leitura do sensor avaliada pelo alarme;
+//   conectado  - primeira sessão MQTT.
+// Saem no log e, retidos, em TOPICO_PARTIDA:
+//   "<armado ms>,<conectado ms>,<PAUSADO|ARMADO>,<luzes acesas>"
+// com o estado e as luzes que vieram da NVS.
+
+#ifndef PARTIDA_ESTAVEL_MS
+#define PARTIDA_ESTAVEL_MS 2000UL
+#endif
+
+#define PARTIDA_VERSAO      1
+#define PARTIDA_BYTES_MAX   (3 + 3 * NUM_COMODOS)
+
+struct EstadoSalvo {
+    bool pausado;
+    uint8_t cores[NUM_COMODOS][3];  // R, G, B de cada cômodo
+};
+
+struct PartidaStats {
+    uint32_t armadoMs;      // 0 = ainda não
+    uint32_t conectadoMs;   // 0 = ainda não
+    bool restaurado;        // havia estado válido na NVS
+    bool pausado;           // o que foi restaurado
+    uint8_t luzes;          // cômodos que voltaram acesos
+    uint32_t gravacoes;
+    uint32_t falhasGravacao;
+};
+
+// Formato na NVS: versão, flags (bit 0 = pausado), cômodos, RGB...
+// Outro formato ou outra quantidade de cômodos é ignorado.
+size_t estadoSalvoCodificar(const EstadoSalvo& e, uint8_t* buf, size_t tamanho);
+bool estadoSalvoDecodificar(const uint8_t* buf, size_t tamanho, EstadoSalvo& e);
+
+// Estado atual da máquina do alarme e das luzes
+EstadoSalvo estadoSalvoAtual();
+
+// ---------------- setup() ----------------
+// Lê a NVS e reaplica pausa e luzes antes das tarefas existirem.
+// Retorna false se não havia nada (primeiro boot).
+bool partidaRestaurar();
+
+// ---------------- taskMQTT ----------------
+// Grava o estado se ele mudou e está estável há PARTIDA_ESTAVEL_MS
+void partidaServicar(uint32_t agoraMs);
+
+// Quanto falta para a gravação pendente (UINT32_MAX se nada)
+uint32_t partidaPrazoMs(uint32_t agoraMs);
+
+// ---------------- Marcos ----------------
+// Só o primeiro conta; retornam true nessa vez
+bool partidaArmado(uint32_t agoraMs);
+bool partidaConectado(uint32_t agoraMs);
+
+PartidaStats partidaEstatisticas();
+
+// Payload de TOPICO_PARTIDA. Retorna o tamanho escrito.
+size_t formatarPartida(char* buf, size_t tamanho, const PartidaStats& s);
+
+// ---------------- Driver (NVS) ----------------
+// partida_esp32.cpp usa armazenamento.h; partida_native.cpp, um
+// buffer em RAM. Ler retorna o tamanho lido (0 se não há nada).
+size_t partidaNvsLer(uint8_t* buf, size_t tamanho);
+bool partidaNvsGravar(const uint8_t* buf, size_t tamanho);
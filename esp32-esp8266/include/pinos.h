@@ -0,0 +1,31 @@
+#pragma once
+
+// ========================================================
+// PINOS DO HARDWARE
+// ========================================================
+// Ultrassônico
+#define TRIG_PIN   25
+#define ECHO_PIN   33
+
+// LED RGB principal do alarme
+#define LED_RED    32
+#define LED_GREEN  21
+#define LED_BLUE   18
+
+// Buzzer e botão
+#define BUZZER_PIN 13
+#define BUTTON_PIN 19
+
+// LEDs RGB dos cômodos: ver a tabela em comodos.h
+
+// ========================================================
+// PWM CONFIGURATION
+// ========================================================
+#define BUZZER_CHANNEL 0
+#define BUZZER_FREQ    2000
+#define BUZZER_RES     8
+
+// Luzes dos cômodos: 12 bits dão degraus finos no escuro depois da
+// correção de gama (ver transicao.h). A 5 kHz o LEDC aceita até 13.
+#define LED_PWM_FREQ   5000
+#define LED_PWM_RES    12
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "hal.h"
+
+// ========================================================
+// PUBLICADOR MQTT (DONO ÚNICO DO SOCKET)
+// ========================================================
+// O PubSubClient não é thread-safe. As tarefas não chamam mais
+// mqttClient.publish(): elas copiam a mensagem para uma fila sem
+// lock (publicar() nunca bloqueia e pode ser chamada de ISR) e só a
+// taskMQTT, que já roda mqttClient.loop(), esvazia a fila com
+// publicadorDrenar(). Cada mensagem enfileirada sinaliza
+// EVENTO_PUBLICAR (eventos.h), que é o que acorda a taskMQTT.
+//
+// Enquanto a sessão MQTT está caída (ver conexao.h) publicar()
+// recusa na hora e conta em descartadasOffline; quem gera dados
+// periódicos consulta publicadorConectado() antes de formatar.
+
+#define PUBLICADOR_CAPACIDADE   16   // mensagens (potência de 2)
+#define PUBLICADOR_PAYLOAD_MAX  128  // bytes por mensagem
+
+struct PublicadorStats {
+    uint32_t enfileiradas;       // aceitas na fila
+    uint32_t publicadas;         // entregues ao PubSubClient
+    uint32_t descartadasCheia;   // fila cheia no momento do publicar()
+    uint32_t descartadasTamanho; // payload maior que PUBLICADOR_PAYLOAD_MAX
+    uint32_t descartadasOffline; // publicar() sem sessão MQTT
+    uint32_t falhasEnvio;        // publish() do PubSubClient retornou false
+    uint32_t picoOcupacao;       // maior ocupação observada
+};
+
+// Chamado pela taskMQTT logo depois de o publish() da mensagem ser
+// aceito (ex.: marca de publicado em latencia.h). Tem que ser curto.
+typedef void (*AvisoEntrega)();
+
+// O tópico precisa ter duração estática (literal ou tabela global):
+// só o ponteiro é copiado para a fila.
+bool publicar(const char* topico, const char* payload, bool retido = false,
+              AvisoEntrega entregue = nullptr);
+bool publicarBinario(const char* topico, const uint8_t* dados, size_t tamanho,
+                     bool retido = false, AvisoEntrega entregue = nullptr);
+
+// Chamado apenas pela tarefa dona do socket; também é quem atualiza
+// o estado de conexão visto pelos produtores
+void publicadorDrenar(PubSubClient& cliente);
+
+// Último estado da conexão visto pela tarefa dona (leitura sem lock)
+bool publicadorConectado();
+
+PublicadorStats publicadorEstatisticas();
@@ -0,0 +1,165 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+#include "comodos.h"
+#include "fila_lockfree.h"
+
+// ========================================================
+// AUTOMAÇÕES LOCAIS (MOTOR DE REGRAS)
+// ========================================================
+// Reações como "alarme disparou -> sala em branco" ou "luz acesa há
+// 30 min -> apaga" não precisam mais do broker nem do dashboard:
+// cada regra liga um gatilho a uma ação e roda no dispositivo, com
+// ou sem rede.
+//
+// Gatilhos (indice / valor):
+//   GATILHO_ALARME - alarme entrou num estado     - / EstadoAlarme
+//   GATILHO_ZONA   - presença começou/acabou      zona / 1 ou 0
+//   GATILHO_LUZ    - cômodo aceso há N segundos   cômodo / N
+//   GATILHO_GESTO  - gesto do botão               GestoBotao / cliques (0 = qualquer)
+// indice REGRAS_QUALQUER casa com qualquer zona, cômodo ou gesto.
+// GATILHO_LUZ dispara uma vez por período aceso.
+//
+// Ações (destino):
+//   ACAO_COR      - aplicarCorComodo(r, g, b, transição) no cômodo,
+//                   em todos (REGRAS_QUALQUER) ou no do gatilho de
+//                   luz (REGRAS_DO_GATILHO);
+//   ACAO_PADRAO   - padraoTocar() do padrão;
+//   ACAO_PUBLICAR - "<nº da regra>,<indice>,<valor>" em
+//                   TOPICO_REGRAS_DISPARO (com o broker fora, perde-se
+//                   só o aviso).
+//
+// Quem produz o gatilho (sensor, botão, transição do alarme) só
+// enfileira um EventoRegra sem lock e sinaliza EVENTO_REGRAS; quem
+// avalia e executa é a taskMQTT, que já é a dona das luzes, da NVS e
+// do publicador. Ela continua rodando sem WiFi; com o broker fora, o
+// pior atraso é uma tentativa de connect() (MQTT_TIMEOUT_CONEXAO_S).
+// A tabela é compilada ao carregar: uma máscara de regras por tipo
+// de gatilho, então avaliar um evento só olha as regras daquele tipo.
+//
+// Tabela (TOPICO_REGRAS, binário, e o mesmo formato na NVS):
+//   u8 versão (1), u8 quantidade, e para cada regra:
+//   u8 gatilho, u8 indice, u16 valor (little-endian),
+//   u8 ação, u8 destino, u8 r, u8 g, u8 b, u8 transição (×100 ms)
+// Uma tabela inválida é recusada inteira e a anterior fica. O
+// resultado sai retido em TOPICO_REGRAS_ESTADO: "OK,<regras>" ou
+// "INVALIDA,<nº da regra ou -1 para o cabeçalho>". Quantidade 0
+// apaga todas.
+
+#define REGRAS_VERSAO       1
+#define REGRAS_MAX          16
+#define REGRAS_BYTES_REGRA  10
+#define REGRAS_BYTES_MAX    (2 + REGRAS_MAX * REGRAS_BYTES_REGRA)
+#define REGRAS_EVENTOS      16   // fila entre os produtores e a taskMQTT
+
+#define REGRAS_QUALQUER     0xFF
+#define REGRAS_DO_GATILHO   0xFE
+
+static_assert(REGRAS_MAX <= 16, "máscaras de regras são de 16 bits");
+
+enum GatilhoRegra : uint8_t {
+    GATILHO_ALARME = 0,
+    GATILHO_ZONA,
+    GATILHO_LUZ,
+    GATILHO_GESTO,
+    NUM_GATILHOS
+};
+
+enum AcaoRegra : uint8_t {
+    ACAO_COR = 0,
+    ACAO_PADRAO,
+    ACAO_PUBLICAR,
+    NUM_ACOES
+};
+
+struct Regra {
+    uint8_t gatilho;
+    uint8_t indice;
+    uint16_t valor;
+    uint8_t acao;
+    uint8_t destino;
+    uint8_t cor[3];
+    uint8_t transicao;  // ×100 ms
+};
+
+struct EventoRegra {
+    uint8_t gatilho;
+    uint8_t indice;
+    uint16_t valor;
+};
+
+struct RegrasStats {
+    uint8_t regras;
+    uint32_t eventos;         // avaliados
+    uint32_t descartados;     // fila cheia
+    uint32_t disparos;        // ações executadas
+    uint32_t recusadas;       // tabelas inválidas
+    uint32_t gravacoes;
+    uint32_t falhasGravacao;
+    uint32_t avaliacaoMaxUs;  // pior evento, da fila às ações
+};
+
+// Valida e decodifica a tabela. Se não for válida, invalida recebe
+// o nº da primeira regra com problema (-1 = cabeçalho).
+bool regrasDecodificar(const uint8_t* buf, size_t tamanho, Regra* tabela, uint8_t& quantidade,
+                       int& invalida);
+// Retorna o tamanho ou 0 se não couber
+size_t regrasCodificar(const Regra* tabela, uint8_t quantidade, uint8_t* buf, size_t tamanho);
+
+class MotorRegras {
+public:
+    // ---------------- Produtores (qualquer tarefa) ----------------
+    void evento(GatilhoRegra gatilho, uint8_t indice, uint16_t valor);
+
+    // ---------------- taskMQTT ----------------
+    // setup(): tabela salva na NVS (nada se não houver)
+    void iniciar();
+    // Tabela nova de TOPICO_REGRAS: troca, grava na NVS e responde
+    void configurar(const uint8_t* buf, size_t tamanho);
+    // Avalia os eventos da fila e os gatilhos de luz
+    void servicar(uint32_t agoraMs);
+    // Quanto falta para o próximo gatilho de luz (UINT32_MAX se nada)
+    uint32_t prazoMs(uint32_t agoraMs) const;
+
+    uint8_t quantidade() const { return quantidade_; }
+    const Regra& regra(uint8_t i) const { return regras_[i]; }
+    RegrasStats estatisticas() const;
+
+private:
+    bool carregar(const uint8_t* buf, size_t tamanho, int& invalida);
+    bool igualAtual(const uint8_t* buf, size_t tamanho) const;
+    void avaliar(const EventoRegra& ev);
+    void executar(uint8_t n, const EventoRegra& ev);
+    void servicarLuzes(uint32_t agoraMs);
+
+    FilaLockFree<EventoRegra, REGRAS_EVENTOS> fila_;
+
+    // Lida pelos produtores para não enfileirar o que nenhuma regra usa
+    std::atomic<uint16_t> porGatilho_[NUM_GATILHOS] = {};  // bit i = regras_[i]
+
+    // Só a taskMQTT usa daqui para baixo
+    Regra regras_[REGRAS_MAX] = {};
+    uint8_t quantidade_ = 0;
+    // Regras de luz que já dispararam no período aceso de cada cômodo
+    unsigned long luzDesde_[NUM_COMODOS] = {};
+    uint16_t luzDisparadas_[NUM_COMODOS] = {};
+
+    std::atomic<uint32_t> eventos_{0};
+    std::atomic<uint32_t> descartados_{0};
+    std::atomic<uint32_t> disparos_{0};
+    std::atomic<uint32_t> recusadas_{0};
+    std::atomic<uint32_t> gravacoes_{0};
+    std::atomic<uint32_t> falhasGravacao_{0};
+    std::atomic<uint32_t> avaliacaoMaxUs_{0};
+};
+
+extern MotorRegras regras;
+
+// ---------------- Driver (NVS) ----------------
+// regras_esp32.cpp usa armazenamento.h; regras_native.cpp, um buffer
+// em RAM. Ler retorna o tamanho lido (0 se não há nada).
+size_t regrasNvsLer(uint8_t* buf, size_t tamanho);
+bool regrasNvsGravar(const uint8_t* buf, size_t tamanho);
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "filtro_distancia.h"
+#include "gravacao.h"
+
+// ========================================================
+// REPRODUÇÃO DE RASTROS NO HOST
+// ========================================================
+// Só no ambiente native (reproducao_native.cpp, usado por
+// test/test_reproducao). Entrega cada amostra de um rastro gravado
+// (gravacao.h) a avaliarSensor(), a mesma decisão da
+// taskSensorUltrassonico: filtro de cada sensor, zonas e máquina do
+// alarme, com o relógio do mock no instante gravado. Os disparos são
+// comparados com intervalos de presença anotados à mão, para medir
+// uma mudança no filtro, no limite ou no período contra um acervo de
+// rastros reais sem andar na frente do dispositivo.
+//
+// Rótulos (texto, um intervalo por linha, em ms desde a primeira
+// amostra do rastro; '#' começa um comentário):
+//   <início>,<fim>
+//
+// Um disparo (alarme passando a ALERTA) conta para o primeiro
+// intervalo que o contém, com toleranciaMs de folga nas duas pontas,
+// e a latência vai do início do intervalo até ele. Intervalo sem
+// disparo é falso negativo; disparo fora de todos, falso positivo.
+// Depois de um disparo o alarme volta a armado quando nenhum sensor
+// vê mais presença, como quem silencia ao sair.
+
+struct IntervaloPresenca {
+    uint32_t inicioMs;
+    uint32_t fimMs;
+};
+
+struct ConfigReproducao {
+    uint16_t limiteCm = 0;                 // 0 = o de cada linha de SENSORES
+    const FiltroConfig* filtro = nullptr;  // nullptr = filtroConfigPadrao(limite)
+    uint8_t decimacao = 1;                 // k = só uma a cada k leituras de cada sensor
+    uint32_t toleranciaMs = 500;
+};
+
+struct RelatorioReproducao {
+    uint32_t amostras;         // entregues a avaliarSensor()
+    uint32_t ignoradas;        // sensor fora de SENSORES
+    uint32_t duracaoMs;        // do rastro
+    uint32_t disparos;
+    uint32_t presencas;        // intervalos rotulados
+    uint32_t detectadas;
+    uint32_t falsosPositivos;
+    uint32_t falsosNegativos;
+    uint32_t redisparos;       // mais de um disparo na mesma presença
+    uint32_t latenciaMinMs;
+    uint32_t latenciaMediaMs;
+    uint32_t latenciaMaxMs;
+    double amostrasPorSegundo; // vazão da reprodução no host
+};
+
+// Lê um rastro (quadros em sequência). Retorna quantas amostras
+// couberam; quadrosPerdidos conta os buracos na numeração e para no
+// primeiro quadro inválido.
+size_t reproducaoLerRastro(const uint8_t* buf, size_t tamanho, AmostraGravada* amostras,
+                           size_t max, uint32_t& quadrosPerdidos);
+
+// Retorna quantos intervalos leu, ou -1 se uma linha não fechar
+int reproducaoLerRotulos(const char* texto, size_t tamanho, IntervaloPresenca* rotulos,
+                         size_t max);
+
+// Reinicia filtros, zonas e alarme antes e devolve os filtros ao
+// padrão de SENSORES depois
+RelatorioReproducao reproduzir(const AmostraGravada* amostras, size_t quantidade,
+                               const IntervaloPresenca* rotulos, size_t numRotulos,
+                               const ConfigReproducao& cfg = ConfigReproducao());
+
+void reproducaoImprimir(const char* nome, const RelatorioReproducao& r);
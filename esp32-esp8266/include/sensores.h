@@ -0,0 +1,177 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "comodos.h"
+#include "pinos.h"
+#include "topicos.h"
+
+// ========================================================
+// TABELA DE SENSORES E ZONAS
+// ========================================================
+// Cada HC-SR04 é uma linha de SENSORES: nome, pinos de trigger e eco,
+// limite de disparo, zona e grupo de disparo. Cada zona é uma linha
+// de ZONAS e tem o estado próprio em zona/<nome>/estado (zonas.h).
+// Como em comodos.h, conflitos de pino são pegos em tempo de
+// compilação.
+//
+// Grupos: sensores do mesmo grupo disparam juntos e os grupos, um
+// depois do outro. Dois sensores que se enxergam (mesmo corredor,
+// frente a frente) precisam de grupos diferentes, senão um lê o eco
+// do outro. Um grupo por sensor é o rodízio puro; sensores em portas
+// distantes podem dividir o grupo e medir em paralelo.
+//
+// Exemplo com três sensores (sala e corredor se veem):
+//   SENSOR("porta",    TRIG_PIN, ECHO_PIN, 30, 0, 0),
+//   SENSOR("sala",     26,       27,       80, 1, 1),
+//   SENSOR("corredor", 14,       34,       50, 1, 0),
+
+struct Zona {
+    const char* nome;
+    const char* topicoEstado;  // zona/<nome>/estado
+};
+
+#define ZONA(nome) { nome, TOPICO_ZONA_PREFIXO nome "/estado" }
+
+constexpr Zona ZONAS[] = {
+    ZONA("entrada"),
+};
+
+constexpr size_t NUM_ZONAS = sizeof(ZONAS) / sizeof(ZONAS[0]);
+
+struct Sensor {
+    const char* nome;
+    uint8_t trig;
+    uint8_t eco;
+    uint16_t limiteCm;  // presença a esta distância ou menos
+    uint8_t zona;       // índice em ZONAS
+    uint8_t grupo;      // grupos disparam em sequência, 0 primeiro
+};
+
+#define SENSOR(nome, trig, eco, limiteCm, zona, grupo) \
+    { nome, trig, eco, limiteCm, zona, grupo }
+
+// Limite do sensor original da porta
+#define DISTANCIA_LIMITE_CM 30
+
+constexpr Sensor SENSORES[] = {
+    SENSOR("porta", TRIG_PIN, ECHO_PIN, DISTANCIA_LIMITE_CM, 0, 0),
+};
+
+constexpr size_t NUM_SENSORES = sizeof(SENSORES) / sizeof(SENSORES[0]);
+
+// Período de cada sensor: um ciclo (todos os grupos) começa no máximo
+// a cada PERIODO_SENSOR_MS. A captura por interrupção não ocupa a CPU
+// durante o eco e o filtro precisa de várias amostras para confirmar,
+// então amostramos rápido (mínimo ~60 ms pelo HC-SR04).
+#ifndef PERIODO_SENSOR_MS
+#define PERIODO_SENSOR_MS 100
+#endif
+
+// Silêncio depois do último eco de um grupo antes do próximo
+// disparar: reflexões tardias do grupo anterior já se perderam
+#ifndef SENSORES_GUARDA_US
+#define SENSORES_GUARDA_US 10000
+#endif
+
+#define SENSORES_MAX 8  // máscaras de 8 bits nas notificações do eco
+
+// ---------------- Verificações em tempo de compilação ----------------
+namespace sensores_detalhe {
+
+constexpr uint8_t PINOS_ALARME[] = {
+    LED_RED, LED_GREEN, LED_BLUE, BUZZER_PIN, BUTTON_PIN,
+};
+
+constexpr bool pinoDeOutro(uint8_t pino) {
+    for (uint8_t p : PINOS_ALARME) {
+        if (p == pino) return true;
+    }
+    for (const Comodo& c : COMODOS) {
+        for (uint8_t p : c.pinos) {
+            if (p == pino) return true;
+        }
+    }
+    return false;
+}
+
+constexpr bool pinosLivres() {
+    for (const Sensor& s : SENSORES) {
+        if (s.trig == s.eco || pinoDeOutro(s.trig) || pinoDeOutro(s.eco)) return false;
+    }
+    return true;
+}
+
+constexpr bool semPinoRepetido() {
+    for (size_t i = 0; i < NUM_SENSORES; ++i) {
+        for (size_t j = i + 1; j < NUM_SENSORES; ++j) {
+            const Sensor& a = SENSORES[i];
+            const Sensor& b = SENSORES[j];
+            if (a.trig == b.trig || a.trig == b.eco || a.eco == b.trig || a.eco == b.eco) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+constexpr bool indicesValidos() {
+    for (const Sensor& s : SENSORES) {
+        if (s.zona >= NUM_ZONAS || s.grupo >= NUM_SENSORES || s.limiteCm == 0) return false;
+    }
+    return true;
+}
+
+}  // namespace sensores_detalhe
+
+static_assert(NUM_SENSORES <= SENSORES_MAX, "sensores demais para as máscaras de eco");
+static_assert(sensores_detalhe::pinosLivres(),
+              "pino de sensor conflita com LED de alarme, buzzer, botão ou cômodo");
+static_assert(sensores_detalhe::semPinoRepetido(), "pino repetido na tabela de sensores");
+static_assert(sensores_detalhe::indicesValidos(),
+              "sensor com zona ou grupo inexistente, ou limite zero");
+
+// ========================================================
+// AGENDA DE DISPAROS
+// ========================================================
+// Decide quando cada grupo dispara. Um grupo termina quando todos os
+// ecos voltaram (ou deu ULTRASSOM_TIMEOUT_US); o próximo dispara
+// SENSORES_GUARDA_US depois, sem esperar o timeout inteiro, então a
+// taxa agregada só depende da distância que os sensores estão vendo.
+// O ciclo seguinte respeita o período de cada sensor.
+
+struct AgendaStats {
+    uint32_t ciclos;
+    uint32_t disparos;       // grupos disparados
+    uint32_t ocupadoUs;      // do primeiro disparo ao fim do último grupo, último ciclo
+    uint32_t ocupadoMaxUs;
+    uint32_t atrasados;      // ciclos que passaram do período
+};
+
+class AgendaSensores {
+public:
+    AgendaSensores(const Sensor* tabela, size_t quantidade, uint32_t periodoUs);
+
+    uint8_t grupos() const { return grupos_; }
+    uint8_t mascara(uint8_t grupo) const { return mascaras_[grupo]; }
+
+    // Grupo a disparar a seguir e quanto esperar por ele (0 = já)
+    uint8_t proximo(uint32_t agoraUs, uint32_t& esperaUs) const;
+
+    // O grupo de proximo() disparou em inicioUs e terminou em fimUs
+    void concluido(uint32_t inicioUs, uint32_t fimUs);
+
+    AgendaStats estatisticas() const { return stats_; }
+
+private:
+    uint8_t mascaras_[SENSORES_MAX];
+    uint8_t grupos_;
+    uint32_t periodoUs_;
+
+    uint8_t grupo_;          // próximo a disparar
+    bool iniciado_;
+    uint32_t inicioCicloUs_;
+    uint32_t liberadoUs_;    // fim do último grupo + guarda
+    AgendaStats stats_;
+};
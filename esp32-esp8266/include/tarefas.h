@@ -0,0 +1,45 @@
+#pragma once
+
+// ========================================================
+// PLANO DE NÚCLEOS E PRIORIDADES DAS TAREFAS FREERTOS
+// ========================================================
+// O ESP32 tem dois núcleos. O IDF já deixa no núcleo 0 (PRO_CPU) o
+// WiFi, o lwIP e a tarefa do esp_timer; o loopTask do Arduino roda
+// no núcleo 1 (APP_CPU). O plano separa a rede do caminho do alarme:
+//
+//   núcleo 0 (rede):   taskMQTT, taskSocket   PRIORIDADE_NORMAL
+//                      taskLog                PRIORIDADE_BAIXA
+//   núcleo 1 (alarme): taskBuzzer             PRIORIDADE_SIRENE
+//                      taskSensor, taskBotao  PRIORIDADE_ALTA
+//                      loopTask (métricas)    1 (do Arduino)
+//
+// Um handshake TLS completo ocupa a CPU por centenas de ms e um
+// lote de publicações mantém a taskMQTT ocupada; antes, na mesma
+// prioridade e sem afinidade, isso disputava o núcleo com a decisão
+// do alarme. Agora nada da rede roda no núcleo do alarme, e lá a
+// sirene preempta até o sensor: o passo do buzzer nunca espera o
+// filtro terminar. A latência eco -> sirene -> estado publicado é
+// medida em latencia.h.
+//
+// Exceção: escrever ou apagar a flash desliga o cache dos dois
+// núcleos até a operação acabar. Nesse tempo só roda código em IRAM:
+// taskSensor, taskBuzzer, taskBotao e a ISR do eco (registrada sem
+// ESP_INTR_FLAG_IRAM) ficam paradas. Apagar um setor de 4 KB leva
+// dezenas de ms; gravar um registro, dezenas de µs. Quem mexe na
+// flash é só a taskMQTT: diário (o setor seguinte é apagado
+// adiantado, num giro ocioso, ver diario.h) e NVS de partida,
+// energia, regras e sessão TLS (que às vezes apaga uma página
+// inteira da NVS). Essas gravações são raras (estado estável há
+// PARTIDA_ESTAVEL_MS, hora de energia fechada, tabela de regras nova,
+// sessão TLS nova); um disparo que coincida com uma delas aparece no
+// histograma de latencia.h.
+//
+// Prioridade maior = número maior (0 a configMAX_PRIORITIES-1)
+
+#define NUCLEO_REDE    0
+#define NUCLEO_ALARME  1
+
+#define PRIORIDADE_SIRENE  6
+#define PRIORIDADE_ALTA    5
+#define PRIORIDADE_NORMAL  3
+#define PRIORIDADE_BAIXA   1
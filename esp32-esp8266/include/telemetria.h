@@ -0,0 +1,74 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// ========================================================
+// TELEMETRIA DO SENSOR
+// ========================================================
+// Dois modos:
+//   TELEMETRIA_TEXTO - comportamento original: uma mensagem "%.1f"
+//                      (ou "NA") em TOPICO_SENSOR a cada
+//                      PERIODO_PUBLICACAO_MEDIDA_MS.
+//   TELEMETRIA_LOTE  - acumula todas as amostras e publica um quadro
+//                      binário em TOPICO_SENSOR_LOTE a cada
+//                      TELEMETRIA_LOTE_AMOSTRAS amostras ou
+//                      TELEMETRIA_LOTE_MS, o que vier primeiro.
+//
+// Quadro do modo lote (little-endian):
+//   u8  versão (1)
+//   u8  flags (bit 0: amostras brutas anexadas)
+//   u8  quantidade de amostras
+//   u8  quantidade de amostras válidas (com eco)
+//   u32 t0: millis() da primeira amostra
+//   u16 intervalo médio entre amostras (ms)
+//   u16 mínimo, u16 máximo, u16 média das válidas (mm)
+//   [u16 mm por amostra, 0xFFFF = sem eco]   se flags bit 0
+
+#ifndef TELEMETRIA_MODO_PADRAO
+#define TELEMETRIA_MODO_PADRAO TELEMETRIA_TEXTO
+#endif
+
+#ifndef PERIODO_PUBLICACAO_MEDIDA_MS
+#define PERIODO_PUBLICACAO_MEDIDA_MS 300
+#endif
+
+#ifndef TELEMETRIA_LOTE_AMOSTRAS
+#define TELEMETRIA_LOTE_AMOSTRAS 30
+#endif
+
+#ifndef TELEMETRIA_LOTE_MS
+#define TELEMETRIA_LOTE_MS 5000UL
+#endif
+
+#ifndef TELEMETRIA_LOTE_BRUTAS
+#define TELEMETRIA_LOTE_BRUTAS 1  // 0 = só mín/máx/média/contagem
+#endif
+
+#define TELEMETRIA_VERSAO        1
+#define TELEMETRIA_CABECALHO     16
+#define TELEMETRIA_SEM_ECO       0xFFFF
+#define TELEMETRIA_QUADRO_MAX    (TELEMETRIA_CABECALHO + 2 * TELEMETRIA_LOTE_AMOSTRAS)
+
+enum ModoTelemetria : uint8_t {
+    TELEMETRIA_TEXTO = 0,
+    TELEMETRIA_LOTE,
+};
+
+struct LoteTelemetria {
+    uint32_t t0Ms;
+    uint32_t ultimoMs;
+    uint8_t quantidade;
+    uint16_t amostrasMm[TELEMETRIA_LOTE_AMOSTRAS];
+};
+
+void telemetriaDefinirModo(ModoTelemetria modo);
+ModoTelemetria telemetriaModo();
+
+// Chamado pela tarefa do sensor a cada leitura (-1 = sem eco)
+void telemetriaAmostra(float distanciaCm, uint32_t agoraMs);
+
+// Serializa o lote no formato acima. Retorna o tamanho ou 0 se
+// o buffer não couber.
+size_t telemetriaCodificarLote(const LoteTelemetria& lote, bool brutas,
+                               uint8_t* buf, size_t tamanho);
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+
+// ========================================================
+// TLS COM O BROKER: RETOMADA DE SESSÃO E CA FIXADA
+// ========================================================
+// O WiFiClientSecure fazia um handshake completo a cada reconexão
+// (troca de chaves ECDHE e verificação de cadeia: segundos de CPU e
+// dezenas de KB de heap), e sem verificar o certificado. O
+// ClienteTls (cliente_tls.h) fala mbedtls direto para poder:
+//   - verificar o broker contra a CA fixada em certificados.h, com
+//     checagem do nome do host (SNI);
+//   - guardar a sessão (ticket ou id de sessão) depois de cada
+//     handshake e oferecê-la na próxima conexão, o que vira um
+//     handshake abreviado quando o broker aceita;
+//   - manter configuração, CA já decodificada e buffers de registro
+//     entre conexões, em vez de alocar e liberar tudo a cada queda.
+//
+// Este arquivo é a parte portável: o acúmulo das medições de cada
+// handshake, separadas entre completo e retomado.
+
+// Pico de heap durante o handshake, amostrado a cada passo da máquina
+// de estados do mbedtls (o pico exato exigiria instrumentar o alocador)
+class MedidorHeap {
+public:
+    void iniciar(uint32_t livre) { inicial_ = livre; menor_ = livre; }
+    void amostrar(uint32_t livre) { if (livre < menor_) menor_ = livre; }
+    uint32_t pico() const { return inicial_ - menor_; }  // bytes acima do início
+
+private:
+    uint32_t inicial_ = 0;
+    uint32_t menor_ = 0;
+};
+
+struct HandshakeStats {
+    uint32_t quantidade;
+    uint32_t ultimoMs;
+    uint32_t medioMs;
+    uint32_t maxMs;
+    uint32_t ultimoHeap;  // pico do último handshake (bytes)
+    uint32_t maxHeap;
+};
+
+struct TlsStats {
+    HandshakeStats completo;
+    HandshakeStats retomado;
+    uint32_t falhas;             // handshakes que não terminaram
+    uint32_t falhasVerificacao;  // certificado recusado
+    uint32_t sessoesRecusadas;   // sessão oferecida e broker pediu completo
+    bool ultimoRetomado;
+};
+
+class MedicoesTls {
+public:
+    MedicoesTls();
+
+    // retomado = handshake abreviado (sem certificado nem troca de chaves)
+    void registrar(bool retomado, bool ofereceuSessao, uint32_t ms, uint32_t heapBytes);
+    void registrarFalha(bool verificacao);
+
+    TlsStats estatisticas() const;
+
+private:
+    struct Acumulador {
+        std::atomic<uint32_t> quantidade;
+        std::atomic<uint32_t> totalMs;
+        std::atomic<uint32_t> ultimoMs;
+        std::atomic<uint32_t> maxMs;
+        std::atomic<uint32_t> ultimoHeap;
+        std::atomic<uint32_t> maxHeap;
+
+        void somar(uint32_t ms, uint32_t heapBytes);
+        HandshakeStats ler() const;
+    };
+
+    Acumulador completo_;
+    Acumulador retomado_;
+    std::atomic<uint32_t> falhas_;
+    std::atomic<uint32_t> falhasVerificacao_;
+    std::atomic<uint32_t> sessoesRecusadas_;
+    std::atomic<bool> ultimoRetomado_;
+};
+
+extern MedicoesTls medicoesTls;
@@ -0,0 +1,40 @@
+#pragma once
+
+// ========================================================
+// TOPICOS MQTT
+// ========================================================
+#define TOPICO_SENSOR      "projeto/home-security/sensor/medida"
+#define TOPICO_SENSOR_LOTE "projeto/home-security/sensor/lote"
+// Rastro bruto do sensor para reprodução no host (ver gravacao.h)
+#define TOPICO_GRAVACAO    "projeto/home-security/sensor/gravacao"
+#define TOPICO_ESTADO      "projeto/home-security/sensor/estado"
+// Link do dispositivo, retido: "ONLINE,<ms para conectar>,<quedas>,..."
+// ao (re)conectar e "OFFLINE" pelo last will quando a sessão cai
+#define TOPICO_REDE        "projeto/home-security/sensor/rede"
+// Tempos do último boot, retido (ver partida.h)
+#define TOPICO_PARTIDA     "projeto/home-security/sensor/partida"
+// Saúde do dispositivo: quadro binário periódico (ver metricas.h)
+#define TOPICO_METRICAS    "projeto/home-security/sensor/metricas"
+// Latência eco -> sirene -> estado publicado, retido (ver latencia.h)
+#define TOPICO_LATENCIA    "projeto/home-security/sensor/latencia"
+// Diário de eventos (ver diario.h): eventos em ordem com id e a
+// confirmação do consumidor com o maior id recebido sem buracos
+#define TOPICO_EVENTOS     "projeto/home-security/eventos"
+#define TOPICO_EVENTOS_ACK TOPICO_EVENTOS "/ack"
+#define TOPICO_CMD         "projeto/home-security/comandos"
+// Luzes por cômodo: comando em led/<nome> ("R,G,B") e estado em
+// led/<nome>/estado (ON/OFF + tempo). Os nomes vêm de comodos.h.
+#define TOPICO_LED_PREFIXO "projeto/home-security/led/"
+#define TOPICO_LED_TODOS   TOPICO_LED_PREFIXO "+"
+// Estado do alarme por zona em zona/<nome>/estado, retido (ver
+// zonas.h). Os nomes vêm de sensores.h.
+#define TOPICO_ZONA_PREFIXO "projeto/home-security/zona/"
+// Automações locais (ver regras.h): tabela binária retida, resultado
+// da última tabela recebida e aviso das regras com ação de publicar
+#define TOPICO_REGRAS         "projeto/home-security/regras"
+#define TOPICO_REGRAS_ESTADO  TOPICO_REGRAS "/estado"
+#define TOPICO_REGRAS_DISPARO TOPICO_REGRAS "/disparo"
+// Cena: várias luzes e o modo do alarme numa mensagem (ver
+// comandos.h) e a confirmação única de cada cena
+#define TOPICO_CENA           "projeto/home-security/cena"
+#define TOPICO_CENA_ESTADO    TOPICO_CENA "/estado"
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "pinos.h"
+
+// ========================================================
+// TRANSIÇÕES DAS LUZES (FADE POR HARDWARE + GAMA)
+// ========================================================
+// As cores chegam em 8 bits por componente (0..255) e viram duty de
+// LED_PWM_RES bits por uma tabela de gama calculada em tempo de
+// compilação. A mudança de cor é entregue ao fade do LEDC: o
+// hardware soma "passo" ao duty a cada "ciclosPorPasso" períodos do
+// PWM, sem CPU envolvida depois do disparo.
+
+static_assert(LED_PWM_RES >= 10 && LED_PWM_RES <= 13,
+              "LED_PWM_RES deve ficar entre 10 e 13 bits");
+
+constexpr uint32_t TRANSICAO_DUTY_MAX = (1u << LED_PWM_RES) - 1;
+
+// Duração usada quando o comando não traz uma ("R,G,B")
+#ifndef TRANSICAO_PADRAO_MS
+#define TRANSICAO_PADRAO_MS 200
+#endif
+
+// Limite aceito no payload ("R,G,B,ms")
+#define TRANSICAO_MAX_MS 10000
+
+// Limites dos campos de fade do LEDC do ESP32 (10 bits cada)
+#define TRANSICAO_MAX_PASSO   1023
+#define TRANSICAO_MAX_CICLOS  1023
+#define TRANSICAO_MAX_PASSOS  1023
+
+// ---------------- Tabela de gama ----------------
+// duty = round(max * (v/255)^2.2). O expoente 2.2 é x² · x^(1/5), com
+// a raiz quinta por Newton, tudo constexpr (sem pow em tempo de
+// compilação no C++17).
+namespace transicao_detalhe {
+
+constexpr double raizQuinta(double x) {
+    if (x <= 0.0) return 0.0;
+    double y = x < 1.0 ? 1.0 : x;
+    for (int i = 0; i < 60; ++i) {
+        double y4 = y * y * y * y;
+        y = y - (y4 * y - x) / (5.0 * y4);
+    }
+    return y;
+}
+
+struct TabelaGama {
+    uint16_t duty[256];
+};
+
+constexpr TabelaGama gerarTabelaGama() {
+    TabelaGama t{};
+    for (int v = 0; v < 256; ++v) {
+        double x = v / 255.0;
+        double d = x * x * raizQuinta(x) * TRANSICAO_DUTY_MAX + 0.5;
+        uint16_t duty = (uint16_t)d;
+        // Nenhum nível aceso pode virar "apagado"
+        if (v > 0 && duty == 0) duty = 1;
+        t.duty[v] = duty;
+    }
+    return t;
+}
+
+constexpr bool tabelaMonotonica(const TabelaGama& t) {
+    for (int v = 1; v < 256; ++v) {
+        if (t.duty[v] < t.duty[v - 1]) return false;
+    }
+    return true;
+}
+
+}  // namespace transicao_detalhe
+
+constexpr transicao_detalhe::TabelaGama GAMA = transicao_detalhe::gerarTabelaGama();
+
+static_assert(GAMA.duty[0] == 0, "gama: 0 deve apagar");
+static_assert(GAMA.duty[255] == TRANSICAO_DUTY_MAX, "gama: 255 deve ser o duty máximo");
+static_assert(transicao_detalhe::tabelaMonotonica(GAMA), "gama: tabela não monotônica");
+
+constexpr uint32_t gamaDuty(uint8_t v) { return GAMA.duty[v]; }
+
+// ---------------- Planejamento do fade ----------------
+// O hardware anda de "passo" em "passo"; numPassos passos inteiros
+// cobrem a distância até a menos de um passo. dutyInicial é de onde
+// eles terminariam exatamente no alvo; o LEDC do ESP32 parte do duty
+// atual e grava o alvo ao fim do fade, o que dá no mesmo. Com
+// numPassos == 0 o duty é escrito direto.
+struct PlanoFade {
+    uint32_t dutyInicial;
+    uint32_t dutyAlvo;
+    uint16_t passo;           // incremento de duty por passo
+    uint16_t ciclosPorPasso;  // períodos do PWM entre passos
+    uint16_t numPassos;
+    uint32_t duracaoRealMs;   // o que o hardware vai de fato levar
+};
+
+PlanoFade planejarFade(uint32_t dutyAtual, uint32_t dutyAlvo, uint32_t duracaoMs,
+                       uint32_t freqPwm = LED_PWM_FREQ);
+
+// ---------------- Canais ----------------
+// No core Arduino do ESP32 (IDF 4.4) não há como parar um fade do
+// LEDC: ledc_set_duty() num canal que ainda está no fade espera ele
+// acabar, o que seguraria a taskMQTT por até TRANSICAO_MAX_MS. Por
+// isso um canal com fade em andamento nunca é tocado: o pedido fica
+// pendente e transicaoServicar() o dispara quando o fade termina,
+// partindo do alvo dele (onde o hardware parou).
+//
+// Um lote (os três canais de um cômodo, ou uma cena inteira, ver
+// comandos.h) é aplicado junto: se algum canal dele ainda está no
+// fade, o lote todo espera o último desses fades acabar. Os canais
+// sem fade são gravados e trocados em sequência, sem nada entre um
+// canal e outro, para a troca cair no mesmo período do PWM (200 µs a
+// 5 kHz); os fades disparam logo depois. Um pedido novo para um canal
+// substitui o que estava pendente nele. Tudo roda na taskMQTT (e no
+// setup(), antes dela).
+struct MudancaCanal {
+    uint8_t canal;
+    uint32_t dutyAlvo;
+    uint32_t duracaoMs;
+};
+
+#define TRANSICAO_NUM_CANAIS 16  // canais LEDC do ESP32
+#define TRANSICAO_MAX_LOTE   TRANSICAO_NUM_CANAIS
+
+// Depois do fim calculado o fade ainda pode ter um período do PWM e
+// o arredondamento de duracaoRealMs pela frente
+#define TRANSICAO_FOLGA_MS 2
+
+void transicaoCanais(const MudancaCanal* mudancas, size_t quantidade);
+
+// Dispara os lotes cujos fades bloqueantes já acabaram
+void transicaoServicar(uint32_t agoraMs);
+
+// O último pedido do canal ainda espera o lote dele disparar
+bool transicaoPendente(uint8_t canal);
+
+// ms até o próximo lote pendente (UINT32_MAX se não há nenhum)
+uint32_t transicaoPrazoMs(uint32_t agoraMs);
+
+// ---------------- Driver (por plataforma) ----------------
+// transicao_esp32.cpp usa o serviço de fade do LEDC; no native
+// transicao_native.cpp guarda o plano e grava o duty final.
+
+// Instala o serviço de fade. Chamar antes de comodosIniciar().
+void transicaoIniciar();
+
+// Grava e troca juntos os canais sem fade e dispara os fades, que
+// partem do duty em que o canal está. Retorna false se não há
+// serviço de fade: o duty final foi escrito direto e nenhum canal
+// ficou no fade.
+bool transicaoDisparar(const MudancaCanal* mudancas, const PlanoFade* planos,
+                       size_t quantidade);
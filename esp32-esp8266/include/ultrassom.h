@@ -0,0 +1,43 @@
+#pragma once
+
+#include <stdint.h>
+
+// ========================================================
+// CAPTURA DOS ULTRASSÔNICOS (HC-SR04)
+// ========================================================
+// Um ou mais sensores da tabela de sensores.h. Modo padrão: cada eco
+// é medido por interrupção de borda no pino de eco do sensor, com
+// timestamps do esp_timer; a largura fica numa posição por sensor e
+// a tarefa do sensor recebe um bit por eco na task notification. Os
+// sensores de um grupo disparam juntos e a tarefa fica bloqueada
+// (sem gastar CPU) até todos os ecos chegarem.
+//
+// Com -DULTRASSOM_MODO_PULSEIN volta ao pulseIn() original, que faz
+// busy-wait de até 30 ms por sensor, um de cada vez, para comparação.
+
+#define ULTRASSOM_TIMEOUT_US 30000  // sem eco depois disso = fora de alcance
+
+// Conversão original: largura do eco (µs) -> cm, ida e volta a 343 m/s
+inline float duracaoParaCm(uint32_t duracaoUs) {
+    return (duracaoUs * 0.0343f) / 2.0f;
+}
+
+// Prepara os pinos e, no modo por interrupção, registra a ISR do eco
+// de cada sensor. Deve ser chamada pela tarefa que vai medir: é ela
+// quem recebe as notificações.
+void ultrassomIniciar();
+
+// Dispara juntos os sensores da máscara (bit i = SENSORES[i]) e
+// espera os ecos. distanciasCm[i] recebe a distância em cm ou -1 se
+// não houve eco dentro de ULTRASSOM_TIMEOUT_US, e ecosUs[i] o fim do
+// eco (micros(), marca de eco em latencia.h) ou o fim da espera; só
+// as posições da máscara são escritas. Retorna a máscara dos que
+// tiveram eco.
+uint8_t ultrassomMedir(uint8_t mascara, float* distanciasCm, uint32_t* ecosUs);
+
+struct UltrassomStats {
+    uint32_t amostras;  // medições com eco
+    uint32_t semEco;    // timeouts
+};
+
+UltrassomStats ultrassomEstatisticas(uint8_t sensor);
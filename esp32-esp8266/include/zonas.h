@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "estado.h"
+#include "sensores.h"
+
+// ========================================================
+// ESTADO DO ALARME POR ZONA (zona/<nome>/estado)
+// ========================================================
+// O alarme continua um só (maquina_alarme.h): buzzer, LEDs, pausa e
+// TOPICO_ESTADO. Cada zona da tabela de sensores.h publica, retido e
+// só quando muda, "<ESTADO>,<seq>" como em estado.h:
+//   ALERTA  - presença confirmada num sensor da zona com o alarme
+//             disparado; fica até o alarme ser silenciado, parado ou
+//             pausado, mesmo que a presença acabe;
+//   PAUSADO - alarme pausado;
+//   OK      - o resto.
+// Com isso o consumidor sabe qual porta disparou e por onde mais a
+// pessoa passou durante o alerta.
+
+static_assert(NUM_ZONAS <= 8, "zonas demais para a máscara de zonas disparadas");
+
+// Tarefa do sensor: o filtro do sensor confirmou ou encerrou presença
+void zonasPresenca(uint8_t sensor, bool presente);
+
+// Recalcula a partir de alarmeEstado() e da presença atual e publica
+// as zonas que mudaram. Chamado depois de cada transição do alarme
+// (qualquer tarefa) e de cada mudança de presença. Chamadas
+// concorrentes não se atropelam: uma tarefa aplica de cada vez e
+// quem chega no meio só pede mais uma passada, então um chamador
+// atrasado nunca republica um estado velho depois do novo.
+void zonasAtualizar();
+
+// Republica todas (ex.: logo após reconectar ao broker)
+void zonasRepublicar();
+
+EstadoAlarme zonaEstado(uint8_t zona);
+bool zonaPresenca(uint8_t zona);
+
+// Volta ao boot: sem presença, nada publicado (testes)
+void zonasReiniciar();
@@ -0,0 +1,161 @@
+#include "alarme.h"
+#include "pinos.h"
+#include "estado.h"
+#include "log.h"
+#include "diario.h"
+#include "latencia.h"
+#include "padroes.h"
+#include "regras.h"
+#include "zonas.h"
+
+#include <array>
+#include <utility>
+
+MaquinaAlarme maquinaAlarme;
+
+// Um filtro por linha de SENSORES, cada um com o próprio limite
+template <size_t... I>
+static std::array<FiltroDistancia, NUM_SENSORES> criarFiltros(std::index_sequence<I...>) {
+    return {{FiltroDistancia(filtroConfigPadrao(SENSORES[I].limiteCm))...}};
+}
+
+static std::array<FiltroDistancia, NUM_SENSORES> filtros =
+    criarFiltros(std::make_index_sequence<NUM_SENSORES>());
+
+FiltroDistancia& filtroSensor(uint8_t sensor) {
+    return filtros[sensor];
+}
+
+// ========================================================
+// FUNÇÕES DE HARDWARE
+// ========================================================
+// O buzzer e a piscada do LED vermelho ficam com o sequenciador de
+// padrões (padroes.h); aqui só se fixam as cores de cada estado.
+void ligarAlerta() {
+    digitalWrite(LED_RED, HIGH);
+    digitalWrite(LED_GREEN, LOW);
+    digitalWrite(LED_BLUE, LOW);
+    padraoTocar(PADRAO_ALERTA);
+}
+
+void desligarAlerta() {
+    padraoParar(PADRAO_ALERTA);
+    digitalWrite(LED_RED, LOW);
+    digitalWrite(LED_GREEN, HIGH);
+    digitalWrite(LED_BLUE, LOW);
+}
+
+void mostrarAlarmePausado() {
+    padraoParar(PADRAO_ALERTA);
+    digitalWrite(LED_RED, LOW);
+    digitalWrite(LED_GREEN, LOW);
+    digitalWrite(LED_BLUE, HIGH);
+}
+
+// ========================================================
+// TRANSIÇÕES
+// ========================================================
+// Leva as saídas ao estado atual da máquina. Se outra tarefa
+// transicionou enquanto isso, repete: quem escreve por último
+// sempre viu a versão mais nova.
+static void sincronizarSaidas() {
+    uint32_t versao;
+    uint32_t depois;
+    do {
+        EstadoAlarme e = maquinaAlarme.estado(versao);
+        switch (e) {
+            case ESTADO_ALERTA:  ligarAlerta(); break;
+            case ESTADO_PAUSADO: mostrarAlarmePausado(); break;
+            default:             desligarAlerta(); break;
+        }
+        estadoAtualizar(e);
+        zonasAtualizar();
+        maquinaAlarme.estado(depois);
+    } while (depois != versao);
+}
+
+TransicaoAlarme alarmeEntrada(EntradaAlarme entrada) {
+    TransicaoAlarme t = maquinaAlarme.aplicar(entrada, millis());
+    if (!t.mudou) return t;
+
+    // Efeitos de uma só vez ficam com quem venceu o CAS
+    if (entrada == ENTRADA_PAUSAR || entrada == ENTRADA_RETOMAR ||
+        entrada == ENTRADA_ALTERNAR_PAUSA) {
+        padraoTocar(PADRAO_BEEP_TRIPLO);
+    }
+    LOG_INFO("[Alarme] %s -> %s (%s, v%lu)", nomeEstado(t.de), nomeEstado(t.para),
+             nomeEntradaAlarme(entrada), (unsigned long)t.versao);
+    diarioRegistrarAlarme(t.de, t.para, millis());  // entregue mesmo se o broker estiver fora
+
+    sincronizarSaidas();
+    regras.evento(GATILHO_ALARME, 0, t.para);
+    return t;
+}
+
+void alarmeRestaurarPausa() {
+    TransicaoAlarme t = maquinaAlarme.aplicar(ENTRADA_PAUSAR, millis());
+    if (!t.mudou) return;
+    LOG_INFO("[Alarme] %s -> %s (restaurado, v%lu)", nomeEstado(t.de), nomeEstado(t.para),
+             (unsigned long)t.versao);
+    diarioRegistrarAlarme(t.de, t.para, millis());
+    sincronizarSaidas();
+}
+
+// ========================================================
+// DECISÃO DO ALARME
+// ========================================================
+FiltroSaida avaliarSensor(uint8_t sensor, float distancia, uint32_t ecoUs) {
+    // O filtro roda sempre, mesmo pausado, para não decidir com
+    // histórico velho quando o alarme voltar.
+    FiltroSaida f = filtros[sensor].processar(distancia);
+
+    // A presença vai para a zona antes da transição: quem sincroniza
+    // as saídas já vê que zona disparou
+    if (f.mudou) zonasPresenca(sensor, f.detectado);
+
+    // Objeto muito próximo (confirmado pelo filtro): só dispara se
+    // estiver armado; pausado ou já em alerta a entrada é ignorada
+    if (f.detectado) {
+        // Rastro aberto antes da transição: a sirene marca de dentro
+        // de alarmeEntrada() (latencia.h)
+        bool armado = alarmeEstado() == ESTADO_OK;
+        if (armado) latencia.abrir(ecoUs, micros());
+
+        if (alarmeEntrada(ENTRADA_DETECCAO).mudou) {
+            if (armado) latencia.confirmar();
+            const Sensor& s = SENSORES[sensor];
+            LOG_INFO("[Sensor] Alerta ativado por distância em %s (zona %s)!", s.nome,
+                     ZONAS[s.zona].nome);
+        } else if (armado) {
+            latencia.descartar();
+        }
+    }
+    // Já em alerta por outra zona, esta também entra
+    if (f.mudou) zonasAtualizar();
+    return f;
+}
+
+// ========================================================
+// BOTÃO
+// ========================================================
+void tratarGestoBotao(const EventoBotao& ev) {
+    regras.evento(GATILHO_GESTO, ev.gesto, ev.cliques);
+
+    switch (ev.gesto) {
+        case GESTO_PRESSAO:
+            // Silencia já na borda (latência = debounce), sem esperar
+            // a sequência fechar
+            if (ev.cliques == 0 && alarmeEntrada(ENTRADA_SILENCIAR).mudou) {
+                LOG_INFO("[Botão] Alarme parado por um clique");
+            }
+            break;
+        case GESTO_MULTIPLO:
+            if (ev.cliques >= BOTAO_MAX_CLIQUES) alarmeEntrada(ENTRADA_ALTERNAR_PAUSA);
+            break;
+        case GESTO_LONGO:
+            alarmeEntrada(ENTRADA_ALTERNAR_PAUSA);
+            break;
+        default:
+            break;
+    }
+}
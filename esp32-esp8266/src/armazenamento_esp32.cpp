@@ -0,0 +1,30 @@
+// Blobs na NVS pelo Preferences. Quem grava roda na taskMQTT; ler
+// também roda no setup().
+#include "armazenamento.h"
+
+#include <Preferences.h>
+
+size_t nvsLerBlob(const char* ns, const char* chave, uint8_t* buf, size_t tamanho) {
+    Preferences prefs;
+    if (!prefs.begin(ns, true)) return 0;  // namespace ainda não existe
+    size_t n = prefs.getBytesLength(chave);
+    if (n == 0 || n > tamanho || prefs.getBytes(chave, buf, n) != n) n = 0;
+    prefs.end();
+    return n;
+}
+
+bool nvsGravarBlob(const char* ns, const char* chave, const uint8_t* buf, size_t tamanho) {
+    Preferences prefs;
+    if (!prefs.begin(ns, false)) return false;
+    bool ok = prefs.putBytes(chave, buf, tamanho) == tamanho;
+    prefs.end();
+    return ok;
+}
+
+bool nvsApagarBlob(const char* ns, const char* chave) {
+    Preferences prefs;
+    if (!prefs.begin(ns, false)) return false;
+    bool ok = prefs.remove(chave);
+    prefs.end();
+    return ok;
+}
@@ -0,0 +1,83 @@
+#include "botao.h"
+
+const char* nomeGesto(GestoBotao gesto) {
+    switch (gesto) {
+        case GESTO_PRESSAO:  return "PRESSAO";
+        case GESTO_CLIQUE:   return "CLIQUE";
+        case GESTO_DUPLO:    return "DUPLO";
+        case GESTO_MULTIPLO: return "MULTIPLO";
+        case GESTO_LONGO:    return "LONGO";
+        default:             return "?";
+    }
+}
+
+ReconhecedorGestos::ReconhecedorGestos()
+    : pressionado_(false), longoEmitido_(false), cliques_(0),
+      inicioPressao_(0), ultimaSoltura_(0), temPrazo_(false), prazo_(0) {}
+
+static EventoBotao evento(GestoBotao gesto, uint8_t cliques, uint32_t instanteMs) {
+    EventoBotao ev;
+    ev.gesto = gesto;
+    ev.cliques = cliques;
+    ev.instanteMs = instanteMs;
+    return ev;
+}
+
+static GestoBotao gestoPorCliques(uint8_t cliques) {
+    if (cliques == 1) return GESTO_CLIQUE;
+    if (cliques == 2) return GESTO_DUPLO;
+    return GESTO_MULTIPLO;
+}
+
+bool ReconhecedorGestos::mudanca(bool pressionado, uint32_t agoraMs, EventoBotao& ev) {
+    if (pressionado == pressionado_) return false;
+    pressionado_ = pressionado;
+
+    if (pressionado) {
+        inicioPressao_ = agoraMs;
+        longoEmitido_ = false;
+        temPrazo_ = true;
+        prazo_ = agoraMs + BOTAO_LONGO_MS;
+        ev = evento(GESTO_PRESSAO, cliques_, agoraMs);
+        return true;
+    }
+
+    // Soltou
+    if (longoEmitido_) {
+        // O toque longo já foi entregue; não vira clique
+        cliques_ = 0;
+        temPrazo_ = false;
+        return false;
+    }
+
+    ++cliques_;
+    ultimaSoltura_ = agoraMs;
+    if (cliques_ >= BOTAO_MAX_CLIQUES) {
+        ev = evento(GESTO_MULTIPLO, cliques_, agoraMs);
+        cliques_ = 0;
+        temPrazo_ = false;
+        return true;
+    }
+    temPrazo_ = true;
+    prazo_ = agoraMs + BOTAO_JANELA_CLIQUES_MS;
+    return false;
+}
+
+bool ReconhecedorGestos::expirar(uint32_t agoraMs, EventoBotao& ev) {
+    if (!temPrazo_ || (int32_t)(agoraMs - prazo_) < 0) return false;
+    temPrazo_ = false;
+
+    if (pressionado_) {
+        // Segurando: toque longo (descarta cliques anteriores da sequência)
+        if (longoEmitido_) return false;
+        longoEmitido_ = true;
+        cliques_ = 0;
+        ev = evento(GESTO_LONGO, 0, inicioPressao_);
+        return true;
+    }
+
+    if (cliques_ == 0) return false;
+    ev = evento(gestoPorCliques(cliques_), cliques_, ultimaSoltura_);
+    cliques_ = 0;
+    return true;
+}
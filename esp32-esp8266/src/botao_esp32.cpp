@@ -0,0 +1,90 @@
+// Driver do botão no ESP32. A ISR (CHANGE) só guarda o instante da
+// primeira borda da rajada e rearma o timer de debounce; os dois
+// esp_timer rodam na mesma tarefa do esp_timer, então o
+// ReconhecedorGestos nunca é usado em paralelo.
+#include "botao.h"
+#include "pinos.h"
+
+#include <Arduino.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "esp_timer.h"
+
+#define BOTAO_FILA_GESTOS 8
+
+static ReconhecedorGestos reconhecedor;
+static QueueHandle_t filaGestos = NULL;
+static esp_timer_handle_t timerDebounce = NULL;
+static esp_timer_handle_t timerPrazo = NULL;
+// 64 bits não são lidos nem escritos de uma vez no Xtensa: a ISR e o
+// timer trocam o instante sob o mesmo spinlock
+static portMUX_TYPE muxBorda = portMUX_INITIALIZER_UNLOCKED;
+static int64_t primeiraBordaUs = -1;
+
+static uint32_t agoraMs() {
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+static void IRAM_ATTR isrBotao() {
+    int64_t agoraUs = esp_timer_get_time();
+    portENTER_CRITICAL_ISR(&muxBorda);
+    if (primeiraBordaUs < 0) primeiraBordaUs = agoraUs;
+    portEXIT_CRITICAL_ISR(&muxBorda);
+    // Cada repique empurra o fim do debounce para frente
+    esp_timer_stop(timerDebounce);
+    esp_timer_start_once(timerDebounce, BOTAO_DEBOUNCE_MS * 1000ULL);
+}
+
+static void postar(const EventoBotao& ev) {
+    // Fila cheia: o consumidor está muito atrasado, o gesto se perde
+    xQueueSend(filaGestos, &ev, 0);
+}
+
+static void reagendarPrazo() {
+    esp_timer_stop(timerPrazo);
+    if (!reconhecedor.temPrazo()) return;
+    int32_t faltaMs = (int32_t)(reconhecedor.prazoMs() - agoraMs());
+    esp_timer_start_once(timerPrazo, faltaMs > 0 ? (uint64_t)faltaMs * 1000 : 1);
+}
+
+// Linha quieta por BOTAO_DEBOUNCE_MS: o nível lido agora é o estável
+static void aoAssentar(void*) {
+    // Lê e zera juntos: uma borda logo depois já abre a próxima rajada
+    portENTER_CRITICAL(&muxBorda);
+    int64_t bordaUs = primeiraBordaUs;
+    primeiraBordaUs = -1;
+    portEXIT_CRITICAL(&muxBorda);
+    if (bordaUs < 0) bordaUs = esp_timer_get_time();
+
+    bool pressionado = digitalRead(BUTTON_PIN) == HIGH;
+    EventoBotao ev;
+    if (reconhecedor.mudanca(pressionado, (uint32_t)(bordaUs / 1000), ev)) postar(ev);
+    reagendarPrazo();
+}
+
+static void aoVencerPrazo(void*) {
+    EventoBotao ev;
+    if (reconhecedor.expirar(agoraMs(), ev)) postar(ev);
+    reagendarPrazo();
+}
+
+void botaoIniciar() {
+    filaGestos = xQueueCreate(BOTAO_FILA_GESTOS, sizeof(EventoBotao));
+
+    esp_timer_create_args_t args = {};
+    args.dispatch_method = ESP_TIMER_TASK;
+    args.callback = aoAssentar;
+    args.name = "botao_debounce";
+    esp_timer_create(&args, &timerDebounce);
+    args.callback = aoVencerPrazo;
+    args.name = "botao_gesto";
+    esp_timer_create(&args, &timerPrazo);
+
+    attachInterrupt(digitalPinToInterrupt(BUTTON_PIN), isrBotao, CHANGE);
+}
+
+bool botaoProximoGesto(EventoBotao& ev, uint32_t timeoutMs) {
+    if (filaGestos == NULL) return false;
+    TickType_t espera = timeoutMs == UINT32_MAX ? portMAX_DELAY : pdMS_TO_TICKS(timeoutMs);
+    return xQueueReceive(filaGestos, &ev, espera) == pdTRUE;
+}
@@ -0,0 +1,11 @@
+// Driver do botão no ambiente native: não há GPIO de verdade. Os
+// testes exercitam o ReconhecedorGestos diretamente.
+#include "botao.h"
+#include "hal.h"
+
+void botaoIniciar() {}
+
+bool botaoProximoGesto(EventoBotao&, uint32_t timeoutMs) {
+    if (timeoutMs != UINT32_MAX) delay(timeoutMs);
+    return false;
+}
@@ -0,0 +1,412 @@
+// Cliente TLS sobre mbedtls e socket lwIP, com a sessão guardada entre
+// conexões. Tudo aqui roda na taskMQTT; ver cliente_tls.h e tls.h.
+#include "cliente_tls.h"
+#include "log.h"
+#include "armazenamento.h"
+
+#include <Arduino.h>
+#include <errno.h>
+#include <string.h>
+
+#include "esp_heap_caps.h"
+#include "lwip/netdb.h"
+#include "lwip/sockets.h"
+#include "mbedtls/error.h"
+#include "mbedtls/net_sockets.h"
+#include "mbedtls/version.h"
+
+namespace {
+
+const char* NVS_NAMESPACE = "tls";
+const char* NVS_CHAVE = "sessao";
+
+// Sessão serializada: usado ao restaurar e ao gravar, os dois na
+// taskMQTT
+uint8_t bufSessao[TLS_SESSAO_MAX_BYTES];
+uint32_t hashNvs = 0;  // da sessão que já está na NVS
+
+uint32_t heapLivre() {
+    return heap_caps_get_free_size(MALLOC_CAP_8BIT);
+}
+
+// FNV-1a: só para não regravar na NVS uma sessão igual
+uint32_t fnv1a(const uint8_t* dados, size_t tamanho) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < tamanho; ++i) {
+        h ^= dados[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// O 2.x deixa o estado do handshake público; no 3.x ele é privado
+int estadoHandshake(const mbedtls_ssl_context& ssl) {
+#if MBEDTLS_VERSION_NUMBER >= 0x03000000
+    return ssl.MBEDTLS_PRIVATE(state);
+#else
+    return ssl.state;
+#endif
+}
+
+void logErro(const char* onde, int ret) {
+    char texto[96];
+    mbedtls_strerror(ret, texto, sizeof(texto));
+    LOG_AVISO("[TLS] %s: -0x%04X %s", onde, (unsigned)-ret, texto);
+}
+
+bool socketFechado(int fd) {
+    uint8_t b;
+    int r = recv(fd, &b, 1, MSG_PEEK | MSG_DONTWAIT);
+    return r == 0 || (r < 0 && errno != EAGAIN && errno != EWOULDBLOCK);
+}
+
+}  // namespace
+
+ClienteTls::ClienteTls()
+    : pronto_(false), temSessao_(false), conectado_(false), fd_(-1), espiado_(-1),
+      timeoutS_(5) {
+    mbedtls_entropy_init(&entropia_);
+    mbedtls_ctr_drbg_init(&drbg_);
+    mbedtls_x509_crt_init(&ca_);
+    mbedtls_ssl_config_init(&conf_);
+    mbedtls_ssl_init(&ssl_);
+    mbedtls_ssl_session_init(&sessao_);
+}
+
+bool ClienteTls::iniciar(const char* caPem) {
+    static const char pers[] = "home-alarm-mqtt";
+    int ret = mbedtls_ctr_drbg_seed(&drbg_, mbedtls_entropy_func, &entropia_,
+                                    (const unsigned char*)pers, sizeof(pers) - 1);
+    if (ret != 0) {
+        logErro("Semente do DRBG", ret);
+        return false;
+    }
+
+    // PEM precisa do '\0' na conta
+    ret = mbedtls_x509_crt_parse(&ca_, (const unsigned char*)caPem, strlen(caPem) + 1);
+    if (ret != 0) {
+        logErro("CA inválida", ret);
+        return false;
+    }
+
+    ret = mbedtls_ssl_config_defaults(&conf_, MBEDTLS_SSL_IS_CLIENT, MBEDTLS_SSL_TRANSPORT_STREAM,
+                                      MBEDTLS_SSL_PRESET_DEFAULT);
+    if (ret != 0) {
+        logErro("Configuração", ret);
+        return false;
+    }
+    mbedtls_ssl_conf_authmode(&conf_, MBEDTLS_SSL_VERIFY_REQUIRED);
+    mbedtls_ssl_conf_ca_chain(&conf_, &ca_, NULL);
+    mbedtls_ssl_conf_rng(&conf_, mbedtls_ctr_drbg_random, &drbg_);
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+    mbedtls_ssl_conf_session_tickets(&conf_, MBEDTLS_SSL_SESSION_TICKETS_ENABLED);
+#endif
+
+    // Buffers de registro alocados uma vez; cada conexão só faz reset
+    ret = mbedtls_ssl_setup(&ssl_, &conf_);
+    if (ret != 0) {
+        logErro("Contexto", ret);
+        return false;
+    }
+    pronto_ = true;
+
+#if TLS_SESSAO_NVS
+    size_t n = nvsLerBlob(NVS_NAMESPACE, NVS_CHAVE, bufSessao, sizeof(bufSessao));
+    // Falha se o mbedtls foi compilado com outras opções: descarta
+    if (n > 0 && mbedtls_ssl_session_load(&sessao_, bufSessao, n) == 0) {
+        temSessao_ = true;
+        hashNvs = fnv1a(bufSessao, n);
+    } else if (n > 0) {
+        mbedtls_ssl_session_free(&sessao_);
+        mbedtls_ssl_session_init(&sessao_);
+    }
+    LOG_INFO("[TLS] CA fixada carregada; sessão salva %s",
+             temSessao_ ? "restaurada da NVS" : "nenhuma");
+#endif
+    return true;
+}
+
+// ========================================================
+// SOCKET
+// ========================================================
+int ClienteTls::enviarBio(void* ctx, const unsigned char* buf, size_t len) {
+    int fd = static_cast<ClienteTls*>(ctx)->fd();
+    int r = send(fd, buf, len, 0);
+    if (r >= 0) return r;
+    if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) return MBEDTLS_ERR_SSL_WANT_WRITE;
+    return MBEDTLS_ERR_NET_SEND_FAILED;
+}
+
+// Com SO_RCVTIMEO, um recv() sem dados até o prazo vira WANT_READ
+int ClienteTls::receberBio(void* ctx, unsigned char* buf, size_t len) {
+    int fd = static_cast<ClienteTls*>(ctx)->fd();
+    int r = recv(fd, buf, len, 0);
+    if (r >= 0) return r;  // 0 = broker fechou
+    if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) return MBEDTLS_ERR_SSL_WANT_READ;
+    return MBEDTLS_ERR_NET_RECV_FAILED;
+}
+
+bool ClienteTls::abrirSocket(const char* host, uint16_t port) {
+    struct addrinfo dicas;
+    memset(&dicas, 0, sizeof(dicas));
+    dicas.ai_family = AF_UNSPEC;  // IPv6 se o DNS tiver, senão IPv4
+    dicas.ai_socktype = SOCK_STREAM;
+    char porta[6];
+    snprintf(porta, sizeof(porta), "%u", port);
+
+    struct addrinfo* enderecos = NULL;
+    if (getaddrinfo(host, porta, &dicas, &enderecos) != 0 || enderecos == NULL) {
+        LOG_AVISO("[TLS] DNS falhou para %s", host);
+        return false;
+    }
+
+    int fd = -1;
+    for (struct addrinfo* a = enderecos; a != NULL && fd < 0; a = a->ai_next) {
+        fd = socket(a->ai_family, SOCK_STREAM, IPPROTO_TCP);
+        if (fd < 0) continue;
+
+        // connect() não bloqueante para respeitar o timeout
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+        int r = ::connect(fd, a->ai_addr, a->ai_addrlen);
+        if (r < 0 && errno == EINPROGRESS) {
+            fd_set escrita;
+            FD_ZERO(&escrita);
+            FD_SET(fd, &escrita);
+            struct timeval limite = {(long)timeoutS_, 0};
+            int erro = 0;
+            socklen_t len = sizeof(erro);
+            if (select(fd + 1, NULL, &escrita, NULL, &limite) == 1 &&
+                getsockopt(fd, SOL_SOCKET, SO_ERROR, &erro, &len) == 0 && erro == 0) {
+                r = 0;
+            }
+        }
+        if (r != 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(enderecos);
+    if (fd < 0) {
+        LOG_AVISO("[TLS] TCP falhou para %s:%u", host, port);
+        return false;
+    }
+
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) & ~O_NONBLOCK);
+    struct timeval limite = {(long)timeoutS_, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &limite, sizeof(limite));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &limite, sizeof(limite));
+    int um = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &um, sizeof(um));  // pacotes MQTT são pequenos
+    fd_.store(fd, std::memory_order_relaxed);
+    return true;
+}
+
+// ========================================================
+// HANDSHAKE
+// ========================================================
+// Passo a passo para amostrar o heap. O handshake abreviado vai do
+// ServerHello direto ao ChangeCipherSpec: se o broker mandou
+// certificado, a sessão oferecida não foi aceita.
+int ClienteTls::handshake(MedidorHeap& heap, bool& retomado) {
+    bool viuCertificado = false;
+    int ret = 0;
+    while (estadoHandshake(ssl_) != MBEDTLS_SSL_HANDSHAKE_OVER) {
+        if (estadoHandshake(ssl_) == MBEDTLS_SSL_SERVER_CERTIFICATE) viuCertificado = true;
+        ret = mbedtls_ssl_handshake_step(&ssl_);
+        heap.amostrar(heapLivre());
+        // WANT_READ aqui é o timeout do socket: desiste
+        if (ret != 0) break;
+    }
+    retomado = !viuCertificado;
+    return ret;
+}
+
+int ClienteTls::connect(IPAddress, uint16_t) {
+    // Sem o nome não há como conferir o certificado do broker
+    LOG_ERRO("[TLS] Conexão por IP recusada: use o nome do broker");
+    return 0;
+}
+
+int ClienteTls::connect(const char* host, uint16_t port) {
+    if (!pronto_) return 0;
+    fechar(false);
+    if (!abrirSocket(host, port)) return 0;
+
+    // Mesmo contexto da conexão anterior: sem realocar buffers
+    mbedtls_ssl_session_reset(&ssl_);
+    mbedtls_ssl_set_hostname(&ssl_, host);  // SNI e conferência do nome
+    mbedtls_ssl_set_bio(&ssl_, this, enviarBio, receberBio, NULL);
+    bool ofereceu = temSessao_ && mbedtls_ssl_set_session(&ssl_, &sessao_) == 0;
+
+    MedidorHeap heap;
+    heap.iniciar(heapLivre());
+    uint32_t inicio = millis();
+    bool retomado = false;
+    int ret = handshake(heap, retomado);
+    uint32_t duracao = millis() - inicio;
+
+    if (ret != 0) {
+        uint32_t flags = mbedtls_ssl_get_verify_result(&ssl_);
+        bool verificacao = ret == MBEDTLS_ERR_X509_CERT_VERIFY_FAILED;
+        logErro("Handshake falhou", ret);
+        if (verificacao) {
+            char texto[128];
+            mbedtls_x509_crt_verify_info(texto, sizeof(texto), "[TLS] Certificado recusado: ", flags);
+            LOG_AVISO("%s", texto);
+        }
+        medicoesTls.registrarFalha(verificacao);
+        // Timeout ou reset (broker reiniciando) não dizem nada da
+        // sessão: ela fica para a próxima tentativa, e um broker que
+        // não a aceita mais já responde com handshake completo. Só um
+        // certificado recusado ou um alerta fatal do broker a descartam.
+        if (ofereceu && (verificacao || ret == MBEDTLS_ERR_SSL_FATAL_ALERT_MESSAGE)) {
+            esquecerSessao();
+        }
+        fechar(false);
+        return 0;
+    }
+
+    conectado_ = true;
+    medicoesTls.registrar(retomado, ofereceu, duracao, heap.pico());
+    LOG_INFO("[TLS] Handshake %s em %lu ms, pico de heap %lu bytes (%s)",
+             retomado ? "retomado" : "completo", (unsigned long)duracao,
+             (unsigned long)heap.pico(), mbedtls_ssl_get_ciphersuite(&ssl_));
+    guardarSessao();
+    return 1;
+}
+
+// ========================================================
+// SESSÃO
+// ========================================================
+void ClienteTls::guardarSessao() {
+    // Depois de um handshake retomado o broker pode ter mandado
+    // ticket novo; pega sempre a sessão vigente
+    mbedtls_ssl_session nova;
+    mbedtls_ssl_session_init(&nova);
+    if (mbedtls_ssl_get_session(&ssl_, &nova) != 0) {
+        mbedtls_ssl_session_free(&nova);
+        return;
+    }
+    mbedtls_ssl_session_free(&sessao_);
+    sessao_ = nova;  // assume os ponteiros (ticket, certificado) de nova
+    temSessao_ = true;
+
+#if TLS_SESSAO_NVS
+    size_t n = 0;
+    // Grande demais para o buffer: fica só na RAM
+    if (mbedtls_ssl_session_save(&sessao_, bufSessao, sizeof(bufSessao), &n) != 0) return;
+    uint32_t h = fnv1a(bufSessao, n);
+    if (h == hashNvs) return;  // retomada por id: nada mudou, poupa a flash
+    if (nvsGravarBlob(NVS_NAMESPACE, NVS_CHAVE, bufSessao, n)) hashNvs = h;
+#endif
+}
+
+void ClienteTls::esquecerSessao() {
+    mbedtls_ssl_session_free(&sessao_);
+    mbedtls_ssl_session_init(&sessao_);
+    temSessao_ = false;
+#if TLS_SESSAO_NVS
+    if (hashNvs != 0) {
+        nvsApagarBlob(NVS_NAMESPACE, NVS_CHAVE);
+        hashNvs = 0;
+    }
+#endif
+}
+
+// ========================================================
+// FLUXO (INTERFACE Client DO PUBSUBCLIENT)
+// ========================================================
+void ClienteTls::fechar(bool avisar) {
+    int fd = fd_.load(std::memory_order_relaxed);
+    if (fd < 0) return;
+    if (avisar && conectado_) mbedtls_ssl_close_notify(&ssl_);
+    conectado_ = false;
+    espiado_ = -1;
+    fd_.store(-1, std::memory_order_relaxed);
+    close(fd);
+}
+
+void ClienteTls::stop() {
+    fechar(true);
+}
+
+uint8_t ClienteTls::connected() {
+    if (!conectado_) return 0;
+    if (espiado_ >= 0 || mbedtls_ssl_get_bytes_avail(&ssl_) > 0) return 1;
+    if (socketFechado(fd())) {
+        fechar(false);
+        return 0;
+    }
+    return 1;
+}
+
+int ClienteTls::available() {
+    if (!conectado_) return 0;
+    int n = (int)mbedtls_ssl_get_bytes_avail(&ssl_) + (espiado_ >= 0 ? 1 : 0);
+    if (n > 0) return n;
+
+    // Só decifra o próximo registro se já chegou algo: não bloqueia
+    uint8_t b;
+    int r = recv(fd(), &b, 1, MSG_PEEK | MSG_DONTWAIT);
+    if (r < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return 0;
+    if (r <= 0) {
+        fechar(false);
+        return 0;
+    }
+    int ret = mbedtls_ssl_read(&ssl_, NULL, 0);
+    if (ret < 0 && ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
+        fechar(false);  // inclui o close_notify do broker
+        return 0;
+    }
+    return (int)mbedtls_ssl_get_bytes_avail(&ssl_);
+}
+
+int ClienteTls::read(uint8_t* buf, size_t size) {
+    if (!conectado_ || size == 0) return -1;
+    size_t n = 0;
+    if (espiado_ >= 0) {
+        buf[n++] = (uint8_t)espiado_;
+        espiado_ = -1;
+    }
+    if (n < size && available() > 0) {
+        int ret = mbedtls_ssl_read(&ssl_, buf + n, size - n);
+        if (ret > 0) {
+            n += ret;
+        } else if (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
+            fechar(false);
+        }
+    }
+    return n > 0 ? (int)n : -1;
+}
+
+int ClienteTls::read() {
+    uint8_t b;
+    return read(&b, 1) == 1 ? b : -1;
+}
+
+int ClienteTls::peek() {
+    if (espiado_ < 0 && available() > 0) {
+        uint8_t b;
+        if (mbedtls_ssl_read(&ssl_, &b, 1) == 1) espiado_ = b;
+    }
+    return espiado_;
+}
+
+size_t ClienteTls::write(const uint8_t* buf, size_t size) {
+    if (!conectado_) return 0;
+    size_t enviado = 0;
+    while (enviado < size) {
+        int ret = mbedtls_ssl_write(&ssl_, buf + enviado, size - enviado);
+        if (ret <= 0) {
+            // Inclui o timeout do socket: broker parado, a sessão caiu
+            fechar(false);
+            break;
+        }
+        enviado += ret;
+    }
+    return enviado;
+}
+
+size_t ClienteTls::write(uint8_t b) {
+    return write(&b, 1);
+}
@@ -0,0 +1,347 @@
+#include "comandos.h"
+#include "alarme.h"
+#include "comodos.h"
+#include "diario.h"
+#include "gravacao.h"
+#include "log.h"
+#include "publicador.h"
+#include "regras.h"
+#include "telemetria.h"
+#include "topicos.h"
+
+#include <string.h>
+
+// ========================================================
+// PARSE SEM ALOCAÇÃO
+// ========================================================
+// Lê um inteiro decimal de [p, fim) com espaços opcionais em volta e
+// sinal opcional. Avança p até o primeiro caractere não consumido.
+static bool lerInteiro(const char*& p, const char* fim, long& valor) {
+    while (p < fim && *p == ' ') ++p;
+
+    bool negativo = false;
+    if (p < fim && (*p == '-' || *p == '+')) {
+        negativo = (*p == '-');
+        ++p;
+    }
+
+    const char* inicio = p;
+    long v = 0;
+    while (p < fim && *p >= '0' && *p <= '9') {
+        if (v < 100000) v = v * 10 + (*p - '0');  // satura, o valor é limitado depois
+        ++p;
+    }
+    if (p == inicio) return false;
+
+    while (p < fim && *p == ' ') ++p;
+    valor = negativo ? -v : v;
+    return true;
+}
+
+// Lê até maxCampos inteiros separados por vírgula ocupando todo o
+// payload. Retorna quantos leu, ou -1 se o formato não fechar.
+static int lerCampos(const char* payload, size_t tamanho, long* v, int maxCampos) {
+    const char* p = payload;
+    const char* fim = payload + tamanho;
+
+    for (int i = 0; i < maxCampos; ++i) {
+        if (!lerInteiro(p, fim, v[i])) return -1;
+        if (p == fim) return i + 1;
+        if (*p != ',') return -1;
+        ++p;
+    }
+    return -1;  // lixo ou campo sobrando depois do último
+}
+
+static void limitarRGB(const long* v, uint8_t &r, uint8_t &g, uint8_t &b) {
+    r = (uint8_t)constrain(v[0], 0L, 255L);
+    g = (uint8_t)constrain(v[1], 0L, 255L);
+    b = (uint8_t)constrain(v[2], 0L, 255L);
+}
+
+bool parseRGB(const char* payload, size_t tamanho, uint8_t &r, uint8_t &g, uint8_t &b) {
+    long v[3];
+    if (lerCampos(payload, tamanho, v, 3) != 3) return false;
+    limitarRGB(v, r, g, b);
+    return true;
+}
+
+bool parseCorLuz(const char* payload, size_t tamanho, uint8_t &r, uint8_t &g, uint8_t &b,
+                 uint32_t &duracaoMs) {
+    long v[4];
+    int n = lerCampos(payload, tamanho, v, 4);
+    if (n < 3) return false;
+    limitarRGB(v, r, g, b);
+    duracaoMs = n == 4 ? (uint32_t)constrain(v[3], 0L, (long)TRANSICAO_MAX_MS) : TRANSICAO_PADRAO_MS;
+    return true;
+}
+
+// Compara um payload (sem '\0') com um literal
+static bool payloadIgual(const char* payload, size_t tamanho, const char* literal, size_t len) {
+    return tamanho == len && memcmp(payload, literal, len) == 0;
+}
+
+// ========================================================
+// COMANDOS DO ALARME (TOPICO_CMD)
+// ========================================================
+static void cmdStop() {
+    alarmeEntrada(ENTRADA_PARAR);
+    LOG_INFO("Alarme parado via MQTT (STOP).");
+}
+
+static void cmdPause() {
+    alarmeEntrada(ENTRADA_PAUSAR);
+    LOG_INFO("Alarme PAUSADO via MQTT.");
+}
+
+static void cmdResume() {
+    alarmeEntrada(ENTRADA_RETOMAR);
+    LOG_INFO("Alarme RETOMADO via MQTT.");
+}
+
+static void cmdTelemetriaLote() {
+    telemetriaDefinirModo(TELEMETRIA_LOTE);
+    LOG_INFO("Telemetria em lote (binário).");
+}
+
+static void cmdTelemetriaTexto() {
+    telemetriaDefinirModo(TELEMETRIA_TEXTO);
+    LOG_INFO("Telemetria em texto por amostra.");
+}
+
+static void cmdGravacaoLigar() {
+    gravacaoDefinir(true);
+    LOG_INFO("Gravação do sensor ligada.");
+}
+
+static void cmdGravacaoDesligar() {
+    gravacaoDefinir(false);
+    GravacaoStats g = gravacaoEstatisticas();
+    LOG_INFO("Gravação do sensor desligada (%lu amostras, %lu quadros, %lu perdidos).",
+             (unsigned long)g.amostras, (unsigned long)g.quadros, (unsigned long)g.perdidos);
+}
+
+struct ComandoAlarme {
+    const char* nome;
+    uint8_t tamanho;
+    void (*executar)();
+};
+
+#define COMANDO(nome, fn) { nome, sizeof(nome) - 1, fn }
+
+static const ComandoAlarme COMANDOS[] = {
+    COMANDO("STOP", cmdStop),
+    COMANDO("PAUSE", cmdPause),
+    COMANDO("RESUME", cmdResume),
+    COMANDO("TELEMETRIA:LOTE", cmdTelemetriaLote),
+    COMANDO("TELEMETRIA:TEXTO", cmdTelemetriaTexto),
+    COMANDO("GRAVACAO:ON", cmdGravacaoLigar),
+    COMANDO("GRAVACAO:OFF", cmdGravacaoDesligar),
+};
+
+static void tratarComando(const char* payload, size_t tamanho) {
+    for (const ComandoAlarme& c : COMANDOS) {
+        if (!payloadIgual(payload, tamanho, c.nome, c.tamanho)) continue;
+        c.executar();
+        return;
+    }
+    LOG_AVISO("Comando desconhecido: %.*s", (int)tamanho, payload);
+}
+
+// ========================================================
+// LUZES DOS CÔMODOS (led/<nome>)
+// ========================================================
+static void tratarLed(const char* nome, size_t tamanhoNome, const char* payload, size_t tamanho) {
+    int indice = buscarComodo(nome, tamanhoNome);
+    if (indice < 0) {
+        LOG_AVISO("Cômodo desconhecido: %.*s", (int)tamanhoNome, nome);
+        return;
+    }
+
+    uint8_t r, g, b;
+    uint32_t duracaoMs;
+    if (parseCorLuz(payload, tamanho, r, g, b, duracaoMs)) {
+        aplicarCorComodo((size_t)indice, r, g, b, duracaoMs);
+    } else {
+        LOG_AVISO("Payload inválido para LED %s (use R,G,B[,ms]).", COMODOS[indice].nome);
+    }
+}
+
+// ========================================================
+// CENAS (TOPICO_CENA)
+// ========================================================
+// Valida tudo antes de mexer em qualquer saída: uma cena pela metade
+// é pior que nenhuma.
+struct ModoCena {
+    const char* nome;
+    uint8_t tamanho;
+    EntradaAlarme entrada;
+};
+
+static const ModoCena MODOS_CENA[] = {
+    COMANDO("STOP", ENTRADA_PARAR),
+    COMANDO("PAUSE", ENTRADA_PAUSAR),
+    COMANDO("RESUME", ENTRADA_RETOMAR),
+};
+
+namespace {
+
+constexpr bool nomeIgual(const char* a, const char* b) {
+    return *a == *b && (*a == '\0' || nomeIgual(a + 1, b + 1));
+}
+
+constexpr bool alvoAlarmeLivre() {
+    for (const Comodo& c : COMODOS) {
+        if (nomeIgual(c.nome, CENA_ALVO_ALARME)) return false;
+    }
+    return true;
+}
+
+}  // namespace
+
+static_assert(alvoAlarmeLivre(), "cômodo com o nome do alvo do alarme na cena");
+
+static bool lerModoCena(const char* valor, size_t tamanho, EntradaAlarme& entrada) {
+    for (const ModoCena& m : MODOS_CENA) {
+        if (!payloadIgual(valor, tamanho, m.nome, m.tamanho)) continue;
+        entrada = m.entrada;
+        return true;
+    }
+    return false;
+}
+
+static bool lerCorCena(const char* nome, size_t tamanhoNome, const char* valor, size_t tamanho,
+                       Cena& cena) {
+    int indice = buscarComodo(nome, tamanhoNome);
+    if (indice < 0) return false;
+
+    CorComodo cor;
+    cor.indice = (uint8_t)indice;
+    if (!parseCorLuz(valor, tamanho, cor.r, cor.g, cor.b, cor.duracaoMs)) return false;
+
+    // Cômodo repetido: vale o último
+    for (uint8_t i = 0; i < cena.numCores; ++i) {
+        if (cena.cores[i].indice == cor.indice) {
+            cena.cores[i] = cor;
+            return true;
+        }
+    }
+    cena.cores[cena.numCores++] = cor;
+    return true;
+}
+
+int parseCena(const char* payload, size_t tamanho, Cena& cena) {
+    cena.numCores = 0;
+    cena.mudaAlarme = false;
+
+    const char* p = payload;
+    const char* fim = payload + tamanho;
+    for (int alvo = 0;; ++alvo) {
+        const char* fimAlvo = (const char*)memchr(p, ';', fim - p);
+        if (fimAlvo == nullptr) fimAlvo = fim;
+        const char* igual = (const char*)memchr(p, '=', fimAlvo - p);
+        if (igual == nullptr) return alvo;
+
+        const char* valor = igual + 1;
+        size_t tamanhoNome = igual - p;
+        size_t tamanhoValor = fimAlvo - valor;
+        bool ok;
+        if (payloadIgual(p, tamanhoNome, CENA_ALVO_ALARME, sizeof(CENA_ALVO_ALARME) - 1)) {
+            ok = lerModoCena(valor, tamanhoValor, cena.entradaAlarme);
+            cena.mudaAlarme = cena.mudaAlarme || ok;
+        } else {
+            ok = lerCorCena(p, tamanhoNome, valor, tamanhoValor, cena);
+        }
+        if (!ok) return alvo;
+
+        if (fimAlvo == fim) return -1;
+        p = fimAlvo + 1;
+    }
+}
+
+static void tratarCena(const char* payload, size_t tamanho) {
+    char buf[PUBLICADOR_PAYLOAD_MAX];
+    Cena cena;
+
+    int invalido = parseCena(payload, tamanho, cena);
+    if (invalido >= 0) {
+        LOG_AVISO("Cena recusada no alvo %d: %.*s", invalido, (int)tamanho, payload);
+        snprintf(buf, sizeof(buf), "INVALIDA,%d", invalido);
+        publicar(TOPICO_CENA_ESTADO, buf);
+        return;
+    }
+
+    aplicarCoresComodos(cena.cores, cena.numCores);
+    if (cena.mudaAlarme) alarmeEntrada(cena.entradaAlarme);
+
+    unsigned alvos = cena.numCores + (cena.mudaAlarme ? 1 : 0);
+    size_t n = (size_t)snprintf(buf, sizeof(buf), "OK,%u,%s", alvos, nomeEstado(alarmeEstado()));
+    for (size_t i = 0; i < NUM_COMODOS && n < sizeof(buf); ++i) {
+        n += (size_t)snprintf(buf + n, sizeof(buf) - n, ",%s",
+                              comodoLigadoPedido(i) ? "ON" : "OFF");
+    }
+    publicar(TOPICO_CENA_ESTADO, buf);
+    LOG_INFO("Cena aplicada: %u alvo(s).", alvos);
+}
+
+// ========================================================
+// CONFIRMAÇÕES DO DIÁRIO
+// ========================================================
+static void tratarConfirmacaoDiario(const char* payload, size_t tamanho) {
+    if (!diario.confirmar(payload, tamanho)) {
+        LOG_AVISO("Confirmação ignorada: %.*s", (int)tamanho, payload);
+    }
+}
+
+// ========================================================
+// TABELA DE REGRAS (TOPICO_REGRAS)
+// ========================================================
+static void tratarRegras(const char* payload, size_t tamanho) {
+    regras.configurar((const uint8_t*)payload, tamanho);
+}
+
+// ========================================================
+// DESPACHO POR TÓPICO
+// ========================================================
+// Hash FNV-1a calculado em tempo de compilação para os tópicos da
+// tabela; no callback só se calcula o hash do tópico recebido e o
+// memcmp final confirma a entrada (colisões não viram comando errado).
+static constexpr uint32_t hashTopico(const char* s, uint32_t h = 2166136261u) {
+    return *s ? hashTopico(s + 1, (h ^ (uint8_t)*s) * 16777619u) : h;
+}
+
+struct RotaTopico {
+    const char* topico;
+    uint32_t hash;
+    void (*tratar)(const char* payload, size_t tamanho);
+};
+
+#define ROTA(topico, fn) { topico, hashTopico(topico), fn }
+
+static const RotaTopico ROTAS[] = {
+    ROTA(TOPICO_CMD, tratarComando),
+    ROTA(TOPICO_EVENTOS_ACK, tratarConfirmacaoDiario),
+    ROTA(TOPICO_REGRAS, tratarRegras),
+    ROTA(TOPICO_CENA, tratarCena),
+};
+
+void mqttCallback(char* topic, byte* payload, unsigned int length) {
+    const char* msg = (const char*)payload;
+
+    LOG_DEBUG("Comando recebido em %s: %.*s", topic, (int)length, msg);
+
+    uint32_t h = hashTopico(topic);
+    for (const RotaTopico& rota : ROTAS) {
+        if (rota.hash == h && strcmp(rota.topico, topic) == 0) {
+            rota.tratar(msg, length);
+            return;
+        }
+    }
+
+    // Assinatura única led/+: o último nível do tópico é o cômodo
+    const size_t prefixo = sizeof(TOPICO_LED_PREFIXO) - 1;
+    if (strncmp(topic, TOPICO_LED_PREFIXO, prefixo) == 0) {
+        const char* nome = topic + prefixo;
+        tratarLed(nome, strlen(nome), msg, length);
+    }
+}
@@ -0,0 +1,179 @@
+#include "comodos.h"
+#include "diario.h"
+#include "energia.h"
+#include "formatacao.h"
+#include "hal.h"
+#include "log.h"
+#include "publicador.h"
+#include "transicao.h"
+
+#include <string.h>
+
+EstadoComodo estadosComodos[NUM_COMODOS];
+
+static_assert(NUM_COMODOS * 3 <= TRANSICAO_MAX_LOTE, "cena não cabe num lote de transições");
+
+// ========================================================
+// COR PEDIDA x COR APLICADA
+// ========================================================
+// Um lote pode ficar esperando o fade anterior acabar (transicao.h).
+// Energia, cor atual, ON/OFF e diário só mudam quando o lote de fato
+// dispara, com o instante do disparo; até lá a cor fica aqui. Um
+// pedido novo para o cômodo substitui o anterior, como na transição.
+namespace {
+
+// O que acompanha a cor quando ela é registrada (em ordem crescente)
+enum AvisoLuz : uint8_t {
+    AVISO_NENHUM = 0,   // só energia e cor atual
+    AVISO_DIARIO,       // + ON/OFF em estadosComodos e no diário
+    AVISO_PUBLICAR,     // + ON/OFF em led/<nome>/estado
+};
+
+struct PedidoCor {
+    bool pendente;
+    AvisoLuz aviso;
+    uint8_t r, g, b;
+    uint32_t duracaoMs;
+};
+
+PedidoCor pedidos[NUM_COMODOS];
+
+void pedir(size_t indice, uint8_t r, uint8_t g, uint8_t b, uint32_t duracaoMs, AvisoLuz aviso) {
+    PedidoCor& p = pedidos[indice];
+    // Substituir um pedido que ia avisar não pode engolir o aviso
+    if (p.pendente && p.aviso > aviso) aviso = p.aviso;
+    p.aviso = aviso;
+    p.pendente = true;
+    p.r = r;
+    p.g = g;
+    p.b = b;
+    p.duracaoMs = duracaoMs;
+}
+
+void montarMudancas(size_t indice, const PedidoCor& p, MudancaCanal* mudancas) {
+    const uint8_t rgb[3] = {p.r, p.g, p.b};
+    for (int cor = 0; cor < 3; ++cor) {
+        mudancas[cor] = {COMODOS[indice].canais[cor], gamaDuty(rgb[cor]), p.duracaoMs};
+    }
+}
+
+}  // namespace
+
+void comodosIniciar() {
+    transicaoIniciar();
+    for (size_t i = 0; i < NUM_COMODOS; ++i) {
+        const Comodo& c = COMODOS[i];
+        for (int cor = 0; cor < 3; ++cor) {
+            pinMode(c.pinos[cor], OUTPUT);
+            ledcSetup(c.canais[cor], LED_PWM_FREQ, LED_PWM_RES);
+            ledcAttachPin(c.pinos[cor], c.canais[cor]);
+        }
+        pedidos[i] = {};
+        definirCorComodo(i, 0, 0, 0, 0);
+        estadosComodos[i].ligado = false;
+        estadosComodos[i].ligadoDesde = 0;
+    }
+}
+
+int buscarComodo(const char* nome, size_t tamanho) {
+    for (size_t i = 0; i < NUM_COMODOS; ++i) {
+        const char* n = COMODOS[i].nome;
+        if (strlen(n) == tamanho && memcmp(n, nome, tamanho) == 0) return (int)i;
+    }
+    return -1;
+}
+
+// Registra (e publica, se pedido) ON/OFF e duração quando a luz muda
+// de apagada para acesa ou vice-versa
+static void atualizarLigado(size_t indice, uint32_t agoraMs, bool publicarEstado) {
+    const Comodo& c = COMODOS[indice];
+    EstadoComodo& e = estadosComodos[indice];
+
+    bool isOn = (e.r != 0 || e.g != 0 || e.b != 0);
+    if (isOn && !e.ligado) {
+        e.ligado = true;
+        e.ligadoDesde = agoraMs;
+        diarioRegistrarLuz((uint8_t)indice, true, e.ligadoDesde);
+        if (publicarEstado && publicadorConectado()) {
+            char buf[64];
+            // publicar ON com timestamp (ms desde boot)
+            formatarEstadoLuz(buf, sizeof(buf), true, e.ligadoDesde);
+            publicar(c.topicoEstado, buf);
+        }
+    } else if (!isOn && e.ligado) {
+        // ficou OFF — calcular duração
+        unsigned long dur = (e.ligadoDesde > 0) ? (agoraMs - e.ligadoDesde) : 0;
+        e.ligado = false;
+        e.ligadoDesde = 0;
+        diarioRegistrarLuz((uint8_t)indice, false, dur);
+        if (publicarEstado && publicadorConectado()) {
+            char buf[64];
+            formatarEstadoLuz(buf, sizeof(buf), false, dur);
+            publicar(c.topicoEstado, buf);
+        }
+    }
+}
+
+// Energia e cor atual (e ON/OFF, se pedido), se o lote do cômodo já
+// disparou
+static void registrarSeDisparou(size_t indice, uint32_t agoraMs) {
+    PedidoCor& p = pedidos[indice];
+    if (!p.pendente || transicaoPendente(COMODOS[indice].canais[0])) return;
+    p.pendente = false;
+
+    const uint32_t duty[3] = {gamaDuty(p.r), gamaDuty(p.g), gamaDuty(p.b)};
+    energia.mudou((uint8_t)indice, duty, p.duracaoMs, agoraMs);
+
+    EstadoComodo& e = estadosComodos[indice];
+    e.r = p.r;
+    e.g = p.g;
+    e.b = p.b;
+    if (p.aviso != AVISO_NENHUM) atualizarLigado(indice, agoraMs, p.aviso == AVISO_PUBLICAR);
+}
+
+static void mudarCor(size_t indice, uint8_t r, uint8_t g, uint8_t b, uint32_t duracaoMs,
+                     AvisoLuz aviso) {
+    pedir(indice, r, g, b, duracaoMs, aviso);
+    MudancaCanal mudancas[3];
+    montarMudancas(indice, pedidos[indice], mudancas);
+    transicaoCanais(mudancas, 3);
+    registrarSeDisparou(indice, millis());
+}
+
+void definirCorComodo(size_t indice, uint8_t r, uint8_t g, uint8_t b, uint32_t duracaoMs) {
+    mudarCor(indice, r, g, b, duracaoMs, AVISO_NENHUM);
+}
+
+void aplicarCorComodo(size_t indice, uint8_t r, uint8_t g, uint8_t b, uint32_t duracaoMs) {
+    mudarCor(indice, r, g, b, duracaoMs, AVISO_PUBLICAR);
+    LOG_DEBUG("LED %s -> R:%d G:%d B:%d (%lu ms)", COMODOS[indice].nome, r, g, b,
+              (unsigned long)duracaoMs);
+}
+
+void aplicarCoresComodos(const CorComodo* cores, size_t quantidade) {
+    if (quantidade > NUM_COMODOS) quantidade = NUM_COMODOS;
+
+    MudancaCanal mudancas[NUM_COMODOS * 3] = {};
+    for (size_t i = 0; i < quantidade; ++i) {
+        const CorComodo& cor = cores[i];
+        // O ON/OFF vai na confirmação da cena (comandos.h), não um
+        // led/<nome>/estado por cômodo
+        pedir(cor.indice, cor.r, cor.g, cor.b, cor.duracaoMs, AVISO_DIARIO);
+        montarMudancas(cor.indice, pedidos[cor.indice], mudancas + i * 3);
+    }
+    transicaoCanais(mudancas, quantidade * 3);
+
+    uint32_t agora = millis();
+    for (size_t i = 0; i < quantidade; ++i) registrarSeDisparou(cores[i].indice, agora);
+}
+
+void comodosServicar(uint32_t agoraMs) {
+    transicaoServicar(agoraMs);
+    for (size_t i = 0; i < NUM_COMODOS; ++i) registrarSeDisparou(i, agoraMs);
+}
+
+bool comodoLigadoPedido(size_t indice) {
+    const PedidoCor& p = pedidos[indice];
+    if (!p.pendente) return estadosComodos[indice].ligado;
+    return p.r != 0 || p.g != 0 || p.b != 0;
+}
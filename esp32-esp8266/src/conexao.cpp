@@ -0,0 +1,210 @@
+#include "conexao.h"
+
+GerenciadorConexao gerenciadorConexao;
+
+namespace {
+
+// Comparação que sobrevive à virada do millis() em 32 bits
+bool venceu(uint32_t agoraMs, uint32_t prazoMs) {
+    return (int32_t)(agoraMs - prazoMs) >= 0;
+}
+
+}  // namespace
+
+const char* nomeEstadoLink(EstadoLink estado) {
+    switch (estado) {
+        case LINK_ESPERA:          return "ESPERA";
+        case LINK_WIFI_CONECTANDO: return "WIFI";
+        case LINK_AGUARDANDO_IP:   return "IPV6";
+        case LINK_MQTT_CONECTANDO: return "MQTT";
+        case LINK_ONLINE:          return "ONLINE";
+        default:                   return "?";
+    }
+}
+
+// ========================================================
+// BACKOFF
+// ========================================================
+Backoff::Backoff(uint32_t baseMs, uint32_t maxMs, uint32_t semente)
+    : baseMs_(baseMs), maxMs_(maxMs), tentativas_(0), rng_(semente ? semente : 1) {}
+
+uint32_t Backoff::proximo() {
+    uint32_t teto = maxMs_;
+    if (tentativas_ < 31 && (baseMs_ << tentativas_) >> tentativas_ == baseMs_) {
+        teto = baseMs_ << tentativas_;
+        if (teto > maxMs_) teto = maxMs_;
+    }
+    ++tentativas_;
+
+    // xorshift32: basta para espalhar, não é criptográfico
+    rng_ ^= rng_ << 13;
+    rng_ ^= rng_ >> 17;
+    rng_ ^= rng_ << 5;
+
+    uint32_t metade = teto / 2;
+    return metade + rng_ % (teto - metade + 1);
+}
+
+// ========================================================
+// MÁQUINA DE ESTADOS
+// ========================================================
+GerenciadorConexao::GerenciadorConexao()
+    : estado_(LINK_ESPERA),
+      backoff_(CONEXAO_BACKOFF_BASE_MS, CONEXAO_BACKOFF_MAX_MS),
+      wifiPronto_(false), prazo_(0), inicioMs_(0), quedaMs_(0), jaConectou_(false),
+      tentativasWifi_(0), timeoutsWifi_(0), tentativasMqtt_(0), falhasMqtt_(0),
+      quedas_(0), reconexoes_(0), primeiraConexaoMs_(0), ultimaReconexaoMs_(0),
+      maxReconexaoMs_(0), offlineTotalMs_(0) {}
+
+void GerenciadorConexao::iniciar(uint32_t agoraMs, uint32_t semente) {
+    backoff_.reiniciar();
+    backoff_.semear(semente);
+    wifiPronto_ = false;
+    prazo_ = agoraMs;  // primeira tentativa já
+    inicioMs_ = agoraMs;
+    quedaMs_ = agoraMs;
+    jaConectou_ = false;
+
+    tentativasWifi_.store(0, std::memory_order_relaxed);
+    timeoutsWifi_.store(0, std::memory_order_relaxed);
+    tentativasMqtt_.store(0, std::memory_order_relaxed);
+    falhasMqtt_.store(0, std::memory_order_relaxed);
+    quedas_.store(0, std::memory_order_relaxed);
+    reconexoes_.store(0, std::memory_order_relaxed);
+    primeiraConexaoMs_.store(0, std::memory_order_relaxed);
+    ultimaReconexaoMs_.store(0, std::memory_order_relaxed);
+    maxReconexaoMs_.store(0, std::memory_order_relaxed);
+    offlineTotalMs_.store(0, std::memory_order_relaxed);
+    mudar(LINK_ESPERA);
+}
+
+void GerenciadorConexao::mudar(EstadoLink novo) {
+    estado_.store(novo, std::memory_order_relaxed);
+}
+
+void GerenciadorConexao::agendarRetentativa(uint32_t agoraMs) {
+    prazo_ = agoraMs + backoff_.proximo();
+    mudar(LINK_ESPERA);
+}
+
+void GerenciadorConexao::sairDeOnline(uint32_t agoraMs) {
+    if (estado() != LINK_ONLINE) return;
+    quedas_.fetch_add(1, std::memory_order_relaxed);
+    quedaMs_ = agoraMs;
+}
+
+void GerenciadorConexao::wifiAssociado(uint32_t agoraMs) {
+    if (estado() != LINK_WIFI_CONECTANDO) return;
+    prazo_ = agoraMs + CONEXAO_PRAZO_IPV6_MS;
+    mudar(LINK_AGUARDANDO_IP);
+}
+
+void GerenciadorConexao::wifiEnderecoObtido() {
+    EstadoLink e = estado();
+    if (e != LINK_WIFI_CONECTANDO && e != LINK_AGUARDANDO_IP) return;
+    wifiPronto_ = true;
+    mudar(LINK_MQTT_CONECTANDO);
+}
+
+void GerenciadorConexao::wifiCaiu(uint32_t agoraMs) {
+    wifiPronto_ = false;
+    if (estado() == LINK_ESPERA) return;  // já tem retentativa marcada
+    sairDeOnline(agoraMs);
+    agendarRetentativa(agoraMs);
+}
+
+void GerenciadorConexao::mqttResultado(bool conectou, uint32_t agoraMs) {
+    if (estado() != LINK_MQTT_CONECTANDO) return;
+    if (!conectou) {
+        falhasMqtt_.fetch_add(1, std::memory_order_relaxed);
+        agendarRetentativa(agoraMs);
+        return;
+    }
+
+    backoff_.reiniciar();
+    uint32_t duracao = agoraMs - quedaMs_;
+    if (!jaConectou_) {
+        jaConectou_ = true;
+        primeiraConexaoMs_.store(agoraMs - inicioMs_, std::memory_order_relaxed);
+    } else {
+        reconexoes_.fetch_add(1, std::memory_order_relaxed);
+        ultimaReconexaoMs_.store(duracao, std::memory_order_relaxed);
+        if (duracao > maxReconexaoMs_.load(std::memory_order_relaxed)) {
+            maxReconexaoMs_.store(duracao, std::memory_order_relaxed);
+        }
+        offlineTotalMs_.fetch_add(duracao, std::memory_order_relaxed);
+    }
+    mudar(LINK_ONLINE);
+}
+
+void GerenciadorConexao::mqttCaiu(uint32_t agoraMs) {
+    if (estado() != LINK_ONLINE) return;
+    sairDeOnline(agoraMs);
+    agendarRetentativa(agoraMs);
+}
+
+AcaoLink GerenciadorConexao::servicar(uint32_t agoraMs) {
+    switch (estado()) {
+        case LINK_ESPERA:
+            if (!venceu(agoraMs, prazo_)) return ACAO_NENHUMA;
+            if (!wifiPronto_) {
+                tentativasWifi_.fetch_add(1, std::memory_order_relaxed);
+                prazo_ = agoraMs + CONEXAO_PRAZO_WIFI_MS;
+                mudar(LINK_WIFI_CONECTANDO);
+                return ACAO_INICIAR_WIFI;
+            }
+            mudar(LINK_MQTT_CONECTANDO);
+            break;
+
+        case LINK_WIFI_CONECTANDO:
+            if (venceu(agoraMs, prazo_)) {
+                timeoutsWifi_.fetch_add(1, std::memory_order_relaxed);
+                agendarRetentativa(agoraMs);
+            }
+            return ACAO_NENHUMA;
+
+        case LINK_AGUARDANDO_IP:
+            if (!venceu(agoraMs, prazo_)) return ACAO_NENHUMA;
+            // Sem IPv6 até o prazo: tenta o broker com o que tiver
+            wifiPronto_ = true;
+            mudar(LINK_MQTT_CONECTANDO);
+            break;
+
+        case LINK_MQTT_CONECTANDO:
+            break;
+
+        default:
+            return ACAO_NENHUMA;
+    }
+
+    tentativasMqtt_.fetch_add(1, std::memory_order_relaxed);
+    return ACAO_CONECTAR_MQTT;
+}
+
+uint32_t GerenciadorConexao::prazoMs(uint32_t agoraMs) const {
+    switch (estado()) {
+        case LINK_ESPERA:
+        case LINK_WIFI_CONECTANDO:
+        case LINK_AGUARDANDO_IP:
+            return venceu(agoraMs, prazo_) ? 0 : prazo_ - agoraMs;
+        case LINK_MQTT_CONECTANDO:
+            return 0;
+        default:
+            return UINT32_MAX;
+    }
+}
+
+ConexaoStats GerenciadorConexao::estatisticas() const {
+    ConexaoStats s;
+    s.tentativasWifi = tentativasWifi_.load(std::memory_order_relaxed);
+    s.timeoutsWifi = timeoutsWifi_.load(std::memory_order_relaxed);
+    s.tentativasMqtt = tentativasMqtt_.load(std::memory_order_relaxed);
+    s.falhasMqtt = falhasMqtt_.load(std::memory_order_relaxed);
+    s.quedas = quedas_.load(std::memory_order_relaxed);
+    s.reconexoes = reconexoes_.load(std::memory_order_relaxed);
+    s.primeiraConexaoMs = primeiraConexaoMs_.load(std::memory_order_relaxed);
+    s.ultimaReconexaoMs = ultimaReconexaoMs_.load(std::memory_order_relaxed);
+    s.maxReconexaoMs = maxReconexaoMs_.load(std::memory_order_relaxed);
+    s.offlineTotalMs = offlineTotalMs_.load(std::memory_order_relaxed);
+    return s;
+}
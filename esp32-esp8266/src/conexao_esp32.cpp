@@ -0,0 +1,73 @@
+// Driver do gerenciador de conexão no ESP32. Os callbacks do WiFi
+// rodam na tarefa de eventos do Arduino: só marcam bits numa máscara
+// atômica e acordam a taskMQTT, que é a única a mexer na máquina.
+#include "conexao.h"
+#include "eventos.h"
+#include "log.h"
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include "../include/config.h"
+
+namespace {
+
+enum : uint32_t {
+    WIFI_ASSOCIADO = 1u << 0,
+    WIFI_ENDERECO  = 1u << 1,
+    WIFI_CAIU      = 1u << 2,
+};
+
+std::atomic<uint32_t> pendentes{0};
+
+void aoEventoWiFi(WiFiEvent_t evento, WiFiEventInfo_t) {
+    uint32_t bit = 0;
+    switch (evento) {
+        case ARDUINO_EVENT_WIFI_STA_CONNECTED:
+            WiFi.enableIpV6();  // o broker é acessado por IPv6
+            bit = WIFI_ASSOCIADO;
+            break;
+        case ARDUINO_EVENT_WIFI_STA_GOT_IP6:
+            bit = WIFI_ENDERECO;
+            break;
+        case ARDUINO_EVENT_WIFI_STA_DISCONNECTED:
+            bit = WIFI_CAIU;
+            break;
+        default:
+            return;
+    }
+    pendentes.fetch_or(bit, std::memory_order_relaxed);
+    eventosSinalizar(EVENTO_REDE);
+}
+
+}  // namespace
+
+void conexaoIniciar() {
+    WiFi.persistent(false);
+    WiFi.setAutoReconnect(false);  // quem decide quando tentar é o backoff
+    WiFi.mode(WIFI_STA);
+    WiFi.onEvent(aoEventoWiFi);
+    gerenciadorConexao.iniciar(millis(), esp_random());
+    eventosSinalizar(EVENTO_REDE);  // taskMQTT começa a primeira tentativa
+}
+
+AcaoLink conexaoServicar(bool mqttConectado) {
+    uint32_t agora = millis();
+    uint32_t ev = pendentes.exchange(0, std::memory_order_relaxed);
+
+    // Queda primeiro: associação e endereço só chegam depois de um begin()
+    if (ev & WIFI_CAIU) gerenciadorConexao.wifiCaiu(agora);
+    if (ev & WIFI_ASSOCIADO) gerenciadorConexao.wifiAssociado(agora);
+    if (ev & WIFI_ENDERECO) gerenciadorConexao.wifiEnderecoObtido();
+    if (!mqttConectado) gerenciadorConexao.mqttCaiu(agora);
+
+    AcaoLink acao = gerenciadorConexao.servicar(agora);
+    if (acao == ACAO_INICIAR_WIFI) {
+        LOG_INFO("[Rede] Conectando ao WiFi %s (tentativa %lu)", WIFI_SSID,
+                 (unsigned long)gerenciadorConexao.estatisticas().tentativasWifi);
+        // Sem disconnect() antes: ele geraria um evento de queda
+        // atrasado que abortaria esta tentativa
+        WiFi.begin(WIFI_SSID, WIFI_PASS);
+        return ACAO_NENHUMA;
+    }
+    return acao;
+}
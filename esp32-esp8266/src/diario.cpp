@@ -0,0 +1,427 @@
+#include "diario.h"
+#include "binario.h"
+#include "comodos.h"
+#include "eventos.h"
+#include "hal.h"
+#include "publicador.h"
+#include "topicos.h"
+
+#include <string.h>
+
+Diario diario;
+
+namespace {
+
+const uint16_t MAGICO = 0xD1A0;
+const uint32_t SLOTS = DIARIO_SLOTS_POR_SETOR;
+
+static_assert(SLOTS >= 2, "setor pequeno demais");
+static_assert(DIARIO_MAX_SETORES <= 255, "setor é uint8_t");
+
+uint8_t crc8(const uint8_t* p, size_t n) {
+    uint8_t crc = 0;
+    while (n--) {
+        crc ^= *p++;
+        for (int i = 0; i < 8; ++i) crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+    }
+    return crc;
+}
+
+// Registro na flash: id(4) valor(4) tipo(1) a(1) b(1) crc8(1)
+void codificar(const EventoDiario& ev, uint8_t* r) {
+    Escritor e = {r, DIARIO_REGISTRO_BYTES, 0, true};
+    e.u32(ev.id);
+    e.u32(ev.valor);
+    e.u8(ev.tipo);
+    e.u8(ev.a);
+    e.u8(ev.b);
+    e.u8(crc8(r, DIARIO_REGISTRO_BYTES - 1));
+}
+
+uint32_t enderecoSlot(uint8_t setor, uint32_t slot) {
+    return (uint32_t)setor * DIARIO_SETOR_BYTES + DIARIO_CABECALHO_BYTES + slot * DIARIO_REGISTRO_BYTES;
+}
+
+}  // namespace
+
+size_t formatarEventoDiario(char* buf, size_t tamanho, uint16_t epoca, const EventoDiario& ev) {
+    int n;
+    if (ev.tipo == DIARIO_ALARME) {
+        n = snprintf(buf, tamanho, "%04X,%lu,ALARME,%s,%s,%lu", epoca, (unsigned long)ev.id,
+                     nomeEstado((EstadoAlarme)ev.a), nomeEstado((EstadoAlarme)ev.b),
+                     (unsigned long)ev.valor);
+    } else {
+        n = snprintf(buf, tamanho, "%04X,%lu,LUZ,%s,%s,%lu", epoca, (unsigned long)ev.id,
+                     ev.a < NUM_COMODOS ? COMODOS[ev.a].nome : "?", ev.b ? "ON" : "OFF",
+                     (unsigned long)ev.valor);
+    }
+    if (n < 0) return 0;
+    return (size_t)n < tamanho ? (size_t)n : tamanho - 1;
+}
+
+// ========================================================
+// PRODUTORES
+// ========================================================
+Diario::Diario()
+    : descartadosFila_(0), setores_(0), epoca_(0), ordemMax_(0), setorMax_(0),
+      cabeca_(0), base_(0), envio_(0), proximoId_(1), confirmado_(0), persistido_(0),
+      ultimoEnviado_(0), maiorEnviado_(0), ultimoEnvioMs_(0), reenvioMs_(DIARIO_REENVIO_MS),
+      proximoApagado_(false), proximoOcupado_(false), confirmadoRecusa_(0), gravados_(0), enviados_(0), reenvios_(0), confirmadoPub_(0), proximoIdPub_(1),
+      descartadosCheio_(0), invalidos_(0), apagamentosMax_(0), apagadosNaHora_(0) {
+    memset(ordem_, 0, sizeof(ordem_));
+    memset(apagamentos_, 0, sizeof(apagamentos_));
+}
+
+bool Diario::registrar(TipoEventoDiario tipo, uint8_t a, uint8_t b, uint32_t valor) {
+    Pendente p = {tipo, a, b, valor};
+    if (!fila_.enfileirar(p)) {
+        descartadosFila_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    eventosSinalizar(EVENTO_PUBLICAR);  // taskMQTT grava, mesmo offline
+    return true;
+}
+
+bool diarioRegistrarAlarme(EstadoAlarme de, EstadoAlarme para, uint32_t instanteMs) {
+    return diario.registrar(DIARIO_ALARME, de, para, instanteMs);
+}
+
+bool diarioRegistrarLuz(uint8_t comodo, bool ligado, uint32_t valorMs) {
+    return diario.registrar(DIARIO_LUZ, comodo, ligado ? 1 : 0, valorMs);
+}
+
+// ========================================================
+// FLASH
+// ========================================================
+uint8_t Diario::setorDe(uint32_t ordem) const {
+    int64_t d = (int64_t)ordem - (int64_t)ordemMax_;
+    int64_t s = ((int64_t)setorMax_ + d) % setores_;
+    return (uint8_t)(s < 0 ? s + setores_ : s);
+}
+
+bool Diario::lerCabecalho(uint8_t setor, Cabecalho& c) {
+    if (!diarioFlashLer((uint32_t)setor * DIARIO_SETOR_BYTES, &c, sizeof(c))) return false;
+    return c.magico == MAGICO && c.ordem != 0 && c.ordem != UINT32_MAX;
+}
+
+Diario::Leitura Diario::ler(uint32_t pos, EventoDiario& ev) {
+    uint32_t ordem = pos / SLOTS;
+    if (ordem == 0 || ordem > ordemMax_) return VAZIO;
+    uint8_t setor = setorDe(ordem);
+    if (ordem_[setor] != ordem) return VAZIO;  // já reaproveitado
+
+    uint8_t r[DIARIO_REGISTRO_BYTES];
+    if (!diarioFlashLer(enderecoSlot(setor, pos % SLOTS), r, sizeof(r))) return INVALIDO;
+
+    bool apagado = true;
+    for (uint8_t byte : r) apagado = apagado && byte == 0xFF;
+    if (apagado) return VAZIO;
+    if (crc8(r, DIARIO_REGISTRO_BYTES - 1) != r[11]) return INVALIDO;
+
+    Leitor l = {r, 0};
+    ev.id = l.u32();
+    ev.valor = l.u32();
+    ev.tipo = (TipoEventoDiario)l.u8();
+    ev.a = l.u8();
+    ev.b = l.u8();
+    if (ev.tipo == DIARIO_CONFIRMACAO) return CONFIRMACAO;
+    if (ev.tipo == DIARIO_ALARME || ev.tipo == DIARIO_LUZ) return EVENTO;
+    return INVALIDO;
+}
+
+bool Diario::setorConfirmado(uint32_t ordem) {
+    EventoDiario ev;
+    for (uint32_t pos = ordem * SLOTS; pos < (ordem + 1) * SLOTS; ++pos) {
+        if (ler(pos, ev) == EVENTO && ev.id > confirmado_) return false;
+    }
+    return true;
+}
+
+// Apaga (se não foi adiantado) o próximo setor do anel e grava o
+// cabeçalho. Recusa se ele ainda guarda evento não confirmado.
+bool Diario::abrirSetor(uint32_t ordem) {
+    static_assert(sizeof(Cabecalho) == DIARIO_CABECALHO_BYTES, "layout do cabeçalho");
+    uint8_t setor = setorDe(ordem);
+    if (!proximoApagado_ || ordem != ordemMax_ + 1) {
+        if (ordem_[setor] != 0 && !setorConfirmado(ordem_[setor])) return false;
+        ordem_[setor] = 0;
+        if (!diarioFlashApagarSetor(setor)) return false;
+        if (ordemMax_ != 0) apagadosNaHora_.fetch_add(1, std::memory_order_relaxed);
+        uint32_t apagamentos = ++apagamentos_[setor];
+        if (apagamentos > apagamentosMax_.load(std::memory_order_relaxed)) {
+            apagamentosMax_.store(apagamentos, std::memory_order_relaxed);
+        }
+    }
+    proximoApagado_ = proximoOcupado_ = false;
+
+    Cabecalho c = {MAGICO, epoca_, ordem, apagamentos_[setor], proximoId_, confirmado_};
+    // O mágico vai por último: cabeçalho cortado não parece válido
+    const uint8_t* bytes = (const uint8_t*)&c;
+    uint32_t base = (uint32_t)setor * DIARIO_SETOR_BYTES;
+    if (!diarioFlashEscrever(base + sizeof(c.magico), bytes + sizeof(c.magico), sizeof(c) - sizeof(c.magico)) ||
+        !diarioFlashEscrever(base, bytes, sizeof(c.magico))) {
+        return false;
+    }
+
+    ordem_[setor] = ordem;
+    ordemMax_ = ordem;
+    setorMax_ = setor;
+    persistido_ = confirmado_;
+    return true;
+}
+
+// Fora do caminho da gravação: o setor que abrirSetor() vai usar já
+// fica apagado. Guardando evento não confirmado, só tenta de novo
+// quando a confirmação andar (setorConfirmado() lê o setor inteiro).
+void Diario::apagarProximo() {
+    if (proximoApagado_ || setores_ == 0 || ordemMax_ == 0) return;
+    if (proximoOcupado_ && confirmadoRecusa_ == confirmado_) return;
+
+    uint8_t setor = setorDe(ordemMax_ + 1);
+    if (ordem_[setor] != 0 && !setorConfirmado(ordem_[setor])) {
+        proximoOcupado_ = true;
+        confirmadoRecusa_ = confirmado_;
+        return;
+    }
+    ordem_[setor] = 0;
+    if (!diarioFlashApagarSetor(setor)) return;
+    uint32_t apagamentos = ++apagamentos_[setor];
+    if (apagamentos > apagamentosMax_.load(std::memory_order_relaxed)) {
+        apagamentosMax_.store(apagamentos, std::memory_order_relaxed);
+    }
+    proximoApagado_ = true;
+}
+
+bool Diario::gravar(const EventoDiario& ev) {
+    uint32_t ordem = cabeca_ / SLOTS;
+    if (ordem > ordemMax_ && !abrirSetor(ordem)) return false;
+
+    uint8_t r[DIARIO_REGISTRO_BYTES];
+    codificar(ev, r);
+    bool ok = diarioFlashEscrever(enderecoSlot(setorMax_, cabeca_ % SLOTS), r, sizeof(r));
+    ++cabeca_;  // mesmo com erro: o slot pode ter ficado sujo
+    return ok;
+}
+
+void Diario::formatar(uint32_t semente) {
+    epoca_ = (uint16_t)(semente ^ (semente >> 16));
+    if (epoca_ == 0) epoca_ = 1;
+    memset(ordem_, 0, sizeof(ordem_));
+    memset(apagamentos_, 0, sizeof(apagamentos_));
+    ordemMax_ = 0;
+    setorMax_ = setores_ - 1;  // o primeiro setor aberto é o 0
+    proximoApagado_ = proximoOcupado_ = false;
+    proximoId_ = 1;
+    confirmado_ = 0;
+    if (!abrirSetor(1)) setores_ = 0;  // flash com defeito: desliga
+    cabeca_ = base_ = envio_ = SLOTS;
+}
+
+// ========================================================
+// TASKMQTT
+// ========================================================
+void Diario::iniciar(uint32_t semente) {
+    uint32_t n = diarioFlashTamanho() / DIARIO_SETOR_BYTES;
+    if (n > DIARIO_MAX_SETORES) n = DIARIO_MAX_SETORES;
+    setores_ = n >= 2 ? (uint8_t)n : 0;  // com um setor só não há o que girar
+
+    invalidos_.store(0, std::memory_order_relaxed);
+    apagamentosMax_.store(0, std::memory_order_relaxed);
+    proximoApagado_ = proximoOcupado_ = false;  // sem cabeçalho não dá para saber
+    reenvioMs_ = DIARIO_REENVIO_MS;
+    if (setores_ == 0) return;
+
+    // Cabeçalhos: o de maior ordem é o setor da cabeça
+    Cabecalho novo = {};
+    uint32_t ordemMin = UINT32_MAX;
+    ordemMax_ = 0;
+    for (uint8_t s = 0; s < setores_; ++s) {
+        Cabecalho c;
+        if (!lerCabecalho(s, c)) {
+            ordem_[s] = 0;
+            apagamentos_[s] = 0;
+            continue;
+        }
+        ordem_[s] = c.ordem;
+        apagamentos_[s] = c.apagamentos;
+        if (c.apagamentos > apagamentosMax_.load(std::memory_order_relaxed)) {
+            apagamentosMax_.store(c.apagamentos, std::memory_order_relaxed);
+        }
+        if (c.ordem > ordemMax_) {
+            ordemMax_ = c.ordem;
+            setorMax_ = s;
+            novo = c;
+        }
+        if (c.ordem < ordemMin) ordemMin = c.ordem;
+    }
+
+    if (ordemMax_ == 0) {
+        formatar(semente);
+    } else {
+        epoca_ = novo.epoca;
+        proximoId_ = novo.proximoId;
+        confirmado_ = novo.confirmado;
+        if (ordemMin + setores_ <= ordemMax_) ordemMin = ordemMax_ - setores_ + 1;
+
+        // Do setor mais velho até a cabeça: maior id e última confirmação
+        cabeca_ = (ordemMax_ + 1) * SLOTS;  // setor da cabeça cheio
+        uint32_t pos = ordemMin * SLOTS;
+        while (pos < (ordemMax_ + 1) * SLOTS) {
+            EventoDiario ev;
+            Leitura r = ler(pos, ev);
+            if (r == VAZIO) {
+                if (pos / SLOTS == ordemMax_) {
+                    cabeca_ = pos;
+                    break;
+                }
+                pos = (pos / SLOTS + 1) * SLOTS;  // resto do setor nunca foi usado
+                continue;
+            }
+            if (r == EVENTO && ev.id >= proximoId_) proximoId_ = ev.id + 1;
+            if (r == CONFIRMACAO && ev.valor > confirmado_) confirmado_ = ev.valor;
+            if (r == INVALIDO) invalidos_.fetch_add(1, std::memory_order_relaxed);
+            ++pos;
+        }
+        if (confirmado_ >= proximoId_) confirmado_ = proximoId_ - 1;
+        base_ = ordemMin * SLOTS;
+    }
+
+    persistido_ = confirmado_;
+    maiorEnviado_ = confirmado_;
+    avancarBase();
+    voltarAoConfirmado();
+    confirmadoPub_.store(confirmado_, std::memory_order_relaxed);
+    proximoIdPub_.store(proximoId_, std::memory_order_relaxed);
+}
+
+void Diario::avancarBase() {
+    EventoDiario ev;
+    while (base_ < cabeca_) {
+        if (ler(base_, ev) == EVENTO && ev.id > confirmado_) break;
+        ++base_;
+    }
+}
+
+void Diario::voltarAoConfirmado() {
+    envio_ = base_;
+    ultimoEnviado_ = confirmado_;
+}
+
+void Diario::servicar(uint32_t agoraMs, bool online) {
+    // 1. O que os produtores deixaram vai para a flash
+    Pendente p;
+    bool ocioso = true;
+    while (fila_.desenfileirar(p)) {
+        ocioso = false;
+        if (setores_ == 0) {
+            descartadosCheio_.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        EventoDiario ev = {proximoId_, p.tipo, p.a, p.b, p.valor};
+        if (gravar(ev)) {
+            ++proximoId_;
+            gravados_.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            descartadosCheio_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    proximoIdPub_.store(proximoId_, std::memory_order_relaxed);
+    if (setores_ == 0) return;
+    if (ocioso) apagarProximo();
+
+    // 2. Sem sessão o que estava em voo conta como perdido
+    if (!online) {
+        voltarAoConfirmado();
+        return;
+    }
+
+    // 3. Prazo de confirmação vencido: volta ao primeiro não confirmado
+    if (ultimoEnviado_ > confirmado_ && agoraMs - ultimoEnvioMs_ >= reenvioMs_) {
+        voltarAoConfirmado();
+        reenvioMs_ = reenvioMs_ * 2 > DIARIO_REENVIO_MAX_MS ? DIARIO_REENVIO_MAX_MS : reenvioMs_ * 2;
+    }
+
+    // 4. Enche a janela, em ordem
+    EventoDiario ev;
+    while (ultimoEnviado_ - confirmado_ < DIARIO_JANELA && envio_ < cabeca_) {
+        if (ler(envio_, ev) == EVENTO && ev.id > ultimoEnviado_) {
+            char buf[64];
+            formatarEventoDiario(buf, sizeof(buf), epoca_, ev);
+            if (!publicar(TOPICO_EVENTOS, buf)) break;  // fila cheia: tenta no próximo
+            enviados_.fetch_add(1, std::memory_order_relaxed);
+            if (ev.id <= maiorEnviado_) reenvios_.fetch_add(1, std::memory_order_relaxed);
+            else maiorEnviado_ = ev.id;
+            ultimoEnviado_ = ev.id;
+            ultimoEnvioMs_ = agoraMs;
+        }
+        ++envio_;
+    }
+
+    // 5. Confirmação na flash quando a janela esvazia (ou a cada 64),
+    //    para não reenviar tudo depois de um reboot
+    if (confirmado_ != persistido_ &&
+        (ultimoEnviado_ == confirmado_ || confirmado_ - persistido_ >= 64)) {
+        EventoDiario c = {0, DIARIO_CONFIRMACAO, 0, 0, confirmado_};
+        if (gravar(c)) persistido_ = confirmado_;
+    }
+}
+
+bool Diario::confirmar(const char* payload, size_t tamanho) {
+    if (setores_ == 0) return false;
+
+    // "<época hex>,<id decimal>"
+    const char* p = payload;
+    const char* fim = payload + tamanho;
+    uint32_t epoca = 0;
+    int digitos = 0;
+    for (; p < fim && *p != ','; ++p, ++digitos) {
+        char c = *p;
+        int v = c >= '0' && c <= '9' ? c - '0'
+              : c >= 'A' && c <= 'F' ? c - 'A' + 10
+              : c >= 'a' && c <= 'f' ? c - 'a' + 10 : -1;
+        if (v < 0 || digitos >= 4) return false;
+        epoca = epoca * 16 + v;
+    }
+    if (digitos == 0 || p == fim) return false;
+    ++p;
+
+    uint64_t id = 0;
+    if (p == fim) return false;
+    for (; p < fim; ++p) {
+        if (*p < '0' || *p > '9' || id > UINT32_MAX) return false;
+        id = id * 10 + (*p - '0');
+    }
+
+    if (epoca != epoca_) return false;  // confirmação de outra formatação
+    if (id <= confirmado_ || id > maiorEnviado_) return false;
+
+    confirmado_ = (uint32_t)id;
+    confirmadoPub_.store(confirmado_, std::memory_order_relaxed);
+    avancarBase();
+    if (ultimoEnviado_ < confirmado_) voltarAoConfirmado();  // confirmou além da passada atual
+    reenvioMs_ = DIARIO_REENVIO_MS;
+    return true;
+}
+
+uint32_t Diario::prazoMs(uint32_t agoraMs) const {
+    if (ultimoEnviado_ <= confirmado_) return UINT32_MAX;
+    uint32_t passou = agoraMs - ultimoEnvioMs_;
+    return passou >= reenvioMs_ ? 0 : reenvioMs_ - passou;
+}
+
+DiarioStats Diario::estatisticas() const {
+    DiarioStats s;
+    s.gravados = gravados_.load(std::memory_order_relaxed);
+    s.enviados = enviados_.load(std::memory_order_relaxed);
+    s.reenvios = reenvios_.load(std::memory_order_relaxed);
+    s.confirmados = confirmadoPub_.load(std::memory_order_relaxed);
+    s.pendentes = proximoIdPub_.load(std::memory_order_relaxed) - 1 - s.confirmados;
+    s.descartadosFila = descartadosFila_.load(std::memory_order_relaxed);
+    s.descartadosCheio = descartadosCheio_.load(std::memory_order_relaxed);
+    s.invalidos = invalidos_.load(std::memory_order_relaxed);
+    s.apagamentosMax = apagamentosMax_.load(std::memory_order_relaxed);
+    s.apagadosNaHora = apagadosNaHora_.load(std::memory_order_relaxed);
+    s.setores = setores_;
+    s.epoca = epoca_;
+    return s;
+}
@@ -0,0 +1,29 @@
+// Flash do diário no ESP32: a partição de dados "diario" (subtipo
+// 0x40) de particoes.csv, acessada crua pelo esp_partition. Sem a
+// partição o diário fica desligado e os eventos só são contados.
+#include "diario.h"
+
+#include "esp_partition.h"
+
+static const esp_partition_t* particao() {
+    static const esp_partition_t* p = esp_partition_find_first(
+        ESP_PARTITION_TYPE_DATA, (esp_partition_subtype_t)0x40, "diario");
+    return p;
+}
+
+uint32_t diarioFlashTamanho() {
+    return particao() ? particao()->size : 0;
+}
+
+bool diarioFlashLer(uint32_t endereco, void* dados, size_t tamanho) {
+    return particao() && esp_partition_read(particao(), endereco, dados, tamanho) == ESP_OK;
+}
+
+bool diarioFlashEscrever(uint32_t endereco, const void* dados, size_t tamanho) {
+    return particao() && esp_partition_write(particao(), endereco, dados, tamanho) == ESP_OK;
+}
+
+bool diarioFlashApagarSetor(uint32_t setor) {
+    return particao() &&
+           esp_partition_erase_range(particao(), setor * DIARIO_SETOR_BYTES, DIARIO_SETOR_BYTES) == ESP_OK;
+}
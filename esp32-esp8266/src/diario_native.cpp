@@ -0,0 +1,40 @@
+// Flash do diário no ambiente native: uma NOR simulada em RAM. Como
+// no chip, escrever só leva bits de 1 para 0 e apagar o setor volta
+// tudo a 0xFF. Os testes mudam o tamanho, contam apagamentos e
+// cortam uma escrita no meio para simular queda de energia.
+#include "diario.h"
+
+#include <string.h>
+
+uint8_t diarioNativeFlash[DIARIO_MAX_SETORES * DIARIO_SETOR_BYTES];
+uint32_t diarioNativeTamanho = 4 * DIARIO_SETOR_BYTES;
+uint32_t diarioNativeApagamentos[DIARIO_MAX_SETORES];
+// >= 0: quantos bytes ainda chegam à flash antes do "corte"
+long diarioNativeBytesAteCorte = -1;
+
+uint32_t diarioFlashTamanho() { return diarioNativeTamanho; }
+
+bool diarioFlashLer(uint32_t endereco, void* dados, size_t tamanho) {
+    if (endereco + tamanho > diarioNativeTamanho) return false;
+    memcpy(dados, diarioNativeFlash + endereco, tamanho);
+    return true;
+}
+
+bool diarioFlashEscrever(uint32_t endereco, const void* dados, size_t tamanho) {
+    if (endereco + tamanho > diarioNativeTamanho) return false;
+    const uint8_t* p = (const uint8_t*)dados;
+    for (size_t i = 0; i < tamanho; ++i) {
+        if (diarioNativeBytesAteCorte == 0) return false;
+        if (diarioNativeBytesAteCorte > 0) --diarioNativeBytesAteCorte;
+        diarioNativeFlash[endereco + i] &= p[i];
+    }
+    return true;
+}
+
+bool diarioFlashApagarSetor(uint32_t setor) {
+    if ((setor + 1) * DIARIO_SETOR_BYTES > diarioNativeTamanho) return false;
+    if (diarioNativeBytesAteCorte == 0) return false;
+    memset(diarioNativeFlash + setor * DIARIO_SETOR_BYTES, 0xFF, DIARIO_SETOR_BYTES);
+    ++diarioNativeApagamentos[setor];
+    return true;
+}
@@ -0,0 +1,316 @@
+#include "energia.h"
+#include "binario.h"
+
+#include <stdio.h>
+#include <string.h>
+
+Energia energia;
+
+namespace {
+
+uint32_t diaDe(uint32_t hora) {
+    return hora / 24;
+}
+
+}  // namespace
+
+Energia::Energia()
+    : hora_(0), sincronizado_(false), eventos_(0), descartados_(0), horasFechadas_(0),
+      gravacoes_(0), falhasGravacao_(0), relogio_(false) {
+    memset(comodos_, 0, sizeof(comodos_));
+}
+
+// ========================================================
+// PRODUTORES
+// ========================================================
+void Energia::mudou(uint8_t comodo, const uint32_t duty[3], uint32_t duracaoMs, uint32_t agoraMs) {
+    if (comodo >= NUM_COMODOS) return;
+    Mudanca m;
+    m.comodo = comodo;
+    for (int cor = 0; cor < 3; ++cor) m.duty[cor] = duty[cor];
+    m.duracaoMs = duracaoMs;
+    m.instanteMs = agoraMs;
+    if (!fila_.enfileirar(m)) {
+        descartados_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    eventos_.fetch_add(1, std::memory_order_relaxed);
+}
+
+// ========================================================
+// INTEGRAÇÃO
+// ========================================================
+uint32_t Energia::dutyEm(const Trecho& t, uint32_t instanteMs) {
+    uint32_t passou = instanteMs - t.inicioMs;
+    if (t.duracaoMs == 0 || passou >= t.duracaoMs) return t.para;
+    int64_t delta = (int64_t)t.para - (int64_t)t.de;
+    return (uint32_t)((int64_t)t.de + delta * passou / t.duracaoMs);
+}
+
+// duty·ms de deMs a ateMs (deMs >= inicioMs): trapézio na rampa,
+// retângulo depois dela
+uint64_t Energia::integrar(const Trecho& t, uint32_t deMs, uint32_t ateMs) {
+    uint64_t total = 0;
+    uint32_t fimRampa = t.inicioMs + t.duracaoMs;
+    if ((int32_t)(fimRampa - deMs) > 0) {
+        uint32_t ate = (int32_t)(ateMs - fimRampa) < 0 ? ateMs : fimRampa;
+        total += ((uint64_t)dutyEm(t, deMs) + dutyEm(t, ate)) * (ate - deMs) / 2;
+        deMs = ate;
+    }
+    return total + (uint64_t)t.para * (ateMs - deMs);
+}
+
+void Energia::avancar(Acumulado& c, uint32_t ateMs) {
+    if ((int32_t)(ateMs - c.ultimoMs) <= 0) return;
+    uint64_t dutyMs = 0;
+    for (int cor = 0; cor < 3; ++cor) dutyMs += integrar(c.canal[cor], c.ultimoMs, ateMs);
+    c.energia += dutyMs * ENERGIA_MW_CANAL;
+    if (c.ligado) c.ligadoMs += ateMs - c.ultimoMs;
+    c.ultimoMs = ateMs;
+}
+
+void Energia::aplicar(const Mudanca& m) {
+    Acumulado& c = comodos_[m.comodo];
+    // Mudança enfileirada depois de uma mais nova de outra tarefa:
+    // vale a partir de onde já foi integrado
+    uint32_t agora = (int32_t)(m.instanteMs - c.ultimoMs) > 0 ? m.instanteMs : c.ultimoMs;
+    avancar(c, agora);
+
+    bool ligado = false;
+    for (int cor = 0; cor < 3; ++cor) {
+        Trecho& t = c.canal[cor];
+        t.de = dutyEm(t, agora);
+        t.para = m.duty[cor];
+        t.inicioMs = agora;
+        t.duracaoMs = m.duracaoMs;
+        ligado |= m.duty[cor] != 0;
+    }
+    if (ligado && !c.ligado) c.ligadoDesdeMs = agora;
+    c.ligado = ligado;
+}
+
+// ========================================================
+// BALDES
+// ========================================================
+// Zera os baldes entre a hora aberta e a nova (o dispositivo pode ter
+// ficado desligado) e abre a nova
+void Energia::abrirHora(uint32_t hora) {
+    uint32_t horas = hora_ == 0 ? ENERGIA_HORAS : hora - hora_;
+    uint32_t dias = hora_ == 0 ? ENERGIA_DIAS : diaDe(hora) - diaDe(hora_);
+    if (horas > ENERGIA_HORAS) horas = ENERGIA_HORAS;
+    if (dias > ENERGIA_DIAS) dias = ENERGIA_DIAS;
+    for (Acumulado& c : comodos_) {
+        for (uint32_t i = 0; i < horas; ++i) c.horas[(hora - i) % ENERGIA_HORAS] = BaldeHora{0, 0};
+        for (uint32_t i = 0; i < dias; ++i) c.dias[(diaDe(hora) - i) % ENERGIA_DIAS] = BaldeDia{0, 0};
+    }
+    hora_ = hora;
+}
+
+void Energia::fecharHora(uint32_t novaHora) {
+    for (Acumulado& c : comodos_) {
+        uint64_t mWh = c.energia / ENERGIA_UNIDADE_MWH;
+        uint64_t minutos = c.ligadoMs / 60000;
+        c.energia -= mWh * ENERGIA_UNIDADE_MWH;  // a sobra fica para a próxima hora
+        c.ligadoMs -= minutos * 60000;
+
+        BaldeHora& h = c.horas[hora_ % ENERGIA_HORAS];
+        h.mWh = mWh > 0xFFFF ? 0xFFFF : (uint16_t)mWh;
+        h.minutos = minutos > 0xFF ? 0xFF : (uint8_t)minutos;
+        BaldeDia& d = c.dias[diaDe(hora_) % ENERGIA_DIAS];
+        d.mWh += (uint32_t)mWh;
+        d.minutos += (uint16_t)minutos;
+        c.totalMwh += (uint32_t)mWh;
+    }
+    horasFechadas_.fetch_add(1, std::memory_order_relaxed);
+    abrirHora(novaHora);
+}
+
+bool Energia::servicar(uint32_t agoraMs, uint32_t hora) {
+    Mudanca m;
+    while (fila_.desenfileirar(m)) aplicar(m);
+    for (Acumulado& c : comodos_) avancar(c, agoraMs);
+
+    if (hora == 0) return false;
+    relogio_.store(true, std::memory_order_relaxed);
+
+    if (!sincronizado_) {
+        // Primeira hora conhecida neste boot: o que veio antes dela
+        // (desde o boot) fica na hora aberta agora
+        sincronizado_ = true;
+        if (hora_ == 0 || hora > hora_) abrirHora(hora);
+        return false;
+    }
+    if (hora <= hora_) return false;  // relógio voltou: segue na hora aberta
+    fecharHora(hora);
+    return true;
+}
+
+// ========================================================
+// CONSULTA
+// ========================================================
+ConsumoComodo Energia::consumo(uint8_t comodo, uint32_t agoraMs) const {
+    const Acumulado& c = comodos_[comodo];
+    ConsumoComodo r;
+    r.ligado = c.ligado;
+    r.ligadoHaS = c.ligado ? (agoraMs - c.ligadoDesdeMs) / 1000 : 0;
+    uint64_t duty = (uint64_t)c.canal[0].para + c.canal[1].para + c.canal[2].para;
+    r.potenciaMw = (uint32_t)(duty * ENERGIA_MW_CANAL / TRANSICAO_DUTY_MAX);
+
+    uint32_t diaMwh = 0;
+    uint32_t diaMin = 0;
+    if (hora_ != 0) {
+        const BaldeDia& d = c.dias[diaDe(hora_) % ENERGIA_DIAS];
+        diaMwh = d.mWh;
+        diaMin = d.minutos;
+    }
+    uint32_t horaMwh = (uint32_t)(c.energia / ENERGIA_UNIDADE_MWH);
+    r.hojeS = diaMin * 60 + (uint32_t)(c.ligadoMs / 1000);
+    r.hojeMwh = diaMwh + horaMwh;
+    r.totalMwh = c.totalMwh + horaMwh;
+    return r;
+}
+
+size_t Energia::codificarHistorico(uint8_t comodo, uint8_t* buf, size_t tamanho) const {
+    const Acumulado& c = comodos_[comodo];
+    Escritor e = {buf, tamanho, 0, true};
+    e.u8(ENERGIA_VERSAO);
+    // Balde mais novo = última hora fechada
+    uint32_t ultima = hora_ ? hora_ - 1 : 0;
+    e.u32(ultima);
+    e.u8(ENERGIA_HORAS);
+    for (uint32_t i = ENERGIA_HORAS; i > 0; --i) {
+        const BaldeHora& h = c.horas[(ultima - (i - 1)) % ENERGIA_HORAS];
+        e.u16(h.mWh);
+        e.u8(h.minutos);
+    }
+    e.u8(ENERGIA_DIAS);
+    uint32_t hoje = diaDe(hora_);
+    for (uint32_t i = ENERGIA_DIAS; i > 0; --i) {
+        const BaldeDia& d = c.dias[(hoje - (i - 1)) % ENERGIA_DIAS];
+        e.u32(d.mWh);
+        e.u16(d.minutos);
+    }
+    return e.cabe ? e.pos : 0;
+}
+
+// ========================================================
+// NVS
+// ========================================================
+size_t Energia::salvar(uint8_t* buf, size_t tamanho) const {
+    Escritor e = {buf, tamanho, 0, true};
+    e.u8(ENERGIA_VERSAO);
+    e.u8(NUM_COMODOS);
+    e.u32(hora_);
+    for (const Acumulado& c : comodos_) {
+        e.u32(c.totalMwh);
+        for (const BaldeHora& h : c.horas) {
+            e.u16(h.mWh);
+            e.u8(h.minutos);
+        }
+        for (const BaldeDia& d : c.dias) {
+            e.u32(d.mWh);
+            e.u16(d.minutos);
+        }
+    }
+    return e.cabe ? e.pos : 0;
+}
+
+bool Energia::carregar(const uint8_t* buf, size_t tamanho) {
+    if (tamanho != ENERGIA_NVS_BYTES) return false;
+    Leitor l = {buf, 0};
+    if (l.u8() != ENERGIA_VERSAO || l.u8() != NUM_COMODOS) return false;
+    hora_ = l.u32();
+    for (Acumulado& c : comodos_) {
+        c.totalMwh = l.u32();
+        for (BaldeHora& h : c.horas) {
+            h.mWh = l.u16();
+            h.minutos = l.u8();
+        }
+        for (BaldeDia& d : c.dias) {
+            d.mWh = l.u32();
+            d.minutos = l.u16();
+        }
+    }
+    return true;
+}
+
+void Energia::iniciar() {
+    uint8_t buf[ENERGIA_NVS_BYTES];
+    size_t n = energiaNvsLer(buf, sizeof(buf));
+    if (n == 0 || !carregar(buf, n)) hora_ = 0;
+    sincronizado_ = false;
+}
+
+void Energia::registrarGravacao(bool ok) {
+    (ok ? gravacoes_ : falhasGravacao_).fetch_add(1, std::memory_order_relaxed);
+}
+
+EnergiaStats Energia::estatisticas() const {
+    EnergiaStats s;
+    s.eventos = eventos_.load(std::memory_order_relaxed);
+    s.descartados = descartados_.load(std::memory_order_relaxed);
+    s.horasFechadas = horasFechadas_.load(std::memory_order_relaxed);
+    s.gravacoes = gravacoes_.load(std::memory_order_relaxed);
+    s.falhasGravacao = falhasGravacao_.load(std::memory_order_relaxed);
+    s.relogio = relogio_.load(std::memory_order_relaxed);
+    return s;
+}
+
+// ========================================================
+// TASKMQTT: GRAVAR E PUBLICAR
+// ========================================================
+namespace {
+
+uint32_t ultimoResumoMs = 0;
+bool resumoFeito = false;
+bool estavaOnline = false;
+
+}  // namespace
+
+size_t formatarConsumo(char* buf, size_t tamanho, const ConsumoComodo& c) {
+    int n = snprintf(buf, tamanho, "%s,%lu,%lu,%lu,%lu,%lu", c.ligado ? "ON" : "OFF",
+                     (unsigned long)c.ligadoHaS, (unsigned long)c.potenciaMw,
+                     (unsigned long)c.hojeS, (unsigned long)c.hojeMwh,
+                     (unsigned long)c.totalMwh);
+    if (n < 0) return 0;
+    return (size_t)n < tamanho ? (size_t)n : tamanho - 1;
+}
+
+void energiaServicar(uint32_t agoraMs) {
+    uint32_t instante = energiaRelogioUnix();
+    bool fechou = energia.servicar(agoraMs, instante ? energiaHoraLocal(instante) : 0);
+
+    if (fechou) {
+        uint8_t buf[ENERGIA_NVS_BYTES];
+        size_t n = energia.salvar(buf, sizeof(buf));
+        energia.registrarGravacao(n > 0 && energiaNvsGravar(buf, n));
+    }
+
+    bool online = publicadorConectado();
+    bool conectou = online && !estavaOnline;
+    estavaOnline = online;
+    if (!online) return;
+
+    if (fechou || conectou) {
+        for (uint8_t i = 0; i < NUM_COMODOS; ++i) {
+            uint8_t quadro[ENERGIA_QUADRO_BYTES];
+            size_t n = energia.codificarHistorico(i, quadro, sizeof(quadro));
+            if (n > 0) publicarBinario(COMODOS[i].topicoHistorico, quadro, n, true);
+        }
+    }
+    if (fechou || conectou || !resumoFeito || agoraMs - ultimoResumoMs >= ENERGIA_RESUMO_MS) {
+        for (uint8_t i = 0; i < NUM_COMODOS; ++i) {
+            char buf[64];
+            formatarConsumo(buf, sizeof(buf), energia.consumo(i, agoraMs));
+            publicar(COMODOS[i].topicoEnergia, buf, true);
+        }
+        ultimoResumoMs = agoraMs;
+        resumoFeito = true;
+    }
+}
+
+uint32_t energiaPrazoMs(uint32_t agoraMs) {
+    if (!resumoFeito) return UINT32_MAX;  // primeiro resumo sai ao conectar
+    uint32_t passou = agoraMs - ultimoResumoMs;
+    return passou >= ENERGIA_RESUMO_MS ? 0 : ENERGIA_RESUMO_MS - passou;
+}
@@ -0,0 +1,35 @@
+// Relógio por SNTP e baldes de energia na NVS. Tudo roda na taskMQTT.
+#include "energia.h"
+#include "armazenamento.h"
+
+#include <Arduino.h>
+#include <time.h>
+
+namespace {
+
+const char* NVS_NAMESPACE = "energia";
+const char* NVS_CHAVE = "baldes";
+
+// Antes disso o relógio ainda está no 1970 do boot
+const time_t UNIX_VALIDO = 1600000000;
+
+}  // namespace
+
+void energiaIniciarRelogio() {
+    // UTC; o fuso entra em energiaHoraLocal(). O cliente SNTP do lwIP
+    // roda sozinho e reacerta periodicamente. Os dois têm IPv6.
+    configTime(0, 0, "time.google.com", "time.cloudflare.com");
+}
+
+uint32_t energiaRelogioUnix() {
+    time_t agora = time(nullptr);
+    return agora > UNIX_VALIDO ? (uint32_t)agora : 0;
+}
+
+size_t energiaNvsLer(uint8_t* buf, size_t tamanho) {
+    return nvsLerBlob(NVS_NAMESPACE, NVS_CHAVE, buf, tamanho);
+}
+
+bool energiaNvsGravar(const uint8_t* buf, size_t tamanho) {
+    return nvsGravarBlob(NVS_NAMESPACE, NVS_CHAVE, buf, tamanho);
+}
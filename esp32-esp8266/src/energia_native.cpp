@@ -0,0 +1,31 @@
+// Relógio e NVS da energia no ambiente native: os testes acertam o
+// instante Unix, preenchem e apagam a NVS e fazem a gravação falhar.
+#include "energia.h"
+
+#include <string.h>
+
+uint32_t energiaNativeUnix = 0;
+uint8_t energiaNativeNvs[ENERGIA_NVS_BYTES + 8];
+size_t energiaNativeTamanho = 0;
+bool energiaNativeFalhar = false;
+uint32_t energiaNativeGravacoes = 0;
+
+void energiaIniciarRelogio() {}
+
+uint32_t energiaRelogioUnix() {
+    return energiaNativeUnix;
+}
+
+size_t energiaNvsLer(uint8_t* buf, size_t tamanho) {
+    if (energiaNativeTamanho == 0 || energiaNativeTamanho > tamanho) return 0;
+    memcpy(buf, energiaNativeNvs, energiaNativeTamanho);
+    return energiaNativeTamanho;
+}
+
+bool energiaNvsGravar(const uint8_t* buf, size_t tamanho) {
+    if (energiaNativeFalhar || tamanho > sizeof(energiaNativeNvs)) return false;
+    memcpy(energiaNativeNvs, buf, tamanho);
+    energiaNativeTamanho = tamanho;
+    ++energiaNativeGravacoes;
+    return true;
+}
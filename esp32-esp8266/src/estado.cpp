@@ -0,0 +1,57 @@
+#include "estado.h"
+#include "hal.h"
+#include "latencia.h"
+#include "publicador.h"
+#include "topicos.h"
+
+#include <atomic>
+
+namespace {
+
+const uint8_t ESTADO_NENHUM = 0xFF;  // nada publicado ainda
+
+std::atomic<uint8_t> ultimoEstado{ESTADO_NENHUM};
+std::atomic<uint32_t> sequencia{0};
+std::atomic<unsigned long> ultimaPublicacaoMs{0};
+
+void emitir(EstadoAlarme estado) {
+    char buf[24];
+    uint32_t seq = sequencia.fetch_add(1, std::memory_order_relaxed) + 1;
+    snprintf(buf, sizeof(buf), "%s,%lu", nomeEstado(estado), (unsigned long)seq);
+    ultimaPublicacaoMs.store(millis(), std::memory_order_relaxed);
+    // ALERTA entregue fecha o rastro do disparo (latencia.h)
+    publicar(TOPICO_ESTADO, buf, true, estado == ESTADO_ALERTA ? latenciaPublicado : nullptr);
+}
+
+}  // namespace
+
+const char* nomeEstado(EstadoAlarme estado) {
+    switch (estado) {
+        case ESTADO_ALERTA:  return "ALERTA";
+        case ESTADO_PAUSADO: return "PAUSADO";
+        default:             return "OK";
+    }
+}
+
+void estadoAtualizar(EstadoAlarme estado) {
+    if (ultimoEstado.exchange(estado, std::memory_order_relaxed) == estado) return;
+    emitir(estado);
+}
+
+void estadoHeartbeat() {
+    if (ESTADO_HEARTBEAT_MS == 0) return;
+    uint8_t atual = ultimoEstado.load(std::memory_order_relaxed);
+    if (atual == ESTADO_NENHUM) return;
+    if (millis() - ultimaPublicacaoMs.load(std::memory_order_relaxed) >= ESTADO_HEARTBEAT_MS) {
+        emitir((EstadoAlarme)atual);
+    }
+}
+
+void estadoRepublicar() {
+    uint8_t atual = ultimoEstado.load(std::memory_order_relaxed);
+    if (atual != ESTADO_NENHUM) emitir((EstadoAlarme)atual);
+}
+
+uint32_t estadoSequencia() {
+    return sequencia.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,25 @@
+#include "eventos.h"
+
+#include <atomic>
+
+static std::atomic<uint32_t> despertares[NUM_TAREFAS_MONITORADAS];
+
+void eventosContarDespertar(TarefaMonitorada tarefa) {
+    despertares[tarefa].fetch_add(1, std::memory_order_relaxed);
+}
+
+uint32_t eventosDespertares(TarefaMonitorada tarefa) {
+    return despertares[tarefa].load(std::memory_order_relaxed);
+}
+
+const char* nomeTarefaMonitorada(TarefaMonitorada tarefa) {
+    switch (tarefa) {
+        case TAREFA_SENSOR: return "sensor";
+        case TAREFA_BOTAO:  return "botao";
+        case TAREFA_MQTT:   return "mqtt";
+        case TAREFA_SOCKET: return "socket";
+        case TAREFA_LOG:    return "log";
+        case TAREFA_BUZZER: return "buzzer";
+        default:            return "?";
+    }
+}
@@ -0,0 +1,35 @@
+// Eventos no ESP32: um event group do FreeRTOS. A sinalização vinda
+// de ISR passa pela tarefa de timers do FreeRTOS (FromISR).
+#include "eventos.h"
+
+#include <Arduino.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/event_groups.h"
+
+static EventGroupHandle_t grupo = NULL;
+
+void eventosIniciar() {
+    if (grupo == NULL) grupo = xEventGroupCreate();
+}
+
+void eventosSinalizar(uint32_t bits) {
+    if (grupo == NULL) return;
+    if (xPortInIsrContext()) {
+        BaseType_t acordou = pdFALSE;
+        xEventGroupSetBitsFromISR(grupo, bits, &acordou);
+        portYIELD_FROM_ISR(acordou);
+    } else {
+        xEventGroupSetBits(grupo, bits);
+    }
+}
+
+uint32_t eventosEsperar(uint32_t bits, uint32_t timeoutMs) {
+    if (grupo == NULL) {
+        vTaskDelay(pdMS_TO_TICKS(timeoutMs));
+        return 0;
+    }
+    TickType_t espera = timeoutMs == EVENTOS_PARA_SEMPRE ? portMAX_DELAY : pdMS_TO_TICKS(timeoutMs);
+    // Limpa ao sair e acorda com qualquer um dos bits
+    EventBits_t r = xEventGroupWaitBits(grupo, bits, pdTRUE, pdFALSE, espera);
+    return r & bits;
+}
@@ -0,0 +1,21 @@
+// Eventos no ambiente native: não há outra tarefa para acordar; os
+// bits ficam numa máscara e eventosEsperar() só consome o que houver
+// (avançando o relógio simulado quando não há nada).
+#include "eventos.h"
+#include "hal.h"
+
+#include <atomic>
+
+std::atomic<uint32_t> eventosNativePendentes{0};
+
+void eventosIniciar() {}
+
+void eventosSinalizar(uint32_t bits) {
+    eventosNativePendentes.fetch_or(bits);
+}
+
+uint32_t eventosEsperar(uint32_t bits, uint32_t timeoutMs) {
+    uint32_t r = eventosNativePendentes.fetch_and(~bits) & bits;
+    if (r == 0 && timeoutMs != EVENTOS_PARA_SEMPRE) delay(timeoutMs);
+    return r;
+}
@@ -0,0 +1,187 @@
+#include "filtro_distancia.h"
+#include "hal.h"
+
+#include <string.h>
+
+namespace {
+
+uint8_t contarBits(uint32_t v) {
+    uint8_t n = 0;
+    while (v) {
+        v &= v - 1;
+        ++n;
+    }
+    return n;
+}
+
+void registrar(EstagioStats& s, uint32_t inicio) {
+    uint32_t ciclos = halCiclos() - inicio;
+    s.chamadas++;
+    s.ciclosTotal += ciclos;
+    if (ciclos > s.ciclosMax) s.ciclosMax = ciclos;
+}
+
+}  // namespace
+
+FiltroConfig filtroConfigPadrao(float limiteCm) {
+    FiltroConfig cfg;
+    cfg.minMm = 20;     // HC-SR04 não mede abaixo de ~2 cm
+    cfg.maxMm = 4000;   // nem acima de ~4 m
+    cfg.maxFalhasSeguidas = 3;
+    cfg.janelaMediana = 3;
+    cfg.alphaQ8 = 192;  // 0,75
+    cfg.limiteMm = (uint16_t)(limiteCm * 10.0f);
+    cfg.histereseMm = 50;
+    cfg.confirmN = 2;
+    cfg.confirmM = 3;
+    return cfg;
+}
+
+uint32_t filtroLatenciaAmostras(const FiltroConfig& cfg, EstagioFiltro estagio) {
+    switch (estagio) {
+        case ESTAGIO_OUTLIER:
+            return 0;
+        case ESTAGIO_MEDIANA:
+            return cfg.janelaMediana > 1 ? cfg.janelaMediana / 2 : 0;
+        case ESTAGIO_EMA:
+            // Constante de tempo de uma EMA: ~(1/alpha - 1) amostras
+            return cfg.alphaQ8 >= 256 ? 0 : (256 - cfg.alphaQ8) / cfg.alphaQ8;
+        case ESTAGIO_CONFIRMACAO:
+            return cfg.confirmN > 0 ? cfg.confirmN - 1 : 0;
+        default:
+            return 0;
+    }
+}
+
+FiltroDistancia::FiltroDistancia(const FiltroConfig& cfg) {
+    configurar(cfg);
+}
+
+void FiltroDistancia::configurar(const FiltroConfig& cfg) {
+    cfg_ = cfg;
+    if (cfg_.janelaMediana < 1) cfg_.janelaMediana = 1;
+    if (cfg_.janelaMediana > FILTRO_JANELA_MAX) cfg_.janelaMediana = FILTRO_JANELA_MAX;
+    if ((cfg_.janelaMediana & 1) == 0) cfg_.janelaMediana--;
+    if (cfg_.alphaQ8 < 1) cfg_.alphaQ8 = 1;
+    if (cfg_.alphaQ8 > 256) cfg_.alphaQ8 = 256;
+    if (cfg_.confirmM < 1) cfg_.confirmM = 1;
+    if (cfg_.confirmM > FILTRO_CONFIRM_MAX) cfg_.confirmM = FILTRO_CONFIRM_MAX;
+    if (cfg_.confirmN < 1) cfg_.confirmN = 1;
+    if (cfg_.confirmN > cfg_.confirmM) cfg_.confirmN = cfg_.confirmM;
+    reiniciar();
+}
+
+void FiltroDistancia::reiniciar() {
+    falhasSeguidas_ = 0;
+    janelaPos_ = 0;
+    janelaCheia_ = 0;
+    emaQ8_ = 0;
+    emaIniciada_ = false;
+    historico_ = 0;
+    historicoLen_ = 0;
+    detectado_ = false;
+    memset(stats_, 0, sizeof(stats_));
+}
+
+// Estágio 1: retorna true se a amostra deve seguir no pipeline
+bool FiltroDistancia::rejeitarOutlier(int32_t brutoMm, int32_t& mm) {
+    if (brutoMm >= cfg_.minMm && brutoMm <= cfg_.maxMm) {
+        falhasSeguidas_ = 0;
+        mm = brutoMm;
+        return true;
+    }
+    // Sem eco ou fora da faixa: tolera algumas seguidas, depois
+    // assume que não há nada à frente do sensor.
+    if (falhasSeguidas_ < cfg_.maxFalhasSeguidas) {
+        falhasSeguidas_++;
+        return false;
+    }
+    mm = cfg_.maxMm;
+    return true;
+}
+
+// Estágio 2: mediana das últimas janelaMediana amostras
+int32_t FiltroDistancia::mediana(int32_t mm) {
+    const uint8_t n = cfg_.janelaMediana;
+    if (n <= 1) return mm;
+
+    janela_[janelaPos_] = mm;
+    janelaPos_ = (uint8_t)((janelaPos_ + 1) % n);
+    if (janelaCheia_ < n) janelaCheia_++;
+
+    // Ordenação por inserção de uma cópia: janela pequena, sem heap
+    int32_t ord[FILTRO_JANELA_MAX];
+    for (uint8_t i = 0; i < janelaCheia_; ++i) {
+        int32_t v = janela_[i];
+        int8_t j = (int8_t)i - 1;
+        while (j >= 0 && ord[j] > v) {
+            ord[j + 1] = ord[j];
+            --j;
+        }
+        ord[j + 1] = v;
+    }
+    return ord[janelaCheia_ / 2];
+}
+
+// Estágio 3: EMA em Q8
+int32_t FiltroDistancia::ema(int32_t mm) {
+    if (!emaIniciada_ || cfg_.alphaQ8 >= 256) {
+        emaQ8_ = mm << 8;
+        emaIniciada_ = true;
+    } else {
+        emaQ8_ += (((mm << 8) - emaQ8_) * (int32_t)cfg_.alphaQ8) >> 8;
+    }
+    return (emaQ8_ + 128) >> 8;
+}
+
+// Estágio 4: N-de-M com histerese. O limiar de "perto" depende do
+// estado atual, então o histórico continua coerente nas transições.
+bool FiltroDistancia::confirmar(int32_t mm, bool& mudou) {
+    int32_t limiar = detectado_ ? (int32_t)cfg_.limiteMm + cfg_.histereseMm
+                                : (int32_t)cfg_.limiteMm;
+    uint32_t mascara = cfg_.confirmM >= 32 ? 0xFFFFFFFFu : ((1u << cfg_.confirmM) - 1);
+
+    historico_ = ((historico_ << 1) | (mm <= limiar ? 1u : 0u)) & mascara;
+    if (historicoLen_ < cfg_.confirmM) historicoLen_++;
+
+    uint8_t perto = contarBits(historico_);
+    uint8_t longe = historicoLen_ - perto;
+
+    mudou = false;
+    if (!detectado_ && perto >= cfg_.confirmN) {
+        detectado_ = true;
+        mudou = true;
+    } else if (detectado_ && longe >= cfg_.confirmN) {
+        detectado_ = false;
+        mudou = true;
+    }
+    return detectado_;
+}
+
+FiltroSaida FiltroDistancia::processar(float distanciaCm) {
+    FiltroSaida s;
+    s.brutoMm = distanciaCm < 0 ? -1 : (int32_t)(distanciaCm * 10.0f + 0.5f);
+    s.filtradoMm = emaIniciada_ ? (emaQ8_ + 128) >> 8 : -1;
+    s.detectado = detectado_;
+    s.mudou = false;
+
+    uint32_t t = halCiclos();
+    int32_t mm = 0;
+    s.valido = rejeitarOutlier(s.brutoMm, mm);
+    registrar(stats_[ESTAGIO_OUTLIER], t);
+    if (!s.valido) return s;  // amostra descartada: mantém a última saída
+
+    t = halCiclos();
+    mm = mediana(mm);
+    registrar(stats_[ESTAGIO_MEDIANA], t);
+
+    t = halCiclos();
+    s.filtradoMm = ema(mm);
+    registrar(stats_[ESTAGIO_EMA], t);
+
+    t = halCiclos();
+    s.detectado = confirmar(s.filtradoMm, s.mudou);
+    registrar(stats_[ESTAGIO_CONFIRMACAO], t);
+
+    return s;
+}
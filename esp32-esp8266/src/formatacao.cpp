@@ -0,0 +1,14 @@
+#include "formatacao.h"
+
+#include <stdio.h>
+
+int formatarMedida(char* buf, size_t tamanho, float distancia) {
+    if (distancia < 0) {
+        return snprintf(buf, tamanho, "NA");
+    }
+    return snprintf(buf, tamanho, "%.1f", distancia);
+}
+
+int formatarEstadoLuz(char* buf, size_t tamanho, bool ligada, unsigned long valor) {
+    return snprintf(buf, tamanho, ligada ? "ON,%lu" : "OFF,%lu", valor);
+}
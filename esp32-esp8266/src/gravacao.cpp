@@ -0,0 +1,111 @@
+#include "gravacao.h"
+#include "binario.h"
+#include "topicos.h"
+
+#include <atomic>
+
+static_assert(GRAVACAO_AMOSTRAS <= 255, "quantidade vai em um byte");
+static_assert(GRAVACAO_QUADRO_MAX <= PUBLICADOR_PAYLOAD_MAX,
+              "quadro de gravação maior que a mensagem do publicador");
+
+namespace {
+
+std::atomic<bool> ligada{false};
+
+std::atomic<uint32_t> amostrasGravadas{0};
+std::atomic<uint32_t> quadrosEntregues{0};
+std::atomic<uint32_t> quadrosPerdidos{0};
+
+// Só a tarefa do sensor mexe nestes
+AmostraGravada pendentes[GRAVACAO_AMOSTRAS];
+uint8_t numPendentes = 0;
+uint16_t proximoNumero = 0;
+
+void descarregar() {
+    if (numPendentes == 0) return;
+    bool entregue = false;
+    if (publicadorConectado()) {  // offline: nem codifica
+        uint8_t quadro[GRAVACAO_QUADRO_MAX];
+        size_t n = gravacaoCodificar(pendentes, numPendentes, proximoNumero, quadro, sizeof(quadro));
+        entregue = n > 0 && publicarBinario(TOPICO_GRAVACAO, quadro, n);
+    }
+    (entregue ? quadrosEntregues : quadrosPerdidos).fetch_add(1, std::memory_order_relaxed);
+    proximoNumero++;
+    numPendentes = 0;
+}
+
+}  // namespace
+
+void gravacaoDefinir(bool valor) {
+    ligada.store(valor, std::memory_order_relaxed);
+}
+
+bool gravacaoLigada() {
+    return ligada.load(std::memory_order_relaxed);
+}
+
+uint16_t gravacaoMm(float distanciaCm) {
+    if (distanciaCm < 0) return GRAVACAO_SEM_ECO;
+    // Mesmo arredondamento de FiltroDistancia::processar()
+    int32_t mm = (int32_t)(distanciaCm * 10.0f + 0.5f);
+    return mm >= GRAVACAO_SEM_ECO ? GRAVACAO_SEM_ECO - 1 : (uint16_t)mm;
+}
+
+float gravacaoCm(uint16_t mm) {
+    return mm == GRAVACAO_SEM_ECO ? -1.0f : mm / 10.0f;
+}
+
+void gravacaoAmostra(uint8_t sensor, float distanciaCm, uint32_t ecoUs) {
+    if (!gravacaoLigada()) {
+        descarregar();  // sobra de quando estava ligada
+        return;
+    }
+
+    pendentes[numPendentes++] = {sensor, ecoUs, gravacaoMm(distanciaCm)};
+    amostrasGravadas.fetch_add(1, std::memory_order_relaxed);
+    if (numPendentes >= GRAVACAO_AMOSTRAS) descarregar();
+}
+
+GravacaoStats gravacaoEstatisticas() {
+    GravacaoStats s;
+    s.amostras = amostrasGravadas.load(std::memory_order_relaxed);
+    s.quadros = quadrosEntregues.load(std::memory_order_relaxed);
+    s.perdidos = quadrosPerdidos.load(std::memory_order_relaxed);
+    return s;
+}
+
+size_t gravacaoCodificar(const AmostraGravada* amostras, uint8_t quantidade, uint16_t numero,
+                         uint8_t* buf, size_t tamanho) {
+    size_t total = GRAVACAO_CABECALHO + (size_t)quantidade * GRAVACAO_BYTES_AMOSTRA;
+    if (quantidade > GRAVACAO_AMOSTRAS || total > tamanho) return 0;
+
+    Escritor e = {buf, tamanho, 0, true};
+    e.u8(GRAVACAO_VERSAO);
+    e.u8(quantidade);
+    e.u16(numero);
+    for (uint8_t i = 0; i < quantidade; ++i) {
+        e.u8(amostras[i].sensor);
+        e.u32(amostras[i].ecoUs);
+        e.u16(amostras[i].mm);
+    }
+    return total;
+}
+
+size_t gravacaoDecodificar(const uint8_t* buf, size_t tamanho, AmostraGravada* amostras,
+                           uint8_t& quantidade, uint16_t& numero) {
+    if (tamanho < GRAVACAO_CABECALHO || buf[0] != GRAVACAO_VERSAO) return 0;
+    if (buf[1] == 0 || buf[1] > GRAVACAO_AMOSTRAS) return 0;
+
+    size_t total = GRAVACAO_CABECALHO + (size_t)buf[1] * GRAVACAO_BYTES_AMOSTRA;
+    if (total > tamanho) return 0;
+
+    Leitor l = {buf, 1};
+    quantidade = l.u8();
+    numero = l.u16();
+    for (uint8_t i = 0; i < quantidade; ++i) {
+        amostras[i].sensor = l.u8();
+        amostras[i].ecoUs = l.u32();
+        amostras[i].mm = l.u16();
+    }
+    return total;
+}
@@ -0,0 +1,171 @@
+// Implementação dos mocks declarados em hal_native.h.
+// Compilado apenas no ambiente "native" (ver build_src_filter).
+#include "hal.h"
+
+#include <stdarg.h>
+#include <stdlib.h>
+#include <chrono>
+#include <new>
+
+// ========================================================
+// CONTAGEM DE ALOCAÇÕES
+// ========================================================
+// Com glibc dá para trocar malloc/realloc/calloc e ainda chegar ao
+// alocador de verdade por __libc_*; nas outras libc (musl, macOS,
+// MinGW) só o operator new é contado.
+volatile unsigned long halNativeAlocacoes = 0;
+
+#if defined(__GLIBC__)
+extern "C" void* __libc_malloc(size_t);
+extern "C" void* __libc_realloc(void*, size_t);
+extern "C" void* __libc_calloc(size_t, size_t);
+
+extern "C" void* malloc(size_t n) {
+    ++halNativeAlocacoes;
+    return __libc_malloc(n);
+}
+
+extern "C" void* realloc(void* p, size_t n) {
+    ++halNativeAlocacoes;
+    return __libc_realloc(p, n);
+}
+
+extern "C" void* calloc(size_t n, size_t tamanho) {
+    ++halNativeAlocacoes;
+    return __libc_calloc(n, tamanho);
+}
+#endif
+
+void* operator new(size_t n) {
+#if !defined(__GLIBC__)
+    ++halNativeAlocacoes;
+#endif
+    void* p = malloc(n);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+// ========================================================
+// RELÓGIO SIMULADO
+// ========================================================
+uint64_t halNativeRelogioUs = 0;
+
+unsigned long millis() { return (unsigned long)(halNativeRelogioUs / 1000); }
+unsigned long micros() { return (unsigned long)halNativeRelogioUs; }
+void delay(uint32_t ms) { halNativeRelogioUs += (uint64_t)ms * 1000; }
+void delayMicroseconds(uint32_t us) { halNativeRelogioUs += us; }
+
+uint32_t halCiclos() {
+    return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// ========================================================
+// GPIO / LEDC
+// ========================================================
+uint8_t halNativeGpio[HAL_NATIVE_NUM_PINOS];
+uint32_t halNativeLedc[HAL_NATIVE_NUM_CANAIS];
+
+void pinMode(uint8_t, uint8_t) {}
+
+void digitalWrite(uint8_t pino, uint8_t nivel) {
+    if (pino < HAL_NATIVE_NUM_PINOS) halNativeGpio[pino] = nivel;
+}
+
+int digitalRead(uint8_t pino) {
+    return pino < HAL_NATIVE_NUM_PINOS ? halNativeGpio[pino] : LOW;
+}
+
+uint32_t ledcSetup(uint8_t, uint32_t freq, uint8_t) { return freq; }
+void ledcAttachPin(uint8_t, uint8_t) {}
+
+void ledcWrite(uint8_t canal, uint32_t duty) {
+    if (canal < HAL_NATIVE_NUM_CANAIS) halNativeLedc[canal] = duty;
+}
+
+// ========================================================
+// SERIAL
+// ========================================================
+bool halNativeSerialEco = false;
+HalNativeSerial Serial;
+
+size_t HalNativeSerial::print(const char* s) {
+    size_t n = strlen(s);
+    if (halNativeSerialEco) fwrite(s, 1, n, stdout);
+    return n;
+}
+
+size_t HalNativeSerial::print(char c) {
+    char s[2] = {c, '\0'};
+    return print(s);
+}
+
+size_t HalNativeSerial::print(int v) { return printf("%d", v); }
+size_t HalNativeSerial::print(unsigned int v) { return printf("%u", v); }
+size_t HalNativeSerial::print(long v) { return printf("%ld", v); }
+size_t HalNativeSerial::print(unsigned long v) { return printf("%lu", v); }
+size_t HalNativeSerial::print(double v, int casas) { return printf("%.*f", casas, v); }
+
+size_t HalNativeSerial::printf(const char* fmt, ...) {
+    char buf[256];
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(buf, sizeof(buf), fmt, args);
+    va_end(args);
+    if (n < 0) return 0;
+    if (halNativeSerialEco) fputs(buf, stdout);
+    return (size_t)n;
+}
+
+// ========================================================
+// FREERTOS
+// ========================================================
+SemaphoreHandle_t xSemaphoreCreateMutex() {
+    return new HalNativeMutex();
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t s, TickType_t espera) {
+    if (espera == portMAX_DELAY) {
+        s->m.lock();
+        return pdTRUE;
+    }
+    return s->m.try_lock_for(std::chrono::milliseconds(espera)) ? pdTRUE : pdFALSE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t s) {
+    s->m.unlock();
+    return pdTRUE;
+}
+
+void vTaskDelay(TickType_t ticks) { delay(ticks * portTICK_PERIOD_MS); }
+TickType_t xTaskGetTickCount() { return (TickType_t)millis(); }
+
+// ========================================================
+// PUBSUBCLIENT
+// ========================================================
+bool PubSubClient::publish(const char* topico, const char* payload) {
+    return publish(topico, payload, false);
+}
+
+bool PubSubClient::publish(const char* topico, const char* payload, bool retido) {
+    return publish(topico, (const uint8_t*)payload, (unsigned int)strlen(payload), retido);
+}
+
+bool PubSubClient::publish(const char* topico, const uint8_t* payload, unsigned int tamanho, bool retido) {
+    if (!conectado) return false;
+    ++publicacoes;
+    snprintf(ultimoTopico, sizeof(ultimoTopico), "%s", topico);
+    if (tamanho >= sizeof(ultimoPayload)) tamanho = sizeof(ultimoPayload) - 1;
+    memcpy(ultimoPayload, payload, tamanho);
+    ultimoPayload[tamanho] = 0;
+    ultimoTamanho = tamanho;
+    ultimoRetido = retido;
+    if (espiao) espiao(topico, ultimoPayload, tamanho);
+    return true;
+}
+
+// No ESP32 o cliente global é definido em main.cpp
+PubSubClient mqttClient;
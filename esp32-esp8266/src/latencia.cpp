@@ -0,0 +1,98 @@
+#include "latencia.h"
+#include "binario.h"
+#include "hal.h"
+
+LatenciaAlarme latencia;
+
+namespace {
+
+const uint32_t LIMITES_US[LATENCIA_BALDES] = {200, 500, 1000, 2000, 5000, 20000, 100000, 0};
+
+const uint32_t MARCAS_TODAS = (1u << NUM_MARCAS_LATENCIA) - 1;
+
+inline uint32_t idRastro(uint32_t rastro) { return rastro >> 8; }
+inline uint32_t marcasRastro(uint32_t rastro) { return rastro & 0xFF; }
+
+}  // namespace
+
+const char* nomeMarcaLatencia(MarcaLatencia marca) {
+    switch (marca) {
+        case MARCA_ECO:       return "eco";
+        case MARCA_LIMIAR:    return "limiar";
+        case MARCA_SIRENE:    return "sirene";
+        case MARCA_PUBLICADO: return "publicado";
+        default:              return "?";
+    }
+}
+
+LatenciaAlarme::LatenciaAlarme() {
+    for (uint8_t m = MARCA_LIMIAR; m < NUM_MARCAS_LATENCIA; ++m) {
+        etapas_[m].configurar(LIMITES_US, LATENCIA_BALDES);
+    }
+}
+
+void LatenciaAlarme::abrir(uint32_t ecoUs, uint32_t limiarUs) {
+    instante_[MARCA_ECO].store(ecoUs, std::memory_order_relaxed);
+    instante_[MARCA_LIMIAR].store(limiarUs, std::memory_order_relaxed);
+
+    uint32_t id = proximoId_;
+    proximoId_ = (proximoId_ + 1) & 0xFFFFFF;
+    if (proximoId_ == 0) proximoId_ = 1;
+    uint32_t novo = (id << 8) | (1u << MARCA_ECO) | (1u << MARCA_LIMIAR);
+
+    // release: quem vê o id novo vê os instantes dele
+    uint32_t anterior = rastro_.exchange(novo, std::memory_order_release);
+    if (idRastro(anterior) != 0 && marcasRastro(anterior) != MARCAS_TODAS) {
+        incompletos_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void LatenciaAlarme::confirmar() {
+    uint32_t eco = instante_[MARCA_ECO].load(std::memory_order_relaxed);
+    uint32_t limiar = instante_[MARCA_LIMIAR].load(std::memory_order_relaxed);
+    etapas_[MARCA_LIMIAR].registrar(limiar - eco);
+    rastros_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void LatenciaAlarme::descartar() {
+    rastro_.store(0, std::memory_order_relaxed);
+}
+
+void LatenciaAlarme::marcar(MarcaLatencia marca, uint32_t agoraUs) {
+    uint32_t bit = 1u << marca;
+    uint32_t atual = rastro_.load(std::memory_order_acquire);
+    for (;;) {
+        if (idRastro(atual) == 0 || (marcasRastro(atual) & bit)) return;
+
+        uint32_t desdeEco = agoraUs - instante_[MARCA_ECO].load(std::memory_order_relaxed);
+        if (desdeEco > LATENCIA_JANELA_US) return;  // fica incompleto
+
+        if (rastro_.compare_exchange_weak(atual, atual | bit, std::memory_order_acquire)) {
+            instante_[marca].store(agoraUs, std::memory_order_relaxed);
+            etapas_[marca].registrar(desdeEco);
+            return;
+        }
+    }
+}
+
+size_t LatenciaAlarme::codificar(uint8_t* buf, size_t tamanho) const {
+    Escritor e = {buf, tamanho, 0, true};
+    e.u8(LATENCIA_VERSAO);
+    e.u16(rastros());
+    e.u16(incompletos());
+
+    e.u8(NUM_MARCAS_LATENCIA - MARCA_LIMIAR);
+    for (uint8_t m = MARCA_LIMIAR; m < NUM_MARCAS_LATENCIA; ++m) {
+        const Histograma& h = etapas_[m];
+        uint32_t contagens[METRICAS_MAX_BALDES];
+        h.ler(contagens);
+        e.u8(h.baldes());
+        for (uint8_t b = 0; b < h.baldes(); ++b) e.u16(contagens[b]);
+        e.u32(h.maximo());
+    }
+    return e.cabe ? e.pos : 0;
+}
+
+void latenciaPublicado() {
+    latencia.marcar(MARCA_PUBLICADO, micros());
+}
@@ -0,0 +1,128 @@
+#include "log.h"
+#include "eventos.h"
+#include "fila_lockfree.h"
+#include "hal.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+namespace {
+
+// Uma linha, um registro: a taskLog nunca vê uma linha pela metade
+struct RegistroLog {
+    uint32_t seq;
+    uint32_t instanteMs;
+    uint8_t nivel;
+    uint8_t tamanho;
+    char texto[LOG_LINHA_MAX];
+};
+
+static_assert(LOG_LINHA_MAX <= 256, "tamanho vai em um byte");
+
+FilaLockFree<RegistroLog, LOG_CAPACIDADE> filas[LOG_NUCLEOS];
+
+std::atomic<uint32_t> sequencia{0};
+std::atomic<uint32_t> escritas{0};
+std::atomic<uint32_t> descartadas{0};
+std::atomic<uint32_t> truncadas{0};
+std::atomic<uint32_t> picoOcupacao{0};
+
+// ---------------- Estado do consumidor (só a taskLog) ----------------
+RegistroLog cabeca[LOG_NUCLEOS];  // próximo registro de cada fila
+bool temCabeca[LOG_NUCLEOS];
+char linha[LOG_LINHA_MAX + 24];   // + "<ms> <nível> " e "\n"
+
+void registrarOcupacao(uint32_t ocupacao) {
+    uint32_t pico = picoOcupacao.load(std::memory_order_relaxed);
+    while (ocupacao > pico &&
+           !picoOcupacao.compare_exchange_weak(pico, ocupacao, std::memory_order_relaxed)) {
+    }
+}
+
+}  // namespace
+
+char letraNivelLog(uint8_t nivel) {
+    switch (nivel) {
+        case LOG_NIVEL_ERRO:  return 'E';
+        case LOG_NIVEL_AVISO: return 'W';
+        case LOG_NIVEL_INFO:  return 'I';
+        case LOG_NIVEL_DEBUG: return 'D';
+        default:              return '?';
+    }
+}
+
+void logEscrever(uint8_t nivel, const char* fmt, ...) {
+    // Formata direto na célula da fila: nem malloc, nem Serial, nem
+    // um RegistroLog de ~270 bytes na pilha de quem chama (botão e
+    // buzzer rodam com 2 KB)
+    uint8_t nucleo = logNucleoAtual();
+    if (nucleo >= LOG_NUCLEOS) nucleo = 0;
+    FilaLockFree<RegistroLog, LOG_CAPACIDADE>& fila = filas[nucleo];
+
+    bool formatou = true;
+    va_list args;
+    va_start(args, fmt);
+    bool aceito = fila.enfileirarCom([&](RegistroLog& r) {
+        int n = vsnprintf(r.texto, sizeof(r.texto), fmt, args);
+        if (n < 0) {
+            formatou = false;
+            n = 0;
+        } else if ((size_t)n >= sizeof(r.texto)) {
+            truncadas.fetch_add(1, std::memory_order_relaxed);
+            n = sizeof(r.texto) - 1;
+        }
+        while (n > 0 && (r.texto[n - 1] == '\n' || r.texto[n - 1] == '\r')) --n;
+
+        r.seq = sequencia.fetch_add(1, std::memory_order_relaxed);
+        r.instanteMs = millis();
+        // Formato inválido: a célula já foi reservada, vai vazia e a
+        // taskLog a pula
+        r.nivel = formatou ? nivel : LOG_NIVEL_NADA;
+        r.tamanho = (uint8_t)n;
+    });
+    va_end(args);
+
+    if (!aceito || !formatou) {
+        descartadas.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    escritas.fetch_add(1, std::memory_order_relaxed);
+    registrarOcupacao(fila.ocupacao());
+    eventosSinalizar(EVENTO_LOG);
+}
+
+size_t logDrenar(void (*escrever)(const char* linha, size_t tamanho)) {
+    size_t linhas = 0;
+    for (;;) {
+        int escolhida = -1;
+        for (int c = 0; c < LOG_NUCLEOS; ++c) {
+            if (!temCabeca[c]) temCabeca[c] = filas[c].desenfileirar(cabeca[c]);
+            if (!temCabeca[c]) continue;
+            if (escolhida < 0 || (int32_t)(cabeca[c].seq - cabeca[escolhida].seq) < 0) escolhida = c;
+        }
+        if (escolhida < 0) break;
+
+        const RegistroLog& r = cabeca[escolhida];
+        temCabeca[escolhida] = false;  // r continua válido até a próxima volta
+        if (r.nivel == LOG_NIVEL_NADA) continue;
+
+        int n = snprintf(linha, sizeof(linha), "%lu %c ", (unsigned long)r.instanteMs,
+                         letraNivelLog(r.nivel));
+        memcpy(linha + n, r.texto, r.tamanho);
+        n += r.tamanho;
+        linha[n++] = '\n';
+        escrever(linha, n);
+        ++linhas;
+    }
+    return linhas;
+}
+
+LogStats logEstatisticas() {
+    LogStats s;
+    s.escritas = escritas.load(std::memory_order_relaxed);
+    s.descartadas = descartadas.load(std::memory_order_relaxed);
+    s.truncadas = truncadas.load(std::memory_order_relaxed);
+    s.picoOcupacao = picoOcupacao.load(std::memory_order_relaxed);
+    return s;
+}
@@ -0,0 +1,42 @@
+// taskLog: a única que escreve no Serial. Prioridade mínima no
+// núcleo da rede (tarefas.h): só roda quando as outras tarefas de lá
+// estão bloqueadas e nunca tira CPU do alarme.
+#include "log.h"
+#include "eventos.h"
+#include "metricas.h"
+#include "tarefas.h"
+
+#include <Arduino.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#define LOG_PILHA 3072
+
+namespace {
+
+void escreverSerial(const char* linha, size_t tamanho) {
+    Serial.write((const uint8_t*)linha, tamanho);
+}
+
+void taskLog(void*) {
+    for (;;) {
+        eventosEsperar(EVENTO_LOG, EVENTOS_PARA_SEMPRE);
+        eventosContarDespertar(TAREFA_LOG);
+        logDrenar(escreverSerial);
+    }
+}
+
+}  // namespace
+
+// Depois de eventosIniciar(): antes disso as linhas esperam na fila
+void logIniciar() {
+    TaskHandle_t tarefa = NULL;
+    xTaskCreatePinnedToCore(taskLog, "TaskLog", LOG_PILHA, NULL, PRIORIDADE_BAIXA, &tarefa,
+                            NUCLEO_REDE);
+    metricasRegistrarTarefa(TAREFA_LOG, tarefa);
+    eventosSinalizar(EVENTO_LOG);  // o que foi logado antes
+}
+
+uint8_t logNucleoAtual() {
+    return (uint8_t)xPortGetCoreID();
+}
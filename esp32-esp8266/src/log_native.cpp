@@ -0,0 +1,11 @@
+// Log no ambiente native: sem taskLog; os testes chamam logDrenar()
+// e escolhem o "núcleo" de quem escreve.
+#include "log.h"
+
+uint8_t logNativeNucleo = 0;
+
+void logIniciar() {}
+
+uint8_t logNucleoAtual() {
+    return logNativeNucleo;
+}
@@ -1,12 +1,40 @@
 #include <Arduino.h>
 #include <WiFi.h>
-#include <WiFiClientSecure.h>
 #include <PubSubClient.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/semphr.h"
 #include "freertos/queue.h"
 #include "../include/config.h"
+#include "pinos.h"
+#include "topicos.h"
+#include "alarme.h"
+#include "comandos.h"
+#include "comodos.h"
+#include "publicador.h"
+#include "estado.h"
+#include "ultrassom.h"
+#include "telemetria.h"
+#include "gravacao.h"
+#include "padroes.h"
+#include "eventos.h"
+#include "botao.h"
+#include "conexao.h"
+#include "diario.h"
+#include "cliente_tls.h"
+#include "certificados.h"
+#include "metricas.h"
+#include "log.h"
+#include "partida.h"
+#include "energia.h"
+#include "sensores.h"
+#include "zonas.h"
+#include "tarefas.h"
+#include "latencia.h"
+#include "regras.h"
+#include "transicao.h"
+
+#include "lwip/sockets.h"
 
 // ========================================================
 // FREERTOS - CONFIGURAÇÃO E SINCRONIZAÇÃO
@@ -15,104 +43,38 @@
 // Cada tarefa tem sua própria função e prioridade
 
 // Mutexes para proteger variáveis compartilhadas entre tarefas
-SemaphoreHandle_t mutexEstado;  // Protege: alertaLatched, alarmePausado, etc
+// (o estado do alarme não usa mutex: ver maquina_alarme.h)
 SemaphoreHandle_t mutexDistancia; // Protege: leitura da distância
 
-// Fila para comunicação entre tarefas (opcional, para envio de comandos)
-QueueHandle_t filaComandos;
-
-// ========================================================
-// PINOS DO HARDWARE
-// ========================================================
-// Ultrassônico
-#define TRIG_PIN   25
-#define ECHO_PIN   33
-
-// LED RGB principal do alarme
-#define LED_RED    32
-#define LED_GREEN  21
-#define LED_BLUE   18
-
-// Buzzer e botão
-#define BUZZER_PIN 13
-#define BUTTON_PIN 19
-
-// LED RGB da SALA
-#define LED_SALA_R 4
-#define LED_SALA_G 2
-#define LED_SALA_B 15
-
-// LED RGB do QUARTO
-#define LED_QUARTO_R 23
-#define LED_QUARTO_G 22
-#define LED_QUARTO_B 5
-
-// ========================================================
-// PWM CONFIGURATION
-// ========================================================
-#define BUZZER_CHANNEL 0
-#define BUZZER_FREQ    2000
-#define BUZZER_RES     8
-
-#define LED_PWM_FREQ   5000
-#define LED_PWM_RES    8
-
-// Canais para LED da SALA
-#define LED_SALA_R_CH  1
-#define LED_SALA_G_CH  2
-#define LED_SALA_B_CH  3
-
-// Canais para LED do QUARTO
-#define LED_QUARTO_R_CH 4
-#define LED_QUARTO_G_CH 5
-#define LED_QUARTO_B_CH 6
-
-// ========================================================
-// TOPICOS MQTT
-// ========================================================
-#define TOPICO_SENSOR      "projeto/home-security/sensor/medida"
-#define TOPICO_ESTADO      "projeto/home-security/sensor/estado"
-#define TOPICO_CMD         "projeto/home-security/comandos"
-#define TOPICO_LED_SALA    "projeto/home-security/led/sala"
-#define TOPICO_LED_QUARTO  "projeto/home-security/led/quarto"
-// Tópicos de estado por cômodo (ON/OFF + tempo)
-#define TOPICO_LED_SALA_ESTADO   "projeto/home-security/led/sala/estado"
-#define TOPICO_LED_QUARTO_ESTADO "projeto/home-security/led/quarto/estado"
+// As publicações MQTT de todas as tarefas passam pela fila sem lock
+// de publicador.h; só a taskMQTT toca no socket.
 
 // ========================================================
 // OBJETOS GLOBAIS
 // ========================================================
-WiFiClientSecure secureClient;
+ClienteTls secureClient;  // TLS com CA fixada e retomada de sessão (tls.h)
 PubSubClient mqttClient(secureClient);
 
 // ========================================================
 // ESTADOS DO SISTEMA (PROTEGIDOS POR MUTEX)
 // ========================================================
-volatile bool alertaLatched = false;
-volatile bool alarmePausado = false;
 volatile float distanciaAtual = -1.0;
 
-// Controle do botão
-int clickCount = 0;
-unsigned long lastClickTime = 0;
-const unsigned long CLICK_TIMEOUT = 1000;
-
-// Estado das luzes por cômodo (para reportar ON/OFF e duração)
-volatile bool salaIsOn = false;
-volatile bool quartoIsOn = false;
-unsigned long salaOnSince = 0;
-unsigned long quartoOnSince = 0;
-
-// Limite de disparo em cm
-const float DISTANCIA_LIMITE_CM = 30.0;
 
 // ========================================================
 // PRIORIDADES DAS TAREFAS FREERTOS
 // ========================================================
-// Prioridade maior = número maior (0 a configMAX_PRIORITIES-1)
-#define PRIORIDADE_ALTA    5
-#define PRIORIDADE_NORMAL  3
-#define PRIORIDADE_BAIXA   1
+// Núcleo e prioridade de cada tarefa: plano em tarefas.h
+
+// Período de cada sensor: PERIODO_SENSOR_MS em sensores.h
+
+// Maior sono da taskMQTT sem eventos: o PubSubClient só manda o
+// PINGREQ de dentro do loop(), então acorda a cada 1/3 do keepalive.
+#define MQTT_ESPERA_MAX_MS (MQTT_KEEPALIVE * 1000UL / 3)
+
+// Limite de cada tentativa de connect(): é o máximo que a taskMQTT
+// fica presa quando o broker não responde
+#define MQTT_TIMEOUT_CONEXAO_S 5
 
 // Stack sizes (tamanho da pilha para cada tarefa em words)
 #define STACK_SIZE_PEQUENO  2048
@@ -120,404 +82,168 @@ const float DISTANCIA_LIMITE_CM = 30.0;
 #define STACK_SIZE_GRANDE   8192
 
 // ========================================================
-// FUNÇÕES DE HARDWARE
+// MQTT
 // ========================================================
-void ligarAlerta() {
-    digitalWrite(LED_RED, HIGH);
-    digitalWrite(LED_GREEN, LOW);
-    digitalWrite(LED_BLUE, LOW);
-    ledcWrite(BUZZER_CHANNEL, 255);
-}
+// Uma única tentativa; quando e quantas vezes tentar é decisão do
+// gerenciador de conexão (conexao.h), que chama isto pela taskMQTT
+bool conectarMQTT() {
+    char clientId[32];
+    snprintf(clientId, sizeof(clientId), "ESP32-Home-Security-%lx", (unsigned long)random(0xffff));
 
-void desligarAlerta() {
-    digitalWrite(LED_RED, LOW);
-    digitalWrite(LED_GREEN, HIGH);
-    digitalWrite(LED_BLUE, LOW);
-    ledcWrite(BUZZER_CHANNEL, 0);
-}
-
-void mostrarAlarmePausado() {
-    digitalWrite(LED_RED, LOW);
-    digitalWrite(LED_GREEN, LOW);
-    digitalWrite(LED_BLUE, HIGH);
-    ledcWrite(BUZZER_CHANNEL, 0);
-}
-
-void beepTriple() {
-    const int level = 128;
-    const unsigned long beepMs = 120;
-    const unsigned long gapMs = 80;
+    LOG_INFO("[Rede] Conectando ao MQTT via IPv6... IPv6 local: %s",
+             WiFi.localIPv6().toString().c_str());
 
-    for (int i = 0; i < 3; ++i) {
-        ledcWrite(BUZZER_CHANNEL, level);
-        vTaskDelay(pdMS_TO_TICKS(beepMs));  // FreeRTOS delay
-        ledcWrite(BUZZER_CHANNEL, 0);
-        if (i < 2) vTaskDelay(pdMS_TO_TICKS(gapMs));
+    // Last will: se a sessão cair sem DISCONNECT, o broker avisa
+    if (!mqttClient.connect(clientId, MQTT_USER, MQTT_PASS, TOPICO_REDE, 0, true, "OFFLINE")) {
+        LOG_AVISO("[Rede] MQTT falhou. rc=%d", mqttClient.state());
+        return false;
     }
-}
 
-void setSalaColor(uint8_t r, uint8_t g, uint8_t b) {
-    ledcWrite(LED_SALA_R_CH, r);
-    ledcWrite(LED_SALA_G_CH, g);
-    ledcWrite(LED_SALA_B_CH, b);
+    LOG_INFO("[Rede] Conectado ao MQTT via IPv6!");
+    mqttClient.subscribe(TOPICO_CMD);
+    mqttClient.subscribe(TOPICO_LED_TODOS);  // led/<cômodo>
+    mqttClient.subscribe(TOPICO_EVENTOS_ACK);
+    mqttClient.subscribe(TOPICO_REGRAS);  // tabela retida: chega a cada conexão
+    mqttClient.subscribe(TOPICO_CENA);
+    publicadorDrenar(mqttClient);  // produtores voltam a publicar
+    // Estado retido pode ter mudado enquanto estava offline
+    estadoRepublicar();
+    zonasRepublicar();
+    eventosSinalizar(EVENTO_CONECTADO);  // vigia do socket
+    return true;
 }
 
-void setQuartoColor(uint8_t r, uint8_t g, uint8_t b) {
-    ledcWrite(LED_QUARTO_R_CH, r);
-    ledcWrite(LED_QUARTO_G_CH, g);
-    ledcWrite(LED_QUARTO_B_CH, b);
+// Tempos do boot e estado restaurado (partida.h), retido
+void publicarPartida() {
+    char buf[48];
+    formatarPartida(buf, sizeof(buf), partidaEstatisticas());
+    publicar(TOPICO_PARTIDA, buf, true);
 }
 
-// ========================================================
-// MEDIÇÃO DO ULTRASSÔNICO
-// ========================================================
-float medirDistanciaCm() {
-    digitalWrite(TRIG_PIN, LOW);
-    delayMicroseconds(2);
-
-    digitalWrite(TRIG_PIN, HIGH);
-    delayMicroseconds(10);
-    digitalWrite(TRIG_PIN, LOW);
-
-    long duracao = pulseIn(ECHO_PIN, HIGH, 30000);
-
-    if (duracao == 0) {
-        return -1.0;
-    }
-
-    float distancia = (duracao * 0.0343f) / 2.0f;
-    return distancia;
+// Tempo até conectar (primeira vez ou desde a queda) e como foi o
+// handshake TLS desta sessão no tópico de rede
+void publicarEstadoRede() {
+    ConexaoStats c = gerenciadorConexao.estatisticas();
+    TlsStats t = medicoesTls.estatisticas();
+    const HandshakeStats& h = t.ultimoRetomado ? t.retomado : t.completo;
+    char buf[64];
+    snprintf(buf, sizeof(buf), "ONLINE,%lu,%lu,%s,%lu,%lu",
+             (unsigned long)(c.reconexoes ? c.ultimaReconexaoMs : c.primeiraConexaoMs),
+             (unsigned long)c.quedas, t.ultimoRetomado ? "RETOMADO" : "COMPLETO",
+             (unsigned long)h.ultimoMs, (unsigned long)h.ultimoHeap);
+    publicar(TOPICO_REDE, buf, true);
 }
 
 // ========================================================
-// WIFI
+// TAREFA 1: LEITURA DOS SENSORES ULTRASSÔNICOS
 // ========================================================
-void conectarWiFi() {
-    Serial.print("Conectando ao WiFi: ");
-    Serial.println(WIFI_SSID);
-
-    WiFi.mode(WIFI_STA);
-    WiFi.begin(WIFI_SSID, WIFI_PASS);
+// Esta tarefa dispara os grupos de sensores na ordem da agenda
+// (sensores.h) e atualiza o estado do alarme e das zonas pela
+// distância medida em cada um
+AgendaSensores agendaSensores(SENSORES, NUM_SENSORES, PERIODO_SENSOR_MS * 1000UL);
 
-    while (WiFi.status() != WL_CONNECTED) {
-        Serial.print(".");
-        vTaskDelay(pdMS_TO_TICKS(500));  // FreeRTOS delay
-    }
+void taskSensorUltrassonico(void *parameter) {
+    LOG_INFO("[FreeRTOS] Task Sensor Ultrassônico iniciada (%u sensores, %u grupos)",
+             (unsigned)NUM_SENSORES, agendaSensores.grupos());
 
-    Serial.println("\nWiFi conectado!");
+    // Registra as ISRs do eco; as amostras chegam a esta tarefa por notificação
+    ultrassomIniciar();
     
-    Serial.print("Aguardando IPv6... ");
-    int tentativas = 0;
-    IPv6Address ipv6;
-    while (tentativas < 30) {
-        ipv6 = WiFi.localIPv6();
-        String ipv6Str = ipv6.toString();
-        if (ipv6Str != "::" && ipv6Str != "0:0:0:0:0:0:0:0") {
-            Serial.println("\n✓ IPv6 obtido!");
-            Serial.print("IPv6: ");
-            Serial.println(ipv6Str);
-            return;
-        }
-        Serial.print(".");
-        vTaskDelay(pdMS_TO_TICKS(1000));
-        tentativas++;
-    }
+    float distancias[NUM_SENSORES];
+    uint32_t ecosUs[NUM_SENSORES];
+#if LOG_NIVEL >= LOG_NIVEL_DEBUG
+    TickType_t ultimaPublicacao = 0;
+#endif
     
-    Serial.println("\n✗ Timeout esperando IPv6");
-}
-
-// ========================================================
-// MQTT
-// ========================================================
-void conectarMQTT() {
-    while (!mqttClient.connected()) {
-        Serial.print("Conectando ao MQTT via IPv6... ");
-
-        String clientId = "ESP32-Home-Security-";
-        clientId += String(random(0xffff), HEX);
-
-        IPv6Address ipv6Local = WiFi.localIPv6();
-        Serial.print("IPv6 Local: ");
-        Serial.println(ipv6Local.toString());
-        
-        mqttClient.setServer(MQTT_HOST, MQTT_PORT);
-        
-        if (mqttClient.connect(clientId.c_str(), MQTT_USER, MQTT_PASS)) {
-            Serial.println("Conectado ao MQTT via IPv6!");
-            mqttClient.subscribe(TOPICO_CMD);
-            mqttClient.subscribe(TOPICO_LED_SALA);
-            mqttClient.subscribe(TOPICO_LED_QUARTO);
-        } else {
-            Serial.print("Falhou. rc=");
-            Serial.println(mqttClient.state());
-            vTaskDelay(pdMS_TO_TICKS(3000));
+    for (;;) {  // Loop infinito da tarefa
+        // Próximo grupo: guarda depois do anterior e, no começo do
+        // ciclo, o período de cada sensor
+        uint32_t esperaUs;
+        uint8_t grupo = agendaSensores.proximo(micros(), esperaUs);
+        if (esperaUs > 0) {
+            // FreeRTOS delay - não bloqueia outras tarefas
+            uint32_t esperaMs = (esperaUs + 999) / 1000;
+            uint32_t antesUs = micros();
+            vTaskDelay(pdMS_TO_TICKS(esperaMs));
+            metricas.despertou((int32_t)(micros() - antesUs) - (int32_t)(esperaMs * 1000));
+            eventosContarDespertar(TAREFA_SENSOR);
         }
-    }
-}
 
-bool parseRGB(const String& msg, uint8_t &r, uint8_t &g, uint8_t &b) {
-    int c1 = msg.indexOf(',');
-    int c2 = msg.indexOf(',', c1 + 1);
-    if (c1 < 0 || c2 < 0) return false;
-
-    String sr = msg.substring(0, c1);
-    String sg = msg.substring(c1 + 1, c2);
-    String sb = msg.substring(c2 + 1);
-
-    int ir = sr.toInt();
-    int ig = sg.toInt();
-    int ib = sb.toInt();
-
-    ir = constrain(ir, 0, 255);
-    ig = constrain(ig, 0, 255);
-    ib = constrain(ib, 0, 255);
-
-    r = (uint8_t)ir;
-    g = (uint8_t)ig;
-    b = (uint8_t)ib;
-
-    return true;
-}
-
-void mqttCallback(char* topic, byte* payload, unsigned int length) {
-    String msg;
-    for (unsigned int i = 0; i < length; i++) {
-        msg += (char)payload[i];
-    }
-
-    Serial.print("Comando recebido em ");
-    Serial.print(topic);
-    Serial.print(": ");
-    Serial.println(msg);
-
-    String t = String(topic);
-
-    // Proteger acesso às variáveis compartilhadas
-    if (xSemaphoreTake(mutexEstado, pdMS_TO_TICKS(1000)) == pdTRUE) {
-        if (t == TOPICO_CMD) {
-            if (msg == "STOP") {
-                alertaLatched = false;
-                alarmePausado = false;
-                desligarAlerta();
-                mqttClient.publish(TOPICO_ESTADO, "OK");
-                Serial.println("Alarme parado via MQTT (STOP).");
-            } else if (msg == "PAUSE") {
-                alarmePausado = true;
-                alertaLatched = false;
-                beepTriple();
-                mostrarAlarmePausado();
-                mqttClient.publish(TOPICO_ESTADO, "PAUSADO");
-                Serial.println("Alarme PAUSADO via MQTT.");
-            } else if (msg == "RESUME") {
-                alarmePausado = false;
-                beepTriple();
-                mqttClient.publish(TOPICO_ESTADO, "OK");
-                Serial.println("Alarme RETOMADO via MQTT.");
-            }
-        }
-        xSemaphoreGive(mutexEstado);
-    }
-    
-    if (t == TOPICO_LED_SALA) {
-        uint8_t r, g, b;
-        if (parseRGB(msg, r, g, b)) {
-            setSalaColor(r, g, b);
-            Serial.printf("LED SALA -> R:%d G:%d B:%d\n", r, g, b);
-            // publicar estado ON/OFF e duração
-            bool isOn = (r != 0 || g != 0 || b != 0);
-            if (isOn && !salaIsOn) {
-                salaIsOn = true;
-                salaOnSince = millis();
-                if (mqttClient.connected()) {
-                    char buf[64];
-                    // publicar ON com timestamp (ms desde boot)
-                    snprintf(buf, sizeof(buf), "ON,%lu", (unsigned long)salaOnSince);
-                    mqttClient.publish(TOPICO_LED_SALA_ESTADO, buf);
-                }
-            } else if (!isOn && salaIsOn) {
-                // ficou OFF — calcular duração
-                unsigned long now = millis();
-                unsigned long dur = (salaOnSince > 0) ? (now - salaOnSince) : 0;
-                salaIsOn = false;
-                salaOnSince = 0;
-                if (mqttClient.connected()) {
-                    char buf[64];
-                    snprintf(buf, sizeof(buf), "OFF,%lu", (unsigned long)dur);
-                    mqttClient.publish(TOPICO_LED_SALA_ESTADO, buf);
-                }
+        // Ler distâncias do grupo (juntos; volta no último eco)
+        uint8_t mascara = agendaSensores.mascara(grupo);
+        uint32_t inicioUs = micros();
+        ultrassomMedir(mascara, distancias, ecosUs);
+        agendaSensores.concluido(inicioUs, micros());
+
+        // Verificar se deve ativar alerta (transição sem lock; nunca
+        // perde o disparo por timeout de mutex)
+        for (uint8_t i = 0; i < NUM_SENSORES; ++i) {
+            if (!(mascara & (1u << i))) continue;
+            gravacaoAmostra(i, distancias[i], ecosUs[i]);  // rastro para reprodução
+            FiltroSaida filtro = avaliarSensor(i, distancias[i], ecosUs[i]);
+            if (filtro.mudou) {
+                LOG_INFO("[Sensor] %s: presença %s (filtrado %ld mm)", SENSORES[i].nome,
+                         filtro.detectado ? "confirmada" : "encerrada",
+                         (long)filtro.filtradoMm);
             }
-        } else {
-            Serial.println("Payload inválido para LED SALA (use R,G,B).");
         }
-    }
-    else if (t == TOPICO_LED_QUARTO) {
-        uint8_t r, g, b;
-        if (parseRGB(msg, r, g, b)) {
-            setQuartoColor(r, g, b);
-            Serial.printf("LED QUARTO -> R:%d G:%d B:%d\n", r, g, b);
-            // publicar estado ON/OFF e duração
-            bool isOn = (r != 0 || g != 0 || b != 0);
-            if (isOn && !quartoIsOn) {
-                quartoIsOn = true;
-                quartoOnSince = millis();
-                if (mqttClient.connected()) {
-                    char buf[64];
-                    snprintf(buf, sizeof(buf), "ON,%lu", (unsigned long)quartoOnSince);
-                    mqttClient.publish(TOPICO_LED_QUARTO_ESTADO, buf);
-                }
-            } else if (!isOn && quartoIsOn) {
-                unsigned long now = millis();
-                unsigned long dur = (quartoOnSince > 0) ? (now - quartoOnSince) : 0;
-                quartoIsOn = false;
-                quartoOnSince = 0;
-                if (mqttClient.connected()) {
-                    char buf[64];
-                    snprintf(buf, sizeof(buf), "OFF,%lu", (unsigned long)dur);
-                    mqttClient.publish(TOPICO_LED_QUARTO_ESTADO, buf);
-                }
-            }
-        } else {
-            Serial.println("Payload inválido para LED QUARTO (use R,G,B).");
+        if (partidaArmado(millis())) {
+            LOG_INFO("[Partida] Alarme armado %lu ms após o boot", (unsigned long)millis());
         }
-    }
-}
 
-// ========================================================
-// TAREFA 1: LEITURA DO SENSOR ULTRASSÔNICO
-// ========================================================
-// Esta tarefa é responsável por ler o sensor e atualizar
-// o estado do alarme baseado na distância medida
-void taskSensorUltrassonico(void *parameter) {
-    Serial.println("[FreeRTOS] Task Sensor Ultrassônico iniciada");
-    
-    const TickType_t periodo = pdMS_TO_TICKS(300); // Executa a cada 300ms
-    
-    for (;;) {  // Loop infinito da tarefa
-        // Ler distância
-        float distancia = medirDistanciaCm();
-        
+        // Distância compartilhada, medida no MQTT e métricas seguem o
+        // primeiro sensor, como antes da tabela
+        if (!(mascara & 1u)) continue;
+        float distancia = distancias[0];
+
         // Atualizar distância compartilhada (com proteção)
         if (xSemaphoreTake(mutexDistancia, pdMS_TO_TICKS(100)) == pdTRUE) {
             distanciaAtual = distancia;
             xSemaphoreGive(mutexDistancia);
         }
         
-        // Exibir leitura no Serial
-        Serial.print("[Sensor] Distância: ");
-        if (distancia < 0) {
-            Serial.println("sem leitura (fora de alcance)");
-        } else {
-            Serial.print(distancia);
-            Serial.println(" cm");
-        }
-        
-        // Verificar se deve ativar alerta (com proteção do mutex)
-        if (xSemaphoreTake(mutexEstado, pdMS_TO_TICKS(100)) == pdTRUE) {
-            bool pausado = alarmePausado;
-            bool alerta = alertaLatched;
-            
-            if (!pausado && !alerta) {
-                // Verificar se objeto muito próximo
-                if (distancia > 0 && distancia <= DISTANCIA_LIMITE_CM) {
-                    alertaLatched = true;
-                    ligarAlerta();
-                    mqttClient.publish(TOPICO_ESTADO, "ALERTA");
-                    Serial.println("[Sensor] Alerta ativado por distância!");
-                } else {
-                    desligarAlerta();
-                    mqttClient.publish(TOPICO_ESTADO, "OK");
-                }
-            }
-            
-            xSemaphoreGive(mutexEstado);
-        }
-        
-        // Publicar medida no MQTT
-        if (mqttClient.connected()) {
-            char msg[16];
+        // Publicar medida no MQTT (texto por amostra ou quadros em lote)
+        telemetriaAmostra(distancia, millis());
+        metricas.amostraSensor(micros());
+
+        // Exibir leitura no Serial no ritmo antigo (nível DEBUG: com
+        // LOG_NIVEL padrão nem é compilado)
+#if LOG_NIVEL >= LOG_NIVEL_DEBUG
+        TickType_t agora = xTaskGetTickCount();
+        if (agora - ultimaPublicacao >= pdMS_TO_TICKS(PERIODO_PUBLICACAO_MEDIDA_MS)) {
+            ultimaPublicacao = agora;
+
             if (distancia < 0) {
-                snprintf(msg, sizeof(msg), "NA");
+                LOG_DEBUG("[Sensor] Distância: sem leitura (fora de alcance)");
             } else {
-                snprintf(msg, sizeof(msg), "%.1f", distancia);
+                LOG_DEBUG("[Sensor] Distância: %.2f cm", distancia);
             }
-            mqttClient.publish(TOPICO_SENSOR, msg);
         }
-        
-        // Aguardar próximo ciclo (FreeRTOS delay - não bloqueia outras tarefas)
-        vTaskDelay(periodo);
+#endif
     }
 }
 
 // ========================================================
-// TAREFA 2: LEITURA DO BOTÃO
+// TAREFA 2: GESTOS DO BOTÃO
 // ========================================================
-// Esta tarefa monitora o botão e detecta cliques simples
-// e múltiplos cliques para controlar o alarme
+// Bordas, debounce e classificação ficam em botao.h (ISR +
+// timers); esta tarefa dorme na fila de gestos e aplica cada um
+// ao alarme
 void taskBotao(void *parameter) {
-    Serial.println("[FreeRTOS] Task Botão iniciada");
-    
-    const TickType_t periodo = pdMS_TO_TICKS(50); // Verifica a cada 50ms
-    
+    LOG_INFO("[FreeRTOS] Task Botão iniciada");
+
+    botaoIniciar();
+
+    EventoBotao ev;
     for (;;) {
-        int leituraBotao = digitalRead(BUTTON_PIN);
-        unsigned long tempoAtual = xTaskGetTickCount() * portTICK_PERIOD_MS;
-        
-        if (leituraBotao == HIGH) {
-            // Proteger acesso às variáveis compartilhadas
-            if (xSemaphoreTake(mutexEstado, pdMS_TO_TICKS(100)) == pdTRUE) {
-                bool pausado = alarmePausado;
-                
-                if (tempoAtual - lastClickTime > CLICK_TIMEOUT) {
-                    clickCount = 1;
-                    lastClickTime = tempoAtual;
-                    
-                    if (!pausado) {
-                        alertaLatched = false;
-                        desligarAlerta();
-                        if (mqttClient.connected()) {
-                            mqttClient.publish(TOPICO_ESTADO, "OK");
-                        }
-                        Serial.println("[Botão] Alarme parado por um clique");
-                    }
-                } else {
-                    clickCount++;
-                    lastClickTime = tempoAtual;
-                    
-                    Serial.print("[Botão] Cliques rápidos: ");
-                    Serial.println(clickCount);
-                    
-                    if (clickCount >= 10) {
-                        alarmePausado = !alarmePausado;
-                        clickCount = 0;
-                        
-                        if (alarmePausado) {
-                            Serial.println("[Botão] Alarme PAUSADO");
-                            alertaLatched = false;
-                            beepTriple();
-                            mostrarAlarmePausado();
-                            if (mqttClient.connected()) {
-                                mqttClient.publish(TOPICO_ESTADO, "PAUSADO");
-                            }
-                        } else {
-                            Serial.println("[Botão] Alarme RETOMADO");
-                            beepTriple();
-                            if (mqttClient.connected()) {
-                                mqttClient.publish(TOPICO_ESTADO, "OK");
-                            }
-                        }
-                    }
-                }
-                
-                xSemaphoreGive(mutexEstado);
-            }
-        }
-        
-        // Reset contador de cliques após timeout
-        if (tempoAtual - lastClickTime > CLICK_TIMEOUT * 2 && clickCount > 0) {
-            clickCount = 0;
+        if (!botaoProximoGesto(ev, UINT32_MAX)) continue;
+        eventosContarDespertar(TAREFA_BOTAO);
+
+        if (ev.gesto != GESTO_PRESSAO) {
+            LOG_INFO("[Botão] Gesto %s (%u cliques)", nomeGesto(ev.gesto), ev.cliques);
         }
-        
-        vTaskDelay(periodo);
+
+        tratarGestoBotao(ev);
     }
 }
 
@@ -525,76 +251,138 @@ void taskBotao(void *parameter) {
 // TAREFA 3: COMUNICAÇÃO MQTT
 // ========================================================
 // Esta tarefa mantém a conexão MQTT ativa e processa
-// mensagens recebidas
+// mensagens recebidas. Dorme até haver o que publicar, o
+// socket ter dados ou o keepalive vencer.
 void taskMQTT(void *parameter) {
-    Serial.println("[FreeRTOS] Task MQTT iniciada");
-    
-    // Conectar inicialmente
-    conectarMQTT();
-    
-    const TickType_t periodo = pdMS_TO_TICKS(100); // Loop MQTT a cada 100ms
-    
+    LOG_INFO("[FreeRTOS] Task MQTT iniciada");
+
+    // Flash, TLS e WiFi ficam fora do setup(): quando chegam aqui o
+    // sensor e o botão já estão rodando (partida.h)
+
+    // Diário de eventos na flash: retoma o que ficou sem confirmação.
+    // O que as outras tarefas registrarem até aqui espera na fila dele.
+    diario.iniciar(esp_random());
+    DiarioStats di = diario.estatisticas();
+    LOG_INFO("[Diário] %u setores, época %04X, %lu eventos pendentes",
+             di.setores, di.epoca, (unsigned long)di.pendentes);
+    // Baldes de consumo da NVS; as mudanças de cor desde o boot
+    // esperam na fila da energia
+    energia.iniciar();
+
+    // TLS verificando o broker contra a CA fixada (certificados.h);
+    // a sessão da última conexão, se houver, volta da NVS
+    if (!secureClient.iniciar(CA_BROKER_PEM)) {
+        LOG_ERRO("[TLS] Falha ao preparar o TLS: MQTT não vai conectar");
+    }
+    secureClient.definirTimeout(MQTT_TIMEOUT_CONEXAO_S);
+
+    // Rede em segundo plano: alarme, buzzer e luzes já funcionam sem
+    // AP ou broker
+    mqttClient.setServer(MQTT_HOST, MQTT_PORT);
+    mqttClient.setSocketTimeout(MQTT_TIMEOUT_CONEXAO_S);
+    mqttClient.setCallback(mqttCallback);
+    conexaoIniciar();
+    energiaIniciarRelogio();
+
+    uint32_t eventos = 0;
+    EstadoLink anterior = gerenciadorConexao.estado();
     for (;;) {
-        // Reconectar se necessário
-        if (!mqttClient.connected()) {
-            conectarMQTT();
+        // Eventos do WiFi, queda da sessão e backoff vencido; nunca
+        // bloqueia além de uma tentativa de connect()
+        if (conexaoServicar(mqttClient.connected()) == ACAO_CONECTAR_MQTT) {
+            bool ok = conectarMQTT();
+            gerenciadorConexao.mqttResultado(ok, millis());
+            if (ok) {
+                if (partidaConectado(millis())) {
+                    PartidaStats p = partidaEstatisticas();
+                    LOG_INFO("[Partida] Conectado %lu ms após o boot (armado em %lu ms)",
+                             (unsigned long)p.conectadoMs, (unsigned long)p.armadoMs);
+                }
+                publicarEstadoRede();
+                publicarPartida();
+            }
         }
+
+        EstadoLink link = gerenciadorConexao.estado();
+        if (link != anterior) {
+            LOG_INFO("[Rede] %s -> %s", nomeEstadoLink(anterior), nomeEstadoLink(link));
+            anterior = link;
+        }
+
+        if (link == LINK_ONLINE) {
+            // Processar mensagens MQTT (o TLS pode ter guardado mais de um
+            // pacote já decifrado, então lê até esvaziar)
+            do {
+                mqttClient.loop();
+            } while (mqttClient.connected() && secureClient.available() > 0);
+            estadoHeartbeat();
+        }
+        if (eventos & EVENTO_SOCKET) eventosSinalizar(EVENTO_SOCKET_LIDO);  // vigia volta ao select()
+
+        // Eventos novos vão para a flash; online, a janela do diário
+        // entra na fila do publicador antes de drenar
+        diario.servicar(millis(), link == LINK_ONLINE);
+        // Pausa e luzes para a NVS, depois de estabilizarem
+        partidaServicar(millis());
+        // Consumo das luzes: fecha a hora, grava e publica resumos
+        energiaServicar(millis());
+        // Automações locais: funcionam com ou sem broker
+        regras.servicar(millis());
+        // Luzes que esperavam o fade anterior acabar (e o registro delas)
+        comodosServicar(millis());
+
+        // Única tarefa que publica: esvazia a fila das outras tarefas
+        // (offline, só registra a queda para os produtores)
+        publicadorDrenar(mqttClient);
         
-        // Processar mensagens MQTT
-        mqttClient.loop();
-        
-        vTaskDelay(periodo);
+        uint32_t agora = millis();
+        uint32_t espera = gerenciadorConexao.prazoMs(agora);
+        uint32_t esperaDiario = diario.prazoMs(agora);
+        if (esperaDiario < espera) espera = esperaDiario;
+        uint32_t esperaPartida = partidaPrazoMs(agora);
+        if (esperaPartida < espera) espera = esperaPartida;
+        uint32_t esperaEnergia = energiaPrazoMs(agora);
+        if (esperaEnergia < espera) espera = esperaEnergia;
+        uint32_t esperaRegras = regras.prazoMs(agora);
+        if (esperaRegras < espera) espera = esperaRegras;
+        uint32_t esperaTransicao = transicaoPrazoMs(agora);
+        if (esperaTransicao < espera) espera = esperaTransicao;
+        if (espera > MQTT_ESPERA_MAX_MS) espera = MQTT_ESPERA_MAX_MS;
+        eventos = eventosEsperar(EVENTO_PUBLICAR | EVENTO_SOCKET | EVENTO_REDE | EVENTO_REGRAS,
+                                 espera);
+        eventosContarDespertar(TAREFA_MQTT);
     }
 }
 
 // ========================================================
-// TAREFA 4: CONTROLE DE LED E BUZZER (BLINK)
+// TAREFA 4: VIGIA DO SOCKET MQTT
 // ========================================================
-// Esta tarefa controla o piscar do LED vermelho e
-// o som do buzzer quando o alerta está ativo
-void taskLedBuzzer(void *parameter) {
-    Serial.println("[FreeRTOS] Task LED/Buzzer iniciada");
-    
-    const TickType_t periodoBlink = pdMS_TO_TICKS(100); // Blink a cada 100ms
-    TickType_t ultimoBlink = 0;
-    bool blinkState = false;
-    
+// Bloqueia no select() do lwIP até o socket do broker ficar
+// legível e então acorda a taskMQTT. Não toca no PubSubClient.
+void taskSocket(void *parameter) {
     for (;;) {
-        TickType_t tempoAtual = xTaskGetTickCount();
-        
-        // Proteger acesso ao estado
-        if (xSemaphoreTake(mutexEstado, pdMS_TO_TICKS(100)) == pdTRUE) {
-            bool pausado = alarmePausado;
-            bool alerta = alertaLatched;
-            
-            if (pausado) {
-                mostrarAlarmePausado();
-                blinkState = false;
-            } else if (alerta) {
-                // Piscar LED vermelho durante alerta
-                if (tempoAtual - ultimoBlink >= pdMS_TO_TICKS(100)) {
-                    blinkState = !blinkState;
-                    digitalWrite(LED_RED, blinkState ? HIGH : LOW);
-                    digitalWrite(LED_GREEN, LOW);
-                    digitalWrite(LED_BLUE, LOW);
-                    ultimoBlink = tempoAtual;
-                }
-                // Manter buzzer ativo
-                ledcWrite(BUZZER_CHANNEL, 128);
-                
-                // Publicar estado de alerta periodicamente
-                if (mqttClient.connected()) {
-                    mqttClient.publish(TOPICO_ESTADO, "ALERTA");
-                }
-            } else {
-                desligarAlerta();
-                blinkState = false;
-            }
-            
-            xSemaphoreGive(mutexEstado);
+        int fd = secureClient.fd();
+        if (fd < 0) {
+            eventosEsperar(EVENTO_CONECTADO, EVENTOS_PARA_SEMPRE);
+            eventosContarDespertar(TAREFA_SOCKET);
+            continue;
+        }
+
+        fd_set leitura;
+        FD_ZERO(&leitura);
+        FD_SET(fd, &leitura);
+        struct timeval limite = {(long)(MQTT_ESPERA_MAX_MS / 1000), 0};
+        int pronto = select(fd + 1, &leitura, NULL, NULL, &limite);
+        eventosContarDespertar(TAREFA_SOCKET);
+
+        if (pronto > 0) {
+            eventosSinalizar(EVENTO_SOCKET);
+            // Até a taskMQTT ler, o socket continua legível
+            eventosEsperar(EVENTO_SOCKET_LIDO, MQTT_ESPERA_MAX_MS);
+        } else if (pronto < 0) {
+            // Socket fechado no meio do select: espera a reconexão
+            eventosEsperar(EVENTO_CONECTADO, MQTT_ESPERA_MAX_MS);
         }
-        
-        vTaskDelay(pdMS_TO_TICKS(50)); // Verifica a cada 50ms
     }
 }
 
@@ -602,155 +390,376 @@ void taskLedBuzzer(void *parameter) {
 // SETUP
 // ========================================================
 void setup() {
+    // Sem espera pelo monitor serial: o que for logado antes dele
+    // abrir fica na fila da taskLog
     Serial.begin(115200);
-    delay(1500);
-    
-    Serial.println("\n===========================================");
-    Serial.println("  SISTEMA HOME ALARM COM FreeRTOS");
-    Serial.println("===========================================\n");
+
+    // Antes de qualquer publicar(): ele sinaliza a taskMQTT
+    eventosIniciar();
+
+    // Daqui em diante o Serial é só da taskLog
+    logIniciar();
+
+    LOG_INFO("===========================================");
+    LOG_INFO("  SISTEMA HOME ALARM COM FreeRTOS");
+    LOG_INFO("===========================================");
+
+    // Só o que é local até as tarefas do alarme existirem: flash do
+    // diário, TLS e WiFi ficam com a taskMQTT (partida.h)
 
     // Configuração de pinos
     pinMode(LED_RED, OUTPUT);
     pinMode(LED_GREEN, OUTPUT);
     pinMode(LED_BLUE, OUTPUT);
     pinMode(BUTTON_PIN, INPUT);
-    pinMode(TRIG_PIN, OUTPUT);
-    pinMode(ECHO_PIN, INPUT);
     
-    pinMode(LED_SALA_R, OUTPUT);
-    pinMode(LED_SALA_G, OUTPUT);
-    pinMode(LED_SALA_B, OUTPUT);
-    pinMode(LED_QUARTO_R, OUTPUT);
-    pinMode(LED_QUARTO_G, OUTPUT);
-    pinMode(LED_QUARTO_B, OUTPUT);
-
     // Configuração PWM do buzzer
     ledcSetup(BUZZER_CHANNEL, BUZZER_FREQ, BUZZER_RES);
     ledcAttachPin(BUZZER_PIN, BUZZER_CHANNEL);
     ledcWrite(BUZZER_CHANNEL, 0);
 
-    // Configuração PWM LEDs sala
-    ledcSetup(LED_SALA_R_CH, LED_PWM_FREQ, LED_PWM_RES);
-    ledcSetup(LED_SALA_G_CH, LED_PWM_FREQ, LED_PWM_RES);
-    ledcSetup(LED_SALA_B_CH, LED_PWM_FREQ, LED_PWM_RES);
-    ledcAttachPin(LED_SALA_R, LED_SALA_R_CH);
-    ledcAttachPin(LED_SALA_G, LED_SALA_G_CH);
-    ledcAttachPin(LED_SALA_B, LED_SALA_B_CH);
-    setSalaColor(0, 0, 0);
-
-    // Configuração PWM LEDs quarto
-    ledcSetup(LED_QUARTO_R_CH, LED_PWM_FREQ, LED_PWM_RES);
-    ledcSetup(LED_QUARTO_G_CH, LED_PWM_FREQ, LED_PWM_RES);
-    ledcSetup(LED_QUARTO_B_CH, LED_PWM_FREQ, LED_PWM_RES);
-    ledcAttachPin(LED_QUARTO_R, LED_QUARTO_R_CH);
-    ledcAttachPin(LED_QUARTO_G, LED_QUARTO_G_CH);
-    ledcAttachPin(LED_QUARTO_B, LED_QUARTO_B_CH);
-    setQuartoColor(0, 0, 0);
-
-    // TLS sem verificação de certificado (didático)
-    secureClient.setInsecure();
-
-    // Conectar WiFi (antes de criar tarefas que precisam de rede)
-    conectarWiFi();
-    mqttClient.setServer(MQTT_HOST, MQTT_PORT);
-    mqttClient.setCallback(mqttCallback);
+    // Bipes e piscada do alerta: taskBuzzer, no núcleo do alarme
+    padroesIniciar();
+
+    // Pinos e PWM das luzes de todos os cômodos (tabela em comodos.h)
+    comodosIniciar();
+
+    // Estado inicial, e por cima dele a pausa e as luzes de antes da
+    // queda de energia (NVS)
+    desligarAlerta();
+    partidaRestaurar();
+
+    // Automações salvas: valem desde já, antes de qualquer rede
+    regras.iniciar();
 
     // ========================================================
     // INICIALIZAR FREERTOS - CRIAÇÃO DE MUTEXES
     // ========================================================
-    Serial.println("\n[FreeRTOS] Criando recursos de sincronização...");
+    LOG_INFO("[FreeRTOS] Criando recursos de sincronização...");
     
-    mutexEstado = xSemaphoreCreateMutex();
     mutexDistancia = xSemaphoreCreateMutex();
     
-    if (mutexEstado == NULL || mutexDistancia == NULL) {
-        Serial.println("[FreeRTOS] ERRO: Falha ao criar mutexes!");
+    if (mutexDistancia == NULL) {
+        LOG_ERRO("[FreeRTOS] ERRO: Falha ao criar mutexes!");
         while(1) delay(1000); // Travar se falhar
     }
     
-    Serial.println("[FreeRTOS] Mutexes criados com sucesso!");
+    LOG_INFO("[FreeRTOS] Mutexes criados com sucesso!");
 
     // ========================================================
     // CRIAR TAREFAS DO FREERTOS
     // ========================================================
-    Serial.println("\n[FreeRTOS] Criando tarefas...");
+    LOG_INFO("[FreeRTOS] Criando tarefas...");
     
-    // Task 1: Sensor Ultrassônico (prioridade normal)
-    xTaskCreate(
+    // Handles só para as métricas (pilha e CPU de cada tarefa)
+    TaskHandle_t tarefa = NULL;
+    metricas.iniciar(PERIODO_SENSOR_MS);
+
+    // Task 1: Sensor Ultrassônico (prioridade alta, núcleo do alarme)
+    xTaskCreatePinnedToCore(
         taskSensorUltrassonico,      // Função da tarefa
         "TaskSensor",                // Nome da tarefa (para debug)
         STACK_SIZE_MEDIO,            // Tamanho da pilha
         NULL,                        // Parâmetros
-        PRIORIDADE_NORMAL,           // Prioridade
-        NULL                         // Handle da tarefa (opcional)
+        PRIORIDADE_ALTA,             // Prioridade
+        &tarefa,                     // Handle da tarefa (opcional)
+        NUCLEO_ALARME                // Núcleo (tarefas.h)
     );
+    metricasRegistrarTarefa(TAREFA_SENSOR, tarefa);
     
-    // Task 2: Botão (prioridade normal)
-    xTaskCreate(
+    // Task 2: Botão (prioridade alta, núcleo do alarme)
+    xTaskCreatePinnedToCore(
         taskBotao,
         "TaskBotao",
         STACK_SIZE_PEQUENO,
         NULL,
-        PRIORIDADE_NORMAL,
-        NULL
+        PRIORIDADE_ALTA,
+        &tarefa,
+        NUCLEO_ALARME
     );
+    metricasRegistrarTarefa(TAREFA_BOTAO, tarefa);
     
-    // Task 3: MQTT (prioridade normal)
-    xTaskCreate(
+    // Proteção local no ar; daqui para baixo é tudo rede, no outro núcleo
+
+    // Task 3: MQTT (prioridade normal, núcleo da rede)
+    xTaskCreatePinnedToCore(
         taskMQTT,
         "TaskMQTT",
         STACK_SIZE_GRANDE,  // MQTT precisa de mais stack
         NULL,
         PRIORIDADE_NORMAL,
-        NULL
+        &tarefa,
+        NUCLEO_REDE
     );
-    
-    // Task 4: LED/Buzzer (prioridade normal)
-    xTaskCreate(
-        taskLedBuzzer,
-        "TaskLED",
+    metricasRegistrarTarefa(TAREFA_MQTT, tarefa);
+
+    // Task 4: vigia do socket MQTT (prioridade normal, quase sempre bloqueada)
+    xTaskCreatePinnedToCore(
+        taskSocket,
+        "TaskSocket",
         STACK_SIZE_PEQUENO,
         NULL,
         PRIORIDADE_NORMAL,
-        NULL
+        &tarefa,
+        NUCLEO_REDE
     );
+    metricasRegistrarTarefa(TAREFA_SOCKET, tarefa);
     
-    Serial.println("Todas as tarefas criadas!");
-    Serial.println("  - Task Sensor Ultrassônico");
-    Serial.println("  - Task Botão");
-    Serial.println("  - Task MQTT");
-    Serial.println("  - Task LED/Buzzer");
-    Serial.println("\n===========================================");
-    Serial.println("  Sistema iniciado!");
-    Serial.println("===========================================\n");
-    
-    // Estado inicial
-    desligarAlerta();
+    // O setup() roda no loopTask, que vira o coletor das métricas
+    metricasRegistrarTarefa(METRICAS_TAREFA_LOOP, xTaskGetCurrentTaskHandle());
+
+    LOG_INFO("Todas as tarefas criadas!");
+    LOG_INFO("  - Task Sensor Ultrassônico");
+    LOG_INFO("  - Task Botão");
+    LOG_INFO("  - Task MQTT");
+    LOG_INFO("  - Task Socket");
+    LOG_INFO("  - Task Log");
+    LOG_INFO("  - Task Buzzer");
+    LOG_INFO("===========================================");
+    LOG_INFO("  Sistema iniciado em %lu ms!", (unsigned long)millis());
+    LOG_INFO("===========================================");
 }
 
 // ========================================================
-// LOOP PRINCIPAL
+// LOOP PRINCIPAL: MÉTRICAS
 // ========================================================
-void loop() {
-    static unsigned long ultimoDebug = 0;
-    unsigned long agora = millis();
-    
-    if (agora - ultimoDebug > 30000) { 
-        ultimoDebug = agora;
-        
-        Serial.println("\n[Debug] Status do sistema:");
-        Serial.print("  Heap livre: ");
-        Serial.print(ESP.getFreeHeap());
-        Serial.println(" bytes");
-        Serial.print("  Tarefas ativas: ");
-        Serial.println(uxTaskGetNumberOfTasks());
-        
-        if (xSemaphoreTake(mutexEstado, pdMS_TO_TICKS(500)) == pdTRUE) {
-            Serial.print("  Estado alarme: ");
-            Serial.println(alarmePausado ? "PAUSADO" : (alertaLatched ? "ALERTA" : "OK"));
-            xSemaphoreGive(mutexEstado);
+// O loopTask tem a menor prioridade de todas: coletar aqui nunca
+// atrasa sensor, botão ou MQTT (ver metricas.h)
+
+#if METRICAS_SERIAL
+// Linhas montadas em partes: cada LOG_INFO vira uma linha inteira
+static void anexar(char* linha, size_t& pos, const char* fmt, ...) {
+    if (pos >= LOG_LINHA_MAX) return;
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(linha + pos, LOG_LINHA_MAX - pos, fmt, args);
+    va_end(args);
+    if (n > 0) pos += n;
+}
+
+// Relatório legível da mesma janela que vai para TOPICO_METRICAS
+static void imprimirMetricas(const RelatorioMetricas& r) {
+    static uint32_t despertaresAnteriores[NUM_TAREFAS_MONITORADAS] = {0};
+    uint32_t intervaloMs = r.janelaMs ? r.janelaMs : 1;
+    char linha[LOG_LINHA_MAX];
+    size_t pos;
+
+    LOG_INFO("[Debug] Status do sistema:");
+    LOG_INFO("  Heap livre: %lu bytes (mínimo %lu, maior bloco %lu)",
+             (unsigned long)r.heapLivre, (unsigned long)r.heapMinimo,
+             (unsigned long)r.maiorBloco);
+    LOG_INFO("  Tarefas ativas: %lu", (unsigned long)uxTaskGetNumberOfTasks());
+
+    PublicadorStats pub = publicadorEstatisticas();
+    LOG_INFO("  Fila MQTT: %lu publicadas, %lu descartadas (cheia), "
+             "%lu grandes demais, %lu offline, %lu falhas, pico %lu/%d",
+             (unsigned long)pub.publicadas, (unsigned long)pub.descartadasCheia,
+             (unsigned long)pub.descartadasTamanho, (unsigned long)pub.descartadasOffline,
+             (unsigned long)pub.falhasEnvio, (unsigned long)pub.picoOcupacao,
+             PUBLICADOR_CAPACIDADE);
+
+    ConexaoStats con = gerenciadorConexao.estatisticas();
+    LOG_INFO("  Rede: %s | primeira conexão %lu ms | %lu quedas, %lu reconexões "
+             "(última %lu ms, pior %lu ms, offline %lu ms) | WiFi %lu tentativas "
+             "%lu timeouts | MQTT %lu tentativas %lu falhas",
+             nomeEstadoLink(gerenciadorConexao.estado()),
+             (unsigned long)con.primeiraConexaoMs, (unsigned long)con.quedas,
+             (unsigned long)con.reconexoes, (unsigned long)con.ultimaReconexaoMs,
+             (unsigned long)con.maxReconexaoMs, (unsigned long)con.offlineTotalMs,
+             (unsigned long)con.tentativasWifi, (unsigned long)con.timeoutsWifi,
+             (unsigned long)con.tentativasMqtt, (unsigned long)con.falhasMqtt);
+
+    TlsStats tls = medicoesTls.estatisticas();
+    LOG_INFO("  TLS: completo %lu× (médio %lu ms, máx %lu ms, heap máx %lu) | "
+             "retomado %lu× (médio %lu ms, máx %lu ms, heap máx %lu) | "
+             "%lu falhas (%lu certificado), %lu sessões recusadas",
+             (unsigned long)tls.completo.quantidade, (unsigned long)tls.completo.medioMs,
+             (unsigned long)tls.completo.maxMs, (unsigned long)tls.completo.maxHeap,
+             (unsigned long)tls.retomado.quantidade, (unsigned long)tls.retomado.medioMs,
+             (unsigned long)tls.retomado.maxMs, (unsigned long)tls.retomado.maxHeap,
+             (unsigned long)tls.falhas, (unsigned long)tls.falhasVerificacao,
+             (unsigned long)tls.sessoesRecusadas);
+
+    PartidaStats pa = partidaEstatisticas();
+    LOG_INFO("  Partida: armado em %lu ms, conectado em %lu ms | restaurado %s | "
+             "%lu gravações na NVS, %lu falhas",
+             (unsigned long)pa.armadoMs, (unsigned long)pa.conectadoMs,
+             pa.restaurado ? (pa.pausado ? "pausado" : "armado") : "nada",
+             (unsigned long)pa.gravacoes, (unsigned long)pa.falhasGravacao);
+
+    EnergiaStats en = energia.estatisticas();
+    LOG_INFO("  Energia: relógio %s, hora %lu | %lu mudanças, %lu descartadas | "
+             "%lu horas fechadas, %lu gravações na NVS, %lu falhas",
+             en.relogio ? "acertado" : "n/d", (unsigned long)energia.horaAtual(),
+             (unsigned long)en.eventos, (unsigned long)en.descartados,
+             (unsigned long)en.horasFechadas, (unsigned long)en.gravacoes,
+             (unsigned long)en.falhasGravacao);
+
+    RegrasStats rg = regras.estatisticas();
+    LOG_INFO("  Regras: %u ativas | %lu eventos, %lu disparos, %lu descartados | "
+             "pior avaliação %lu µs | %lu tabelas recusadas, %lu gravações, %lu falhas",
+             rg.regras, (unsigned long)rg.eventos, (unsigned long)rg.disparos,
+             (unsigned long)rg.descartados, (unsigned long)rg.avaliacaoMaxUs,
+             (unsigned long)rg.recusadas, (unsigned long)rg.gravacoes,
+             (unsigned long)rg.falhasGravacao);
+
+    LogStats lg = logEstatisticas();
+    LOG_INFO("  Log: %lu linhas, %lu descartadas, %lu truncadas, pico %lu/%d",
+             (unsigned long)lg.escritas, (unsigned long)lg.descartadas,
+             (unsigned long)lg.truncadas, (unsigned long)lg.picoOcupacao, LOG_CAPACIDADE);
+
+    // Despertares por segundo de cada tarefa desde o último relatório
+    pos = 0;
+    anexar(linha, pos, "  Despertares/s:");
+    for (uint8_t t = 0; t < NUM_TAREFAS_MONITORADAS; ++t) {
+        uint32_t total = eventosDespertares((TarefaMonitorada)t);
+        uint32_t delta = total - despertaresAnteriores[t];
+        despertaresAnteriores[t] = total;
+        anexar(linha, pos, " %s %.2f", nomeTarefaMonitorada((TarefaMonitorada)t),
+               delta * 1000.0 / intervaloMs);
+    }
+    if (r.ocioso != METRICAS_SEM_DADO) anexar(linha, pos, " | ocioso %u%%", r.ocioso);
+    else anexar(linha, pos, " | ocioso n/d (sem run time stats)");
+    LOG_INFO("%s", linha);
+
+    pos = 0;
+    anexar(linha, pos, "  Tarefas (CPU, pilha livre):");
+    for (uint8_t i = 0; i < r.tarefas; ++i) {
+        const MetricasTarefa& t = r.tarefa[i];
+        const char* nome = t.id == METRICAS_TAREFA_LOOP
+                               ? "loop"
+                               : nomeTarefaMonitorada((TarefaMonitorada)t.id);
+        if (t.cpu != METRICAS_SEM_DADO) {
+            anexar(linha, pos, " %s %u%% %lu", nome, t.cpu, (unsigned long)t.pilhaLivre);
+        } else {
+            anexar(linha, pos, " %s %lu", nome, (unsigned long)t.pilhaLivre);
+        }
+    }
+    LOG_INFO("%s", linha);
+
+    const Histograma& hi = metricas.intervalo();
+    pos = 0;
+    anexar(linha, pos, "  Intervalo do sensor (%% do período):");
+    for (uint8_t b = 0; b < hi.baldes(); ++b) {
+        if (b + 1 < hi.baldes()) anexar(linha, pos, " <=%lu:", (unsigned long)hi.limite(b));
+        else anexar(linha, pos, " >:");
+        anexar(linha, pos, "%lu", (unsigned long)r.intervalo[b]);
+    }
+    LOG_INFO("%s", linha);
+
+    const Histograma& ha = metricas.atraso();
+    pos = 0;
+    anexar(linha, pos, "  Atraso ao acordar (µs):");
+    for (uint8_t b = 0; b < ha.baldes(); ++b) {
+        if (b + 1 < ha.baldes()) anexar(linha, pos, " <=%lu:", (unsigned long)ha.limite(b));
+        else anexar(linha, pos, " >:");
+        anexar(linha, pos, "%lu", (unsigned long)r.atraso[b]);
+    }
+    anexar(linha, pos, " | máx %lu", (unsigned long)r.atrasoMaxUs);
+    LOG_INFO("%s", linha);
+
+    // Do eco ao estado publicado, desde o boot (latencia.h)
+    LOG_INFO("  Latência do alarme: %lu disparos, %lu incompletos",
+             (unsigned long)latencia.rastros(), (unsigned long)latencia.incompletos());
+    for (uint8_t m = MARCA_LIMIAR; m < NUM_MARCAS_LATENCIA; ++m) {
+        const Histograma& hl = latencia.etapa((MarcaLatencia)m);
+        uint32_t contagens[METRICAS_MAX_BALDES];
+        hl.ler(contagens);
+        pos = 0;
+        anexar(linha, pos, "    eco -> %-9s (µs):", nomeMarcaLatencia((MarcaLatencia)m));
+        for (uint8_t b = 0; b < hl.baldes(); ++b) {
+            if (b + 1 < hl.baldes()) anexar(linha, pos, " <=%lu:", (unsigned long)hl.limite(b));
+            else anexar(linha, pos, " >:");
+            anexar(linha, pos, "%lu", (unsigned long)contagens[b]);
         }
+        anexar(linha, pos, " | máx %lu", (unsigned long)hl.maximo());
+        LOG_INFO("%s", linha);
+    }
+
+    DiarioStats di = diario.estatisticas();
+    LOG_INFO("  Diário: %lu gravados, %lu pendentes (até id %lu confirmado), "
+             "%lu envios (%lu reenvios), descartados %lu fila / %lu cheio, "
+             "%lu inválidos, apagamentos máx %lu (%lu na hora de gravar)",
+             (unsigned long)di.gravados, (unsigned long)di.pendentes,
+             (unsigned long)di.confirmados, (unsigned long)di.enviados,
+             (unsigned long)di.reenvios, (unsigned long)di.descartadosFila,
+             (unsigned long)di.descartadosCheio, (unsigned long)di.invalidos,
+             (unsigned long)di.apagamentosMax, (unsigned long)di.apagadosNaHora);
+
+    AgendaStats ag = agendaSensores.estatisticas();
+    LOG_INFO("  Sensores: %u em %u grupos | %lu ciclos, ocupado %lu µs (máx %lu), "
+             "%lu passaram do período",
+             (unsigned)NUM_SENSORES, agendaSensores.grupos(), (unsigned long)ag.ciclos,
+             (unsigned long)ag.ocupadoUs, (unsigned long)ag.ocupadoMaxUs,
+             (unsigned long)ag.atrasados);
+    for (uint8_t i = 0; i < NUM_SENSORES; ++i) {
+        const Sensor& s = SENSORES[i];
+        UltrassomStats us = ultrassomEstatisticas(i);
+        LOG_INFO("    %s (zona %s, %u cm): %lu amostras, %lu sem eco | zona %s%s",
+                 s.nome, ZONAS[s.zona].nome, s.limiteCm, (unsigned long)us.amostras,
+                 (unsigned long)us.semEco, nomeEstado(zonaEstado(s.zona)),
+                 zonaPresenca(s.zona) ? ", presença" : "");
+    }
+
+    // Custo dos estágios no filtro do primeiro sensor (os outros
+    // rodam o mesmo código)
+    static const char* nomesEstagios[NUM_ESTAGIOS_FILTRO] = {
+        "outlier", "mediana", "ema", "confirmacao"};
+    for (uint8_t e = 0; e < NUM_ESTAGIOS_FILTRO; ++e) {
+        const EstagioStats& st = filtroSensor(0).estatisticas((EstagioFiltro)e);
+        uint32_t medio = st.chamadas ? st.ciclosTotal / st.chamadas : 0;
+        LOG_INFO("  Filtro %-11s: %lu ciclos médio, %lu máx, +%lu amostras de atraso",
+                 nomesEstagios[e], (unsigned long)medio, (unsigned long)st.ciclosMax,
+                 (unsigned long)filtroLatenciaAmostras(filtroSensor(0).config(), (EstagioFiltro)e));
     }
     
-    vTaskDelay(pdMS_TO_TICKS(1000));
+    // Leitura sem lock; conflitos = CAS perdidos entre tarefas
+    uint32_t versao;
+    EstadoAlarme estadoAlarme = maquinaAlarme.estado(versao);
+    MaquinaAlarmeStats ma = maquinaAlarme.estatisticas();
+    LOG_INFO("  Estado alarme: %s (v%lu) | %lu transições, %lu ignoradas, "
+             "%lu conflitos de CAS, pior caso %lu tentativas",
+             nomeEstado(estadoAlarme), (unsigned long)versao,
+             (unsigned long)ma.transicoes, (unsigned long)ma.ignoradas,
+             (unsigned long)ma.conflitos, (unsigned long)ma.maxTentativas);
+
+    RegistroTransicao recentes[4];
+    uint32_t n = maquinaAlarme.historico(recentes, 4);
+    for (uint32_t i = 0; i < n; ++i) {
+        LOG_INFO("    v%lu %lu ms: %s -> %s (%s)", (unsigned long)recentes[i].versao,
+                 (unsigned long)recentes[i].instanteMs, nomeEstado(recentes[i].de),
+                 nomeEstado(recentes[i].para), nomeEntradaAlarme(recentes[i].entrada));
+    }
+}
+#endif
+
+void loop() {
+    // Primeira janela começa no boot; CPU por tarefa só a partir da segunda
+    vTaskDelay(pdMS_TO_TICKS(METRICAS_PERIODO_MS));
+
+    AmostraSistema amostra;
+    metricasColetarSistema(amostra);
+    RelatorioMetricas r = metricas.fechar(amostra);
+
+    if (publicadorConectado()) {
+        uint8_t quadro[METRICAS_QUADRO_MAX];
+        size_t n = metricasCodificar(r, quadro, sizeof(quadro));
+        if (n > 0) publicarBinario(TOPICO_METRICAS, quadro, n);
+
+        // Latência do alarme: cumulativa e retida, então só sai
+        // quando algum disparo mexeu nela
+        static uint8_t ultimaLatencia[LATENCIA_QUADRO_MAX];
+        static size_t tamanhoLatencia = 0;
+        uint8_t lat[LATENCIA_QUADRO_MAX];
+        size_t nl = latencia.rastros() ? latencia.codificar(lat, sizeof(lat)) : 0;
+        if (nl > 0 && (nl != tamanhoLatencia || memcmp(lat, ultimaLatencia, nl) != 0) &&
+            publicarBinario(TOPICO_LATENCIA, lat, nl, true)) {
+            memcpy(ultimaLatencia, lat, nl);
+            tamanhoLatencia = nl;
+        }
+    }
+
+#if METRICAS_SERIAL
+    imprimirMetricas(r);
+#endif
 }
\ No newline at end of file
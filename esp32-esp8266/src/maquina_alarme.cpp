@@ -0,0 +1,107 @@
+#include "maquina_alarme.h"
+
+// Cabeçalho de uma posição do histórico:
+//   bits 0..3 para, 4..7 de, 8..11 entrada, 12..31 versão (20 bits)
+static uint32_t empacotar(uint32_t versao, EstadoAlarme de, EstadoAlarme para, EntradaAlarme entrada) {
+    return ((versao & 0xFFFFF) << 12) | ((uint32_t)entrada << 8) | ((uint32_t)de << 4) | para;
+}
+
+const char* nomeEntradaAlarme(EntradaAlarme entrada) {
+    switch (entrada) {
+        case ENTRADA_DETECCAO:       return "DETECCAO";
+        case ENTRADA_SILENCIAR:      return "SILENCIAR";
+        case ENTRADA_PARAR:          return "PARAR";
+        case ENTRADA_PAUSAR:         return "PAUSAR";
+        case ENTRADA_RETOMAR:        return "RETOMAR";
+        case ENTRADA_ALTERNAR_PAUSA: return "ALTERNAR_PAUSA";
+        default:                     return "?";
+    }
+}
+
+MaquinaAlarme::MaquinaAlarme() {
+    reiniciar();
+}
+
+void MaquinaAlarme::reiniciar() {
+    palavra_.store(ESTADO_OK);
+    for (Posicao& p : historico_) {
+        p.cabecalho.store(0);
+        p.instanteMs.store(0);
+    }
+    transicoes_.store(0);
+    ignoradas_.store(0);
+    conflitos_.store(0);
+    maxTentativas_.store(0);
+}
+
+TransicaoAlarme MaquinaAlarme::aplicar(EntradaAlarme entrada, uint32_t agoraMs) {
+    uint32_t atual = palavra_.load(std::memory_order_acquire);
+    uint32_t tentativas = 1;
+
+    for (;;) {
+        EstadoAlarme de = (EstadoAlarme)(atual & 0xFF);
+        EstadoAlarme para = proximoEstadoAlarme(de, entrada);
+        if (para == de) {
+            ignoradas_.fetch_add(1, std::memory_order_relaxed);
+            return {false, de, de, atual >> 8};
+        }
+
+        uint32_t versao = (atual >> 8) + 1;
+        uint32_t nova = (versao << 8) | para;
+        // Em caso de falha "atual" recebe o valor vencedor
+        if (palavra_.compare_exchange_weak(atual, nova, std::memory_order_acq_rel,
+                                           std::memory_order_acquire)) {
+            transicoes_.fetch_add(1, std::memory_order_relaxed);
+            uint32_t pior = maxTentativas_.load(std::memory_order_relaxed);
+            while (tentativas > pior &&
+                   !maxTentativas_.compare_exchange_weak(pior, tentativas, std::memory_order_relaxed)) {
+            }
+            registrar(versao, de, para, entrada, agoraMs);
+            return {true, de, para, versao};
+        }
+        conflitos_.fetch_add(1, std::memory_order_relaxed);
+        ++tentativas;
+    }
+}
+
+void MaquinaAlarme::registrar(uint32_t versao, EstadoAlarme de, EstadoAlarme para,
+                              EntradaAlarme entrada, uint32_t agoraMs) {
+    // Versões são únicas, então cada vencedor escreve a sua posição
+    Posicao& p = historico_[versao & (MAQUINA_HISTORICO - 1)];
+    p.cabecalho.store(0);
+    p.instanteMs.store(agoraMs);
+    p.cabecalho.store(empacotar(versao, de, para, entrada));
+}
+
+uint32_t MaquinaAlarme::historico(RegistroTransicao* saida, uint32_t max) const {
+    uint32_t ultima = versao();
+    uint32_t primeira = ultima > MAQUINA_HISTORICO ? ultima - MAQUINA_HISTORICO + 1 : 1;
+    if (ultima - primeira + 1 > max) primeira = ultima - max + 1;
+
+    uint32_t n = 0;
+    for (uint32_t v = primeira; v <= ultima && ultima != 0; ++v) {
+        const Posicao& p = historico_[v & (MAQUINA_HISTORICO - 1)];
+        uint32_t c1 = p.cabecalho.load();
+        uint32_t instante = p.instanteMs.load();
+        uint32_t c2 = p.cabecalho.load();
+        // Vazia, sendo reescrita ou já de outra volta do anel
+        if (c1 == 0 || c1 != c2 || (c1 >> 12) != (v & 0xFFFFF)) continue;
+
+        RegistroTransicao& r = saida[n++];
+        r.versao = v;
+        r.para = (EstadoAlarme)(c1 & 0xF);
+        r.de = (EstadoAlarme)((c1 >> 4) & 0xF);
+        r.entrada = (EntradaAlarme)((c1 >> 8) & 0xF);
+        r.instanteMs = instante;
+    }
+    return n;
+}
+
+MaquinaAlarmeStats MaquinaAlarme::estatisticas() const {
+    MaquinaAlarmeStats s;
+    s.transicoes = transicoes_.load(std::memory_order_relaxed);
+    s.ignoradas = ignoradas_.load(std::memory_order_relaxed);
+    s.conflitos = conflitos_.load(std::memory_order_relaxed);
+    s.maxTentativas = maxTentativas_.load(std::memory_order_relaxed);
+    return s;
+}
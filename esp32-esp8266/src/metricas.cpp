@@ -0,0 +1,173 @@
+#include "metricas.h"
+#include "binario.h"
+
+#include <string.h>
+
+#include "conexao.h"
+#include "publicador.h"
+
+Metricas metricas;
+
+// ========================================================
+// HISTOGRAMA
+// ========================================================
+void Histograma::configurar(const uint32_t* limites, uint8_t baldes) {
+    if (baldes > METRICAS_MAX_BALDES) baldes = METRICAS_MAX_BALDES;
+    for (uint8_t i = 0; i < baldes; ++i) limites_[i] = limites[i];
+    baldes_ = baldes;
+}
+
+void Histograma::registrar(uint32_t valor) {
+    if (baldes_ == 0) return;
+    uint8_t b = 0;
+    while (b < baldes_ - 1 && valor > limites_[b]) ++b;
+    contagens_[b].fetch_add(1, std::memory_order_relaxed);
+
+    uint32_t max = maximo_.load(std::memory_order_relaxed);
+    while (valor > max &&
+           !maximo_.compare_exchange_weak(max, valor, std::memory_order_relaxed)) {
+    }
+}
+
+void Histograma::ler(uint32_t contagens[METRICAS_MAX_BALDES]) const {
+    for (uint8_t i = 0; i < METRICAS_MAX_BALDES; ++i) {
+        contagens[i] = contagens_[i].load(std::memory_order_relaxed);
+    }
+}
+
+// ========================================================
+// COLETA
+// ========================================================
+void Metricas::iniciar(uint32_t periodoSensorMs) {
+    periodoSensorMs_ = periodoSensorMs;
+
+    // Intervalo em % do período: no ritmo, atrasado, amostra perdida
+    static const uint32_t limitesIntervalo[METRICAS_BALDES_INTERVALO] = {
+        95, 105, 125, 150, 200, 400, UINT32_MAX};
+    static const uint32_t limitesAtraso[METRICAS_BALDES_ATRASO] = {
+        250, 500, 1000, 2000, 5000, 10000, 50000, UINT32_MAX};
+    intervalo_.configurar(limitesIntervalo, METRICAS_BALDES_INTERVALO);
+    atraso_.configurar(limitesAtraso, METRICAS_BALDES_ATRASO);
+}
+
+void Metricas::amostraSensor(uint32_t agoraUs) {
+    if (temAmostra_ && periodoSensorMs_ > 0) {
+        uint32_t dUs = agoraUs - ultimaAmostraUs_;
+        intervalo_.registrar((uint32_t)((uint64_t)dUs / 10 / periodoSensorMs_));  // % do período
+    }
+    ultimaAmostraUs_ = agoraUs;
+    temAmostra_ = true;
+}
+
+void Metricas::despertou(int32_t desvioUs) {
+    // O vTaskDelay() pode acordar até um tick antes: conta o módulo
+    atraso_.registrar(desvioUs < 0 ? (uint32_t)-desvioUs : (uint32_t)desvioUs);
+}
+
+uint8_t metricasParcela(uint32_t dExecucao, uint32_t dRelogio) {
+    if (dRelogio == 0) return METRICAS_SEM_DADO;
+    uint64_t p = (uint64_t)dExecucao * 100 / dRelogio;
+    return p > 100 ? 100 : (uint8_t)p;
+}
+
+RelatorioMetricas Metricas::fechar(const AmostraSistema& atual) {
+    RelatorioMetricas r;
+    memset(&r, 0, sizeof(r));
+    r.janelaMs = temAnterior_ ? atual.instanteMs - anterior_.instanteMs : atual.instanteMs;
+    r.uptimeMs = atual.instanteMs;
+    r.heapLivre = atual.heapLivre;
+    r.heapMinimo = atual.heapMinimo;
+    r.maiorBloco = atual.maiorBloco;
+
+    // Contadores cumulativos de outros módulos: a janela é a diferença
+    PublicadorStats pub = publicadorEstatisticas();
+    uint32_t descartadas = pub.descartadasCheia + pub.descartadasTamanho + pub.descartadasOffline;
+    r.publicadas = pub.publicadas - publicadas_;
+    r.descartadas = descartadas - descartadas_;
+    r.falhasEnvio = pub.falhasEnvio - falhasEnvio_;
+    publicadas_ = pub.publicadas;
+    descartadas_ = descartadas;
+    falhasEnvio_ = pub.falhasEnvio;
+
+    ConexaoStats con = gerenciadorConexao.estatisticas();
+    r.quedas = con.quedas;
+    r.reconexoes = con.reconexoes;
+    r.falhasMqtt = con.falhasMqtt;
+
+    // CPU: precisa de duas amostras com o contador de execução
+    bool cpu = atual.temExecucao && temAnterior_ && anterior_.temExecucao;
+    uint32_t dRelogio = atual.relogio - anterior_.relogio;
+    r.ocioso = cpu && atual.nucleos
+                   ? metricasParcela(atual.ocioso - anterior_.ocioso, dRelogio * atual.nucleos)
+                   : METRICAS_SEM_DADO;
+
+    r.tarefas = atual.tarefas;
+    for (uint8_t i = 0; i < atual.tarefas; ++i) {
+        const AmostraTarefa& t = atual.tarefa[i];
+        r.tarefa[i].id = t.id;
+        r.tarefa[i].pilhaLivre = t.pilhaLivre;
+        r.tarefa[i].cpu = METRICAS_SEM_DADO;
+        if (!cpu) continue;
+        // Procura pelo id: a tarefa pode ter sido registrada depois
+        for (uint8_t j = 0; j < anterior_.tarefas; ++j) {
+            if (anterior_.tarefa[j].id != t.id) continue;
+            r.tarefa[i].cpu = metricasParcela(t.execucao - anterior_.tarefa[j].execucao, dRelogio);
+            break;
+        }
+    }
+
+    uint32_t cont[METRICAS_MAX_BALDES];
+    intervalo_.ler(cont);
+    for (uint8_t b = 0; b < METRICAS_MAX_BALDES; ++b) {
+        r.intervalo[b] = cont[b] - intervaloAnt_[b];
+        intervaloAnt_[b] = cont[b];
+    }
+    atraso_.ler(cont);
+    for (uint8_t b = 0; b < METRICAS_MAX_BALDES; ++b) {
+        r.atraso[b] = cont[b] - atrasoAnt_[b];
+        atrasoAnt_[b] = cont[b];
+    }
+    r.atrasoMaxUs = atraso_.maximo();
+
+    anterior_ = atual;
+    temAnterior_ = true;
+    return r;
+}
+
+// ========================================================
+// QUADRO
+// ========================================================
+
+size_t metricasCodificar(const RelatorioMetricas& r, uint8_t* buf, size_t tamanho) {
+    Escritor e = {buf, tamanho, 0, true};
+    e.u8(METRICAS_VERSAO);
+    bool cpu = false;
+    for (uint8_t i = 0; i < r.tarefas; ++i) cpu |= r.tarefa[i].cpu != METRICAS_SEM_DADO;
+    e.u8(cpu ? 1 : 0);
+    e.u16(r.janelaMs / 1000);
+    e.u32(r.uptimeMs / 1000);
+    e.u32(r.heapLivre);
+    e.u32(r.heapMinimo);
+    e.u32(r.maiorBloco);
+    e.u16(r.publicadas);
+    e.u16(r.descartadas);
+    e.u16(r.falhasEnvio);
+    e.u16(r.quedas);
+    e.u16(r.reconexoes);
+    e.u16(r.falhasMqtt);
+    e.u8(r.ocioso);
+
+    e.u8(r.tarefas);
+    for (uint8_t i = 0; i < r.tarefas; ++i) {
+        e.u8(r.tarefa[i].id);
+        e.u8(r.tarefa[i].cpu);
+        e.u16(r.tarefa[i].pilhaLivre);
+    }
+
+    e.u8(METRICAS_BALDES_INTERVALO);
+    for (uint8_t b = 0; b < METRICAS_BALDES_INTERVALO; ++b) e.u16(r.intervalo[b]);
+    e.u8(METRICAS_BALDES_ATRASO);
+    for (uint8_t b = 0; b < METRICAS_BALDES_ATRASO; ++b) e.u16(r.atraso[b]);
+
+    return e.cabe ? e.pos : 0;
+}
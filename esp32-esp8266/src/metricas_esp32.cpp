@@ -0,0 +1,68 @@
+// Coleta do lado do ESP32: heap pelo heap_caps e tarefas pelo
+// vTaskGetInfo(). Roda no loop(); as tarefas medidas não param.
+#include "metricas.h"
+
+#include <Arduino.h>
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+namespace {
+
+TaskHandle_t tarefas[METRICAS_MAX_TAREFAS];
+uint8_t ids[METRICAS_MAX_TAREFAS];
+std::atomic<uint8_t> quantidade{0};
+
+// eRunning evita o eTaskGetState(), que entra em seção crítica; o
+// estado não é usado. Com pdTRUE ele varre a pilha atrás da marca
+// d'água, sem lock.
+void lerTarefa(TaskHandle_t t, TaskStatus_t& st) {
+    vTaskGetInfo(t, &st, pdTRUE, eRunning);
+}
+
+}  // namespace
+
+// Chamado no setup(), logo depois de cada xTaskCreate()
+void metricasRegistrarTarefa(uint8_t id, void* tarefa) {
+    uint8_t n = quantidade.load(std::memory_order_relaxed);
+    if (tarefa == NULL || n >= METRICAS_MAX_TAREFAS) return;
+    tarefas[n] = (TaskHandle_t)tarefa;
+    ids[n] = id;
+    quantidade.store(n + 1, std::memory_order_release);
+}
+
+void metricasColetarSistema(AmostraSistema& a) {
+    a.instanteMs = millis();
+    a.heapLivre = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    a.heapMinimo = heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT);
+    a.maiorBloco = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+    a.nucleos = portNUM_PROCESSORS;
+
+    TaskStatus_t st;
+    uint8_t n = quantidade.load(std::memory_order_acquire);
+    a.tarefas = n;
+    for (uint8_t i = 0; i < n; ++i) {
+        lerTarefa(tarefas[i], st);
+        a.tarefa[i].id = ids[i];
+        a.tarefa[i].pilhaLivre = st.usStackHighWaterMark * sizeof(StackType_t);
+#if configGENERATE_RUN_TIME_STATS
+        a.tarefa[i].execucao = st.ulRunTimeCounter;
+#else
+        a.tarefa[i].execucao = 0;
+#endif
+    }
+
+#if configGENERATE_RUN_TIME_STATS
+    a.temExecucao = true;
+    a.relogio = portGET_RUN_TIME_COUNTER_VALUE();
+    a.ocioso = 0;
+    for (BaseType_t cpu = 0; cpu < portNUM_PROCESSORS; ++cpu) {
+        lerTarefa(xTaskGetIdleTaskHandleForCPU(cpu), st);
+        a.ocioso += st.ulRunTimeCounter;
+    }
+#else
+    a.temExecucao = false;
+    a.relogio = 0;
+    a.ocioso = 0;
+#endif
+}
@@ -0,0 +1,152 @@
+#include "padroes.h"
+#include "fila_lockfree.h"
+#include "hal.h"
+#include "latencia.h"
+#include "pinos.h"
+
+#include <atomic>
+
+namespace {
+
+struct PassoPadrao {
+    uint8_t buzzer;     // duty do buzzer
+    int8_t vermelho;    // LED_RED: 1, 0 ou -1 (não mexe)
+    uint16_t duracaoMs; // até o próximo passo
+};
+
+struct DefinicaoPadrao {
+    const PassoPadrao* passos;
+    uint8_t quantidade;
+    bool deFundo;
+};
+
+const PassoPadrao BEEP_CURTO[] = {
+    {128, -1, 60},
+    {0, -1, 0},
+};
+
+const PassoPadrao BEEP_TRIPLO[] = {
+    {128, -1, 120}, {0, -1, 80},
+    {128, -1, 120}, {0, -1, 80},
+    {128, -1, 120}, {0, -1, 0},
+};
+
+const PassoPadrao ALERTA[] = {
+    {128, 1, 100},
+    {128, 0, 100},
+};
+
+#define DEFINICAO(passos, deFundo) { passos, sizeof(passos) / sizeof(passos[0]), deFundo }
+
+const DefinicaoPadrao DEFINICOES[NUM_PADROES] = {
+    {nullptr, 0, false},             // PADRAO_NENHUM
+    DEFINICAO(BEEP_CURTO, false),
+    DEFINICAO(BEEP_TRIPLO, false),
+    DEFINICAO(ALERTA, true),
+};
+
+FilaLockFree<uint8_t, 8> avulsos;
+std::atomic<uint8_t> fundoPedido{PADRAO_NENHUM};
+std::atomic<bool> rodando{false};
+
+// Estado do passo atual: só o driver escreve ("atual" é
+// lido por padraoParar para saber se precisa cortar o passo)
+std::atomic<uint8_t> atual{PADRAO_NENHUM};
+uint8_t passo = 0;
+
+void executar(const PassoPadrao& p) {
+    ledcWrite(BUZZER_CHANNEL, p.buzzer);
+    if (p.vermelho >= 0) digitalWrite(LED_RED, p.vermelho ? HIGH : LOW);
+}
+
+void silenciar() {
+    ledcWrite(BUZZER_CHANNEL, 0);
+}
+
+// Acorda o sequenciador se ele estiver parado
+void acordar() {
+    if (!rodando.exchange(true)) padroesAgendar(0);
+}
+
+// Escolhe o que tocar a seguir: avulsos primeiro, depois o fundo
+bool escolherProximo() {
+    uint8_t p;
+    if (avulsos.desenfileirar(p)) {
+        atual = p;
+        passo = 0;
+        return true;
+    }
+    uint8_t fundo = fundoPedido.load();
+    if (fundo != PADRAO_NENHUM) {
+        atual = fundo;
+        passo = 0;
+        return true;
+    }
+    atual = PADRAO_NENHUM;
+    return false;
+}
+
+}  // namespace
+
+bool padraoTocar(Padrao padrao) {
+    if (padrao == PADRAO_NENHUM || padrao >= NUM_PADROES) return false;
+
+    if (DEFINICOES[padrao].deFundo) {
+        if (fundoPedido.exchange(padrao) != padrao) acordar();
+        return true;
+    }
+
+    if (!avulsos.enfileirar(padrao)) return false;
+    acordar();
+    return true;
+}
+
+void padraoParar(Padrao padrao) {
+    uint8_t esperado = padrao;
+    if (!fundoPedido.compare_exchange_strong(esperado, PADRAO_NENHUM)) return;
+
+    // Se o fundo está tocando agora, corta o passo em andamento; um
+    // bipe avulso em andamento termina no tempo dele.
+    if (rodando.load() && atual.load() == padrao) padroesAgendar(0);
+}
+
+Padrao padraoDeFundo() {
+    return (Padrao)fundoPedido.load();
+}
+
+uint32_t padroesAvancar() {
+    for (;;) {
+        uint8_t tocando = atual.load();
+
+        // Fundo desligado no meio: volta o LED e o buzzer ao repouso
+        if (tocando != PADRAO_NENHUM && DEFINICOES[tocando].deFundo &&
+            fundoPedido.load() != tocando) {
+            silenciar();
+            digitalWrite(LED_RED, LOW);
+            tocando = PADRAO_NENHUM;
+        }
+
+        // Fim do padrão (ou de um ciclo do fundo): avulsos pendentes
+        // tocam antes de o fundo repetir
+        if (tocando == PADRAO_NENHUM || passo >= DEFINICOES[tocando].quantidade) {
+            if (!escolherProximo()) {
+                silenciar();
+                rodando.store(false);
+                // Alguém enfileirou entre a escolha e o store acima?
+                if ((avulsos.ocupacao() > 0 || fundoPedido.load() != PADRAO_NENHUM) &&
+                    !rodando.exchange(true)) {
+                    continue;
+                }
+                return 0;
+            }
+            tocando = atual.load();
+        }
+
+        const PassoPadrao& p = DEFINICOES[tocando].passos[passo++];
+        executar(p);
+        // Som do alerta: marca de sirene do disparo (latencia.h)
+        if (tocando == PADRAO_ALERTA && p.buzzer > 0) latencia.marcar(MARCA_SIRENE, micros());
+        if (p.duracaoMs > 0) return p.duracaoMs;
+        // Passo de duração zero: aplica e segue para o próximo já
+    }
+}
@@ -0,0 +1,45 @@
+// Driver do sequenciador de padrões no ESP32: a taskBuzzer, presa ao
+// núcleo do alarme acima do sensor (tarefas.h). Dorme na notificação
+// com o prazo do passo atual; padroesAgendar() troca o prazo. Só ela
+// chama padroesAvancar(), então ele nunca executa em paralelo.
+#include "padroes.h"
+#include "eventos.h"
+#include "metricas.h"
+#include "tarefas.h"
+
+#include <Arduino.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#define PADROES_PILHA 2048
+
+static TaskHandle_t tarefaPadroes = NULL;
+
+static void taskBuzzer(void*) {
+    bool agendado = false;
+    uint32_t proximoMs = 0;
+    for (;;) {
+        TickType_t espera = agendado ? pdMS_TO_TICKS(proximoMs) : portMAX_DELAY;
+        uint32_t pedidoMs;
+        if (espera > 0 && xTaskNotifyWait(0, UINT32_MAX, &pedidoMs, espera) == pdTRUE) {
+            // Reagendamento: o prazo conta a partir de agora
+            agendado = true;
+            proximoMs = pedidoMs;
+            continue;
+        }
+        eventosContarDespertar(TAREFA_BUZZER);
+        proximoMs = padroesAvancar();
+        agendado = proximoMs > 0;
+    }
+}
+
+void padroesIniciar() {
+    xTaskCreatePinnedToCore(taskBuzzer, "TaskBuzzer", PADROES_PILHA, NULL, PRIORIDADE_SIRENE,
+                            &tarefaPadroes, NUCLEO_ALARME);
+    metricasRegistrarTarefa(TAREFA_BUZZER, tarefaPadroes);
+}
+
+void padroesAgendar(uint32_t ms) {
+    if (tarefaPadroes == NULL) return;
+    xTaskNotify(tarefaPadroes, ms, eSetValueWithOverwrite);
+}
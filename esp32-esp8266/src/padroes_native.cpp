@@ -0,0 +1,11 @@
+// Driver do sequenciador no ambiente native: não há timer, só guarda
+// o próximo agendamento para os testes chamarem padroesAvancar().
+#include "padroes.h"
+
+long padroesNativeProximoMs = -1;
+
+void padroesIniciar() {}
+
+void padroesAgendar(uint32_t ms) {
+    padroesNativeProximoMs = (long)ms;
+}
@@ -0,0 +1,177 @@
+#include "partida.h"
+#include "alarme.h"
+#include "comodos.h"
+#include "log.h"
+
+#include <stdio.h>
+#include <string.h>
+
+namespace {
+
+std::atomic<uint32_t> armadoMs{0};
+std::atomic<uint32_t> conectadoMs{0};
+std::atomic<uint32_t> gravacoes{0};
+std::atomic<uint32_t> falhasGravacao{0};
+
+// Escritos no setup(), antes de existir outra tarefa
+bool restaurado = false;
+bool pausadoRestaurado = false;
+uint8_t luzesRestauradas = 0;
+
+// ---------------- Estado do gravador (só a taskMQTT) ----------------
+uint8_t gravado[PARTIDA_BYTES_MAX];  // o que está na NVS
+size_t tamanhoGravado = 0;
+uint8_t pendente[PARTIDA_BYTES_MAX]; // mudança esperando estabilizar
+size_t tamanhoPendente = 0;
+uint32_t pendenteDesdeMs = 0;
+
+// Chamado a cada amostra do sensor: depois da primeira, só um load
+bool marcar(std::atomic<uint32_t>& marco, uint32_t agoraMs) {
+    uint32_t zero = 0;
+    if (marco.load(std::memory_order_relaxed) != 0) return false;
+    return marco.compare_exchange_strong(zero, agoraMs ? agoraMs : 1, std::memory_order_relaxed);
+}
+
+bool iguais(const uint8_t* a, size_t na, const uint8_t* b, size_t nb) {
+    return na == nb && memcmp(a, b, na) == 0;
+}
+
+}  // namespace
+
+// ========================================================
+// FORMATO
+// ========================================================
+size_t estadoSalvoCodificar(const EstadoSalvo& e, uint8_t* buf, size_t tamanho) {
+    if (tamanho < PARTIDA_BYTES_MAX) return 0;
+    size_t pos = 0;
+    buf[pos++] = PARTIDA_VERSAO;
+    buf[pos++] = e.pausado ? 1 : 0;
+    buf[pos++] = NUM_COMODOS;
+    for (size_t i = 0; i < NUM_COMODOS; ++i) {
+        for (int cor = 0; cor < 3; ++cor) buf[pos++] = e.cores[i][cor];
+    }
+    return pos;
+}
+
+bool estadoSalvoDecodificar(const uint8_t* buf, size_t tamanho, EstadoSalvo& e) {
+    if (tamanho != PARTIDA_BYTES_MAX) return false;
+    if (buf[0] != PARTIDA_VERSAO || buf[2] != NUM_COMODOS) return false;
+    e.pausado = (buf[1] & 1) != 0;
+    size_t pos = 3;
+    for (size_t i = 0; i < NUM_COMODOS; ++i) {
+        for (int cor = 0; cor < 3; ++cor) e.cores[i][cor] = buf[pos++];
+    }
+    return true;
+}
+
+EstadoSalvo estadoSalvoAtual() {
+    EstadoSalvo e;
+    e.pausado = alarmeEstado() == ESTADO_PAUSADO;
+    for (size_t i = 0; i < NUM_COMODOS; ++i) {
+        e.cores[i][0] = estadosComodos[i].r;
+        e.cores[i][1] = estadosComodos[i].g;
+        e.cores[i][2] = estadosComodos[i].b;
+    }
+    return e;
+}
+
+// ========================================================
+// BOOT
+// ========================================================
+bool partidaRestaurar() {
+    uint8_t buf[PARTIDA_BYTES_MAX];
+    size_t n = partidaNvsLer(buf, sizeof(buf));
+    EstadoSalvo e;
+    restaurado = n > 0 && estadoSalvoDecodificar(buf, n, e);
+    pausadoRestaurado = false;
+    luzesRestauradas = 0;
+
+    if (restaurado) {
+        if (e.pausado) {
+            alarmeRestaurarPausa();
+            pausadoRestaurado = true;
+        }
+        for (size_t i = 0; i < NUM_COMODOS; ++i) {
+            const uint8_t* c = e.cores[i];
+            if (c[0] == 0 && c[1] == 0 && c[2] == 0) continue;
+            aplicarCorComodo(i, c[0], c[1], c[2]);
+            ++luzesRestauradas;
+        }
+        LOG_INFO("[Partida] Estado restaurado: %s, %u luzes acesas",
+                 pausadoRestaurado ? "pausado" : "armado", luzesRestauradas);
+    } else {
+        LOG_INFO("[Partida] Nenhum estado salvo: armado, luzes apagadas");
+    }
+
+    // Já é o que está na NVS (ou o padrão): nada a regravar
+    tamanhoGravado = estadoSalvoCodificar(estadoSalvoAtual(), gravado, sizeof(gravado));
+    tamanhoPendente = 0;
+    return restaurado;
+}
+
+// ========================================================
+// GRAVAÇÃO (taskMQTT)
+// ========================================================
+void partidaServicar(uint32_t agoraMs) {
+    uint8_t atual[PARTIDA_BYTES_MAX];
+    size_t n = estadoSalvoCodificar(estadoSalvoAtual(), atual, sizeof(atual));
+
+    if (iguais(atual, n, gravado, tamanhoGravado)) {
+        tamanhoPendente = 0;  // voltou ao que já estava gravado
+        return;
+    }
+    if (!iguais(atual, n, pendente, tamanhoPendente)) {
+        memcpy(pendente, atual, n);
+        tamanhoPendente = n;
+        pendenteDesdeMs = agoraMs;
+        return;
+    }
+    if (agoraMs - pendenteDesdeMs < PARTIDA_ESTAVEL_MS) return;
+
+    if (partidaNvsGravar(atual, n)) {
+        memcpy(gravado, atual, n);
+        tamanhoGravado = n;
+        tamanhoPendente = 0;
+        gravacoes.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        // Tenta de novo depois de outro intervalo
+        pendenteDesdeMs = agoraMs;
+        falhasGravacao.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+uint32_t partidaPrazoMs(uint32_t agoraMs) {
+    if (tamanhoPendente == 0) return UINT32_MAX;
+    uint32_t passou = agoraMs - pendenteDesdeMs;
+    return passou >= PARTIDA_ESTAVEL_MS ? 0 : PARTIDA_ESTAVEL_MS - passou;
+}
+
+// ========================================================
+// MARCOS
+// ========================================================
+bool partidaArmado(uint32_t agoraMs) {
+    return marcar(armadoMs, agoraMs);
+}
+
+bool partidaConectado(uint32_t agoraMs) {
+    return marcar(conectadoMs, agoraMs);
+}
+
+PartidaStats partidaEstatisticas() {
+    PartidaStats s;
+    s.armadoMs = armadoMs.load(std::memory_order_relaxed);
+    s.conectadoMs = conectadoMs.load(std::memory_order_relaxed);
+    s.restaurado = restaurado;
+    s.pausado = pausadoRestaurado;
+    s.luzes = luzesRestauradas;
+    s.gravacoes = gravacoes.load(std::memory_order_relaxed);
+    s.falhasGravacao = falhasGravacao.load(std::memory_order_relaxed);
+    return s;
+}
+
+size_t formatarPartida(char* buf, size_t tamanho, const PartidaStats& s) {
+    int n = snprintf(buf, tamanho, "%lu,%lu,%s,%u", (unsigned long)s.armadoMs,
+                     (unsigned long)s.conectadoMs, s.pausado ? "PAUSADO" : "ARMADO", s.luzes);
+    if (n < 0) return 0;
+    return (size_t)n < tamanho ? (size_t)n : tamanho - 1;
+}
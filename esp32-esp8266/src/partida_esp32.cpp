@@ -0,0 +1,18 @@
+// Estado salvo na NVS. Ler roda no setup(); gravar, só na taskMQTT.
+#include "partida.h"
+#include "armazenamento.h"
+
+namespace {
+
+const char* NVS_NAMESPACE = "partida";
+const char* NVS_CHAVE = "estado";
+
+}  // namespace
+
+size_t partidaNvsLer(uint8_t* buf, size_t tamanho) {
+    return nvsLerBlob(NVS_NAMESPACE, NVS_CHAVE, buf, tamanho);
+}
+
+bool partidaNvsGravar(const uint8_t* buf, size_t tamanho) {
+    return nvsGravarBlob(NVS_NAMESPACE, NVS_CHAVE, buf, tamanho);
+}
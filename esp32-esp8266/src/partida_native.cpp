@@ -0,0 +1,24 @@
+// NVS do estado salvo no ambiente native: um buffer em RAM. Os
+// testes preenchem, apagam e fazem a gravação falhar.
+#include "partida.h"
+
+#include <string.h>
+
+uint8_t partidaNativeNvs[PARTIDA_BYTES_MAX + 8];
+size_t partidaNativeTamanho = 0;
+bool partidaNativeFalhar = false;
+uint32_t partidaNativeGravacoes = 0;
+
+size_t partidaNvsLer(uint8_t* buf, size_t tamanho) {
+    if (partidaNativeTamanho == 0 || partidaNativeTamanho > tamanho) return 0;
+    memcpy(buf, partidaNativeNvs, partidaNativeTamanho);
+    return partidaNativeTamanho;
+}
+
+bool partidaNvsGravar(const uint8_t* buf, size_t tamanho) {
+    if (partidaNativeFalhar || tamanho > sizeof(partidaNativeNvs)) return false;
+    memcpy(partidaNativeNvs, buf, tamanho);
+    partidaNativeTamanho = tamanho;
+    ++partidaNativeGravacoes;
+    return true;
+}
@@ -0,0 +1,106 @@
+#include "publicador.h"
+#include "eventos.h"
+#include "fila_lockfree.h"
+
+#include <string.h>
+
+namespace {
+
+struct MensagemMqtt {
+    const char* topico;
+    uint16_t tamanho;
+    bool retido;
+    AvisoEntrega entregue;
+    uint8_t payload[PUBLICADOR_PAYLOAD_MAX + 1];  // +1 para o '\0' dos textos
+};
+
+FilaLockFree<MensagemMqtt, PUBLICADOR_CAPACIDADE> fila;
+
+std::atomic<bool> conectado{false};
+std::atomic<uint32_t> enfileiradas{0};
+std::atomic<uint32_t> publicadas{0};
+std::atomic<uint32_t> descartadasCheia{0};
+std::atomic<uint32_t> descartadasTamanho{0};
+std::atomic<uint32_t> descartadasOffline{0};
+std::atomic<uint32_t> falhasEnvio{0};
+std::atomic<uint32_t> picoOcupacao{0};
+
+void registrarOcupacao() {
+    uint32_t ocupacao = fila.ocupacao();
+    uint32_t pico = picoOcupacao.load(std::memory_order_relaxed);
+    while (ocupacao > pico &&
+           !picoOcupacao.compare_exchange_weak(pico, ocupacao, std::memory_order_relaxed)) {
+    }
+}
+
+}  // namespace
+
+bool publicarBinario(const char* topico, const uint8_t* dados, size_t tamanho, bool retido,
+                     AvisoEntrega entregue) {
+    // Sem link não adianta enfileirar nem acordar a taskMQTT; o estado
+    // retido é republicado quando a sessão volta
+    if (!conectado.load(std::memory_order_relaxed)) {
+        descartadasOffline.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    if (tamanho > PUBLICADOR_PAYLOAD_MAX) {
+        descartadasTamanho.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    MensagemMqtt msg;
+    msg.topico = topico;
+    msg.tamanho = (uint16_t)tamanho;
+    msg.retido = retido;
+    msg.entregue = entregue;
+    memcpy(msg.payload, dados, tamanho);
+    msg.payload[tamanho] = '\0';
+
+    if (!fila.enfileirar(msg)) {
+        descartadasCheia.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    enfileiradas.fetch_add(1, std::memory_order_relaxed);
+    registrarOcupacao();
+    eventosSinalizar(EVENTO_PUBLICAR);  // acorda a taskMQTT
+    return true;
+}
+
+bool publicar(const char* topico, const char* payload, bool retido, AvisoEntrega entregue) {
+    return publicarBinario(topico, (const uint8_t*)payload, strlen(payload), retido, entregue);
+}
+
+void publicadorDrenar(PubSubClient& cliente) {
+    bool online = cliente.connected();
+    conectado.store(online, std::memory_order_relaxed);
+
+    // Desconectado: o que já estava na fila espera a reconexão; as
+    // novas publicações são recusadas em publicar() até lá.
+    if (!online) return;
+
+    MensagemMqtt msg;
+    while (fila.desenfileirar(msg)) {
+        if (cliente.publish(msg.topico, msg.payload, msg.tamanho, msg.retido)) {
+            publicadas.fetch_add(1, std::memory_order_relaxed);
+            if (msg.entregue) msg.entregue();
+        } else {
+            falhasEnvio.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+}
+
+bool publicadorConectado() {
+    return conectado.load(std::memory_order_relaxed);
+}
+
+PublicadorStats publicadorEstatisticas() {
+    PublicadorStats s;
+    s.enfileiradas = enfileiradas.load(std::memory_order_relaxed);
+    s.publicadas = publicadas.load(std::memory_order_relaxed);
+    s.descartadasCheia = descartadasCheia.load(std::memory_order_relaxed);
+    s.descartadasTamanho = descartadasTamanho.load(std::memory_order_relaxed);
+    s.descartadasOffline = descartadasOffline.load(std::memory_order_relaxed);
+    s.falhasEnvio = falhasEnvio.load(std::memory_order_relaxed);
+    s.picoOcupacao = picoOcupacao.load(std::memory_order_relaxed);
+    return s;
+}
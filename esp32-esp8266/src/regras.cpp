@@ -0,0 +1,333 @@
+#include "regras.h"
+#include "botao.h"
+#include "estado.h"
+#include "eventos.h"
+#include "hal.h"
+#include "log.h"
+#include "padroes.h"
+#include "publicador.h"
+#include "sensores.h"
+#include "topicos.h"
+
+#include <stdio.h>
+#include <string.h>
+
+MotorRegras regras;
+
+namespace {
+
+bool indiceValido(uint8_t indice, size_t limite) {
+    return indice == REGRAS_QUALQUER || indice < limite;
+}
+
+bool gatilhoValido(const Regra& r) {
+    switch (r.gatilho) {
+        case GATILHO_ALARME: return r.valor <= ESTADO_PAUSADO;
+        case GATILHO_ZONA:   return indiceValido(r.indice, NUM_ZONAS) && r.valor <= 1;
+        case GATILHO_LUZ:    return indiceValido(r.indice, NUM_COMODOS) && r.valor > 0;
+        case GATILHO_GESTO:
+            return indiceValido(r.indice, GESTO_LONGO + 1) && r.valor <= BOTAO_MAX_CLIQUES;
+        default:             return false;
+    }
+}
+
+bool acaoValida(const Regra& r) {
+    switch (r.acao) {
+        case ACAO_COR:
+            // "O cômodo do gatilho" só existe no gatilho de luz
+            if (r.destino == REGRAS_DO_GATILHO) {
+                if (r.gatilho != GATILHO_LUZ) return false;
+            } else if (!indiceValido(r.destino, NUM_COMODOS)) {
+                return false;
+            }
+            return r.transicao * 100UL <= TRANSICAO_MAX_MS;
+        case ACAO_PADRAO:
+            return r.destino != PADRAO_NENHUM && r.destino < NUM_PADROES;
+        case ACAO_PUBLICAR:
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool casa(const Regra& r, const EventoRegra& ev) {
+    if (r.gatilho != GATILHO_ALARME && r.indice != REGRAS_QUALQUER && r.indice != ev.indice) {
+        return false;
+    }
+    if (r.gatilho == GATILHO_GESTO && r.valor == 0) return true;  // qualquer nº de cliques
+    return r.valor == ev.valor;
+}
+
+void responder(const char* resultado, int valor) {
+    char buf[24];
+    snprintf(buf, sizeof(buf), "%s,%d", resultado, valor);
+    publicar(TOPICO_REGRAS_ESTADO, buf, true);
+}
+
+}  // namespace
+
+// ========================================================
+// FORMATO DA TABELA
+// ========================================================
+bool regrasDecodificar(const uint8_t* buf, size_t tamanho, Regra* tabela, uint8_t& quantidade,
+                       int& invalida) {
+    invalida = -1;
+    if (tamanho < 2 || buf[0] != REGRAS_VERSAO || buf[1] > REGRAS_MAX ||
+        tamanho != 2 + (size_t)buf[1] * REGRAS_BYTES_REGRA) {
+        return false;
+    }
+
+    for (uint8_t i = 0; i < buf[1]; ++i) {
+        const uint8_t* p = buf + 2 + i * REGRAS_BYTES_REGRA;
+        Regra r;
+        r.gatilho = p[0];
+        r.indice = p[1];
+        r.valor = (uint16_t)(p[2] | (p[3] << 8));
+        r.acao = p[4];
+        r.destino = p[5];
+        r.cor[0] = p[6];
+        r.cor[1] = p[7];
+        r.cor[2] = p[8];
+        r.transicao = p[9];
+        if (!gatilhoValido(r) || !acaoValida(r)) {
+            invalida = i;
+            return false;
+        }
+        tabela[i] = r;
+    }
+    quantidade = buf[1];
+    return true;
+}
+
+size_t regrasCodificar(const Regra* tabela, uint8_t quantidade, uint8_t* buf, size_t tamanho) {
+    size_t total = 2 + (size_t)quantidade * REGRAS_BYTES_REGRA;
+    if (quantidade > REGRAS_MAX || total > tamanho) return 0;
+
+    buf[0] = REGRAS_VERSAO;
+    buf[1] = quantidade;
+    for (uint8_t i = 0; i < quantidade; ++i) {
+        const Regra& r = tabela[i];
+        uint8_t* p = buf + 2 + i * REGRAS_BYTES_REGRA;
+        p[0] = r.gatilho;
+        p[1] = r.indice;
+        p[2] = r.valor & 0xFF;
+        p[3] = r.valor >> 8;
+        p[4] = r.acao;
+        p[5] = r.destino;
+        p[6] = r.cor[0];
+        p[7] = r.cor[1];
+        p[8] = r.cor[2];
+        p[9] = r.transicao;
+    }
+    return total;
+}
+
+// ========================================================
+// PRODUTORES
+// ========================================================
+void MotorRegras::evento(GatilhoRegra gatilho, uint8_t indice, uint16_t valor) {
+    if (porGatilho_[gatilho].load(std::memory_order_relaxed) == 0) return;
+
+    EventoRegra ev = {gatilho, indice, valor};
+    if (!fila_.enfileirar(ev)) {
+        descartados_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    eventosSinalizar(EVENTO_REGRAS);  // acorda a taskMQTT
+}
+
+// ========================================================
+// TABELA (taskMQTT)
+// ========================================================
+bool MotorRegras::carregar(const uint8_t* buf, size_t tamanho, int& invalida) {
+    Regra novas[REGRAS_MAX];
+    uint8_t quantidade = 0;
+    if (!regrasDecodificar(buf, tamanho, novas, quantidade, invalida)) return false;
+
+    // Compila: uma máscara por tipo de gatilho
+    uint16_t mascaras[NUM_GATILHOS] = {};
+    for (uint8_t i = 0; i < quantidade; ++i) {
+        regras_[i] = novas[i];
+        mascaras[novas[i].gatilho] |= 1u << i;
+    }
+    quantidade_ = quantidade;
+    for (uint8_t g = 0; g < NUM_GATILHOS; ++g) {
+        porGatilho_[g].store(mascaras[g], std::memory_order_relaxed);
+    }
+
+    // Regras de luz novas valem também para quem já está aceso
+    for (size_t c = 0; c < NUM_COMODOS; ++c) luzDisparadas_[c] = 0;
+    return true;
+}
+
+bool MotorRegras::igualAtual(const uint8_t* buf, size_t tamanho) const {
+    uint8_t atual[REGRAS_BYTES_MAX];
+    size_t n = regrasCodificar(regras_, quantidade_, atual, sizeof(atual));
+    return n == tamanho && memcmp(atual, buf, n) == 0;
+}
+
+void MotorRegras::iniciar() {
+    uint8_t buf[REGRAS_BYTES_MAX];
+    size_t n = regrasNvsLer(buf, sizeof(buf));
+    if (n == 0) return;
+
+    int invalida;
+    if (carregar(buf, n, invalida)) {
+        LOG_INFO("[Regras] %u regras restauradas da NVS", quantidade_);
+    } else {
+        LOG_AVISO("[Regras] Tabela da NVS inválida (regra %d): sem automações", invalida);
+    }
+}
+
+void MotorRegras::configurar(const uint8_t* buf, size_t tamanho) {
+    // A tabela é retida no broker e volta a cada reconexão: igual à
+    // atual, só responde (não gasta a flash)
+    if (igualAtual(buf, tamanho)) {
+        responder("OK", quantidade_);
+        return;
+    }
+
+    int invalida;
+    if (!carregar(buf, tamanho, invalida)) {
+        recusadas_.fetch_add(1, std::memory_order_relaxed);
+        LOG_AVISO("[Regras] Tabela recusada (regra %d); mantidas %u regras", invalida,
+                  quantidade_);
+        responder("INVALIDA", invalida);
+        return;
+    }
+
+    if (regrasNvsGravar(buf, tamanho)) {
+        gravacoes_.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        falhasGravacao_.fetch_add(1, std::memory_order_relaxed);
+        LOG_AVISO("[Regras] Falha ao gravar na NVS: valem só até o próximo boot");
+    }
+    LOG_INFO("[Regras] %u regras carregadas", quantidade_);
+    responder("OK", quantidade_);
+}
+
+// ========================================================
+// AVALIAÇÃO (taskMQTT)
+// ========================================================
+void MotorRegras::executar(uint8_t n, const EventoRegra& ev) {
+    const Regra& r = regras_[n];
+    switch (r.acao) {
+        case ACAO_COR: {
+            uint32_t duracaoMs = r.transicao * 100UL;
+            if (r.destino == REGRAS_QUALQUER) {
+                for (size_t c = 0; c < NUM_COMODOS; ++c) {
+                    aplicarCorComodo(c, r.cor[0], r.cor[1], r.cor[2], duracaoMs);
+                }
+            } else {
+                size_t c = r.destino == REGRAS_DO_GATILHO ? ev.indice : r.destino;
+                aplicarCorComodo(c, r.cor[0], r.cor[1], r.cor[2], duracaoMs);
+            }
+            break;
+        }
+        case ACAO_PADRAO:
+            padraoTocar((Padrao)r.destino);
+            break;
+        case ACAO_PUBLICAR: {
+            char buf[24];
+            snprintf(buf, sizeof(buf), "%u,%u,%u", n, ev.indice, ev.valor);
+            publicar(TOPICO_REGRAS_DISPARO, buf);
+            break;
+        }
+        default:
+            break;
+    }
+    disparos_.fetch_add(1, std::memory_order_relaxed);
+    LOG_DEBUG("[Regras] Regra %u disparou (gatilho %u, %u, %u)", n, ev.gatilho, ev.indice,
+              ev.valor);
+}
+
+void MotorRegras::avaliar(const EventoRegra& ev) {
+    eventos_.fetch_add(1, std::memory_order_relaxed);
+    uint16_t candidatas = porGatilho_[ev.gatilho].load(std::memory_order_relaxed);
+    for (uint8_t i = 0; candidatas; ++i, candidatas >>= 1) {
+        if ((candidatas & 1) && casa(regras_[i], ev)) executar(i, ev);
+    }
+}
+
+void MotorRegras::servicarLuzes(uint32_t agoraMs) {
+    uint16_t luz = porGatilho_[GATILHO_LUZ].load(std::memory_order_relaxed);
+    if (luz == 0) return;
+
+    for (size_t c = 0; c < NUM_COMODOS; ++c) {
+        const EstadoComodo& e = estadosComodos[c];
+        if (!e.ligado) {
+            luzDisparadas_[c] = 0;
+            continue;
+        }
+        // Acendeu de novo desde a última olhada: outro período
+        if (e.ligadoDesde != luzDesde_[c]) {
+            luzDesde_[c] = e.ligadoDesde;
+            luzDisparadas_[c] = 0;
+        }
+
+        uint32_t acesoMs = agoraMs - e.ligadoDesde;
+        uint16_t pendentes = luz & ~luzDisparadas_[c];
+        for (uint8_t i = 0; pendentes; ++i, pendentes >>= 1) {
+            if (!(pendentes & 1)) continue;
+            const Regra& r = regras_[i];
+            if (r.indice != REGRAS_QUALQUER && r.indice != c) continue;
+            if (acesoMs < r.valor * 1000UL) continue;
+
+            luzDisparadas_[c] |= 1u << i;
+            EventoRegra ev = {GATILHO_LUZ, (uint8_t)c, r.valor};
+            eventos_.fetch_add(1, std::memory_order_relaxed);
+            executar(i, ev);
+            if (!e.ligado) break;  // a própria regra apagou
+        }
+    }
+}
+
+void MotorRegras::servicar(uint32_t agoraMs) {
+    EventoRegra ev;
+    while (fila_.desenfileirar(ev)) {
+        uint32_t inicio = micros();
+        avaliar(ev);
+        uint32_t gasto = micros() - inicio;
+        if (gasto > avaliacaoMaxUs_.load(std::memory_order_relaxed)) {
+            avaliacaoMaxUs_.store(gasto, std::memory_order_relaxed);
+        }
+    }
+    servicarLuzes(agoraMs);
+}
+
+uint32_t MotorRegras::prazoMs(uint32_t agoraMs) const {
+    uint16_t luz = porGatilho_[GATILHO_LUZ].load(std::memory_order_relaxed);
+    uint32_t prazo = UINT32_MAX;
+    if (luz == 0) return prazo;
+
+    for (size_t c = 0; c < NUM_COMODOS; ++c) {
+        const EstadoComodo& e = estadosComodos[c];
+        if (!e.ligado) continue;
+        uint32_t acesoMs = agoraMs - e.ligadoDesde;
+        // Período novo ainda não visto por servicarLuzes(): nada disparou
+        uint16_t disparadas = e.ligadoDesde == luzDesde_[c] ? luzDisparadas_[c] : 0;
+        uint16_t pendentes = luz & ~disparadas;
+        for (uint8_t i = 0; pendentes; ++i, pendentes >>= 1) {
+            if (!(pendentes & 1)) continue;
+            const Regra& r = regras_[i];
+            if (r.indice != REGRAS_QUALQUER && r.indice != c) continue;
+            uint32_t limite = r.valor * 1000UL;
+            uint32_t falta = acesoMs >= limite ? 0 : limite - acesoMs;
+            if (falta < prazo) prazo = falta;
+        }
+    }
+    return prazo;
+}
+
+RegrasStats MotorRegras::estatisticas() const {
+    RegrasStats s;
+    s.regras = quantidade_;
+    s.eventos = eventos_.load(std::memory_order_relaxed);
+    s.descartados = descartados_.load(std::memory_order_relaxed);
+    s.disparos = disparos_.load(std::memory_order_relaxed);
+    s.recusadas = recusadas_.load(std::memory_order_relaxed);
+    s.gravacoes = gravacoes_.load(std::memory_order_relaxed);
+    s.falhasGravacao = falhasGravacao_.load(std::memory_order_relaxed);
+    s.avaliacaoMaxUs = avaliacaoMaxUs_.load(std::memory_order_relaxed);
+    return s;
+}
@@ -0,0 +1,19 @@
+// Tabela de regras na NVS. Ler roda no setup(); gravar, só na
+// taskMQTT.
+#include "regras.h"
+#include "armazenamento.h"
+
+namespace {
+
+const char* NVS_NAMESPACE = "regras";
+const char* NVS_CHAVE = "tabela";
+
+}  // namespace
+
+size_t regrasNvsLer(uint8_t* buf, size_t tamanho) {
+    return nvsLerBlob(NVS_NAMESPACE, NVS_CHAVE, buf, tamanho);
+}
+
+bool regrasNvsGravar(const uint8_t* buf, size_t tamanho) {
+    return nvsGravarBlob(NVS_NAMESPACE, NVS_CHAVE, buf, tamanho);
+}
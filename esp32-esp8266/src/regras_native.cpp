@@ -0,0 +1,24 @@
+// NVS da tabela de regras no ambiente native: um buffer em RAM. Os
+// testes preenchem, apagam e fazem a gravação falhar.
+#include "regras.h"
+
+#include <string.h>
+
+uint8_t regrasNativeNvs[REGRAS_BYTES_MAX];
+size_t regrasNativeTamanho = 0;
+bool regrasNativeFalhar = false;
+uint32_t regrasNativeGravacoes = 0;
+
+size_t regrasNvsLer(uint8_t* buf, size_t tamanho) {
+    if (regrasNativeTamanho == 0 || regrasNativeTamanho > tamanho) return 0;
+    memcpy(buf, regrasNativeNvs, regrasNativeTamanho);
+    return regrasNativeTamanho;
+}
+
+bool regrasNvsGravar(const uint8_t* buf, size_t tamanho) {
+    if (regrasNativeFalhar || tamanho > sizeof(regrasNativeNvs)) return false;
+    memcpy(regrasNativeNvs, buf, tamanho);
+    regrasNativeTamanho = tamanho;
+    ++regrasNativeGravacoes;
+    return true;
+}
@@ -0,0 +1,184 @@
+// Reprodução de rastros no ambiente native (ver reproducao.h): o
+// relógio do mock anda até o instante de cada amostra e avaliarSensor()
+// decide como no dispositivo.
+#include "reproducao.h"
+#include "alarme.h"
+#include "hal.h"
+#include "zonas.h"
+
+#include <chrono>
+#include <stdio.h>
+#include <vector>
+
+size_t reproducaoLerRastro(const uint8_t* buf, size_t tamanho, AmostraGravada* amostras,
+                           size_t max, uint32_t& quadrosPerdidos) {
+    quadrosPerdidos = 0;
+    size_t total = 0;
+    bool primeiro = true;
+    uint16_t esperado = 0;
+
+    size_t pos = 0;
+    while (pos < tamanho) {
+        AmostraGravada quadro[GRAVACAO_AMOSTRAS];
+        uint8_t n;
+        uint16_t numero;
+        size_t lidos = gravacaoDecodificar(buf + pos, tamanho - pos, quadro, n, numero);
+        if (lidos == 0) break;
+        pos += lidos;
+
+        if (!primeiro) quadrosPerdidos += (uint16_t)(numero - esperado);
+        primeiro = false;
+        esperado = (uint16_t)(numero + 1);
+
+        for (uint8_t i = 0; i < n && total < max; ++i) amostras[total++] = quadro[i];
+    }
+    return total;
+}
+
+// Inteiro decimal sem sinal em [p, fim), com espaços em volta
+static bool lerNumero(const char*& p, const char* fim, uint32_t& valor) {
+    while (p < fim && (*p == ' ' || *p == '\t')) ++p;
+    const char* inicio = p;
+    uint64_t v = 0;
+    while (p < fim && *p >= '0' && *p <= '9') {
+        if (v <= UINT32_MAX) v = v * 10 + (*p - '0');
+        ++p;
+    }
+    if (p == inicio || v > UINT32_MAX) return false;
+    while (p < fim && (*p == ' ' || *p == '\t')) ++p;
+    valor = (uint32_t)v;
+    return true;
+}
+
+int reproducaoLerRotulos(const char* texto, size_t tamanho, IntervaloPresenca* rotulos,
+                         size_t max) {
+    size_t n = 0;
+    const char* p = texto;
+    const char* fim = texto + tamanho;
+    while (p < fim) {
+        const char* fimLinha = p;
+        while (fimLinha < fim && *fimLinha != '\n') ++fimLinha;
+        const char* fimDados = p;
+        while (fimDados < fimLinha && *fimDados != '#' && *fimDados != '\r') ++fimDados;
+
+        const char* q = p;
+        while (q < fimDados && (*q == ' ' || *q == '\t')) ++q;
+        if (q < fimDados) {
+            IntervaloPresenca r;
+            if (!lerNumero(q, fimDados, r.inicioMs) || q == fimDados || *q++ != ',' ||
+                !lerNumero(q, fimDados, r.fimMs) || q != fimDados || r.fimMs < r.inicioMs) {
+                return -1;
+            }
+            if (n < max) rotulos[n++] = r;
+        }
+        p = fimLinha < fim ? fimLinha + 1 : fim;
+    }
+    return (int)n;
+}
+
+RelatorioReproducao reproduzir(const AmostraGravada* amostras, size_t quantidade,
+                               const IntervaloPresenca* rotulos, size_t numRotulos,
+                               const ConfigReproducao& cfg) {
+    RelatorioReproducao r = {};
+    r.presencas = (uint32_t)numRotulos;
+
+    for (uint8_t i = 0; i < NUM_SENSORES; ++i) {
+        uint16_t limite = cfg.limiteCm ? cfg.limiteCm : SENSORES[i].limiteCm;
+        filtroSensor(i).configurar(cfg.filtro ? *cfg.filtro : filtroConfigPadrao(limite));
+    }
+    maquinaAlarme.reiniciar();
+    zonasReiniciar();
+
+    std::vector<bool> detectada(numRotulos, false);
+    uint64_t somaLatenciaMs = 0;
+    uint32_t leituras[NUM_SENSORES] = {};
+    uint8_t presenca = 0;  // bit i = sensor i com presença confirmada
+    const uint8_t decimacao = cfg.decimacao ? cfg.decimacao : 1;
+
+    uint64_t relogioUs = 0;
+    uint64_t inicioUs = 0;
+    uint32_t anteriorUs = 0;
+
+    auto inicio = std::chrono::steady_clock::now();
+    for (size_t k = 0; k < quantidade; ++k) {
+        const AmostraGravada& a = amostras[k];
+
+        // micros() de 32 bits dá a volta: o relógio do mock segue a
+        // diferença, e a parte baixa dele é o ecoUs gravado
+        if (k == 0) {
+            relogioUs = inicioUs = a.ecoUs;
+        } else {
+            relogioUs += (uint32_t)(a.ecoUs - anteriorUs);
+        }
+        anteriorUs = a.ecoUs;
+
+        if (a.sensor >= NUM_SENSORES) {
+            r.ignoradas++;
+            continue;
+        }
+        if (leituras[a.sensor]++ % decimacao != 0) continue;
+
+        halNativeRelogioUs = relogioUs;
+        bool estavaEmAlerta = alarmeEstado() == ESTADO_ALERTA;
+        FiltroSaida f = avaliarSensor(a.sensor, gravacaoCm(a.mm), a.ecoUs);
+        r.amostras++;
+
+        if (f.detectado) {
+            presenca |= (uint8_t)(1u << a.sensor);
+        } else {
+            presenca &= (uint8_t)~(1u << a.sensor);
+        }
+
+        if (!estavaEmAlerta && alarmeEstado() == ESTADO_ALERTA) {
+            r.disparos++;
+            uint32_t tMs = (uint32_t)((relogioUs - inicioUs) / 1000);
+            size_t j = 0;
+            for (; j < numRotulos; ++j) {
+                uint32_t de = rotulos[j].inicioMs > cfg.toleranciaMs
+                                  ? rotulos[j].inicioMs - cfg.toleranciaMs : 0;
+                if (tMs >= de && tMs <= rotulos[j].fimMs + cfg.toleranciaMs) break;
+            }
+            if (j == numRotulos) {
+                r.falsosPositivos++;
+            } else if (detectada[j]) {
+                r.redisparos++;
+            } else {
+                detectada[j] = true;
+                r.detectadas++;
+                uint32_t latencia = tMs > rotulos[j].inicioMs ? tMs - rotulos[j].inicioMs : 0;
+                if (r.detectadas == 1 || latencia < r.latenciaMinMs) r.latenciaMinMs = latencia;
+                if (latencia > r.latenciaMaxMs) r.latenciaMaxMs = latencia;
+                somaLatenciaMs += latencia;
+            }
+        }
+        if (presenca == 0 && alarmeEstado() == ESTADO_ALERTA) alarmeEntrada(ENTRADA_PARAR);
+    }
+    std::chrono::duration<double> passou = std::chrono::steady_clock::now() - inicio;
+
+    r.duracaoMs = (uint32_t)((relogioUs - inicioUs) / 1000);
+    r.falsosNegativos = r.presencas - r.detectadas;
+    r.latenciaMediaMs = r.detectadas ? (uint32_t)(somaLatenciaMs / r.detectadas) : 0;
+    r.amostrasPorSegundo = passou.count() > 0 ? r.amostras / passou.count() : 0;
+
+    for (uint8_t i = 0; i < NUM_SENSORES; ++i) {
+        filtroSensor(i).configurar(filtroConfigPadrao(SENSORES[i].limiteCm));
+    }
+    maquinaAlarme.reiniciar();
+    zonasReiniciar();
+    return r;
+}
+
+void reproducaoImprimir(const char* nome, const RelatorioReproducao& r) {
+    printf("%s: %lu amostras em %.1f s (%lu ignoradas), %.0f amostras/s\n", nome,
+           (unsigned long)r.amostras, r.duracaoMs / 1000.0, (unsigned long)r.ignoradas,
+           r.amostrasPorSegundo);
+    printf("  presenças %lu, detectadas %lu, falsos negativos %lu\n",
+           (unsigned long)r.presencas, (unsigned long)r.detectadas,
+           (unsigned long)r.falsosNegativos);
+    printf("  disparos %lu, falsos positivos %lu, redisparos %lu\n",
+           (unsigned long)r.disparos, (unsigned long)r.falsosPositivos,
+           (unsigned long)r.redisparos);
+    printf("  latência do disparo mín/méd/máx %lu/%lu/%lu ms\n",
+           (unsigned long)r.latenciaMinMs, (unsigned long)r.latenciaMediaMs,
+           (unsigned long)r.latenciaMaxMs);
+}
@@ -0,0 +1,47 @@
+#include "sensores.h"
+
+#include <string.h>
+
+AgendaSensores::AgendaSensores(const Sensor* tabela, size_t quantidade, uint32_t periodoUs)
+    : grupos_(0), periodoUs_(periodoUs), grupo_(0), iniciado_(false), inicioCicloUs_(0),
+      liberadoUs_(0) {
+    memset(mascaras_, 0, sizeof(mascaras_));
+    memset(&stats_, 0, sizeof(stats_));
+
+    // Na ordem dos números de grupo; número sem sensor não vira grupo vazio
+    for (uint8_t g = 0; g < SENSORES_MAX; ++g) {
+        uint8_t m = 0;
+        for (size_t i = 0; i < quantidade && i < SENSORES_MAX; ++i) {
+            if (tabela[i].grupo == g) m |= 1u << i;
+        }
+        if (m) mascaras_[grupos_++] = m;
+    }
+}
+
+uint8_t AgendaSensores::proximo(uint32_t agoraUs, uint32_t& esperaUs) const {
+    esperaUs = 0;
+    if (!iniciado_) return 0;
+
+    uint32_t alvo = liberadoUs_;
+    if (grupo_ == 0 && (int32_t)(inicioCicloUs_ + periodoUs_ - alvo) > 0) {
+        alvo = inicioCicloUs_ + periodoUs_;
+    }
+    if ((int32_t)(alvo - agoraUs) > 0) esperaUs = alvo - agoraUs;
+    return grupo_;
+}
+
+void AgendaSensores::concluido(uint32_t inicioUs, uint32_t fimUs) {
+    if (grupo_ == 0) {
+        inicioCicloUs_ = inicioUs;
+        iniciado_ = true;
+    }
+    ++stats_.disparos;
+    liberadoUs_ = fimUs + SENSORES_GUARDA_US;
+
+    if (++grupo_ < grupos_) return;
+    grupo_ = 0;
+    ++stats_.ciclos;
+    stats_.ocupadoUs = fimUs - inicioCicloUs_;
+    if (stats_.ocupadoUs > stats_.ocupadoMaxUs) stats_.ocupadoMaxUs = stats_.ocupadoUs;
+    if (stats_.ocupadoUs + SENSORES_GUARDA_US > periodoUs_) ++stats_.atrasados;
+}
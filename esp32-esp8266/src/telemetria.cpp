@@ -0,0 +1,106 @@
+#include "telemetria.h"
+#include "binario.h"
+#include "formatacao.h"
+#include "publicador.h"
+#include "topicos.h"
+
+#include <atomic>
+
+static_assert(TELEMETRIA_LOTE_AMOSTRAS <= 255, "quantidade vai em um byte");
+static_assert(TELEMETRIA_QUADRO_MAX <= PUBLICADOR_PAYLOAD_MAX,
+              "quadro de telemetria maior que a mensagem do publicador");
+
+namespace {
+
+std::atomic<uint8_t> modoAtual{TELEMETRIA_MODO_PADRAO};
+
+// Só a tarefa do sensor mexe nestes
+LoteTelemetria lote;
+uint32_t ultimaTextoMs = 0;
+bool textoIniciado = false;
+
+void descarregarLote() {
+    if (lote.quantidade == 0) return;
+    if (publicadorConectado()) {  // offline: nem codifica
+        uint8_t quadro[TELEMETRIA_QUADRO_MAX];
+        size_t n = telemetriaCodificarLote(lote, TELEMETRIA_LOTE_BRUTAS, quadro, sizeof(quadro));
+        if (n > 0) publicarBinario(TOPICO_SENSOR_LOTE, quadro, n);
+    }
+    lote.quantidade = 0;
+}
+
+}  // namespace
+
+void telemetriaDefinirModo(ModoTelemetria modo) {
+    modoAtual.store(modo, std::memory_order_relaxed);
+}
+
+ModoTelemetria telemetriaModo() {
+    return (ModoTelemetria)modoAtual.load(std::memory_order_relaxed);
+}
+
+size_t telemetriaCodificarLote(const LoteTelemetria& lote, bool brutas,
+                               uint8_t* buf, size_t tamanho) {
+    size_t total = TELEMETRIA_CABECALHO + (brutas ? 2u * lote.quantidade : 0u);
+    if (total > tamanho) return 0;
+
+    uint16_t minimo = TELEMETRIA_SEM_ECO, maximo = 0;
+    uint32_t soma = 0;
+    uint8_t validas = 0;
+    for (uint8_t i = 0; i < lote.quantidade; ++i) {
+        uint16_t mm = lote.amostrasMm[i];
+        if (mm == TELEMETRIA_SEM_ECO) continue;
+        if (mm < minimo) minimo = mm;
+        if (mm > maximo) maximo = mm;
+        soma += mm;
+        validas++;
+    }
+    if (validas == 0) minimo = maximo = TELEMETRIA_SEM_ECO;
+
+    uint16_t intervalo = lote.quantidade > 1
+        ? (uint16_t)((lote.ultimoMs - lote.t0Ms) / (lote.quantidade - 1)) : 0;
+
+    Escritor e = {buf, tamanho, 0, true};
+    e.u8(TELEMETRIA_VERSAO);
+    e.u8(brutas ? 0x01 : 0x00);
+    e.u8(lote.quantidade);
+    e.u8(validas);
+    e.u32(lote.t0Ms);
+    e.u16(intervalo);
+    e.u16(minimo);
+    e.u16(maximo);
+    e.u16(validas ? (uint16_t)(soma / validas) : TELEMETRIA_SEM_ECO);
+
+    if (brutas) {
+        for (uint8_t i = 0; i < lote.quantidade; ++i) e.u16(lote.amostrasMm[i]);
+    }
+    return total;
+}
+
+void telemetriaAmostra(float distanciaCm, uint32_t agoraMs) {
+    if (telemetriaModo() == TELEMETRIA_TEXTO) {
+        descarregarLote();  // sobra de quando estava em modo lote
+
+        if (textoIniciado && agoraMs - ultimaTextoMs < PERIODO_PUBLICACAO_MEDIDA_MS) return;
+        textoIniciado = true;
+        ultimaTextoMs = agoraMs;
+
+        if (publicadorConectado()) {
+            char msg[16];
+            formatarMedida(msg, sizeof(msg), distanciaCm);
+            publicar(TOPICO_SENSOR, msg);
+        }
+        return;
+    }
+
+    if (lote.quantidade == 0) lote.t0Ms = agoraMs;
+    lote.ultimoMs = agoraMs;
+    lote.amostrasMm[lote.quantidade++] = distanciaCm < 0
+        ? TELEMETRIA_SEM_ECO
+        : (uint16_t)(distanciaCm * 10.0f + 0.5f);
+
+    if (lote.quantidade >= TELEMETRIA_LOTE_AMOSTRAS ||
+        agoraMs - lote.t0Ms >= TELEMETRIA_LOTE_MS) {
+        descarregarLote();
+    }
+}
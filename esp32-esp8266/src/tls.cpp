@@ -0,0 +1,53 @@
+#include "tls.h"
+
+MedicoesTls medicoesTls;
+
+// Só a taskMQTT registra: load + store basta, o atômico é para quem lê
+void MedicoesTls::Acumulador::somar(uint32_t ms, uint32_t heapBytes) {
+    quantidade.fetch_add(1, std::memory_order_relaxed);
+    totalMs.fetch_add(ms, std::memory_order_relaxed);
+    ultimoMs.store(ms, std::memory_order_relaxed);
+    if (ms > maxMs.load(std::memory_order_relaxed)) maxMs.store(ms, std::memory_order_relaxed);
+    ultimoHeap.store(heapBytes, std::memory_order_relaxed);
+    if (heapBytes > maxHeap.load(std::memory_order_relaxed)) {
+        maxHeap.store(heapBytes, std::memory_order_relaxed);
+    }
+}
+
+HandshakeStats MedicoesTls::Acumulador::ler() const {
+    HandshakeStats s;
+    s.quantidade = quantidade.load(std::memory_order_relaxed);
+    uint32_t total = totalMs.load(std::memory_order_relaxed);
+    s.medioMs = s.quantidade ? total / s.quantidade : 0;
+    s.ultimoMs = ultimoMs.load(std::memory_order_relaxed);
+    s.maxMs = maxMs.load(std::memory_order_relaxed);
+    s.ultimoHeap = ultimoHeap.load(std::memory_order_relaxed);
+    s.maxHeap = maxHeap.load(std::memory_order_relaxed);
+    return s;
+}
+
+MedicoesTls::MedicoesTls()
+    : completo_{}, retomado_{}, falhas_(0), falhasVerificacao_(0), sessoesRecusadas_(0),
+      ultimoRetomado_(false) {}
+
+void MedicoesTls::registrar(bool retomado, bool ofereceuSessao, uint32_t ms, uint32_t heapBytes) {
+    (retomado ? retomado_ : completo_).somar(ms, heapBytes);
+    if (ofereceuSessao && !retomado) sessoesRecusadas_.fetch_add(1, std::memory_order_relaxed);
+    ultimoRetomado_.store(retomado, std::memory_order_relaxed);
+}
+
+void MedicoesTls::registrarFalha(bool verificacao) {
+    falhas_.fetch_add(1, std::memory_order_relaxed);
+    if (verificacao) falhasVerificacao_.fetch_add(1, std::memory_order_relaxed);
+}
+
+TlsStats MedicoesTls::estatisticas() const {
+    TlsStats s;
+    s.completo = completo_.ler();
+    s.retomado = retomado_.ler();
+    s.falhas = falhas_.load(std::memory_order_relaxed);
+    s.falhasVerificacao = falhasVerificacao_.load(std::memory_order_relaxed);
+    s.sessoesRecusadas = sessoesRecusadas_.load(std::memory_order_relaxed);
+    s.ultimoRetomado = ultimoRetomado_.load(std::memory_order_relaxed);
+    return s;
+}
@@ -0,0 +1,154 @@
+#include "transicao.h"
+#include "hal.h"
+
+static uint32_t divisaoTeto(uint32_t a, uint32_t b) {
+    return (a + b - 1) / b;
+}
+
+PlanoFade planejarFade(uint32_t dutyAtual, uint32_t dutyAlvo, uint32_t duracaoMs, uint32_t freqPwm) {
+    PlanoFade plano = {dutyAlvo, dutyAlvo, 0, 0, 0, 0};
+
+    uint32_t delta = dutyAlvo > dutyAtual ? dutyAlvo - dutyAtual : dutyAtual - dutyAlvo;
+    uint32_t ciclos = (uint32_t)((uint64_t)duracaoMs * freqPwm / 1000);
+    if (delta == 0 || ciclos == 0) return plano;
+
+    // No máximo um passo por período e no máximo TRANSICAO_MAX_PASSOS
+    uint32_t passoMin = divisaoTeto(delta, TRANSICAO_MAX_PASSOS);
+    uint32_t porCiclo = divisaoTeto(delta, ciclos);
+    if (porCiclo > passoMin) passoMin = porCiclo;
+    if (passoMin > TRANSICAO_MAX_PASSO) passoMin = TRANSICAO_MAX_PASSO;
+
+    // Os períodos por passo são inteiros: numPassos * ciclosPorPasso
+    // quase nunca dá "ciclos" exato. Passos um pouco maiores às vezes
+    // chegam mais perto da duração pedida; testa até o dobro do mínimo.
+    uint32_t passoMax = passoMin * 2;
+    if (passoMax > TRANSICAO_MAX_PASSO) passoMax = TRANSICAO_MAX_PASSO;
+    if (passoMax > delta) passoMax = delta;
+
+    uint32_t passo = passoMin;
+    uint32_t melhorTotal = 0;
+    for (uint32_t candidato = passoMin; candidato <= passoMax; ++candidato) {
+        uint32_t n = delta / candidato;
+        uint32_t porPasso = ciclos / n;
+        if (porPasso < 1) porPasso = 1;
+        if (porPasso > TRANSICAO_MAX_CICLOS) porPasso = TRANSICAO_MAX_CICLOS;
+        uint32_t total = n * porPasso;
+        uint32_t erro = total > ciclos ? total - ciclos : ciclos - total;
+        uint32_t erroMelhor = melhorTotal > ciclos ? melhorTotal - ciclos : ciclos - melhorTotal;
+        if (candidato == passoMin || erro < erroMelhor) {
+            passo = candidato;
+            melhorTotal = total;
+        }
+    }
+
+    // Passos inteiros; a sobra vira um salto inicial menor que um passo
+    uint32_t numPassos = delta / passo;
+    uint32_t percorrido = numPassos * passo;
+    plano.dutyInicial = dutyAlvo > dutyAtual ? dutyAlvo - percorrido : dutyAlvo + percorrido;
+
+    uint32_t ciclosPorPasso = ciclos / numPassos;
+    if (ciclosPorPasso < 1) ciclosPorPasso = 1;
+    if (ciclosPorPasso > TRANSICAO_MAX_CICLOS) ciclosPorPasso = TRANSICAO_MAX_CICLOS;
+
+    plano.passo = (uint16_t)passo;
+    plano.ciclosPorPasso = (uint16_t)ciclosPorPasso;
+    plano.numPassos = (uint16_t)numPassos;
+    plano.duracaoRealMs = (uint32_t)((uint64_t)numPassos * ciclosPorPasso * 1000 / freqPwm);
+    return plano;
+}
+
+// ========================================================
+// CANAIS: NUNCA TOCAR NUM FADE EM ANDAMENTO
+// ========================================================
+namespace {
+
+struct EstadoCanal {
+    uint32_t duty;      // alvo do último fade: onde o hardware para
+    uint32_t fimMs;     // fim do fade (com folga)
+    bool noFade;
+    bool pendente;      // pedido esperando o lote poder disparar
+    uint32_t pendenteDuty;
+    uint32_t pendenteDuracaoMs;
+    uint32_t pendentePrazoMs;
+};
+
+EstadoCanal canais[TRANSICAO_NUM_CANAIS];
+
+bool emFade(const EstadoCanal& e, uint32_t agoraMs) {
+    return e.noFade && (int32_t)(e.fimMs - agoraMs) > 0;
+}
+
+// Planeja a partir do duty conhecido de cada canal e dispara juntos
+void disparar(const MudancaCanal* mudancas, size_t quantidade, uint32_t agoraMs) {
+    if (quantidade == 0) return;
+    PlanoFade planos[TRANSICAO_MAX_LOTE] = {};
+    for (size_t i = 0; i < quantidade; ++i) {
+        planos[i] = planejarFade(canais[mudancas[i].canal].duty, mudancas[i].dutyAlvo,
+                                 mudancas[i].duracaoMs);
+    }
+    bool comFade = transicaoDisparar(mudancas, planos, quantidade);
+    for (size_t i = 0; i < quantidade; ++i) {
+        EstadoCanal& e = canais[mudancas[i].canal];
+        e.duty = mudancas[i].dutyAlvo;
+        e.noFade = comFade && planos[i].numPassos > 0;
+        e.fimMs = agoraMs + planos[i].duracaoRealMs + TRANSICAO_FOLGA_MS;
+    }
+}
+
+}  // namespace
+
+void transicaoCanais(const MudancaCanal* mudancas, size_t quantidade) {
+    if (quantidade > TRANSICAO_MAX_LOTE) quantidade = TRANSICAO_MAX_LOTE;
+    uint32_t agora = millis();
+
+    // Espera até o fim do último fade que o lote encontrou andando
+    bool esperar = false;
+    uint32_t prazo = agora;
+    size_t validas = 0;
+    MudancaCanal lote[TRANSICAO_MAX_LOTE];
+    for (size_t i = 0; i < quantidade; ++i) {
+        if (mudancas[i].canal >= TRANSICAO_NUM_CANAIS) continue;
+        lote[validas++] = mudancas[i];
+        const EstadoCanal& e = canais[mudancas[i].canal];
+        if (!emFade(e, agora)) continue;
+        if (!esperar || (int32_t)(e.fimMs - prazo) > 0) prazo = e.fimMs;
+        esperar = true;
+    }
+
+    for (size_t i = 0; i < validas; ++i) {
+        EstadoCanal& e = canais[lote[i].canal];
+        e.pendente = esperar;
+        e.pendenteDuty = lote[i].dutyAlvo;
+        e.pendenteDuracaoMs = lote[i].duracaoMs;
+        e.pendentePrazoMs = prazo;
+    }
+    if (!esperar) disparar(lote, validas, agora);
+}
+
+void transicaoServicar(uint32_t agoraMs) {
+    // Lotes que vencem juntos disparam juntos
+    MudancaCanal lote[TRANSICAO_MAX_LOTE];
+    size_t quantidade = 0;
+    for (uint8_t c = 0; c < TRANSICAO_NUM_CANAIS; ++c) {
+        EstadoCanal& e = canais[c];
+        if (!e.pendente || (int32_t)(e.pendentePrazoMs - agoraMs) > 0) continue;
+        e.pendente = false;
+        lote[quantidade++] = {c, e.pendenteDuty, e.pendenteDuracaoMs};
+    }
+    disparar(lote, quantidade, agoraMs);
+}
+
+bool transicaoPendente(uint8_t canal) {
+    return canal < TRANSICAO_NUM_CANAIS && canais[canal].pendente;
+}
+
+uint32_t transicaoPrazoMs(uint32_t agoraMs) {
+    uint32_t espera = UINT32_MAX;
+    for (const EstadoCanal& e : canais) {
+        if (!e.pendente) continue;
+        int32_t falta = (int32_t)(e.pendentePrazoMs - agoraMs);
+        if (falta <= 0) return 0;
+        if ((uint32_t)falta < espera) espera = (uint32_t)falta;
+    }
+    return espera;
+}
@@ -0,0 +1,53 @@
+// Driver das transições no ESP32: usa o serviço de fade do LEDC do
+// ESP-IDF sobre os canais já configurados por ledcSetup(). No core
+// Arduino os canais 0..7 ficam no grupo de alta velocidade e 8..15
+// no de baixa. transicao.cpp garante que nenhum canal chega aqui com
+// um fade ainda em andamento, então nada abaixo bloqueia.
+#include "transicao.h"
+
+#include "driver/ledc.h"
+
+static bool servicoInstalado = false;
+
+static ledc_mode_t modoDoCanal(uint8_t canal) {
+    return canal < 8 ? LEDC_HIGH_SPEED_MODE : LEDC_LOW_SPEED_MODE;
+}
+
+void transicaoIniciar() {
+    if (servicoInstalado) return;
+    servicoInstalado = ledc_fade_func_install(0) == ESP_OK;
+}
+
+bool transicaoDisparar(const MudancaCanal* mudancas, const PlanoFade* planos,
+                       size_t quantidade) {
+    // O duty novo só vale no próximo período de cada canal: gravar
+    // todos e então trocar todos deixa a janela em poucos µs. Sem o
+    // serviço de fade vai direto o alvo.
+    //
+    // Canais com fade não passam por aqui: ledc_set_fade_with_step()
+    // lê o duty de partida do hardware, e um dutyInicial recém-gravado
+    // só é visto lá no período seguinte. O canal está parado no duty
+    // conhecido (nenhum fade em andamento, ver transicao.cpp), que é
+    // de onde o plano partiu; o excesso menor que um passo o driver
+    // acerta no fim, gravando o alvo.
+    for (size_t i = 0; i < quantidade; ++i) {
+        if (servicoInstalado && planos[i].numPassos > 0) continue;
+        ledc_set_duty(modoDoCanal(mudancas[i].canal), (ledc_channel_t)(mudancas[i].canal % 8),
+                      planos[i].dutyAlvo);
+    }
+    for (size_t i = 0; i < quantidade; ++i) {
+        if (servicoInstalado && planos[i].numPassos > 0) continue;
+        ledc_update_duty(modoDoCanal(mudancas[i].canal), (ledc_channel_t)(mudancas[i].canal % 8));
+    }
+    if (!servicoInstalado) return false;
+
+    for (size_t i = 0; i < quantidade; ++i) {
+        if (planos[i].numPassos == 0) continue;
+        ledc_mode_t modo = modoDoCanal(mudancas[i].canal);
+        ledc_channel_t ch = (ledc_channel_t)(mudancas[i].canal % 8);
+        ledc_set_fade_with_step(modo, ch, planos[i].dutyAlvo, planos[i].passo,
+                                planos[i].ciclosPorPasso);
+        ledc_fade_start(modo, ch, LEDC_FADE_NO_WAIT);
+    }
+    return true;
+}
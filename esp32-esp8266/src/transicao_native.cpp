@@ -0,0 +1,23 @@
+// Driver das transições no ambiente native: não há fade; o duty final
+// vai direto para halNativeLedc e o plano fica guardado para os testes.
+// O fim do fade (e o que espera por ele) segue o relógio do mock.
+#include "transicao.h"
+#include "hal.h"
+
+PlanoFade transicaoNativePlanos[HAL_NATIVE_NUM_CANAIS];
+
+// Quantos lotes foram disparados: uma cena é um lote só
+uint32_t transicaoNativeLotes = 0;
+
+void transicaoIniciar() {}
+
+bool transicaoDisparar(const MudancaCanal* mudancas, const PlanoFade* planos,
+                       size_t quantidade) {
+    ++transicaoNativeLotes;
+    for (size_t i = 0; i < quantidade; ++i) {
+        if (mudancas[i].canal >= HAL_NATIVE_NUM_CANAIS) continue;
+        transicaoNativePlanos[mudancas[i].canal] = planos[i];
+        ledcWrite(mudancas[i].canal, planos[i].dutyAlvo);
+    }
+    return true;
+}
@@ -0,0 +1,153 @@
+#include "ultrassom.h"
+#include "sensores.h"
+
+#include <Arduino.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "driver/gpio.h"
+#include "esp_timer.h"
+
+static uint32_t amostras[NUM_SENSORES] = {0};
+static uint32_t semEco[NUM_SENSORES] = {0};
+
+// Pulso de 10 µs no trigger de todos os sensores da máscara
+static void disparar(uint8_t mascara) {
+    for (uint8_t i = 0; i < NUM_SENSORES; ++i) {
+        if (mascara & (1u << i)) digitalWrite(SENSORES[i].trig, LOW);
+    }
+    delayMicroseconds(2);
+    for (uint8_t i = 0; i < NUM_SENSORES; ++i) {
+        if (mascara & (1u << i)) digitalWrite(SENSORES[i].trig, HIGH);
+    }
+    delayMicroseconds(10);
+    for (uint8_t i = 0; i < NUM_SENSORES; ++i) {
+        if (mascara & (1u << i)) digitalWrite(SENSORES[i].trig, LOW);
+    }
+}
+
+static void contar(uint8_t sensor, bool eco) {
+    if (eco) amostras[sensor]++;
+    else semEco[sensor]++;
+}
+
+#ifdef ULTRASSOM_MODO_PULSEIN
+
+void ultrassomIniciar() {
+    for (const Sensor& s : SENSORES) {
+        pinMode(s.trig, OUTPUT);
+        pinMode(s.eco, INPUT);
+    }
+}
+
+uint8_t ultrassomMedir(uint8_t mascara, float* distanciasCm, uint32_t* ecosUs) {
+    // pulseIn() só acompanha um pino: o grupo vira rodízio
+    uint8_t ecos = 0;
+    for (uint8_t i = 0; i < NUM_SENSORES; ++i) {
+        if (!(mascara & (1u << i))) continue;
+        disparar(1u << i);
+        long duracao = pulseIn(SENSORES[i].eco, HIGH, ULTRASSOM_TIMEOUT_US);
+        ecosUs[i] = micros();
+        contar(i, duracao != 0);
+        if (duracao == 0) {
+            distanciasCm[i] = -1.0;
+            continue;
+        }
+        distanciasCm[i] = duracaoParaCm((uint32_t)duracao);
+        ecos |= 1u << i;
+    }
+    return ecos;
+}
+
+#else  // captura por interrupção
+
+static TaskHandle_t tarefaSensor = NULL;
+
+// Cópias em RAM para a ISR, que não pode ler a tabela na flash
+static uint8_t pinoEco[NUM_SENSORES];
+static volatile int64_t inicioEcoUs[NUM_SENSORES];
+static volatile uint32_t larguraUs[NUM_SENSORES];
+static volatile uint32_t fimEcoUs[NUM_SENSORES];  // mesma base de micros()
+
+// Borda de subida marca o início do eco; a de descida guarda a
+// largura do pulso e acende o bit do sensor na notificação da tarefa.
+static void IRAM_ATTR isrEco(void* arg) {
+    uint8_t i = (uint8_t)(uintptr_t)arg;
+    int64_t agora = esp_timer_get_time();
+
+    if (gpio_get_level((gpio_num_t)pinoEco[i])) {
+        inicioEcoUs[i] = agora;
+        return;
+    }
+
+    if (inicioEcoUs[i] == 0) return;  // descida sem subida (ruído)
+
+    larguraUs[i] = (uint32_t)(agora - inicioEcoUs[i]);
+    fimEcoUs[i] = (uint32_t)agora;
+    inicioEcoUs[i] = 0;
+
+    BaseType_t acordar = pdFALSE;
+    xTaskNotifyFromISR(tarefaSensor, 1u << i, eSetBits, &acordar);
+    portYIELD_FROM_ISR(acordar);
+}
+
+void ultrassomIniciar() {
+    tarefaSensor = xTaskGetCurrentTaskHandle();
+    for (uint8_t i = 0; i < NUM_SENSORES; ++i) {
+        const Sensor& s = SENSORES[i];
+        pinoEco[i] = s.eco;
+        pinMode(s.trig, OUTPUT);
+        pinMode(s.eco, INPUT);
+        attachInterruptArg(digitalPinToInterrupt(s.eco), isrEco, (void*)(uintptr_t)i, CHANGE);
+    }
+}
+
+uint8_t ultrassomMedir(uint8_t mascara, float* distanciasCm, uint32_t* ecosUs) {
+    // Descarta notificação atrasada de uma medição anterior
+    xTaskNotifyWait(0, UINT32_MAX, NULL, 0);
+    for (uint8_t i = 0; i < NUM_SENSORES; ++i) {
+        if (mascara & (1u << i)) inicioEcoUs[i] = 0;
+    }
+
+    disparar(mascara);
+
+    // O HC-SR04 leva ~0,5 ms para levantar o eco; soma uma margem
+    // ao timeout para não cortar pulsos perto do limite. Retorna assim
+    // que o último eco do grupo chega.
+    uint32_t ecos = 0;
+    TickType_t inicio = xTaskGetTickCount();
+    TickType_t limite = pdMS_TO_TICKS(ULTRASSOM_TIMEOUT_US / 1000 + 10);
+    while ((ecos & mascara) != mascara) {
+        TickType_t passou = xTaskGetTickCount() - inicio;
+        if (passou >= limite) break;
+        uint32_t bits = 0;
+        if (xTaskNotifyWait(0, UINT32_MAX, &bits, limite - passou) != pdTRUE) break;
+        ecos |= bits;
+    }
+    ecos &= mascara;
+    uint32_t fimUs = micros();
+
+    for (uint8_t i = 0; i < NUM_SENSORES; ++i) {
+        if (!(mascara & (1u << i))) continue;
+        uint32_t largura = larguraUs[i];
+        if (!(ecos & (1u << i)) || largura == 0 || largura > ULTRASSOM_TIMEOUT_US) {
+            ecos &= ~(1u << i);
+            distanciasCm[i] = -1.0;
+            ecosUs[i] = fimUs;
+            contar(i, false);
+            continue;
+        }
+        distanciasCm[i] = duracaoParaCm(largura);
+        ecosUs[i] = fimEcoUs[i];
+        contar(i, true);
+    }
+    return (uint8_t)ecos;
+}
+
+#endif
+
+UltrassomStats ultrassomEstatisticas(uint8_t sensor) {
+    UltrassomStats s;
+    s.amostras = amostras[sensor];
+    s.semEco = semEco[sensor];
+    return s;
+}
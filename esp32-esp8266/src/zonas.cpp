@@ -0,0 +1,114 @@
+#include "zonas.h"
+#include "alarme.h"
+#include "publicador.h"
+#include "regras.h"
+
+#include <stdio.h>
+#include <atomic>
+
+namespace {
+
+std::atomic<uint8_t> presentes{0};    // bit i = SENSORES[i]
+std::atomic<uint8_t> disparadas{0};   // bit z = ZONAS[z] em ALERTA
+std::atomic<uint8_t> ultimoEstado[NUM_ZONAS];  // estado + 1; 0 = nada publicado
+std::atomic<uint32_t> sequencia[NUM_ZONAS];
+std::atomic<bool> aplicando{false};  // alguma tarefa está em aplicar()
+std::atomic<bool> pendente{false};   // entrada mudou depois da última leitura
+std::atomic<bool> republicar{false}; // próxima passada publica todas
+
+uint8_t zonasPresentes() {
+    uint8_t sensores = presentes.load(std::memory_order_relaxed);
+    uint8_t zonas = 0;
+    for (uint8_t i = 0; i < NUM_SENSORES; ++i) {
+        if (sensores & (1u << i)) zonas |= 1u << SENSORES[i].zona;
+    }
+    return zonas;
+}
+
+void emitir(uint8_t zona, EstadoAlarme estado) {
+    char buf[24];
+    uint32_t seq = sequencia[zona].fetch_add(1, std::memory_order_relaxed) + 1;
+    snprintf(buf, sizeof(buf), "%s,%lu", nomeEstado(estado), (unsigned long)seq);
+    publicar(ZONAS[zona].topicoEstado, buf, true);
+}
+
+// Uma passada com o estado atual da máquina e da presença
+void aplicar() {
+    bool todas = republicar.exchange(false, std::memory_order_relaxed);
+    EstadoAlarme alarme = alarmeEstado();
+    uint8_t alerta;
+    if (alarme == ESTADO_ALERTA) {
+        uint8_t agora = zonasPresentes();
+        alerta = disparadas.fetch_or(agora, std::memory_order_relaxed) | agora;
+    } else {
+        disparadas.store(0, std::memory_order_relaxed);
+        alerta = 0;
+    }
+
+    for (uint8_t z = 0; z < NUM_ZONAS; ++z) {
+        EstadoAlarme e = alarme == ESTADO_PAUSADO ? ESTADO_PAUSADO
+                         : (alerta & (1u << z))   ? ESTADO_ALERTA
+                                                  : ESTADO_OK;
+        if (ultimoEstado[z].exchange(e + 1, std::memory_order_relaxed) != e + 1 || todas) {
+            emitir(z, e);
+        }
+    }
+}
+
+}  // namespace
+
+void zonasPresenca(uint8_t sensor, bool presente) {
+    uint8_t antes = zonasPresentes();
+    if (presente) presentes.fetch_or(1u << sensor, std::memory_order_relaxed);
+    else presentes.fetch_and(~(1u << sensor), std::memory_order_relaxed);
+
+    // Gatilho de zona: só quando a zona inteira muda (outro sensor
+    // da mesma zona pode continuar vendo alguém)
+    uint8_t depois = zonasPresentes();
+    for (uint8_t z = 0; z < NUM_ZONAS; ++z) {
+        if ((antes ^ depois) & (1u << z)) {
+            regras.evento(GATILHO_ZONA, z, (depois >> z) & 1);
+        }
+    }
+}
+
+// Só uma tarefa aplica por vez, sem bloquear ninguém: quem chega
+// enquanto outra aplica só marca "pendente" e volta; a que está
+// aplicando relê a máquina e a presença até não sobrar pendência.
+// Assim a última publicação retida é sempre do estado mais novo.
+void zonasAtualizar() {
+    pendente.store(true, std::memory_order_release);
+    while (!aplicando.exchange(true, std::memory_order_acquire)) {
+        while (pendente.exchange(false, std::memory_order_acq_rel)) aplicar();
+        aplicando.store(false, std::memory_order_release);
+        // Chegou alguém entre a última passada e a liberação?
+        if (!pendente.load(std::memory_order_acquire)) break;
+    }
+}
+
+// Passa pelo mesmo aplicador para não intercalar com uma atualização
+void zonasRepublicar() {
+    republicar.store(true, std::memory_order_relaxed);
+    zonasAtualizar();
+}
+
+EstadoAlarme zonaEstado(uint8_t zona) {
+    uint8_t atual = ultimoEstado[zona].load(std::memory_order_relaxed);
+    return atual == 0 ? ESTADO_OK : (EstadoAlarme)(atual - 1);
+}
+
+bool zonaPresenca(uint8_t zona) {
+    return (zonasPresentes() & (1u << zona)) != 0;
+}
+
+void zonasReiniciar() {
+    presentes.store(0, std::memory_order_relaxed);
+    pendente.store(false, std::memory_order_relaxed);
+    republicar.store(false, std::memory_order_relaxed);
+    aplicando.store(false, std::memory_order_relaxed);
+    disparadas.store(0, std::memory_order_relaxed);
+    for (uint8_t z = 0; z < NUM_ZONAS; ++z) {
+        ultimoEstado[z].store(0, std::memory_order_relaxed);
+        sequencia[z].store(0, std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,146 @@
+// ========================================================
+// BENCHMARK DOS CAMINHOS QUENTES DO FIRMWARE
+// ========================================================
+// Roda no ambiente native:  pio test -e native -f test_bench -v
+// Para cada caminho imprime ns/op e alocações de heap por chamada.
+// Os números servem para comparar versões entre si; não são o
+// tempo absoluto do ESP32.
+#include <unity.h>
+#include <chrono>
+
+#include "hal.h"
+#include "alarme.h"
+#include "comandos.h"
+#include "formatacao.h"
+#include "publicador.h"
+#include "telemetria.h"
+#include "topicos.h"
+
+// ---------------- Infra de medição ----------------
+static const unsigned long ITERACOES = 200000;
+
+template <typename F>
+static void medir(const char* nome, F&& corpo) {
+    for (unsigned long i = 0; i < ITERACOES / 10; ++i) corpo(i);  // aquecimento
+
+    unsigned long alocAntes = halNativeAlocacoes;
+    auto inicio = std::chrono::steady_clock::now();
+    for (unsigned long i = 0; i < ITERACOES; ++i) corpo(i);
+    auto fim = std::chrono::steady_clock::now();
+    unsigned long aloc = halNativeAlocacoes - alocAntes;
+
+    double ns = std::chrono::duration<double, std::nano>(fim - inicio).count() / ITERACOES;
+    char linha[128];
+    snprintf(linha, sizeof(linha), "%-24s %10.1f ns/op %8.2f allocs/op",
+             nome, ns, (double)aloc / ITERACOES);
+    TEST_MESSAGE(linha);
+}
+
+void setUp() {
+    mqttClient.conectado = true;
+    maquinaAlarme.reiniciar();
+}
+
+void tearDown() {}
+
+// ---------------- Benchmarks ----------------
+void bench_parseRGB() {
+    const char msg[] = "128,64,255";
+    uint8_t r, g, b;
+    medir("parseRGB", [&](unsigned long) {
+        parseRGB(msg, sizeof(msg) - 1, r, g, b);
+    });
+    TEST_ASSERT_EQUAL_UINT8(64, g);
+}
+
+void bench_mqttCallback_led() {
+    char topico[] = TOPICO_LED_PREFIXO "sala";
+    byte liga[] = "255,255,255";
+    byte desliga[] = "0,0,0";
+    medir("mqttCallback led", [&](unsigned long i) {
+        if (i & 1) mqttCallback(topico, desliga, sizeof(desliga) - 1);
+        else mqttCallback(topico, liga, sizeof(liga) - 1);
+        publicadorDrenar(mqttClient);
+    });
+}
+
+void bench_mqttCallback_cmd() {
+    char topico[] = TOPICO_CMD;
+    byte stop[] = "STOP";
+    medir("mqttCallback cmd", [&](unsigned long) {
+        mqttCallback(topico, stop, sizeof(stop) - 1);
+        publicadorDrenar(mqttClient);
+    });
+    TEST_ASSERT_EQUAL(ESTADO_OK, alarmeEstado());
+}
+
+void bench_avaliarSensor() {
+    medir("avaliarSensor", [&](unsigned long i) {
+        alarmeEntrada(ENTRADA_SILENCIAR);
+        avaliarSensor(0, (i & 7) == 0 ? 12.5f : 150.0f, micros());
+        publicadorDrenar(mqttClient);
+    });
+}
+
+void bench_filtro() {
+    FiltroDistancia filtro(filtroConfigPadrao(30.0f));
+    medir("FiltroDistancia", [&](unsigned long i) {
+        // Aproximação lenta com um eco perdido a cada 16 amostras
+        filtro.processar((i & 15) == 0 ? -1.0f : (float)(200 - (i % 190)));
+    });
+}
+
+void bench_telemetriaLote() {
+    LoteTelemetria lote;
+    lote.t0Ms = 1000;
+    lote.ultimoMs = 1000 + 100 * (TELEMETRIA_LOTE_AMOSTRAS - 1);
+    lote.quantidade = TELEMETRIA_LOTE_AMOSTRAS;
+    for (uint8_t i = 0; i < lote.quantidade; ++i) {
+        lote.amostrasMm[i] = (i % 7 == 0) ? TELEMETRIA_SEM_ECO : (uint16_t)(300 + i);
+    }
+    uint8_t quadro[TELEMETRIA_QUADRO_MAX];
+    size_t n = 0;
+    medir("telemetriaCodificarLote", [&](unsigned long) {
+        n = telemetriaCodificarLote(lote, true, quadro, sizeof(quadro));
+    });
+    TEST_ASSERT_EQUAL_UINT32(TELEMETRIA_QUADRO_MAX, n);
+}
+
+void bench_publicar() {
+    medir("publicar+drenar", [&](unsigned long) {
+        publicar(TOPICO_ESTADO, "OK");
+        publicadorDrenar(mqttClient);
+    });
+    PublicadorStats s = publicadorEstatisticas();
+    TEST_ASSERT_EQUAL_UINT32(0, s.descartadasCheia);
+}
+
+void bench_formatarMedida() {
+    char buf[16];
+    medir("formatarMedida", [&](unsigned long i) {
+        formatarMedida(buf, sizeof(buf), (float)(i % 400) * 0.5f);
+    });
+}
+
+void bench_formatarEstadoLuz() {
+    char buf[64];
+    medir("formatarEstadoLuz", [&](unsigned long i) {
+        formatarEstadoLuz(buf, sizeof(buf), i & 1, i);
+    });
+}
+
+int main(int, char**) {
+    publicadorDrenar(mqttClient);  // marca o mock como conectado
+
+    UNITY_BEGIN();
+    RUN_TEST(bench_parseRGB);
+    RUN_TEST(bench_mqttCallback_led);
+    RUN_TEST(bench_mqttCallback_cmd);
+    RUN_TEST(bench_avaliarSensor);
+    RUN_TEST(bench_filtro);
+    RUN_TEST(bench_telemetriaLote);
+    RUN_TEST(bench_publicar);
+    RUN_TEST(bench_formatarMedida);
+    RUN_TEST(bench_formatarEstadoLuz);
+    return UNITY_END();
+}
@@ -0,0 +1,175 @@
+// Testes do reconhecimento de gestos do botão (ambiente native):
+//   pio test -e native -f test_botao
+#include <unity.h>
+
+#include "hal.h"
+#include "alarme.h"
+#include "botao.h"
+#include "publicador.h"
+
+// Roda o reconhecedor como o driver faz: mudanças de nível nos
+// instantes dados e expirar() sempre que o prazo vence no caminho.
+struct Simulador {
+    ReconhecedorGestos r;
+    EventoBotao eventos[16];
+    int n = 0;
+    uint32_t agora = 0;
+
+    void ate(uint32_t t) {
+        while (r.temPrazo() && (int32_t)(r.prazoMs() - t) <= 0) {
+            uint32_t prazo = r.prazoMs();
+            EventoBotao ev;
+            if (r.expirar(prazo, ev)) eventos[n++] = ev;
+        }
+        agora = t;
+    }
+
+    void nivel(bool pressionado, uint32_t t) {
+        ate(t);
+        EventoBotao ev;
+        if (r.mudanca(pressionado, t, ev)) eventos[n++] = ev;
+    }
+
+    void clique(uint32_t t, uint32_t duracao = 80) {
+        nivel(true, t);
+        nivel(false, t + duracao);
+    }
+
+    // Eventos sem as PRESSAO, que aparecem a cada aperto
+    int gestos(EventoBotao* saida) {
+        int k = 0;
+        for (int i = 0; i < n; ++i) {
+            if (eventos[i].gesto != GESTO_PRESSAO) saida[k++] = eventos[i];
+        }
+        return k;
+    }
+};
+
+void setUp() {
+    maquinaAlarme.reiniciar();
+}
+
+void tearDown() {}
+
+void test_clique_simples() {
+    Simulador s;
+    s.clique(1000);
+    TEST_ASSERT_EQUAL_INT(1, s.n);  // só a PRESSAO até a janela fechar
+    TEST_ASSERT_EQUAL(GESTO_PRESSAO, s.eventos[0].gesto);
+    TEST_ASSERT_EQUAL_UINT32(1000, s.eventos[0].instanteMs);
+
+    s.ate(1080 + BOTAO_JANELA_CLIQUES_MS);
+    EventoBotao g[16];
+    TEST_ASSERT_EQUAL_INT(1, s.gestos(g));
+    TEST_ASSERT_EQUAL(GESTO_CLIQUE, g[0].gesto);
+    TEST_ASSERT_EQUAL_UINT8(1, g[0].cliques);
+}
+
+void test_duplo_e_multiplo() {
+    Simulador s;
+    s.clique(0);
+    s.clique(200);
+    s.ate(5000);
+    s.clique(6000);
+    s.clique(6200);
+    s.clique(6400);
+    s.ate(10000);
+
+    EventoBotao g[16];
+    TEST_ASSERT_EQUAL_INT(2, s.gestos(g));
+    TEST_ASSERT_EQUAL(GESTO_DUPLO, g[0].gesto);
+    TEST_ASSERT_EQUAL(GESTO_MULTIPLO, g[1].gesto);
+    TEST_ASSERT_EQUAL_UINT8(3, g[1].cliques);
+    // A PRESSAO traz quantos cliques vieram antes na sequência
+    TEST_ASSERT_EQUAL_UINT8(0, s.eventos[0].cliques);
+    TEST_ASSERT_EQUAL_UINT8(1, s.eventos[1].cliques);
+}
+
+void test_janela_separa_sequencias() {
+    Simulador s;
+    s.clique(0);
+    s.clique(80 + BOTAO_JANELA_CLIQUES_MS + 1);  // chegou tarde: sequência nova
+    s.ate(5000);
+    EventoBotao g[16];
+    TEST_ASSERT_EQUAL_INT(2, s.gestos(g));
+    TEST_ASSERT_EQUAL(GESTO_CLIQUE, g[0].gesto);
+    TEST_ASSERT_EQUAL(GESTO_CLIQUE, g[1].gesto);
+}
+
+void test_max_cliques_fecha_na_hora() {
+    Simulador s;
+    for (int i = 0; i < BOTAO_MAX_CLIQUES; ++i) s.clique(i * 150, 60);
+    EventoBotao g[16];
+    // Sem esperar a janela
+    TEST_ASSERT_EQUAL_INT(1, s.gestos(g));
+    TEST_ASSERT_EQUAL(GESTO_MULTIPLO, g[0].gesto);
+    TEST_ASSERT_EQUAL_UINT8(BOTAO_MAX_CLIQUES, g[0].cliques);
+    TEST_ASSERT_FALSE(s.r.temPrazo());
+}
+
+void test_toque_longo_emitido_segurando() {
+    Simulador s;
+    s.nivel(true, 100);
+    s.ate(100 + BOTAO_LONGO_MS - 1);
+    EventoBotao g[16];
+    TEST_ASSERT_EQUAL_INT(0, s.gestos(g));
+    s.ate(100 + BOTAO_LONGO_MS);
+    TEST_ASSERT_EQUAL_INT(1, s.gestos(g));
+    TEST_ASSERT_EQUAL(GESTO_LONGO, g[0].gesto);
+
+    // Soltar depois não vira clique
+    s.nivel(false, 5000);
+    s.ate(10000);
+    TEST_ASSERT_EQUAL_INT(1, s.gestos(g));
+}
+
+void test_segurar_nao_repete_cliques() {
+    // O polling antigo contava um clique a cada 50 ms com o botão
+    // apertado; aqui segurar 1 s é um único aperto
+    Simulador s;
+    s.clique(0, 1000);
+    s.ate(5000);
+    EventoBotao g[16];
+    TEST_ASSERT_EQUAL_INT(1, s.gestos(g));
+    TEST_ASSERT_EQUAL(GESTO_CLIQUE, g[0].gesto);
+}
+
+void test_gestos_no_alarme() {
+    EventoBotao ev = {GESTO_PRESSAO, 0, 0};
+    alarmeEntrada(ENTRADA_DETECCAO);
+    tratarGestoBotao(ev);
+    TEST_ASSERT_EQUAL(ESTADO_OK, alarmeEstado());
+
+    // Pressões seguintes da mesma sequência não mexem no alarme
+    alarmeEntrada(ENTRADA_DETECCAO);
+    ev.cliques = 3;
+    tratarGestoBotao(ev);
+    TEST_ASSERT_EQUAL(ESTADO_ALERTA, alarmeEstado());
+
+    ev.gesto = GESTO_MULTIPLO;
+    ev.cliques = BOTAO_MAX_CLIQUES;
+    tratarGestoBotao(ev);
+    TEST_ASSERT_EQUAL(ESTADO_PAUSADO, alarmeEstado());
+
+    // Pausado: a pressão não "silencia" para armado
+    ev.gesto = GESTO_PRESSAO;
+    ev.cliques = 0;
+    tratarGestoBotao(ev);
+    TEST_ASSERT_EQUAL(ESTADO_PAUSADO, alarmeEstado());
+
+    ev.gesto = GESTO_LONGO;
+    tratarGestoBotao(ev);
+    TEST_ASSERT_EQUAL(ESTADO_OK, alarmeEstado());
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_clique_simples);
+    RUN_TEST(test_duplo_e_multiplo);
+    RUN_TEST(test_janela_separa_sequencias);
+    RUN_TEST(test_max_cliques_fecha_na_hora);
+    RUN_TEST(test_toque_longo_emitido_segurando);
+    RUN_TEST(test_segurar_nao_repete_cliques);
+    RUN_TEST(test_gestos_no_alarme);
+    return UNITY_END();
+}
@@ -0,0 +1,315 @@
+// Testes do tratamento de comandos MQTT (ambiente native):
+//   pio test -e native -f test_comandos
+#include <unity.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "hal.h"
+#include "alarme.h"
+#include "comandos.h"
+#include "comodos.h"
+#include "eventos.h"
+#include "padroes.h"
+#include "pinos.h"
+#include "publicador.h"
+#include "topicos.h"
+
+static void enviar(const char* topico, const char* payload) {
+    char t[128];
+    snprintf(t, sizeof(t), "%s", topico);
+    mqttCallback(t, (byte*)payload, (unsigned int)strlen(payload));
+    publicadorDrenar(mqttClient);
+}
+
+// Deixa acabar os fades andando e dispara (e registra) o que esperava
+// por eles (transicao.h)
+static void assentarLuzes() {
+    for (int i = 0; i < 2; ++i) {
+        halNativeRelogioUs += (uint64_t)(TRANSICAO_MAX_MS + TRANSICAO_FOLGA_MS) * 1000;
+        comodosServicar(millis());
+    }
+    publicadorDrenar(mqttClient);
+}
+
+void setUp() {
+    mqttClient.conectado = true;
+    maquinaAlarme.reiniciar();
+    assentarLuzes();
+}
+
+void tearDown() {}
+
+void test_parseRGB_valido() {
+    uint8_t r, g, b;
+    TEST_ASSERT_TRUE(parseRGB("12,34,56", 8, r, g, b));
+    TEST_ASSERT_EQUAL_UINT8(12, r);
+    TEST_ASSERT_EQUAL_UINT8(34, g);
+    TEST_ASSERT_EQUAL_UINT8(56, b);
+
+    TEST_ASSERT_TRUE(parseRGB(" 1, 2 ,3", 8, r, g, b));
+    TEST_ASSERT_EQUAL_UINT8(2, g);
+}
+
+void test_parseRGB_limita_faixa() {
+    uint8_t r, g, b;
+    TEST_ASSERT_TRUE(parseRGB("300,-5,255", 10, r, g, b));
+    TEST_ASSERT_EQUAL_UINT8(255, r);
+    TEST_ASSERT_EQUAL_UINT8(0, g);
+    TEST_ASSERT_EQUAL_UINT8(255, b);
+}
+
+void test_parseRGB_invalido() {
+    uint8_t r, g, b;
+    TEST_ASSERT_FALSE(parseRGB("1,2", 3, r, g, b));
+    TEST_ASSERT_FALSE(parseRGB("a,2,3", 5, r, g, b));
+    TEST_ASSERT_FALSE(parseRGB("1,2,3,4", 7, r, g, b));
+    TEST_ASSERT_FALSE(parseRGB("1,,3", 4, r, g, b));
+    TEST_ASSERT_FALSE(parseRGB("", 0, r, g, b));
+    // O tamanho manda, não um '\0': "9" depois do fim é ignorado
+    TEST_ASSERT_TRUE(parseRGB("1,2,39", 5, r, g, b));
+    TEST_ASSERT_EQUAL_UINT8(3, b);
+}
+
+void test_parseCorLuz_duracao_opcional() {
+    uint8_t r, g, b;
+    uint32_t ms;
+    TEST_ASSERT_TRUE(parseCorLuz("1,2,3", 5, r, g, b, ms));
+    TEST_ASSERT_EQUAL_UINT32(TRANSICAO_PADRAO_MS, ms);
+    TEST_ASSERT_TRUE(parseCorLuz("1,2,3,750", 9, r, g, b, ms));
+    TEST_ASSERT_EQUAL_UINT32(750, ms);
+    TEST_ASSERT_EQUAL_UINT8(3, b);
+    TEST_ASSERT_TRUE(parseCorLuz("1,2,3,99999", 11, r, g, b, ms));
+    TEST_ASSERT_EQUAL_UINT32(TRANSICAO_MAX_MS, ms);
+    TEST_ASSERT_FALSE(parseCorLuz("1,2,3,4,5", 9, r, g, b, ms));
+    TEST_ASSERT_FALSE(parseCorLuz("1,2,3,", 6, r, g, b, ms));
+}
+
+void test_led_sala_aplica_cor() {
+    enviar(TOPICO_LED_PREFIXO "sala", "10,20,30");
+    TEST_ASSERT_EQUAL_UINT32(gamaDuty(10), halNativeLedc[COMODOS[0].canais[0]]);
+    TEST_ASSERT_EQUAL_UINT32(gamaDuty(20), halNativeLedc[COMODOS[0].canais[1]]);
+    TEST_ASSERT_EQUAL_UINT32(gamaDuty(30), halNativeLedc[COMODOS[0].canais[2]]);
+    enviar(TOPICO_LED_PREFIXO "sala", "0,0,0");
+}
+
+void test_led_quarto_pelo_curinga() {
+    enviar(TOPICO_LED_PREFIXO "quarto", "7,8,9");
+    TEST_ASSERT_EQUAL_UINT32(gamaDuty(7), halNativeLedc[COMODOS[1].canais[0]]);
+    TEST_ASSERT_TRUE(estadosComodos[1].ligado);
+    TEST_ASSERT_EQUAL_STRING(COMODOS[1].topicoEstado, mqttClient.ultimoTopico);
+    // Ainda no fade de 7,8,9: apaga quando o lote disparar
+    enviar(TOPICO_LED_PREFIXO "quarto", "0,0,0");
+    TEST_ASSERT_TRUE(estadosComodos[1].ligado);
+    assentarLuzes();
+    TEST_ASSERT_FALSE(estadosComodos[1].ligado);
+}
+
+void test_comodo_desconhecido_ignorado() {
+    unsigned long antes = mqttClient.publicacoes;
+    enviar(TOPICO_LED_PREFIXO "garagem", "1,2,3");
+    TEST_ASSERT_EQUAL_UINT32(antes, mqttClient.publicacoes);
+}
+
+void test_topico_desconhecido_ignorado() {
+    unsigned long antes = mqttClient.publicacoes;
+    enviar("projeto/home-security/outro", "STOP");
+    TEST_ASSERT_EQUAL_UINT32(antes, mqttClient.publicacoes);
+}
+
+void test_stop_limpa_alerta() {
+    alarmeEntrada(ENTRADA_DETECCAO);
+    TEST_ASSERT_EQUAL(ESTADO_ALERTA, alarmeEstado());
+    enviar(TOPICO_CMD, "STOP");
+    TEST_ASSERT_EQUAL(ESTADO_OK, alarmeEstado());
+    while (padroesAvancar() > 0) {}
+}
+
+// padroes_native.cpp: último agendamento pedido ao "timer"
+extern long padroesNativeProximoMs;
+
+void test_pause_nao_bloqueia_e_bipa_tres_vezes() {
+    uint64_t antes = halNativeRelogioUs;
+    enviar(TOPICO_CMD, "PAUSE");
+    TEST_ASSERT_EQUAL(ESTADO_PAUSADO, alarmeEstado());
+    // Nada de vTaskDelay no caminho do comando: o relógio não andou
+    TEST_ASSERT_EQUAL_UINT64(antes, halNativeRelogioUs);
+    TEST_ASSERT_EQUAL_INT(0, padroesNativeProximoMs);
+
+    // O "timer" executa os passos; conta as subidas do buzzer
+    int bipes = 0;
+    uint32_t totalMs = 0;
+    uint32_t anterior = 0;
+    for (uint32_t ms = padroesAvancar(); ms > 0; ms = padroesAvancar()) {
+        if (anterior == 0 && halNativeLedc[BUZZER_CHANNEL] > 0) ++bipes;
+        anterior = halNativeLedc[BUZZER_CHANNEL];
+        totalMs += ms;
+    }
+    TEST_ASSERT_EQUAL_INT(3, bipes);
+    TEST_ASSERT_EQUAL_UINT32(3 * 120 + 2 * 80, totalMs);
+    TEST_ASSERT_EQUAL_UINT32(0, halNativeLedc[BUZZER_CHANNEL]);
+
+    enviar(TOPICO_CMD, "RESUME");
+    while (padroesAvancar() > 0) {}
+}
+
+void test_alerta_pisca_ate_parar() {
+    ligarAlerta();
+    TEST_ASSERT_EQUAL(PADRAO_ALERTA, padraoDeFundo());
+    TEST_ASSERT_EQUAL_UINT32(100, padroesAvancar());
+    TEST_ASSERT_EQUAL_UINT8(HIGH, halNativeGpio[LED_RED]);
+    TEST_ASSERT_EQUAL_UINT32(100, padroesAvancar());
+    TEST_ASSERT_EQUAL_UINT8(LOW, halNativeGpio[LED_RED]);
+    TEST_ASSERT_EQUAL_UINT32(100, padroesAvancar());
+    TEST_ASSERT_EQUAL_UINT8(HIGH, halNativeGpio[LED_RED]);
+    TEST_ASSERT_TRUE(halNativeLedc[BUZZER_CHANNEL] > 0);
+
+    desligarAlerta();
+    TEST_ASSERT_EQUAL_UINT32(0, padroesAvancar());
+    TEST_ASSERT_EQUAL_UINT32(0, halNativeLedc[BUZZER_CHANNEL]);
+    TEST_ASSERT_EQUAL_UINT8(LOW, halNativeGpio[LED_RED]);
+    TEST_ASSERT_EQUAL_UINT8(HIGH, halNativeGpio[LED_GREEN]);
+}
+
+void test_publicacao_acorda_mqtt() {
+    eventosEsperar(EVENTO_PUBLICAR, 0);  // limpa
+    TEST_ASSERT_EQUAL_UINT32(0, eventosEsperar(EVENTO_PUBLICAR, 0));
+
+    char t[] = TOPICO_LED_PREFIXO "sala";
+    mqttCallback(t, (byte*)"1,1,1", 5);  // acende: publica ON
+    TEST_ASSERT_EQUAL_UINT32(EVENTO_PUBLICAR, eventosEsperar(EVENTO_PUBLICAR | EVENTO_SOCKET, 0));
+
+    // Sem mudança de ON/OFF não há o que publicar: nada acorda a taskMQTT
+    mqttCallback(t, (byte*)"2,2,2", 5);
+    TEST_ASSERT_EQUAL_UINT32(0, eventosEsperar(EVENTO_PUBLICAR, 0));
+    enviar(t, "0,0,0");
+}
+
+// ---------------- Cenas ----------------
+// transicao_native.cpp: chamadas a transicaoCanais()
+extern uint32_t transicaoNativeLotes;
+
+void test_parseCena_valida() {
+    Cena cena;
+    const char* p = "sala=255,180,90,800;quarto=1,2,3;alarme=PAUSE";
+    TEST_ASSERT_EQUAL_INT(-1, parseCena(p, strlen(p), cena));
+    TEST_ASSERT_EQUAL_UINT8(2, cena.numCores);
+    TEST_ASSERT_EQUAL_UINT8(0, cena.cores[0].indice);
+    TEST_ASSERT_EQUAL_UINT32(800, cena.cores[0].duracaoMs);
+    TEST_ASSERT_EQUAL_UINT8(1, cena.cores[1].indice);
+    TEST_ASSERT_EQUAL_UINT32(TRANSICAO_PADRAO_MS, cena.cores[1].duracaoMs);
+    TEST_ASSERT_TRUE(cena.mudaAlarme);
+    TEST_ASSERT_EQUAL(ENTRADA_PAUSAR, cena.entradaAlarme);
+
+    // Cômodo repetido: vale o último
+    p = "sala=1,1,1;sala=9,9,9";
+    TEST_ASSERT_EQUAL_INT(-1, parseCena(p, strlen(p), cena));
+    TEST_ASSERT_EQUAL_UINT8(1, cena.numCores);
+    TEST_ASSERT_EQUAL_UINT8(9, cena.cores[0].r);
+    TEST_ASSERT_FALSE(cena.mudaAlarme);
+}
+
+void test_parseCena_aponta_o_alvo_invalido() {
+    Cena cena;
+    const char* casos[][2] = {
+        {"", "0"},
+        {"sala", "0"},
+        {"sala=1,2", "0"},
+        {"sala=1,2,3;garagem=1,2,3", "1"},
+        {"sala=1,2,3;quarto=1,2,3;alarme=DORMIR", "2"},
+        {"alarme=STOP;", "1"},
+        {"sala=1,2,3;;quarto=1,2,3", "1"},
+    };
+    for (auto& caso : casos) {
+        TEST_ASSERT_EQUAL_INT_MESSAGE(atoi(caso[1]), parseCena(caso[0], strlen(caso[0]), cena),
+                                      caso[0]);
+    }
+}
+
+void test_cena_muda_luzes_juntas_e_confirma_uma_vez() {
+    enviar(TOPICO_LED_PREFIXO "quarto", "5,5,5");
+    // Com um fade ainda andando a cena esperaria por ele (transicao.h)
+    assentarLuzes();
+    uint32_t lotes = transicaoNativeLotes;
+    unsigned long publicacoes = mqttClient.publicacoes;
+
+    enviar(TOPICO_CENA, "sala=255,180,90,800;quarto=0,0,0,800;alarme=PAUSE");
+    TEST_ASSERT_EQUAL_UINT32(lotes + 1, transicaoNativeLotes);
+    // Nenhum led/<nome>/estado: confirmação, sensor/estado e as zonas
+    TEST_ASSERT_EQUAL_UINT32(publicacoes + 2 + NUM_ZONAS, mqttClient.publicacoes);
+    TEST_ASSERT_EQUAL_UINT32(gamaDuty(180), halNativeLedc[COMODOS[0].canais[1]]);
+    TEST_ASSERT_EQUAL_UINT32(0, halNativeLedc[COMODOS[1].canais[0]]);
+    TEST_ASSERT_TRUE(estadosComodos[0].ligado);
+    TEST_ASSERT_FALSE(estadosComodos[1].ligado);
+    TEST_ASSERT_EQUAL(ESTADO_PAUSADO, alarmeEstado());
+
+    // Confirmação é a última publicação: sai depois de tudo aplicado
+    TEST_ASSERT_EQUAL_STRING(TOPICO_CENA_ESTADO, mqttClient.ultimoTopico);
+    TEST_ASSERT_EQUAL_STRING("OK,3,PAUSADO,ON,OFF", (const char*)mqttClient.ultimoPayload);
+    TEST_ASSERT_FALSE(mqttClient.ultimoRetido);
+
+    enviar(TOPICO_CENA, "sala=0,0,0;alarme=RESUME");
+    TEST_ASSERT_EQUAL_STRING("OK,2,OK,OFF,OFF", (const char*)mqttClient.ultimoPayload);
+    while (padroesAvancar() > 0) {}
+}
+
+void test_cena_invalida_nao_aplica_nada() {
+    uint32_t lotes = transicaoNativeLotes;
+    enviar(TOPICO_CENA, "sala=255,0,0;alarme=PAUSE;quarto=lixo");
+    TEST_ASSERT_EQUAL_UINT32(lotes, transicaoNativeLotes);
+    TEST_ASSERT_FALSE(estadosComodos[0].ligado);
+    TEST_ASSERT_EQUAL(ESTADO_OK, alarmeEstado());
+    TEST_ASSERT_EQUAL_STRING(TOPICO_CENA_ESTADO, mqttClient.ultimoTopico);
+    TEST_ASSERT_EQUAL_STRING("INVALIDA,2", (const char*)mqttClient.ultimoPayload);
+}
+
+void test_comandos_sem_alocacao() {
+    // Aquece: primeira publicação de cada tópico etc.
+    enviar(TOPICO_LED_PREFIXO "sala", "255,0,0");
+    enviar(TOPICO_LED_PREFIXO "sala", "0,0,0");
+    enviar(TOPICO_CMD, "STOP");
+
+    const char* casos[][2] = {
+        {TOPICO_LED_PREFIXO "sala", "255,128,0"},
+        {TOPICO_LED_PREFIXO "sala", "0,0,0"},
+        {TOPICO_LED_PREFIXO "quarto", "1,2,3"},
+        {TOPICO_LED_PREFIXO "quarto", "0,0,0"},
+        {TOPICO_LED_PREFIXO "quarto", "lixo"},
+        {TOPICO_LED_PREFIXO "garagem", "1,2,3"},
+        {TOPICO_CMD, "STOP"},
+        {TOPICO_CMD, "TELEMETRIA:TEXTO"},
+        {TOPICO_CMD, "DESCONHECIDO"},
+        {TOPICO_CENA, "sala=9,9,9,300;quarto=9,9,9,300"},
+        {TOPICO_CENA, "sala=0,0,0;quarto=0,0,0;alarme=STOP"},
+        {TOPICO_CENA, "sala=0,0,0;varanda=1,1,1"},
+    };
+
+    for (auto& caso : casos) {
+        unsigned long antes = halNativeAlocacoes;
+        enviar(caso[0], caso[1]);
+        TEST_ASSERT_EQUAL_UINT_MESSAGE(antes, halNativeAlocacoes, caso[1]);
+    }
+}
+
+int main(int, char**) {
+
+    UNITY_BEGIN();
+    RUN_TEST(test_parseRGB_valido);
+    RUN_TEST(test_parseRGB_limita_faixa);
+    RUN_TEST(test_parseRGB_invalido);
+    RUN_TEST(test_parseCorLuz_duracao_opcional);
+    RUN_TEST(test_led_sala_aplica_cor);
+    RUN_TEST(test_led_quarto_pelo_curinga);
+    RUN_TEST(test_comodo_desconhecido_ignorado);
+    RUN_TEST(test_topico_desconhecido_ignorado);
+    RUN_TEST(test_stop_limpa_alerta);
+    RUN_TEST(test_pause_nao_bloqueia_e_bipa_tres_vezes);
+    RUN_TEST(test_alerta_pisca_ate_parar);
+    RUN_TEST(test_publicacao_acorda_mqtt);
+    RUN_TEST(test_parseCena_valida);
+    RUN_TEST(test_parseCena_aponta_o_alvo_invalido);
+    RUN_TEST(test_cena_muda_luzes_juntas_e_confirma_uma_vez);
+    RUN_TEST(test_cena_invalida_nao_aplica_nada);
+    RUN_TEST(test_comandos_sem_alocacao);
+    return UNITY_END();
+}
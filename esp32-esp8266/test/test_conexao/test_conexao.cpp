@@ -0,0 +1,205 @@
+// Testes do gerenciador de conexão e do backoff (ambiente native):
+//   pio test -e native -f test_conexao
+#include <unity.h>
+
+#include "hal.h"
+#include "comandos.h"
+#include "conexao.h"
+#include "publicador.h"
+#include "topicos.h"
+
+static GerenciadorConexao g;
+
+void setUp() {
+    g.iniciar(1000, 42);
+}
+
+void tearDown() {}
+
+// ---------------- Backoff ----------------
+void test_backoff_cresce_ate_o_teto_com_jitter() {
+    Backoff b(500, 8000, 7);
+    uint32_t teto = 500;
+    for (int i = 0; i < 12; ++i) {
+        uint32_t espera = b.proximo();
+        TEST_ASSERT_TRUE(espera >= teto / 2);
+        TEST_ASSERT_TRUE(espera <= teto);
+        if (teto < 8000) teto *= 2;
+    }
+    b.reiniciar();
+    TEST_ASSERT_TRUE(b.proximo() <= 500);
+}
+
+void test_backoff_nao_estoura_em_muitas_falhas() {
+    Backoff b(CONEXAO_BACKOFF_BASE_MS, CONEXAO_BACKOFF_MAX_MS, 1);
+    for (int i = 0; i < 100; ++i) {
+        uint32_t espera = b.proximo();
+        TEST_ASSERT_TRUE(espera >= CONEXAO_BACKOFF_BASE_MS / 2);
+        TEST_ASSERT_TRUE(espera <= CONEXAO_BACKOFF_MAX_MS);
+    }
+}
+
+void test_backoff_espalha_dispositivos() {
+    // Mesma sequência de falhas, sementes diferentes: esperas diferentes
+    Backoff a(500, 60000, 1), b(500, 60000, 2);
+    int iguais = 0;
+    for (int i = 0; i < 10; ++i) {
+        if (a.proximo() == b.proximo()) ++iguais;
+    }
+    TEST_ASSERT_TRUE(iguais < 3);
+}
+
+// ---------------- Máquina ----------------
+void test_fluxo_ate_online() {
+    TEST_ASSERT_EQUAL(LINK_ESPERA, g.estado());
+    TEST_ASSERT_EQUAL_UINT32(0, g.prazoMs(1000));  // primeira tentativa imediata
+
+    TEST_ASSERT_EQUAL(ACAO_INICIAR_WIFI, g.servicar(1000));
+    TEST_ASSERT_EQUAL(LINK_WIFI_CONECTANDO, g.estado());
+    TEST_ASSERT_EQUAL(ACAO_NENHUMA, g.servicar(1500));
+    TEST_ASSERT_EQUAL_UINT32(CONEXAO_PRAZO_WIFI_MS - 500, g.prazoMs(1500));
+
+    g.wifiAssociado(2000);
+    TEST_ASSERT_EQUAL(LINK_AGUARDANDO_IP, g.estado());
+    g.wifiEnderecoObtido();
+    TEST_ASSERT_EQUAL(LINK_MQTT_CONECTANDO, g.estado());
+    TEST_ASSERT_EQUAL_UINT32(0, g.prazoMs(2500));
+
+    TEST_ASSERT_EQUAL(ACAO_CONECTAR_MQTT, g.servicar(2500));
+    g.mqttResultado(true, 3000);
+    TEST_ASSERT_TRUE(g.online());
+    TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, g.prazoMs(3000));
+    TEST_ASSERT_EQUAL(ACAO_NENHUMA, g.servicar(3000));
+
+    ConexaoStats s = g.estatisticas();
+    TEST_ASSERT_EQUAL_UINT32(2000, s.primeiraConexaoMs);
+    TEST_ASSERT_EQUAL_UINT32(1, s.tentativasWifi);
+    TEST_ASSERT_EQUAL_UINT32(1, s.tentativasMqtt);
+    TEST_ASSERT_EQUAL_UINT32(0, s.quedas);
+}
+
+void test_sem_ipv6_tenta_o_broker_no_prazo() {
+    g.servicar(1000);
+    g.wifiAssociado(1100);
+    TEST_ASSERT_EQUAL(ACAO_NENHUMA, g.servicar(1100 + CONEXAO_PRAZO_IPV6_MS - 1));
+    TEST_ASSERT_EQUAL(ACAO_CONECTAR_MQTT, g.servicar(1100 + CONEXAO_PRAZO_IPV6_MS));
+}
+
+void test_timeout_do_wifi_agenda_backoff() {
+    g.servicar(1000);
+    TEST_ASSERT_EQUAL(ACAO_NENHUMA, g.servicar(1000 + CONEXAO_PRAZO_WIFI_MS));
+    TEST_ASSERT_EQUAL(LINK_ESPERA, g.estado());
+    TEST_ASSERT_EQUAL_UINT32(1, g.estatisticas().timeoutsWifi);
+
+    uint32_t agora = 1000 + CONEXAO_PRAZO_WIFI_MS;
+    uint32_t espera = g.prazoMs(agora);
+    TEST_ASSERT_TRUE(espera >= CONEXAO_BACKOFF_BASE_MS / 2 && espera <= CONEXAO_BACKOFF_BASE_MS);
+    TEST_ASSERT_EQUAL(ACAO_NENHUMA, g.servicar(agora + espera - 1));
+    TEST_ASSERT_EQUAL(ACAO_INICIAR_WIFI, g.servicar(agora + espera));
+}
+
+void test_falhas_do_broker_nao_refazem_o_wifi() {
+    g.servicar(1000);
+    g.wifiAssociado(1000);
+    g.wifiEnderecoObtido();
+
+    uint32_t agora = 1000;
+    uint32_t esperaAnterior = 0;
+    for (int i = 0; i < 6; ++i) {
+        TEST_ASSERT_EQUAL(ACAO_CONECTAR_MQTT, g.servicar(agora));
+        g.mqttResultado(false, agora);
+        uint32_t espera = g.prazoMs(agora);
+        // o teto dobra: a espera mínima de agora supera a máxima de duas falhas atrás
+        if (i >= 2) TEST_ASSERT_TRUE(espera * 2 > esperaAnterior);
+        esperaAnterior = espera;
+        agora += espera;
+    }
+    ConexaoStats s = g.estatisticas();
+    TEST_ASSERT_EQUAL_UINT32(1, s.tentativasWifi);
+    TEST_ASSERT_EQUAL_UINT32(6, s.falhasMqtt);
+}
+
+void test_reconexao_e_medida() {
+    g.servicar(1000);
+    g.wifiAssociado(1000);
+    g.wifiEnderecoObtido();
+    g.servicar(1000);
+    g.mqttResultado(true, 1200);
+
+    // AP some por um tempo
+    g.wifiCaiu(10000);
+    TEST_ASSERT_EQUAL(LINK_ESPERA, g.estado());
+    TEST_ASSERT_FALSE(g.online());
+
+    uint32_t agora = 10000;
+    for (int i = 0; i < 3; ++i) {
+        agora += g.prazoMs(agora);
+        TEST_ASSERT_EQUAL(ACAO_INICIAR_WIFI, g.servicar(agora));
+        g.wifiCaiu(agora + 100);  // associação recusada
+        agora += 100;
+    }
+    agora += g.prazoMs(agora);
+    TEST_ASSERT_EQUAL(ACAO_INICIAR_WIFI, g.servicar(agora));
+    g.wifiAssociado(agora + 50);
+    g.wifiEnderecoObtido();
+    TEST_ASSERT_EQUAL(ACAO_CONECTAR_MQTT, g.servicar(agora + 80));
+    g.mqttResultado(true, agora + 300);
+
+    ConexaoStats s = g.estatisticas();
+    TEST_ASSERT_EQUAL_UINT32(1, s.quedas);
+    TEST_ASSERT_EQUAL_UINT32(1, s.reconexoes);
+    TEST_ASSERT_EQUAL_UINT32(agora + 300 - 10000, s.ultimaReconexaoMs);
+    TEST_ASSERT_EQUAL_UINT32(s.ultimaReconexaoMs, s.maxReconexaoMs);
+    TEST_ASSERT_EQUAL_UINT32(s.ultimaReconexaoMs, s.offlineTotalMs);
+
+    // Queda só da sessão: volta direto ao broker
+    g.mqttCaiu(100000);
+    agora = 100000 + g.prazoMs(100000);
+    TEST_ASSERT_EQUAL(ACAO_CONECTAR_MQTT, g.servicar(agora));
+    g.mqttResultado(true, agora + 20);
+    s = g.estatisticas();
+    TEST_ASSERT_EQUAL_UINT32(2, s.quedas);
+    TEST_ASSERT_EQUAL_UINT32(agora + 20 - 100000, s.ultimaReconexaoMs);
+    TEST_ASSERT_TRUE(s.ultimaReconexaoMs <= CONEXAO_BACKOFF_BASE_MS + 20);  // backoff zerou no ONLINE
+}
+
+void test_relogio_virando() {
+    g.iniciar(UINT32_MAX - 100, 3);
+    TEST_ASSERT_EQUAL(ACAO_INICIAR_WIFI, g.servicar(UINT32_MAX - 100));
+    TEST_ASSERT_EQUAL(ACAO_NENHUMA, g.servicar(50));  // 151 ms depois
+    TEST_ASSERT_EQUAL(LINK_WIFI_CONECTANDO, g.estado());
+}
+
+// ---------------- Publicador ----------------
+void test_publicar_offline_recusa_sem_enfileirar() {
+    mqttClient.conectado = false;
+    publicadorDrenar(mqttClient);
+    TEST_ASSERT_FALSE(publicadorConectado());
+
+    PublicadorStats antes = publicadorEstatisticas();
+    TEST_ASSERT_FALSE(publicar(TOPICO_ESTADO, "OK,1", true));
+    PublicadorStats depois = publicadorEstatisticas();
+    TEST_ASSERT_EQUAL_UINT32(antes.descartadasOffline + 1, depois.descartadasOffline);
+    TEST_ASSERT_EQUAL_UINT32(antes.enfileiradas, depois.enfileiradas);
+
+    mqttClient.conectado = true;
+    publicadorDrenar(mqttClient);
+    TEST_ASSERT_TRUE(publicar(TOPICO_ESTADO, "OK,2", true));
+    publicadorDrenar(mqttClient);
+    TEST_ASSERT_EQUAL_STRING("OK,2", (const char*)mqttClient.ultimoPayload);
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_backoff_cresce_ate_o_teto_com_jitter);
+    RUN_TEST(test_backoff_nao_estoura_em_muitas_falhas);
+    RUN_TEST(test_backoff_espalha_dispositivos);
+    RUN_TEST(test_fluxo_ate_online);
+    RUN_TEST(test_sem_ipv6_tenta_o_broker_no_prazo);
+    RUN_TEST(test_timeout_do_wifi_agenda_backoff);
+    RUN_TEST(test_falhas_do_broker_nao_refazem_o_wifi);
+    RUN_TEST(test_reconexao_e_medida);
+    RUN_TEST(test_relogio_virando);
+    RUN_TEST(test_publicar_offline_recusa_sem_enfileirar);
+    return UNITY_END();
+}
@@ -0,0 +1,383 @@
+// Testes do diário de eventos contra um broker simulado (ambiente
+// native): o PubSubClient de mentira entrega cada publicação a um
+// "mosquitto" que pode estar fora do ar ou perder mensagens, e um
+// consumidor do outro lado descarta repetidos e confirma.
+//   pio test -e native -f test_diario -v
+#include <unity.h>
+
+#include <vector>
+
+#include "hal.h"
+#include "comandos.h"
+#include "diario.h"
+#include "publicador.h"
+#include "topicos.h"
+
+extern uint8_t diarioNativeFlash[];
+extern uint32_t diarioNativeTamanho;
+extern uint32_t diarioNativeApagamentos[];
+extern long diarioNativeBytesAteCorte;
+
+// ---------------- Broker + consumidor ----------------
+struct BrokerSimulado {
+    bool noAr = true;
+    uint32_t perderCada = 0;  // 0 = não perde; N = perde uma a cada N
+    uint32_t vistas = 0;
+
+    // Consumidor (o mesmo algoritmo do dashboard): aceita só o próximo
+    // id da época e confirma o maior recebido sem buracos
+    uint32_t epoca = 0;
+    uint32_t ultimo = 0;
+    std::vector<uint32_t> recebidos;
+    uint32_t duplicados = 0;
+    uint32_t foraDeOrdem = 0;  // chegou depois de um buraco
+    std::vector<uint32_t> confirmacoes;  // em trânsito para o dispositivo
+    char ultimoEvento[64] = {0};
+
+    void receber(const char* topico, const uint8_t* payload, unsigned int tamanho) {
+        if (strcmp(topico, TOPICO_EVENTOS) != 0) return;
+        ++vistas;
+        if (!noAr) return;
+        if (perderCada && vistas % perderCada == 0) return;
+
+        unsigned int ep = 0;
+        unsigned long id = 0;
+        if (sscanf((const char*)payload, "%x,%lu,", &ep, &id) != 2) return;
+        if (ep != epoca) {  // época nova: sincroniza no que chegou
+            epoca = ep;
+            ultimo = (uint32_t)id - 1;
+        }
+        if (id == ultimo + 1) {
+            ultimo = (uint32_t)id;
+            recebidos.push_back(ultimo);
+            snprintf(ultimoEvento, sizeof(ultimoEvento), "%.*s", (int)tamanho, (const char*)payload);
+        } else if (id <= ultimo) {
+            ++duplicados;
+        } else {
+            ++foraDeOrdem;
+        }
+        confirmacoes.push_back(ultimo);
+    }
+};
+
+static BrokerSimulado broker;
+
+static void espiao(const char* topico, const uint8_t* payload, unsigned int tamanho) {
+    broker.receber(topico, payload, tamanho);
+}
+
+// Um giro da taskMQTT: diário, publicador e as confirmações que o
+// broker devolveu
+static void girar(Diario& d) {
+    mqttClient.conectado = broker.noAr;
+    d.servicar(millis(), broker.noAr);
+    publicadorDrenar(mqttClient);
+    std::vector<uint32_t> acks;
+    acks.swap(broker.confirmacoes);
+    for (uint32_t id : acks) {
+        if (!broker.noAr) break;
+        char buf[24];
+        int n = snprintf(buf, sizeof(buf), "%04X,%lu", (unsigned)broker.epoca, (unsigned long)id);
+        d.confirmar(buf, (size_t)n);
+    }
+}
+
+// Gira até esvaziar, avançando o relógio para vencer os reenvios
+static void assentar(Diario& d, int giros = 2000) {
+    for (int i = 0; i < giros; ++i) {
+        girar(d);
+        if (d.estatisticas().pendentes == 0) return;
+        uint32_t prazo = d.prazoMs(millis());
+        delay(prazo == UINT32_MAX ? 10 : prazo + 1);
+    }
+}
+
+static bool contiguos(const std::vector<uint32_t>& v, uint32_t n) {
+    if (v.size() != n) return false;
+    for (uint32_t i = 0; i < n; ++i) {
+        if (v[i] != i + 1) return false;
+    }
+    return true;
+}
+
+static void apagarFlash(uint32_t setores) {
+    memset(diarioNativeFlash, 0xFF, DIARIO_MAX_SETORES * DIARIO_SETOR_BYTES);
+    memset(diarioNativeApagamentos, 0, DIARIO_MAX_SETORES * sizeof(uint32_t));
+    diarioNativeTamanho = setores * DIARIO_SETOR_BYTES;
+    diarioNativeBytesAteCorte = -1;
+}
+
+void setUp() {
+    apagarFlash(4);
+    broker = BrokerSimulado();
+    mqttClient.espiao = espiao;
+    mqttClient.conectado = true;
+    publicadorDrenar(mqttClient);
+}
+
+void tearDown() {
+    mqttClient.espiao = nullptr;
+}
+
+// ---------------- Testes ----------------
+void test_formato_do_evento() {
+    char buf[64];
+    EventoDiario a = {42, DIARIO_ALARME, ESTADO_OK, ESTADO_ALERTA, 123456};
+    formatarEventoDiario(buf, sizeof(buf), 0x1F, a);
+    TEST_ASSERT_EQUAL_STRING("001F,42,ALARME,OK,ALERTA,123456", buf);
+
+    EventoDiario l = {43, DIARIO_LUZ, 0, 0, 5321};
+    formatarEventoDiario(buf, sizeof(buf), 0xBEEF, l);
+    TEST_ASSERT_EQUAL_STRING("BEEF,43,LUZ,sala,OFF,5321", buf);
+}
+
+void test_online_entrega_em_ordem() {
+    Diario d;
+    d.iniciar(0xABCD);
+    for (uint32_t i = 0; i < 50; ++i) {
+        d.registrar(DIARIO_LUZ, 0, i & 1, i);
+        girar(d);
+    }
+    assentar(d);
+
+    TEST_ASSERT_TRUE(contiguos(broker.recebidos, 50));
+    DiarioStats s = d.estatisticas();
+    TEST_ASSERT_EQUAL_UINT32(50, s.gravados);
+    TEST_ASSERT_EQUAL_UINT32(50, s.confirmados);
+    TEST_ASSERT_EQUAL_UINT32(0, s.pendentes);
+    TEST_ASSERT_EQUAL_UINT32(0, s.reenvios);
+}
+
+void test_queda_do_broker_guarda_e_reenvia_em_ordem() {
+    Diario d;
+    d.iniciar(1);
+    for (uint32_t i = 0; i < 5; ++i) {
+        d.registrar(DIARIO_ALARME, ESTADO_OK, ESTADO_ALERTA, i);
+        girar(d);
+    }
+    assentar(d);
+
+    // Broker cai: os eventos continuam indo para a flash
+    broker.noAr = false;
+    for (uint32_t i = 0; i < 300; ++i) {
+        d.registrar(DIARIO_LUZ, 1, i & 1, i);
+        girar(d);
+        delay(100);
+    }
+    TEST_ASSERT_EQUAL_UINT32(300, d.estatisticas().pendentes);
+    TEST_ASSERT_EQUAL_UINT32(5, broker.recebidos.size());
+
+    broker.noAr = true;
+    assentar(d);
+    TEST_ASSERT_TRUE(contiguos(broker.recebidos, 305));
+    TEST_ASSERT_EQUAL_UINT32(0, d.estatisticas().pendentes);
+    TEST_ASSERT_EQUAL_STRING("0001,305,LUZ,quarto,ON,299", broker.ultimoEvento);
+}
+
+void test_perdas_voltam_pelo_prazo_sem_furar_a_ordem() {
+    Diario d;
+    d.iniciar(7);
+    broker.perderCada = 3;
+    for (uint32_t i = 0; i < 100; ++i) {
+        d.registrar(DIARIO_ALARME, ESTADO_ALERTA, ESTADO_OK, i);
+        girar(d);
+    }
+    assentar(d, 20000);
+
+    TEST_ASSERT_TRUE(contiguos(broker.recebidos, 100));
+    DiarioStats s = d.estatisticas();
+    TEST_ASSERT_EQUAL_UINT32(0, s.pendentes);
+    TEST_ASSERT_TRUE(s.reenvios > 0);
+    TEST_ASSERT_TRUE(broker.foraDeOrdem > 0);  // o consumidor viu o buraco e esperou
+}
+
+void test_reboot_retoma_do_ultimo_confirmado() {
+    Diario* d = new Diario();
+    d->iniciar(0x1234);
+    for (uint32_t i = 0; i < 10; ++i) {
+        d->registrar(DIARIO_LUZ, 0, 1, i);
+        girar(*d);
+    }
+    assentar(*d);
+    broker.noAr = false;
+    for (uint32_t i = 0; i < 20; ++i) {
+        d->registrar(DIARIO_LUZ, 0, 0, i);
+        girar(*d);
+    }
+    uint16_t epoca = d->estatisticas().epoca;
+    delete d;
+
+    // "Reboot": nova instância lendo a mesma flash
+    d = new Diario();
+    d->iniciar(0x9999);
+    DiarioStats s = d->estatisticas();
+    TEST_ASSERT_EQUAL_UINT16(epoca, s.epoca);
+    TEST_ASSERT_EQUAL_UINT32(10, s.confirmados);
+    TEST_ASSERT_EQUAL_UINT32(20, s.pendentes);
+
+    broker.noAr = true;
+    d->registrar(DIARIO_ALARME, ESTADO_OK, ESTADO_ALERTA, 0);
+    assentar(*d);
+    TEST_ASSERT_TRUE(contiguos(broker.recebidos, 31));
+    TEST_ASSERT_EQUAL_UINT32(0, broker.duplicados);  // confirmação estava na flash
+    delete d;
+}
+
+void test_escrita_cortada_nao_abre_buraco_nos_ids() {
+    Diario* d = new Diario();
+    d->iniciar(5);
+    broker.noAr = false;
+    for (uint32_t i = 0; i < 4; ++i) {
+        d->registrar(DIARIO_LUZ, 0, 1, i);
+        girar(*d);
+    }
+    diarioNativeBytesAteCorte = 5;  // energia cai no meio do registro 5
+    d->registrar(DIARIO_LUZ, 0, 1, 4);
+    girar(*d);
+    delete d;
+    diarioNativeBytesAteCorte = -1;
+
+    d = new Diario();
+    d->iniciar(5);
+    DiarioStats s = d->estatisticas();
+    TEST_ASSERT_EQUAL_UINT32(1, s.invalidos);
+    TEST_ASSERT_EQUAL_UINT32(4, s.pendentes);
+
+    d->registrar(DIARIO_LUZ, 0, 0, 99);
+    broker.noAr = true;
+    assentar(*d);
+    TEST_ASSERT_TRUE(contiguos(broker.recebidos, 5));
+    delete d;
+}
+
+void test_anel_cheio_descarta_novos_sem_buraco() {
+    apagarFlash(2);
+    Diario d;
+    d.iniciar(3);
+    broker.noAr = false;
+    const uint32_t TOTAL = 3 * DIARIO_SLOTS_POR_SETOR;
+    for (uint32_t i = 0; i < TOTAL; ++i) {
+        d.registrar(DIARIO_LUZ, 0, 1, i);
+        if (i % 8 == 0) girar(d);
+    }
+    girar(d);
+    DiarioStats s = d.estatisticas();
+    TEST_ASSERT_EQUAL_UINT32(2 * DIARIO_SLOTS_POR_SETOR, s.gravados);
+    TEST_ASSERT_EQUAL_UINT32(TOTAL - s.gravados, s.descartadosCheio);
+
+    broker.noAr = true;
+    assentar(d, 50000);
+    TEST_ASSERT_TRUE(contiguos(broker.recebidos, s.gravados));
+
+    // Confirmados, os setores voltam a ser usados
+    d.registrar(DIARIO_ALARME, ESTADO_OK, ESTADO_ALERTA, 1);
+    assentar(d);
+    TEST_ASSERT_EQUAL_UINT32(s.gravados + 1, broker.recebidos.size());
+}
+
+void test_milhares_cabem_na_particao() {
+    apagarFlash(DIARIO_MAX_SETORES);
+    Diario d;
+    d.iniciar(11);
+    broker.noAr = false;
+    for (uint32_t i = 0; i < 5000; ++i) {
+        d.registrar(DIARIO_LUZ, i % 2, i & 1, i);
+        if (i % 8 == 7) girar(d);
+    }
+    girar(d);
+    DiarioStats s = d.estatisticas();
+    TEST_ASSERT_EQUAL_UINT32(5000, s.gravados);
+    TEST_ASSERT_EQUAL_UINT32(0, s.descartadosCheio);
+    TEST_ASSERT_EQUAL_UINT32(5000, s.pendentes);
+}
+
+void test_desgaste_distribuido_entre_setores() {
+    Diario d;
+    d.iniciar(13);
+    for (uint32_t i = 0; i < 20 * DIARIO_SLOTS_POR_SETOR; ++i) {
+        d.registrar(DIARIO_ALARME, ESTADO_OK, ESTADO_ALERTA, i);
+        girar(d);
+    }
+    assentar(d);
+
+    uint32_t menor = UINT32_MAX, maior = 0;
+    for (uint32_t s = 0; s < 4; ++s) {
+        if (diarioNativeApagamentos[s] < menor) menor = diarioNativeApagamentos[s];
+        if (diarioNativeApagamentos[s] > maior) maior = diarioNativeApagamentos[s];
+    }
+    TEST_ASSERT_TRUE(menor >= 5);
+    TEST_ASSERT_TRUE(maior - menor <= 1);
+    TEST_ASSERT_EQUAL_UINT32(0, d.estatisticas().pendentes);
+}
+
+void test_proximo_setor_e_apagado_antes_de_encher() {
+    Diario d;
+    d.iniciar(17);
+    for (uint32_t i = 0; i < 3 * DIARIO_SLOTS_POR_SETOR; ++i) {
+        d.registrar(DIARIO_LUZ, 0, 1, i);
+        girar(d);
+        girar(d);  // giro ocioso: é nele que o apagamento acontece
+    }
+    assentar(d);
+    TEST_ASSERT_EQUAL_UINT32(0, d.estatisticas().apagadosNaHora);
+    TEST_ASSERT_TRUE(contiguos(broker.recebidos, 3 * DIARIO_SLOTS_POR_SETOR));
+
+    // Giros que só gravam: o que abre o setor seguinte não apaga nada
+    uint32_t antes = 0, depois = 0;
+    for (uint32_t s = 0; s < 4; ++s) antes += diarioNativeApagamentos[s];
+    for (uint32_t i = 0; i < DIARIO_SLOTS_POR_SETOR; ++i) {
+        d.registrar(DIARIO_LUZ, 0, 0, i);
+        d.servicar(millis(), false);
+    }
+    for (uint32_t s = 0; s < 4; ++s) depois += diarioNativeApagamentos[s];
+    TEST_ASSERT_EQUAL_UINT32(antes, depois);
+    TEST_ASSERT_EQUAL_UINT32(0, d.estatisticas().apagadosNaHora);
+}
+
+void test_confirmacoes_invalidas() {
+    Diario d;
+    d.iniciar(0x00AB);
+    d.registrar(DIARIO_LUZ, 0, 1, 0);
+    broker.noAr = false;  // segura a confirmação
+    mqttClient.conectado = true;
+    d.servicar(millis(), true);
+
+    TEST_ASSERT_FALSE(d.confirmar("00AC,1", 6));   // outra época
+    TEST_ASSERT_FALSE(d.confirmar("00AB,2", 6));   // além do enviado
+    TEST_ASSERT_FALSE(d.confirmar("00AB", 4));
+    TEST_ASSERT_FALSE(d.confirmar("00AB,1x", 7));
+    TEST_ASSERT_FALSE(d.confirmar("12345,1", 7));
+    TEST_ASSERT_TRUE(d.confirmar("00ab,1", 6));
+    TEST_ASSERT_FALSE(d.confirmar("00AB,1", 6));   // repetida
+}
+
+void test_confirmacao_pelo_callback_mqtt() {
+    apagarFlash(4);
+    diario.iniciar(0x0042);
+    diarioRegistrarAlarme(ESTADO_OK, ESTADO_ALERTA, 10);
+    diario.servicar(millis(), true);
+    publicadorDrenar(mqttClient);
+    TEST_ASSERT_EQUAL_UINT32(1, diario.estatisticas().pendentes);
+
+    char topico[] = TOPICO_EVENTOS_ACK;
+    const char ack[] = "0042,1";
+    mqttCallback(topico, (byte*)ack, sizeof(ack) - 1);
+    TEST_ASSERT_EQUAL_UINT32(0, diario.estatisticas().pendentes);
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_formato_do_evento);
+    RUN_TEST(test_online_entrega_em_ordem);
+    RUN_TEST(test_queda_do_broker_guarda_e_reenvia_em_ordem);
+    RUN_TEST(test_perdas_voltam_pelo_prazo_sem_furar_a_ordem);
+    RUN_TEST(test_reboot_retoma_do_ultimo_confirmado);
+    RUN_TEST(test_escrita_cortada_nao_abre_buraco_nos_ids);
+    RUN_TEST(test_anel_cheio_descarta_novos_sem_buraco);
+    RUN_TEST(test_milhares_cabem_na_particao);
+    RUN_TEST(test_desgaste_distribuido_entre_setores);
+    RUN_TEST(test_proximo_setor_e_apagado_antes_de_encher);
+    RUN_TEST(test_confirmacoes_invalidas);
+    RUN_TEST(test_confirmacao_pelo_callback_mqtt);
+    return UNITY_END();
+}
@@ -0,0 +1,355 @@
+// Testes do consumo das luzes (ambiente native):
+//   pio test -e native -f test_energia
+#include <unity.h>
+
+#include <string.h>
+#include <vector>
+#include <string>
+
+#include "hal.h"
+#include "comandos.h"
+#include "comodos.h"
+#include "energia.h"
+#include "publicador.h"
+
+extern uint32_t energiaNativeUnix;
+extern uint8_t energiaNativeNvs[];
+extern size_t energiaNativeTamanho;
+extern bool energiaNativeFalhar;
+extern uint32_t energiaNativeGravacoes;
+
+static const uint32_t MAX = TRANSICAO_DUTY_MAX;
+static const uint32_t HORA_MS = 3600000;
+
+// Uma hora no meio de um dia qualquer
+static const uint32_t DIA = 20000;
+static const uint32_t H = DIA * 24 + 5;
+
+static void mudar(Energia& e, uint32_t r, uint32_t g, uint32_t b, uint32_t duracaoMs,
+                  uint32_t agoraMs) {
+    const uint32_t duty[3] = {r, g, b};
+    e.mudou(0, duty, duracaoMs, agoraMs);
+}
+
+// Balde de hora mais novo do quadro de histórico
+static void baldeMaisNovo(const Energia& e, uint16_t& mWh, uint8_t& minutos, size_t voltar = 0) {
+    uint8_t quadro[ENERGIA_QUADRO_BYTES];
+    TEST_ASSERT_EQUAL(ENERGIA_QUADRO_BYTES, e.codificarHistorico(0, quadro, sizeof(quadro)));
+    size_t pos = 6 + (ENERGIA_HORAS - 1 - voltar) * 3;
+    mWh = quadro[pos] | (quadro[pos + 1] << 8);
+    minutos = quadro[pos + 2];
+}
+
+// ---------------- Publicações ----------------
+struct Publicacao {
+    std::string topico;
+    std::vector<uint8_t> payload;
+};
+
+static std::vector<Publicacao> publicadas;
+
+static void espiao(const char* topico, const uint8_t* payload, unsigned int tamanho) {
+    publicadas.push_back({topico, std::vector<uint8_t>(payload, payload + tamanho)});
+}
+
+static size_t contar(const char* topico) {
+    size_t n = 0;
+    for (const Publicacao& p : publicadas) n += p.topico == topico;
+    return n;
+}
+
+void setUp() {
+    halNativeRelogioUs = 1000000;
+    energiaNativeUnix = 0;
+    energiaNativeTamanho = 0;
+    energiaNativeFalhar = false;
+    energiaNativeGravacoes = 0;
+    publicadas.clear();
+}
+
+void tearDown() {}
+
+// ---------------- Integração ----------------
+void test_duty_constante() {
+    Energia e;
+    mudar(e, MAX, 0, 0, 0, 1000);
+    e.servicar(1000 + HORA_MS, 0);
+
+    ConsumoComodo c = e.consumo(0, 1000 + HORA_MS);
+    TEST_ASSERT_TRUE(c.ligado);
+    TEST_ASSERT_EQUAL_UINT32(3600, c.ligadoHaS);
+    TEST_ASSERT_EQUAL_UINT32(ENERGIA_MW_CANAL, c.potenciaMw);
+    TEST_ASSERT_EQUAL_UINT32(ENERGIA_MW_CANAL, c.hojeMwh);  // 1 h a 66 mW
+    TEST_ASSERT_EQUAL_UINT32(3600, c.hojeS);
+
+    // Apagada não consome nem conta tempo
+    mudar(e, 0, 0, 0, 0, 1000 + HORA_MS);
+    e.servicar(1000 + 2 * HORA_MS, 0);
+    c = e.consumo(0, 1000 + 2 * HORA_MS);
+    TEST_ASSERT_FALSE(c.ligado);
+    TEST_ASSERT_EQUAL_UINT32(0, c.potenciaMw);
+    TEST_ASSERT_EQUAL_UINT32(ENERGIA_MW_CANAL, c.totalMwh);
+    TEST_ASSERT_EQUAL_UINT32(3600, c.hojeS);
+}
+
+void test_fade_vira_rampa() {
+    Energia e;
+    // De apagado a branco em 1 h: metade da energia de 1 h acesa
+    mudar(e, MAX, MAX, MAX, HORA_MS, 0);
+    e.servicar(HORA_MS / 2, 0);  // integrar no meio da rampa não muda nada
+    e.servicar(HORA_MS, 0);
+    // (o duty inteiro no meio da rampa arredonda para baixo: até 1 mWh a menos)
+    TEST_ASSERT_UINT32_WITHIN(1, 3 * ENERGIA_MW_CANAL / 2 - 1, e.consumo(0, HORA_MS).hojeMwh);
+
+    e.servicar(2 * HORA_MS, 0);
+    TEST_ASSERT_UINT32_WITHIN(1, 3 * ENERGIA_MW_CANAL * 3 / 2 - 1, e.consumo(0, 2 * HORA_MS).hojeMwh);
+}
+
+void test_fade_interrompido_parte_de_onde_estava() {
+    Energia e;
+    mudar(e, MAX, 0, 0, HORA_MS, 0);
+    // No meio do fade (duty = MAX/2) volta a apagar em 1 h, descendo
+    // de MAX/2 e não de MAX
+    mudar(e, 0, 0, 0, HORA_MS, HORA_MS / 2);
+    e.servicar(3 * HORA_MS, 0);
+    // 1/8 de hora cheia na subida + 1/4 na descida = 24,75 mWh
+    TEST_ASSERT_UINT32_WITHIN(1, ENERGIA_MW_CANAL * 3 / 8 - 1, e.consumo(0, 3 * HORA_MS).totalMwh);
+}
+
+// ---------------- Baldes ----------------
+void test_hora_fechada_leva_a_sobra() {
+    Energia e;
+    e.servicar(0, H);
+    mudar(e, MAX, 0, 0, 0, 0);
+
+    // 10^6 ms a 66 mW = 18,33 mWh e 16,67 min por hora
+    TEST_ASSERT_TRUE(e.servicar(1000000, H + 1));
+    TEST_ASSERT_TRUE(e.servicar(2000000, H + 2));
+    TEST_ASSERT_TRUE(e.servicar(3000000, H + 3));
+    TEST_ASSERT_FALSE(e.servicar(3000000, H + 3));
+
+    uint16_t mWh;
+    uint8_t minutos;
+    baldeMaisNovo(e, mWh, minutos, 2);
+    TEST_ASSERT_EQUAL_UINT16(18, mWh);
+    TEST_ASSERT_EQUAL_UINT8(16, minutos);
+    baldeMaisNovo(e, mWh, minutos, 1);
+    TEST_ASSERT_EQUAL_UINT16(18, mWh);
+    TEST_ASSERT_EQUAL_UINT8(17, minutos);
+    baldeMaisNovo(e, mWh, minutos, 0);
+    TEST_ASSERT_EQUAL_UINT16(19, mWh);  // 55 mWh no total, sem perder frações
+    TEST_ASSERT_EQUAL_UINT8(17, minutos);
+
+    ConsumoComodo c = e.consumo(0, 3000000);
+    TEST_ASSERT_EQUAL_UINT32(55, c.hojeMwh);
+    TEST_ASSERT_EQUAL_UINT32(3000, c.hojeS);
+    TEST_ASSERT_EQUAL_UINT32(3, e.estatisticas().horasFechadas);
+}
+
+void test_virada_do_dia() {
+    Energia e;
+    uint32_t ultima = (DIA + 1) * 24 - 1;
+    e.servicar(0, ultima);
+    mudar(e, MAX, 0, 0, 0, 0);
+    e.servicar(HORA_MS, ultima + 1);
+    // Meia hora do dia novo
+    e.servicar(HORA_MS + HORA_MS / 2, ultima + 1);
+
+    ConsumoComodo c = e.consumo(0, HORA_MS + HORA_MS / 2);
+    TEST_ASSERT_EQUAL_UINT32(ENERGIA_MW_CANAL / 2, c.hojeMwh);
+    TEST_ASSERT_EQUAL_UINT32(1800, c.hojeS);
+    TEST_ASSERT_EQUAL_UINT32(ENERGIA_MW_CANAL * 3 / 2, c.totalMwh);
+
+    // Ontem é o penúltimo dia do quadro
+    uint8_t quadro[ENERGIA_QUADRO_BYTES];
+    e.codificarHistorico(0, quadro, sizeof(quadro));
+    size_t ontem = 6 + ENERGIA_HORAS * 3 + 1 + (ENERGIA_DIAS - 2) * 6;
+    TEST_ASSERT_EQUAL_UINT8(ENERGIA_MW_CANAL, quadro[ontem]);
+    TEST_ASSERT_EQUAL_UINT8(60, quadro[ontem + 4]);
+}
+
+void test_antes_do_relogio_vai_para_a_primeira_hora() {
+    Energia e;
+    mudar(e, MAX, 0, 0, 0, 0);
+    e.servicar(HORA_MS, 0);
+    TEST_ASSERT_EQUAL_UINT32(0, e.horaAtual());
+    TEST_ASSERT_FALSE(e.estatisticas().relogio);
+
+    // Relógio acerta: a hora de antes fica na hora aberta agora
+    TEST_ASSERT_FALSE(e.servicar(HORA_MS, H));
+    TEST_ASSERT_EQUAL_UINT32(H, e.horaAtual());
+    TEST_ASSERT_TRUE(e.servicar(2 * HORA_MS, H + 1));
+
+    uint16_t mWh;
+    uint8_t minutos;
+    baldeMaisNovo(e, mWh, minutos);
+    TEST_ASSERT_EQUAL_UINT16(2 * ENERGIA_MW_CANAL, mWh);
+    TEST_ASSERT_EQUAL_UINT8(120, minutos);
+}
+
+void test_relogio_voltando_nao_fecha_hora() {
+    Energia e;
+    e.servicar(0, H);
+    TEST_ASSERT_FALSE(e.servicar(1000, H - 2));
+    TEST_ASSERT_EQUAL_UINT32(H, e.horaAtual());
+}
+
+// ---------------- NVS ----------------
+void test_salvar_e_carregar() {
+    Energia e;
+    e.servicar(0, H);
+    mudar(e, MAX, 0, 0, 0, 0);
+    e.servicar(HORA_MS, H + 1);
+
+    uint8_t buf[ENERGIA_NVS_BYTES];
+    TEST_ASSERT_EQUAL(ENERGIA_NVS_BYTES, e.salvar(buf, sizeof(buf)));
+    TEST_ASSERT_EQUAL(0, e.salvar(buf, sizeof(buf) - 1));
+
+    Energia lida;
+    TEST_ASSERT_TRUE(lida.carregar(buf, sizeof(buf)));
+    TEST_ASSERT_EQUAL_UINT32(H + 1, lida.horaAtual());
+    TEST_ASSERT_EQUAL_UINT32(ENERGIA_MW_CANAL, lida.consumo(0, 0).totalMwh);
+    TEST_ASSERT_EQUAL_UINT32(ENERGIA_MW_CANAL, lida.consumo(0, 0).hojeMwh);
+
+    buf[0] = ENERGIA_VERSAO + 1;
+    TEST_ASSERT_FALSE(lida.carregar(buf, sizeof(buf)));
+    buf[0] = ENERGIA_VERSAO;
+    buf[1] = NUM_COMODOS + 1;
+    TEST_ASSERT_FALSE(lida.carregar(buf, sizeof(buf)));
+}
+
+void test_boot_depois_de_horas_desligado_zera_o_buraco() {
+    Energia e;
+    e.servicar(0, H);
+    mudar(e, MAX, 0, 0, 0, 0);
+    e.servicar(HORA_MS, H + 1);
+    energiaNativeTamanho = e.salvar(energiaNativeNvs, ENERGIA_NVS_BYTES);
+
+    // Volta 3 horas depois
+    Energia boot;
+    boot.iniciar();
+    TEST_ASSERT_EQUAL_UINT32(H + 1, boot.horaAtual());
+    boot.servicar(0, H + 4);
+    TEST_ASSERT_EQUAL_UINT32(H + 4, boot.horaAtual());
+    boot.servicar(HORA_MS, H + 5);
+
+    uint16_t mWh;
+    uint8_t minutos;
+    for (size_t voltar = 0; voltar < 4; ++voltar) {
+        baldeMaisNovo(boot, mWh, minutos, voltar);
+        TEST_ASSERT_EQUAL_UINT16(0, mWh);
+    }
+    baldeMaisNovo(boot, mWh, minutos, 4);  // hora H, antes do boot
+    TEST_ASSERT_EQUAL_UINT16(ENERGIA_MW_CANAL, mWh);
+    TEST_ASSERT_EQUAL_UINT32(ENERGIA_MW_CANAL, boot.consumo(0, HORA_MS).hojeMwh);
+}
+
+// ---------------- Formatos ----------------
+void test_formatar_consumo() {
+    ConsumoComodo c = {true, 125, 66, 3600, 120, 4500};
+    char buf[64];
+    formatarConsumo(buf, sizeof(buf), c);
+    TEST_ASSERT_EQUAL_STRING("ON,125,66,3600,120,4500", buf);
+    c.ligado = false;
+    formatarConsumo(buf, sizeof(buf), c);
+    TEST_ASSERT_EQUAL_STRING("OFF,125,66,3600,120,4500", buf);
+}
+
+void test_quadro_de_historico() {
+    Energia e;
+    e.servicar(0, H);
+    uint8_t quadro[ENERGIA_QUADRO_BYTES];
+    TEST_ASSERT_EQUAL(0, e.codificarHistorico(0, quadro, sizeof(quadro) - 1));
+    TEST_ASSERT_EQUAL(ENERGIA_QUADRO_BYTES, e.codificarHistorico(0, quadro, sizeof(quadro)));
+    TEST_ASSERT_EQUAL_UINT8(ENERGIA_VERSAO, quadro[0]);
+    uint32_t hora = quadro[1] | (quadro[2] << 8) | (quadro[3] << 16) | ((uint32_t)quadro[4] << 24);
+    TEST_ASSERT_EQUAL_UINT32(H - 1, hora);
+    TEST_ASSERT_EQUAL_UINT8(ENERGIA_HORAS, quadro[5]);
+    TEST_ASSERT_EQUAL_UINT8(ENERGIA_DIAS, quadro[6 + ENERGIA_HORAS * 3]);
+
+    // Hora local: UTC + ENERGIA_FUSO_HORAS
+    TEST_ASSERT_EQUAL_UINT32(H, energiaHoraLocal((H - ENERGIA_FUSO_HORAS) * 3600 + 59));
+}
+
+// ---------------- Caminho completo ----------------
+void test_definir_cor_enfileira() {
+    // comodosIniciar() apaga tudo pelo mesmo caminho
+    uint32_t antes = energia.estatisticas().eventos;
+    comodosIniciar();
+    definirCorComodo(1, 255, 0, 0, 0);
+    TEST_ASSERT_EQUAL_UINT32(antes + NUM_COMODOS + 1, energia.estatisticas().eventos);
+
+    energia.servicar(millis() + HORA_MS, 0);
+    ConsumoComodo c = energia.consumo(1, millis() + HORA_MS);
+    TEST_ASSERT_TRUE(c.ligado);
+    TEST_ASSERT_EQUAL_UINT32(ENERGIA_MW_CANAL, c.potenciaMw);
+    TEST_ASSERT_FALSE(energia.consumo(0, millis()).ligado);
+
+    // Fila cheia: conta e descarta
+    uint32_t descartados = energia.estatisticas().descartados;
+    for (int i = 0; i < ENERGIA_EVENTOS + 3; ++i) definirCorComodo(0, 0, 0, 0, 0);
+    TEST_ASSERT_EQUAL_UINT32(descartados + 3, energia.estatisticas().descartados);
+    energia.servicar(millis() + HORA_MS, 0);
+}
+
+void test_publica_resumo_e_historico() {
+    mqttClient.espiao = espiao;
+    mqttClient.conectado = true;
+    publicadorDrenar(mqttClient);  // publicador online
+
+    energiaNativeUnix = (H + 1) * 3600 - ENERGIA_FUSO_HORAS * 3600 - 60;  // H, 1 min antes do fim
+    energiaServicar(millis());
+    publicadorDrenar(mqttClient);
+    for (size_t i = 0; i < NUM_COMODOS; ++i) {
+        TEST_ASSERT_EQUAL(1, contar(COMODOS[i].topicoEnergia));
+        TEST_ASSERT_EQUAL(1, contar(COMODOS[i].topicoHistorico));
+    }
+    TEST_ASSERT_TRUE(mqttClient.ultimoRetido);
+    TEST_ASSERT_EQUAL_UINT32(ENERGIA_RESUMO_MS, energiaPrazoMs(millis()));
+
+    // Nada a fazer antes do prazo
+    publicadas.clear();
+    halNativeRelogioUs += 1000000;
+    energiaServicar(millis());
+    publicadorDrenar(mqttClient);
+    TEST_ASSERT_EQUAL(0, publicadas.size());
+
+    // Fecha a hora: grava na NVS e republica o histórico
+    energiaNativeUnix += 60;
+    energiaServicar(millis());
+    publicadorDrenar(mqttClient);
+    TEST_ASSERT_EQUAL_UINT32(1, energiaNativeGravacoes);
+    TEST_ASSERT_EQUAL(ENERGIA_NVS_BYTES, energiaNativeTamanho);
+    TEST_ASSERT_EQUAL(1, contar(COMODOS[0].topicoHistorico));
+    const Publicacao& p = publicadas[0];
+    TEST_ASSERT_EQUAL(ENERGIA_QUADRO_BYTES, p.payload.size());
+
+    // Resumo a cada ENERGIA_RESUMO_MS
+    publicadas.clear();
+    halNativeRelogioUs += (uint64_t)ENERGIA_RESUMO_MS * 1000;
+    TEST_ASSERT_EQUAL_UINT32(0, energiaPrazoMs(millis()));
+    energiaServicar(millis());
+    publicadorDrenar(mqttClient);
+    TEST_ASSERT_EQUAL(1, contar(COMODOS[0].topicoEnergia));
+    TEST_ASSERT_EQUAL(0, contar(COMODOS[0].topicoHistorico));
+
+    mqttClient.espiao = nullptr;
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_duty_constante);
+    RUN_TEST(test_fade_vira_rampa);
+    RUN_TEST(test_fade_interrompido_parte_de_onde_estava);
+    RUN_TEST(test_hora_fechada_leva_a_sobra);
+    RUN_TEST(test_virada_do_dia);
+    RUN_TEST(test_antes_do_relogio_vai_para_a_primeira_hora);
+    RUN_TEST(test_relogio_voltando_nao_fecha_hora);
+    RUN_TEST(test_salvar_e_carregar);
+    RUN_TEST(test_boot_depois_de_horas_desligado_zera_o_buraco);
+    RUN_TEST(test_formatar_consumo);
+    RUN_TEST(test_quadro_de_historico);
+    RUN_TEST(test_definir_cor_enfileira);
+    RUN_TEST(test_publica_resumo_e_historico);
+    return UNITY_END();
+}
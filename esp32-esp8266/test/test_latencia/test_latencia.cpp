@@ -0,0 +1,194 @@
+// Testes dos rastros de latência do alarme (ambiente native):
+//   pio test -e native -f test_latencia
+#include <unity.h>
+
+#include <string.h>
+
+#include "hal.h"
+#include "alarme.h"
+#include "comandos.h"
+#include "estado.h"
+#include "latencia.h"
+#include "padroes.h"
+#include "publicador.h"
+#include "topicos.h"
+#include "zonas.h"
+
+void setUp() {
+    halNativeRelogioUs = 1000000;
+    maquinaAlarme.reiniciar();
+    zonasReiniciar();
+    for (uint8_t i = 0; i < NUM_SENSORES; ++i) filtroSensor(i).reiniciar();
+}
+
+void tearDown() {}
+
+static uint16_t le16(const uint8_t* p) {
+    return p[0] | (p[1] << 8);
+}
+
+static uint32_t le32(const uint8_t* p) {
+    return le16(p) | ((uint32_t)le16(p + 2) << 16);
+}
+
+static uint32_t contagem(const LatenciaAlarme& l, MarcaLatencia marca, uint8_t balde) {
+    uint32_t c[METRICAS_MAX_BALDES];
+    l.etapa(marca).ler(c);
+    return c[balde];
+}
+
+static uint32_t total(const LatenciaAlarme& l, MarcaLatencia marca) {
+    uint32_t c[METRICAS_MAX_BALDES];
+    l.etapa(marca).ler(c);
+    uint32_t soma = 0;
+    for (uint8_t b = 0; b < l.etapa(marca).baldes(); ++b) soma += c[b];
+    return soma;
+}
+
+// ---------------- Caminho do firmware ----------------
+// Eco 300 µs antes da decisão, sirene 150 µs depois, estado entregue
+// 2 ms depois disso
+void test_disparo_marca_eco_limiar_sirene_publicado() {
+    mqttClient.conectado = true;
+    publicadorDrenar(mqttClient);
+
+    bool disparou = false;
+    for (int i = 0; i < 20 && !disparou; ++i) {
+        halNativeRelogioUs += 100000;
+        avaliarSensor(0, SENSORES[0].limiteCm / 2.0f, micros() - 300);
+        disparou = alarmeEstado() == ESTADO_ALERTA;
+    }
+    TEST_ASSERT_TRUE(disparou);
+    TEST_ASSERT_EQUAL_UINT32(1, latencia.rastros());
+    TEST_ASSERT_EQUAL_UINT32(300, latencia.etapa(MARCA_LIMIAR).maximo());
+
+    halNativeRelogioUs += 150;
+    padroesAvancar();  // primeiro passo do alerta liga o buzzer
+    TEST_ASSERT_EQUAL_UINT32(450, latencia.etapa(MARCA_SIRENE).maximo());
+    TEST_ASSERT_EQUAL_UINT32(0, total(latencia, MARCA_PUBLICADO));
+
+    halNativeRelogioUs += 2000;
+    publicadorDrenar(mqttClient);
+    TEST_ASSERT_EQUAL_UINT32(2450, latencia.etapa(MARCA_PUBLICADO).maximo());
+    TEST_ASSERT_EQUAL_UINT32(1, contagem(latencia, MARCA_PUBLICADO, 4));  // <= 5000
+
+    // O alerta repete e o estado é republicado: o rastro não muda
+    halNativeRelogioUs += 100000;
+    padroesAvancar();
+    padroesAvancar();
+    estadoRepublicar();
+    publicadorDrenar(mqttClient);
+    TEST_ASSERT_EQUAL_UINT32(1, total(latencia, MARCA_SIRENE));
+    TEST_ASSERT_EQUAL_UINT32(1, total(latencia, MARCA_PUBLICADO));
+
+    // Presença continua com o alarme em alerta: nenhum rastro novo
+    avaliarSensor(0, SENSORES[0].limiteCm / 2.0f, micros());
+    TEST_ASSERT_EQUAL_UINT32(1, latencia.rastros());
+    TEST_ASSERT_EQUAL_UINT32(0, latencia.incompletos());
+
+    alarmeEntrada(ENTRADA_SILENCIAR);
+    while (padroesAvancar() > 0) {}
+    publicadorDrenar(mqttClient);
+}
+
+// ---------------- Rastro isolado ----------------
+void test_marca_sem_rastro_e_repetida_sao_ignoradas() {
+    LatenciaAlarme l;
+    l.marcar(MARCA_SIRENE, 500);
+    TEST_ASSERT_EQUAL_UINT32(0, total(l, MARCA_SIRENE));
+
+    l.abrir(1000, 1100);
+    l.confirmar();
+    l.marcar(MARCA_SIRENE, 1200);
+    l.marcar(MARCA_SIRENE, 1900);
+    TEST_ASSERT_EQUAL_UINT32(1, total(l, MARCA_SIRENE));
+    TEST_ASSERT_EQUAL_UINT32(200, l.etapa(MARCA_SIRENE).maximo());
+    TEST_ASSERT_EQUAL_UINT32(1, contagem(l, MARCA_SIRENE, 0));  // <= 200
+}
+
+void test_descartado_nao_conta() {
+    LatenciaAlarme l;
+    l.abrir(1000, 1100);
+    l.descartar();
+    l.marcar(MARCA_SIRENE, 1200);
+    TEST_ASSERT_EQUAL_UINT32(0, l.rastros());
+    TEST_ASSERT_EQUAL_UINT32(0, total(l, MARCA_LIMIAR));
+    TEST_ASSERT_EQUAL_UINT32(0, total(l, MARCA_SIRENE));
+
+    // O próximo rastro não vê o descartado como incompleto
+    l.abrir(5000, 5050);
+    TEST_ASSERT_EQUAL_UINT32(0, l.incompletos());
+}
+
+void test_sem_publicacao_fica_incompleto() {
+    LatenciaAlarme l;
+    l.abrir(1000, 1100);
+    l.confirmar();
+    l.marcar(MARCA_SIRENE, 1200);
+
+    // Marca fora da janela (broker voltou muito depois): ignorada
+    l.marcar(MARCA_PUBLICADO, 1000 + LATENCIA_JANELA_US + 1);
+    TEST_ASSERT_EQUAL_UINT32(0, total(l, MARCA_PUBLICADO));
+    TEST_ASSERT_EQUAL_UINT32(0, l.incompletos());
+
+    l.abrir(20000000, 20000100);
+    l.confirmar();
+    TEST_ASSERT_EQUAL_UINT32(2, l.rastros());
+    TEST_ASSERT_EQUAL_UINT32(1, l.incompletos());
+
+    // O completo não entra como incompleto
+    l.marcar(MARCA_SIRENE, 20000300);
+    l.marcar(MARCA_PUBLICADO, 20004000);
+    l.abrir(40000000, 40000100);
+    TEST_ASSERT_EQUAL_UINT32(1, l.incompletos());
+}
+
+void test_relogio_que_da_a_volta() {
+    LatenciaAlarme l;
+    l.abrir(UINT32_MAX - 99, 0);
+    l.confirmar();
+    l.marcar(MARCA_SIRENE, 400);
+    TEST_ASSERT_EQUAL_UINT32(100, l.etapa(MARCA_LIMIAR).maximo());
+    TEST_ASSERT_EQUAL_UINT32(500, l.etapa(MARCA_SIRENE).maximo());
+}
+
+// ---------------- Quadro ----------------
+void test_quadro_cumulativo() {
+    LatenciaAlarme l;
+    l.abrir(1000, 1250);
+    l.confirmar();
+    l.marcar(MARCA_SIRENE, 1400);
+    l.marcar(MARCA_PUBLICADO, 151000);
+
+    uint8_t q[LATENCIA_QUADRO_MAX];
+    size_t n = l.codificar(q, sizeof(q));
+    TEST_ASSERT_EQUAL_UINT32(1 + 2 + 2 + 1 + 3 * (1 + 2 * LATENCIA_BALDES + 4), n);
+    TEST_ASSERT_EQUAL_UINT8(LATENCIA_VERSAO, q[0]);
+    TEST_ASSERT_EQUAL_UINT16(1, le16(q + 1));
+    TEST_ASSERT_EQUAL_UINT16(0, le16(q + 3));
+    TEST_ASSERT_EQUAL_UINT8(3, q[5]);
+
+    const size_t etapa = 1 + 2 * LATENCIA_BALDES + 4;
+    const uint8_t* limiar = q + 6;
+    const uint8_t* sirene = limiar + etapa;
+    const uint8_t* publicado = sirene + etapa;
+    TEST_ASSERT_EQUAL_UINT8(LATENCIA_BALDES, limiar[0]);
+    TEST_ASSERT_EQUAL_UINT16(1, le16(limiar + 1 + 2 * 1));     // 250: <= 500
+    TEST_ASSERT_EQUAL_UINT32(250, le32(limiar + 1 + 2 * LATENCIA_BALDES));
+    TEST_ASSERT_EQUAL_UINT16(1, le16(sirene + 1 + 2 * 1));     // 400: <= 500
+    TEST_ASSERT_EQUAL_UINT16(1, le16(publicado + 1 + 2 * 7));  // 150000: sem teto
+    TEST_ASSERT_EQUAL_UINT32(150000, le32(publicado + 1 + 2 * LATENCIA_BALDES));
+
+    TEST_ASSERT_EQUAL_UINT32(0, l.codificar(q, n - 1));
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_disparo_marca_eco_limiar_sirene_publicado);
+    RUN_TEST(test_marca_sem_rastro_e_repetida_sao_ignoradas);
+    RUN_TEST(test_descartado_nao_conta);
+    RUN_TEST(test_sem_publicacao_fica_incompleto);
+    RUN_TEST(test_relogio_que_da_a_volta);
+    RUN_TEST(test_quadro_cumulativo);
+    return UNITY_END();
+}
@@ -0,0 +1,154 @@
+// Testes do log assíncrono (ambiente native):
+//   pio test -e native -f test_log
+#include <unity.h>
+
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "hal.h"
+#include "eventos.h"
+#include "log.h"
+
+extern uint8_t logNativeNucleo;
+
+static std::vector<std::string> saida;
+
+static void capturar(const char* linha, size_t tamanho) {
+    saida.push_back(std::string(linha, tamanho));
+}
+
+// Texto da linha sem o "<ms> <nível> " e sem o '\n'
+static std::string texto(size_t i) {
+    const std::string& l = saida[i];
+    size_t p = l.find(' ', l.find(' ') + 1);
+    return l.substr(p + 1, l.size() - p - 2);
+}
+
+void setUp() {
+    logNativeNucleo = 0;
+    logDrenar(capturar);
+    saida.clear();
+}
+
+void tearDown() {}
+
+// ---------------- Formato ----------------
+void test_linha_com_instante_e_nivel() {
+    halNativeRelogioUs = 1234000;
+    LOG_AVISO("valor %d", 42);
+    TEST_ASSERT_EQUAL(1, logDrenar(capturar));
+    TEST_ASSERT_EQUAL_STRING("1234 W valor 42\n", saida[0].c_str());
+}
+
+void test_quebra_de_linha_final_e_da_tarefa() {
+    LOG_INFO("com quebra\n");
+    LOG_INFO("sem quebra");
+    TEST_ASSERT_EQUAL(2, logDrenar(capturar));
+    TEST_ASSERT_EQUAL_STRING("com quebra", texto(0).c_str());
+    TEST_ASSERT_EQUAL_STRING("sem quebra", texto(1).c_str());
+}
+
+void test_escrever_acorda_a_tarefa() {
+    eventosEsperar(EVENTO_LOG, 0);
+    LOG_INFO("acorda");
+    TEST_ASSERT_EQUAL_UINT32(EVENTO_LOG, eventosEsperar(EVENTO_LOG, 0));
+}
+
+// ---------------- Ordem entre núcleos ----------------
+void test_filas_dos_nucleos_saem_na_ordem_de_escrita() {
+    const char* ordem[] = {"a", "b", "c", "d", "e"};
+    const uint8_t nucleos[] = {1, 0, 0, 1, 0};
+    for (int i = 0; i < 5; ++i) {
+        logNativeNucleo = nucleos[i];
+        LOG_INFO("%s", ordem[i]);
+    }
+    TEST_ASSERT_EQUAL(5, logDrenar(capturar));
+    for (int i = 0; i < 5; ++i) TEST_ASSERT_EQUAL_STRING(ordem[i], texto(i).c_str());
+}
+
+// ---------------- Linhas longas ----------------
+void test_linha_longa_sai_inteira_antes_da_seguinte() {
+    std::string longa(LOG_LINHA_MAX - 1, 'x');
+    for (size_t i = 0; i < longa.size(); ++i) longa[i] = 'a' + i % 26;
+    LOG_INFO("%s", longa.c_str());
+    logNativeNucleo = 1;
+    LOG_INFO("depois");
+    TEST_ASSERT_EQUAL(2, logDrenar(capturar));
+    TEST_ASSERT_EQUAL_STRING(longa.c_str(), texto(0).c_str());
+    TEST_ASSERT_EQUAL_STRING("depois", texto(1).c_str());
+}
+
+void test_linha_maior_que_o_buffer_e_truncada() {
+    LogStats antes = logEstatisticas();
+    std::string enorme(LOG_LINHA_MAX + 50, 'z');
+    LOG_INFO("%s", enorme.c_str());
+    TEST_ASSERT_EQUAL(1, logDrenar(capturar));
+    TEST_ASSERT_EQUAL(LOG_LINHA_MAX - 1, texto(0).size());
+    TEST_ASSERT_EQUAL_UINT32(antes.truncadas + 1, logEstatisticas().truncadas);
+}
+
+// ---------------- Fila cheia ----------------
+void test_fila_cheia_descarta_sem_bloquear() {
+    LogStats antes = logEstatisticas();
+    for (int i = 0; i < LOG_CAPACIDADE + 3; ++i) LOG_INFO("linha %d", i);
+    LogStats s = logEstatisticas();
+    TEST_ASSERT_EQUAL_UINT32(antes.descartadas + 3, s.descartadas);
+    TEST_ASSERT_EQUAL_UINT32(antes.escritas + LOG_CAPACIDADE, s.escritas);
+    TEST_ASSERT_EQUAL_UINT32(LOG_CAPACIDADE, s.picoOcupacao);
+
+    // A outra fila não é afetada
+    logNativeNucleo = 1;
+    LOG_INFO("outro núcleo");
+    TEST_ASSERT_EQUAL(LOG_CAPACIDADE + 1, logDrenar(capturar));
+    TEST_ASSERT_EQUAL_STRING("linha 0", texto(0).c_str());
+    TEST_ASSERT_EQUAL_STRING("outro núcleo", texto(LOG_CAPACIDADE).c_str());
+}
+
+void test_linha_longa_com_fila_cheia_se_perde_inteira() {
+    LogStats antes = logEstatisticas();
+    for (int i = 0; i < LOG_CAPACIDADE; ++i) LOG_INFO("%d", i);
+    std::string longa(LOG_LINHA_MAX - 1, 'q');
+    LOG_INFO("%s", longa.c_str());
+    TEST_ASSERT_EQUAL_UINT32(antes.descartadas + 1, logEstatisticas().descartadas);
+    TEST_ASSERT_EQUAL(LOG_CAPACIDADE, logDrenar(capturar));
+
+    // Nenhum pedaço dela aparece na linha seguinte
+    LOG_INFO("seguinte");
+    TEST_ASSERT_EQUAL(1, logDrenar(capturar));
+    TEST_ASSERT_EQUAL_STRING("seguinte", texto(LOG_CAPACIDADE).c_str());
+}
+
+// ---------------- Níveis ----------------
+static int avaliacoes = 0;
+
+static int efeito() {
+    return ++avaliacoes;
+}
+
+void test_nivel_desligado_nem_avalia_argumentos() {
+    // LOG_NIVEL padrão é INFO: DEBUG some na compilação
+    TEST_ASSERT_EQUAL(LOG_NIVEL_INFO, LOG_NIVEL);
+    LOG_DEBUG("efeito %d", efeito());
+    TEST_ASSERT_EQUAL(0, avaliacoes);
+    TEST_ASSERT_EQUAL(0, logDrenar(capturar));
+
+    LOG_ERRO("efeito %d", efeito());
+    TEST_ASSERT_EQUAL(1, avaliacoes);
+    TEST_ASSERT_EQUAL(1, logDrenar(capturar));
+    TEST_ASSERT_EQUAL('E', saida[0][saida[0].find(' ') + 1]);
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_linha_com_instante_e_nivel);
+    RUN_TEST(test_quebra_de_linha_final_e_da_tarefa);
+    RUN_TEST(test_escrever_acorda_a_tarefa);
+    RUN_TEST(test_filas_dos_nucleos_saem_na_ordem_de_escrita);
+    RUN_TEST(test_linha_longa_sai_inteira_antes_da_seguinte);
+    RUN_TEST(test_linha_maior_que_o_buffer_e_truncada);
+    RUN_TEST(test_fila_cheia_descarta_sem_bloquear);
+    RUN_TEST(test_linha_longa_com_fila_cheia_se_perde_inteira);
+    RUN_TEST(test_nivel_desligado_nem_avalia_argumentos);
+    return UNITY_END();
+}
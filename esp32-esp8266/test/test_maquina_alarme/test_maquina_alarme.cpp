@@ -0,0 +1,187 @@
+// Testes da máquina de estados do alarme, inclusive sob contenção
+// real de várias threads (ambiente native):
+//   pio test -e native -f test_maquina_alarme -v
+#include <unity.h>
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "maquina_alarme.h"
+
+static MaquinaAlarme maquina;
+
+void setUp() {
+    maquina.reiniciar();
+}
+
+void tearDown() {}
+
+// ---------------- Tabela ----------------
+void test_tabela_de_transicao() {
+    TEST_ASSERT_EQUAL(ESTADO_ALERTA, proximoEstadoAlarme(ESTADO_OK, ENTRADA_DETECCAO));
+    TEST_ASSERT_EQUAL(ESTADO_PAUSADO, proximoEstadoAlarme(ESTADO_PAUSADO, ENTRADA_DETECCAO));
+    TEST_ASSERT_EQUAL(ESTADO_OK, proximoEstadoAlarme(ESTADO_ALERTA, ENTRADA_SILENCIAR));
+    TEST_ASSERT_EQUAL(ESTADO_PAUSADO, proximoEstadoAlarme(ESTADO_PAUSADO, ENTRADA_SILENCIAR));
+    TEST_ASSERT_EQUAL(ESTADO_OK, proximoEstadoAlarme(ESTADO_PAUSADO, ENTRADA_PARAR));
+    TEST_ASSERT_EQUAL(ESTADO_PAUSADO, proximoEstadoAlarme(ESTADO_ALERTA, ENTRADA_PAUSAR));
+    TEST_ASSERT_EQUAL(ESTADO_ALERTA, proximoEstadoAlarme(ESTADO_ALERTA, ENTRADA_RETOMAR));
+    TEST_ASSERT_EQUAL(ESTADO_OK, proximoEstadoAlarme(ESTADO_PAUSADO, ENTRADA_ALTERNAR_PAUSA));
+    TEST_ASSERT_EQUAL(ESTADO_PAUSADO, proximoEstadoAlarme(ESTADO_OK, ENTRADA_ALTERNAR_PAUSA));
+}
+
+void test_transicoes_e_historico() {
+    TransicaoAlarme t = maquina.aplicar(ENTRADA_DETECCAO, 100);
+    TEST_ASSERT_TRUE(t.mudou);
+    TEST_ASSERT_EQUAL_UINT32(1, t.versao);
+
+    t = maquina.aplicar(ENTRADA_DETECCAO, 110);  // já em alerta
+    TEST_ASSERT_FALSE(t.mudou);
+    TEST_ASSERT_EQUAL_UINT32(1, t.versao);
+
+    maquina.aplicar(ENTRADA_PAUSAR, 200);
+    maquina.aplicar(ENTRADA_RETOMAR, 300);
+    TEST_ASSERT_EQUAL(ESTADO_OK, maquina.estado());
+    TEST_ASSERT_EQUAL_UINT32(3, maquina.versao());
+
+    RegistroTransicao h[8];
+    TEST_ASSERT_EQUAL_UINT32(3, maquina.historico(h, 8));
+    TEST_ASSERT_EQUAL(ENTRADA_DETECCAO, h[0].entrada);
+    TEST_ASSERT_EQUAL(ESTADO_ALERTA, h[1].de);
+    TEST_ASSERT_EQUAL(ESTADO_PAUSADO, h[1].para);
+    TEST_ASSERT_EQUAL_UINT32(300, h[2].instanteMs);
+
+    // max menor que o disponível: ficam as mais recentes
+    TEST_ASSERT_EQUAL_UINT32(2, maquina.historico(h, 2));
+    TEST_ASSERT_EQUAL_UINT32(2, h[0].versao);
+
+    MaquinaAlarmeStats s = maquina.estatisticas();
+    TEST_ASSERT_EQUAL_UINT32(3, s.transicoes);
+    TEST_ASSERT_EQUAL_UINT32(1, s.ignoradas);
+    TEST_ASSERT_EQUAL_UINT32(0, s.conflitos);
+}
+
+void test_historico_da_volta_no_anel() {
+    for (uint32_t i = 0; i < 3 * MAQUINA_HISTORICO + 5; ++i) {
+        maquina.aplicar(ENTRADA_ALTERNAR_PAUSA, i);
+    }
+    RegistroTransicao h[2 * MAQUINA_HISTORICO];
+    uint32_t n = maquina.historico(h, 2 * MAQUINA_HISTORICO);
+    TEST_ASSERT_EQUAL_UINT32(MAQUINA_HISTORICO, n);
+    TEST_ASSERT_EQUAL_UINT32(maquina.versao(), h[n - 1].versao);
+    for (uint32_t i = 1; i < n; ++i) {
+        TEST_ASSERT_EQUAL_UINT32(h[i - 1].versao + 1, h[i].versao);
+        TEST_ASSERT_EQUAL(h[i - 1].para, h[i].de);
+    }
+}
+
+// ---------------- Estresse ----------------
+struct Vencida {
+    uint32_t versao;
+    EstadoAlarme de;
+    EstadoAlarme para;
+};
+
+void test_estresse_concorrente() {
+    const int ESCRITORAS = 4;
+    const int POR_THREAD = 200000;
+
+    std::vector<Vencida> vencidas[ESCRITORAS];
+    std::atomic<bool> parar{false};
+    std::atomic<uint32_t> leiturasInvalidas{0};
+    std::atomic<uint32_t> versaoVoltou{0};
+    std::vector<RegistroTransicao> lidosDoHistorico;
+
+    // Leitora: estado sempre válido e versão nunca anda para trás
+    std::thread leitora([&] {
+        uint32_t ultima = 0;
+        while (!parar.load()) {
+            uint32_t v;
+            EstadoAlarme e = maquina.estado(v);
+            if (e > ESTADO_PAUSADO) leiturasInvalidas.fetch_add(1);
+            if (v < ultima) versaoVoltou.fetch_add(1);
+            ultima = v;
+        }
+    });
+
+    // Leitora do histórico enquanto ele é reescrito (testa o seqlock)
+    std::thread historiadora([&] {
+        RegistroTransicao h[MAQUINA_HISTORICO];
+        while (!parar.load()) {
+            uint32_t n = maquina.historico(h, MAQUINA_HISTORICO);
+            lidosDoHistorico.insert(lidosDoHistorico.end(), h, h + n);
+            if (lidosDoHistorico.size() > 200000) lidosDoHistorico.clear();
+        }
+    });
+
+    std::vector<std::thread> escritoras;
+    for (int t = 0; t < ESCRITORAS; ++t) {
+        vencidas[t].reserve(POR_THREAD);
+        escritoras.emplace_back([&, t] {
+            uint32_t semente = 12345u + t;
+            for (int i = 0; i < POR_THREAD; ++i) {
+                semente = semente * 1103515245u + 12345u;
+                EntradaAlarme e = (EntradaAlarme)((semente >> 16) % NUM_ENTRADAS_ALARME);
+                TransicaoAlarme r = maquina.aplicar(e, (uint32_t)i);
+                if (r.mudou) vencidas[t].push_back({r.versao, r.de, r.para});
+            }
+        });
+    }
+    for (auto& th : escritoras) th.join();
+    parar.store(true);
+    leitora.join();
+    historiadora.join();
+
+    TEST_ASSERT_EQUAL_UINT32(0, leiturasInvalidas.load());
+    TEST_ASSERT_EQUAL_UINT32(0, versaoVoltou.load());
+
+    // Toda transição vencida tem versão única e elas formam uma cadeia
+    // contínua 1..V: o "para" de uma é o "de" da seguinte.
+    std::vector<Vencida> todas;
+    for (auto& v : vencidas) todas.insert(todas.end(), v.begin(), v.end());
+    std::sort(todas.begin(), todas.end(),
+              [](const Vencida& a, const Vencida& b) { return a.versao < b.versao; });
+
+    MaquinaAlarmeStats s = maquina.estatisticas();
+    TEST_ASSERT_EQUAL_UINT32(maquina.versao(), todas.size());
+    TEST_ASSERT_EQUAL_UINT32(s.transicoes, todas.size());
+    TEST_ASSERT_EQUAL_UINT32(ESCRITORAS * POR_THREAD, s.transicoes + s.ignoradas);
+
+    EstadoAlarme esperado = ESTADO_OK;
+    bool cadeiaOk = true;
+    for (size_t i = 0; i < todas.size(); ++i) {
+        if (todas[i].versao != i + 1 || todas[i].de != esperado || todas[i].para == todas[i].de) {
+            cadeiaOk = false;
+            break;
+        }
+        esperado = todas[i].para;
+    }
+    TEST_ASSERT_TRUE(cadeiaOk);
+    TEST_ASSERT_EQUAL(esperado, maquina.estado());
+
+    // O que a leitora de histórico viu bate com o que aconteceu
+    uint32_t divergentes = 0;
+    for (const RegistroTransicao& r : lidosDoHistorico) {
+        const Vencida& v = todas[r.versao - 1];
+        if (v.de != r.de || v.para != r.para) ++divergentes;
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, divergentes);
+
+    char msg[160];
+    snprintf(msg, sizeof(msg),
+             "%d threads x %d entradas: %lu transições, %lu ignoradas, %lu conflitos de CAS, "
+             "pior caso %lu tentativas",
+             ESCRITORAS, POR_THREAD, (unsigned long)s.transicoes, (unsigned long)s.ignoradas,
+             (unsigned long)s.conflitos, (unsigned long)s.maxTentativas);
+    TEST_MESSAGE(msg);
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_tabela_de_transicao);
+    RUN_TEST(test_transicoes_e_historico);
+    RUN_TEST(test_historico_da_volta_no_anel);
+    RUN_TEST(test_estresse_concorrente);
+    return UNITY_END();
+}
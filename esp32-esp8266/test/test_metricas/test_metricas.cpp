@@ -0,0 +1,204 @@
+// Testes das métricas de saúde (ambiente native):
+//   pio test -e native -f test_metricas
+#include <unity.h>
+
+#include <string.h>
+
+#include "hal.h"
+#include "comandos.h"
+#include "metricas.h"
+#include "publicador.h"
+#include "topicos.h"
+
+void setUp() {}
+
+void tearDown() {}
+
+static AmostraSistema amostra(uint32_t instanteMs, uint32_t relogio) {
+    AmostraSistema a;
+    memset(&a, 0, sizeof(a));
+    a.instanteMs = instanteMs;
+    a.heapLivre = 150000;
+    a.heapMinimo = 120000;
+    a.maiorBloco = 90000;
+    a.temExecucao = true;
+    a.relogio = relogio;
+    a.nucleos = 2;
+    return a;
+}
+
+static uint16_t le16(const uint8_t* p) {
+    return p[0] | (p[1] << 8);
+}
+
+static uint32_t le32(const uint8_t* p) {
+    return le16(p) | ((uint32_t)le16(p + 2) << 16);
+}
+
+// ---------------- Histograma ----------------
+void test_histograma_baldes_por_teto() {
+    static const uint32_t limites[3] = {10, 20, UINT32_MAX};
+    Histograma h;
+    h.configurar(limites, 3);
+    h.registrar(0);
+    h.registrar(10);   // teto é inclusivo
+    h.registrar(11);
+    h.registrar(500);
+
+    uint32_t c[METRICAS_MAX_BALDES];
+    h.ler(c);
+    TEST_ASSERT_EQUAL_UINT32(2, c[0]);
+    TEST_ASSERT_EQUAL_UINT32(1, c[1]);
+    TEST_ASSERT_EQUAL_UINT32(1, c[2]);
+    TEST_ASSERT_EQUAL_UINT32(500, h.maximo());
+}
+
+void test_intervalo_relativo_ao_periodo() {
+    Metricas m;
+    m.iniciar(100);
+    m.amostraSensor(1000000);
+    m.amostraSensor(1100000);  // 100 ms = 100%
+    m.amostraSensor(1230000);  // 130 ms
+    m.amostraSensor(1530000);  // 300 ms: amostras perdidas
+
+    uint32_t c[METRICAS_MAX_BALDES];
+    m.intervalo().ler(c);
+    TEST_ASSERT_EQUAL_UINT32(1, c[1]);  // <= 105%
+    TEST_ASSERT_EQUAL_UINT32(1, c[3]);  // <= 150%
+    TEST_ASSERT_EQUAL_UINT32(1, c[5]);  // <= 400%
+}
+
+void test_atraso_conta_o_modulo() {
+    Metricas m;
+    m.iniciar(100);
+    m.despertou(-900);   // um tick antes
+    m.despertou(300);
+    m.despertou(70000);
+
+    uint32_t c[METRICAS_MAX_BALDES];
+    m.atraso().ler(c);
+    TEST_ASSERT_EQUAL_UINT32(1, c[1]);  // 300 <= 500
+    TEST_ASSERT_EQUAL_UINT32(1, c[2]);  // 900 <= 1000
+    TEST_ASSERT_EQUAL_UINT32(1, c[7]);  // sem teto
+    TEST_ASSERT_EQUAL_UINT32(70000, m.atraso().maximo());
+}
+
+// ---------------- Janela ----------------
+void test_janela_subtrai_a_anterior() {
+    Metricas m;
+    m.iniciar(100);
+    m.despertou(100);
+    m.despertou(100);
+    RelatorioMetricas r1 = m.fechar(amostra(30000, 0));
+    TEST_ASSERT_EQUAL_UINT32(2, r1.atraso[0]);
+    TEST_ASSERT_EQUAL_UINT32(30000, r1.janelaMs);
+
+    m.despertou(100);
+    RelatorioMetricas r2 = m.fechar(amostra(60000, 0));
+    TEST_ASSERT_EQUAL_UINT32(1, r2.atraso[0]);
+    TEST_ASSERT_EQUAL_UINT32(30000, r2.janelaMs);
+    TEST_ASSERT_EQUAL_UINT32(60000, r2.uptimeMs);
+}
+
+void test_cpu_por_tarefa_e_ocioso() {
+    Metricas m;
+    m.iniciar(100);
+    AmostraSistema a = amostra(30000, 1000000);
+    a.tarefas = 2;
+    a.tarefa[0] = {TAREFA_SENSOR, 5000, 1200};
+    a.tarefa[1] = {TAREFA_MQTT, 100000, 3000};
+    a.ocioso = 500000;
+    RelatorioMetricas r = m.fechar(a);
+    TEST_ASSERT_EQUAL_UINT8(METRICAS_SEM_DADO, r.tarefa[0].cpu);  // primeira janela
+    TEST_ASSERT_EQUAL_UINT8(METRICAS_SEM_DADO, r.ocioso);
+
+    AmostraSistema b = amostra(60000, 2000000);
+    b.tarefas = 3;
+    b.tarefa[0] = {TAREFA_MQTT, 350000, 2900};   // ordem mudou: casa pelo id
+    b.tarefa[1] = {TAREFA_SENSOR, 25000, 1100};
+    b.tarefa[2] = {METRICAS_TAREFA_LOOP, 1000, 800};  // registrada depois
+    b.ocioso = 500000 + 1500000;  // 1,5 s dos 2 s dos dois núcleos
+    r = m.fechar(b);
+    TEST_ASSERT_EQUAL_UINT8(25, r.tarefa[0].cpu);
+    TEST_ASSERT_EQUAL_UINT8(2, r.tarefa[1].cpu);
+    TEST_ASSERT_EQUAL_UINT8(METRICAS_SEM_DADO, r.tarefa[2].cpu);
+    TEST_ASSERT_EQUAL_UINT32(1100, r.tarefa[1].pilhaLivre);
+    TEST_ASSERT_EQUAL_UINT8(75, r.ocioso);
+}
+
+void test_sem_tempo_de_execucao() {
+    Metricas m;
+    m.iniciar(100);
+    AmostraSistema a = amostra(30000, 0);
+    a.temExecucao = false;
+    a.tarefas = 1;
+    a.tarefa[0] = {TAREFA_BOTAO, 0, 900};
+    m.fechar(a);
+    a.instanteMs = 60000;
+    RelatorioMetricas r = m.fechar(a);
+    TEST_ASSERT_EQUAL_UINT8(METRICAS_SEM_DADO, r.tarefa[0].cpu);
+    TEST_ASSERT_EQUAL_UINT8(METRICAS_SEM_DADO, r.ocioso);
+    TEST_ASSERT_EQUAL_UINT32(900, r.tarefa[0].pilhaLivre);
+}
+
+void test_publicador_na_janela() {
+    Metricas m;
+    m.iniciar(100);
+    mqttClient.conectado = true;
+    publicadorDrenar(mqttClient);
+    m.fechar(amostra(30000, 0));
+
+    publicar(TOPICO_ESTADO, "OK,1");
+    publicar(TOPICO_ESTADO, "OK,2");
+    publicadorDrenar(mqttClient);
+    RelatorioMetricas r = m.fechar(amostra(60000, 0));
+    TEST_ASSERT_EQUAL_UINT32(2, r.publicadas);
+    TEST_ASSERT_EQUAL_UINT32(0, r.descartadas);
+}
+
+// ---------------- Quadro ----------------
+void test_quadro_cabe_no_publicador() {
+    Metricas m;
+    m.iniciar(100);
+    AmostraSistema a = amostra(90000, 0);
+    a.tarefas = METRICAS_MAX_TAREFAS;
+    for (uint8_t i = 0; i < a.tarefas; ++i) a.tarefa[i] = {i, 0, 70000};  // satura em u16
+    RelatorioMetricas r = m.fechar(a);
+
+    uint8_t buf[METRICAS_QUADRO_MAX];
+    size_t n = metricasCodificar(r, buf, sizeof(buf));
+    TEST_ASSERT_TRUE(n > 0);
+    TEST_ASSERT_TRUE(n <= PUBLICADOR_PAYLOAD_MAX);
+
+    TEST_ASSERT_EQUAL_UINT8(METRICAS_VERSAO, buf[0]);
+    TEST_ASSERT_EQUAL_UINT8(0, buf[1]);
+    TEST_ASSERT_EQUAL_UINT16(90, le16(buf + 2));
+    TEST_ASSERT_EQUAL_UINT32(90, le32(buf + 4));
+    TEST_ASSERT_EQUAL_UINT32(150000, le32(buf + 8));
+    TEST_ASSERT_EQUAL_UINT32(120000, le32(buf + 12));
+    TEST_ASSERT_EQUAL_UINT32(90000, le32(buf + 16));
+    TEST_ASSERT_EQUAL_UINT8(METRICAS_SEM_DADO, buf[32]);  // ocioso
+    TEST_ASSERT_EQUAL_UINT8(METRICAS_MAX_TAREFAS, buf[33]);
+    TEST_ASSERT_EQUAL_UINT16(0xFFFF, le16(buf + 34 + 2));
+
+    size_t pos = 34 + 4 * METRICAS_MAX_TAREFAS;
+    TEST_ASSERT_EQUAL_UINT8(METRICAS_BALDES_INTERVALO, buf[pos]);
+    pos += 1 + 2 * METRICAS_BALDES_INTERVALO;
+    TEST_ASSERT_EQUAL_UINT8(METRICAS_BALDES_ATRASO, buf[pos]);
+    TEST_ASSERT_EQUAL(pos + 1 + 2 * METRICAS_BALDES_ATRASO, n);
+
+    TEST_ASSERT_EQUAL(0, metricasCodificar(r, buf, 40));  // não cabe
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_histograma_baldes_por_teto);
+    RUN_TEST(test_intervalo_relativo_ao_periodo);
+    RUN_TEST(test_atraso_conta_o_modulo);
+    RUN_TEST(test_janela_subtrai_a_anterior);
+    RUN_TEST(test_cpu_por_tarefa_e_ocioso);
+    RUN_TEST(test_sem_tempo_de_execucao);
+    RUN_TEST(test_publicador_na_janela);
+    RUN_TEST(test_quadro_cabe_no_publicador);
+    return UNITY_END();
+}
@@ -0,0 +1,197 @@
+// Testes da partida rápida e do estado salvo (ambiente native):
+//   pio test -e native -f test_partida
+#include <unity.h>
+
+#include <string.h>
+
+#include "hal.h"
+#include "alarme.h"
+#include "comodos.h"
+#include "partida.h"
+#include "pinos.h"
+
+extern uint8_t partidaNativeNvs[];
+extern size_t partidaNativeTamanho;
+extern bool partidaNativeFalhar;
+extern uint32_t partidaNativeGravacoes;
+
+static void avancarMs(uint32_t ms) {
+    halNativeRelogioUs += (uint64_t)ms * 1000;
+}
+
+static void salvarNaNvs(bool pausado, uint8_t r, uint8_t g, uint8_t b) {
+    EstadoSalvo e;
+    memset(&e, 0, sizeof(e));
+    e.pausado = pausado;
+    e.cores[0][0] = r;
+    e.cores[0][1] = g;
+    e.cores[0][2] = b;
+    partidaNativeTamanho = estadoSalvoCodificar(e, partidaNativeNvs, PARTIDA_BYTES_MAX);
+}
+
+void setUp() {
+    halNativeRelogioUs = 1000000;
+    maquinaAlarme.reiniciar();
+    comodosIniciar();
+    partidaNativeTamanho = 0;
+    partidaNativeFalhar = false;
+    partidaNativeGravacoes = 0;
+}
+
+void tearDown() {}
+
+// ---------------- Formato ----------------
+void test_codificar_e_decodificar() {
+    EstadoSalvo e;
+    memset(&e, 0, sizeof(e));
+    e.pausado = true;
+    e.cores[NUM_COMODOS - 1][2] = 200;
+    uint8_t buf[PARTIDA_BYTES_MAX];
+    TEST_ASSERT_EQUAL(PARTIDA_BYTES_MAX, estadoSalvoCodificar(e, buf, sizeof(buf)));
+
+    EstadoSalvo lido;
+    TEST_ASSERT_TRUE(estadoSalvoDecodificar(buf, sizeof(buf), lido));
+    TEST_ASSERT_TRUE(lido.pausado);
+    TEST_ASSERT_EQUAL_UINT8(200, lido.cores[NUM_COMODOS - 1][2]);
+    TEST_ASSERT_EQUAL_UINT8(0, lido.cores[0][0]);
+}
+
+void test_formato_diferente_e_ignorado() {
+    EstadoSalvo e;
+    memset(&e, 0, sizeof(e));
+    uint8_t buf[PARTIDA_BYTES_MAX];
+    estadoSalvoCodificar(e, buf, sizeof(buf));
+    EstadoSalvo lido;
+
+    TEST_ASSERT_FALSE(estadoSalvoDecodificar(buf, sizeof(buf) - 1, lido));
+    buf[0] = PARTIDA_VERSAO + 1;
+    TEST_ASSERT_FALSE(estadoSalvoDecodificar(buf, sizeof(buf), lido));
+    buf[0] = PARTIDA_VERSAO;
+    buf[2] = NUM_COMODOS + 1;  // tabela de cômodos mudou
+    TEST_ASSERT_FALSE(estadoSalvoDecodificar(buf, sizeof(buf), lido));
+}
+
+// ---------------- Restauração ----------------
+void test_primeiro_boot_fica_armado_e_apagado() {
+    TEST_ASSERT_FALSE(partidaRestaurar());
+    TEST_ASSERT_EQUAL(ESTADO_OK, alarmeEstado());
+    TEST_ASSERT_FALSE(estadosComodos[0].ligado);
+
+    // O padrão não precisa ir para a NVS
+    avancarMs(PARTIDA_ESTAVEL_MS * 2);
+    partidaServicar(millis());
+    TEST_ASSERT_EQUAL_UINT32(0, partidaNativeGravacoes);
+    TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, partidaPrazoMs(millis()));
+}
+
+void test_restaura_pausa_e_luzes() {
+    salvarNaNvs(true, 10, 20, 30);
+    TEST_ASSERT_TRUE(partidaRestaurar());
+
+    TEST_ASSERT_EQUAL(ESTADO_PAUSADO, alarmeEstado());
+    TEST_ASSERT_EQUAL_UINT8(HIGH, halNativeGpio[LED_BLUE]);
+    TEST_ASSERT_TRUE(estadosComodos[0].ligado);
+    TEST_ASSERT_EQUAL_UINT8(20, estadosComodos[0].g);
+    TEST_ASSERT_FALSE(estadosComodos[1].ligado);
+
+    PartidaStats s = partidaEstatisticas();
+    TEST_ASSERT_TRUE(s.restaurado);
+    TEST_ASSERT_TRUE(s.pausado);
+    TEST_ASSERT_EQUAL_UINT8(1, s.luzes);
+
+    // O que foi restaurado já é o que está na NVS
+    avancarMs(PARTIDA_ESTAVEL_MS * 2);
+    partidaServicar(millis());
+    TEST_ASSERT_EQUAL_UINT32(0, partidaNativeGravacoes);
+}
+
+// ---------------- Gravação ----------------
+void test_grava_so_depois_de_estabilizar() {
+    partidaRestaurar();
+    aplicarCorComodo(1, 1, 2, 3, 0);
+    partidaServicar(millis());
+    TEST_ASSERT_EQUAL_UINT32(PARTIDA_ESTAVEL_MS, partidaPrazoMs(millis()));
+
+    // Outra mudança no meio recomeça a contagem
+    avancarMs(PARTIDA_ESTAVEL_MS - 1);
+    aplicarCorComodo(1, 4, 5, 6, 0);
+    partidaServicar(millis());
+    avancarMs(PARTIDA_ESTAVEL_MS - 1);
+    partidaServicar(millis());
+    TEST_ASSERT_EQUAL_UINT32(0, partidaNativeGravacoes);
+    TEST_ASSERT_EQUAL_UINT32(1, partidaPrazoMs(millis()));
+
+    avancarMs(1);
+    partidaServicar(millis());
+    TEST_ASSERT_EQUAL_UINT32(1, partidaNativeGravacoes);
+    TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, partidaPrazoMs(millis()));
+
+    EstadoSalvo lido;
+    TEST_ASSERT_TRUE(estadoSalvoDecodificar(partidaNativeNvs, partidaNativeTamanho, lido));
+    TEST_ASSERT_EQUAL_UINT8(5, lido.cores[1][1]);
+    TEST_ASSERT_FALSE(lido.pausado);
+}
+
+void test_ida_e_volta_nao_grava() {
+    partidaRestaurar();
+    alarmeEntrada(ENTRADA_PAUSAR);
+    partidaServicar(millis());
+    alarmeEntrada(ENTRADA_RETOMAR);
+    avancarMs(PARTIDA_ESTAVEL_MS);
+    partidaServicar(millis());
+    TEST_ASSERT_EQUAL_UINT32(0, partidaNativeGravacoes);
+    TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, partidaPrazoMs(millis()));
+}
+
+void test_falha_na_nvs_tenta_de_novo() {
+    partidaRestaurar();
+    alarmeEntrada(ENTRADA_PAUSAR);
+    partidaServicar(millis());
+    partidaNativeFalhar = true;
+    avancarMs(PARTIDA_ESTAVEL_MS);
+    uint32_t falhas = partidaEstatisticas().falhasGravacao;
+    partidaServicar(millis());
+    TEST_ASSERT_EQUAL_UINT32(falhas + 1, partidaEstatisticas().falhasGravacao);
+    TEST_ASSERT_EQUAL_UINT32(PARTIDA_ESTAVEL_MS, partidaPrazoMs(millis()));
+
+    partidaNativeFalhar = false;
+    avancarMs(PARTIDA_ESTAVEL_MS);
+    partidaServicar(millis());
+    TEST_ASSERT_EQUAL_UINT32(1, partidaNativeGravacoes);
+
+    // O próximo boot volta pausado
+    maquinaAlarme.reiniciar();
+    TEST_ASSERT_TRUE(partidaRestaurar());
+    TEST_ASSERT_EQUAL(ESTADO_PAUSADO, alarmeEstado());
+}
+
+// ---------------- Marcos ----------------
+void test_so_o_primeiro_marco_conta() {
+    TEST_ASSERT_TRUE(partidaArmado(120));
+    TEST_ASSERT_FALSE(partidaArmado(220));
+    TEST_ASSERT_TRUE(partidaConectado(4500));
+    TEST_ASSERT_FALSE(partidaConectado(9000));
+
+    PartidaStats s = partidaEstatisticas();
+    TEST_ASSERT_EQUAL_UINT32(120, s.armadoMs);
+    TEST_ASSERT_EQUAL_UINT32(4500, s.conectadoMs);
+
+    char buf[48];
+    s.pausado = true;
+    s.luzes = 2;
+    formatarPartida(buf, sizeof(buf), s);
+    TEST_ASSERT_EQUAL_STRING("120,4500,PAUSADO,2", buf);
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_codificar_e_decodificar);
+    RUN_TEST(test_formato_diferente_e_ignorado);
+    RUN_TEST(test_primeiro_boot_fica_armado_e_apagado);
+    RUN_TEST(test_restaura_pausa_e_luzes);
+    RUN_TEST(test_grava_so_depois_de_estabilizar);
+    RUN_TEST(test_ida_e_volta_nao_grava);
+    RUN_TEST(test_falha_na_nvs_tenta_de_novo);
+    RUN_TEST(test_so_o_primeiro_marco_conta);
+    return UNITY_END();
+}
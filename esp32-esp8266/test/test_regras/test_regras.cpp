@@ -0,0 +1,278 @@
+// Testes do motor de regras (ambiente native):
+//   pio test -e native -f test_regras
+#include <unity.h>
+
+#include <string.h>
+
+#include "hal.h"
+#include "alarme.h"
+#include "comandos.h"
+#include "comodos.h"
+#include "eventos.h"
+#include "padroes.h"
+#include "publicador.h"
+#include "regras.h"
+#include "topicos.h"
+#include "zonas.h"
+
+extern uint8_t regrasNativeNvs[];
+extern size_t regrasNativeTamanho;
+extern bool regrasNativeFalhar;
+extern uint32_t regrasNativeGravacoes;
+extern std::atomic<uint32_t> eventosNativePendentes;
+extern long padroesNativeProximoMs;
+
+static void avancarMs(uint32_t ms) {
+    halNativeRelogioUs += (uint64_t)ms * 1000;
+}
+
+static Regra regra(GatilhoRegra gatilho, uint8_t indice, uint16_t valor, AcaoRegra acao,
+                   uint8_t destino, uint8_t r = 0, uint8_t g = 0, uint8_t b = 0,
+                   uint8_t transicao = 0) {
+    Regra x = {gatilho, indice, valor, acao, destino, {r, g, b}, transicao};
+    return x;
+}
+
+// Codifica e entrega como se viesse de TOPICO_REGRAS
+static void configurar(const Regra* tabela, uint8_t quantidade) {
+    uint8_t buf[REGRAS_BYTES_MAX];
+    size_t n = regrasCodificar(tabela, quantidade, buf, sizeof(buf));
+    regras.configurar(buf, n);
+}
+
+// Os contadores do motor são cumulativos: conta a partir do setUp()
+static uint32_t disparosAntes = 0;
+
+static uint32_t disparos() {
+    return regras.estatisticas().disparos - disparosAntes;
+}
+
+static void conectar() {
+    mqttClient.conectado = true;
+    publicadorDrenar(mqttClient);
+}
+
+void setUp() {
+    halNativeRelogioUs = 1000000;
+    maquinaAlarme.reiniciar();
+    zonasReiniciar();
+    comodosIniciar();
+    configurar(nullptr, 0);
+    regras.servicar(millis());
+    disparosAntes = regras.estatisticas().disparos;
+    regrasNativeTamanho = 0;
+    regrasNativeFalhar = false;
+    regrasNativeGravacoes = 0;
+    mqttClient.conectado = false;
+    publicadorDrenar(mqttClient);
+}
+
+void tearDown() {
+    alarmeEntrada(ENTRADA_PARAR);  // o alerta repete até sair dele
+    while (padroesAvancar() > 0) {}
+}
+
+// ---------------- Formato ----------------
+void test_tabela_codifica_e_valida() {
+    const Regra tabela[] = {
+        regra(GATILHO_ALARME, 0, ESTADO_ALERTA, ACAO_COR, 0, 255, 255, 255, 5),
+        regra(GATILHO_LUZ, REGRAS_QUALQUER, 1800, ACAO_COR, REGRAS_DO_GATILHO),
+    };
+    uint8_t buf[REGRAS_BYTES_MAX];
+    size_t n = regrasCodificar(tabela, 2, buf, sizeof(buf));
+    TEST_ASSERT_EQUAL_UINT32(2 + 2 * REGRAS_BYTES_REGRA, n);
+
+    Regra lidas[REGRAS_MAX];
+    uint8_t quantidade = 0;
+    int invalida;
+    TEST_ASSERT_TRUE(regrasDecodificar(buf, n, lidas, quantidade, invalida));
+    TEST_ASSERT_EQUAL_UINT8(2, quantidade);
+    TEST_ASSERT_EQUAL_UINT16(1800, lidas[1].valor);
+    TEST_ASSERT_EQUAL_UINT8(5, lidas[0].transicao);
+
+    // Tamanho que não fecha com a quantidade: cabeçalho
+    TEST_ASSERT_FALSE(regrasDecodificar(buf, n - 1, lidas, quantidade, invalida));
+    TEST_ASSERT_EQUAL_INT(-1, invalida);
+
+    // "Cômodo do gatilho" sem gatilho de luz
+    const Regra ruins[] = {
+        tabela[0],
+        regra(GATILHO_ALARME, 0, ESTADO_ALERTA, ACAO_COR, REGRAS_DO_GATILHO),
+    };
+    n = regrasCodificar(ruins, 2, buf, sizeof(buf));
+    TEST_ASSERT_FALSE(regrasDecodificar(buf, n, lidas, quantidade, invalida));
+    TEST_ASSERT_EQUAL_INT(1, invalida);
+
+    const Regra semComodo[] = {regra(GATILHO_ALARME, 0, ESTADO_ALERTA, ACAO_COR, NUM_COMODOS)};
+    n = regrasCodificar(semComodo, 1, buf, sizeof(buf));
+    TEST_ASSERT_FALSE(regrasDecodificar(buf, n, lidas, quantidade, invalida));
+    TEST_ASSERT_EQUAL_INT(0, invalida);
+}
+
+// ---------------- Gatilhos e ações ----------------
+void test_alerta_acende_a_sala_sem_rede() {
+    const Regra tabela[] = {
+        regra(GATILHO_ALARME, 0, ESTADO_ALERTA, ACAO_COR, 0, 255, 255, 255),
+    };
+    configurar(tabela, 1);
+    TEST_ASSERT_FALSE(publicadorConectado());
+
+    alarmeEntrada(ENTRADA_DETECCAO);
+    TEST_ASSERT_TRUE(eventosNativePendentes.load() & EVENTO_REGRAS);
+    TEST_ASSERT_FALSE(estadosComodos[0].ligado);  // quem executa é a taskMQTT
+
+    regras.servicar(millis());
+    TEST_ASSERT_TRUE(estadosComodos[0].ligado);
+    TEST_ASSERT_EQUAL_UINT8(255, estadosComodos[0].r);
+    TEST_ASSERT_FALSE(estadosComodos[1].ligado);
+    TEST_ASSERT_EQUAL_UINT32(1, disparos());
+
+    // Outros estados não casam
+    alarmeEntrada(ENTRADA_SILENCIAR);
+    regras.servicar(millis());
+    TEST_ASSERT_EQUAL_UINT32(1, disparos());
+}
+
+void test_luz_acesa_apaga_sozinha_uma_vez_por_periodo() {
+    const Regra tabela[] = {
+        regra(GATILHO_LUZ, REGRAS_QUALQUER, 60, ACAO_COR, REGRAS_DO_GATILHO),
+    };
+    configurar(tabela, 1);
+    TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, regras.prazoMs(millis()));
+
+    aplicarCorComodo(1, 10, 20, 30, 0);
+    regras.servicar(millis());
+    TEST_ASSERT_EQUAL_UINT32(60000, regras.prazoMs(millis()));
+
+    avancarMs(59000);
+    regras.servicar(millis());
+    TEST_ASSERT_TRUE(estadosComodos[1].ligado);
+    TEST_ASSERT_EQUAL_UINT32(1000, regras.prazoMs(millis()));
+
+    avancarMs(1000);
+    regras.servicar(millis());
+    TEST_ASSERT_FALSE(estadosComodos[1].ligado);
+    TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, regras.prazoMs(millis()));
+
+    // Acendeu de novo: conta outro período
+    avancarMs(5000);
+    aplicarCorComodo(1, 10, 20, 30, 0);
+    regras.servicar(millis());
+    avancarMs(60000);
+    regras.servicar(millis());
+    TEST_ASSERT_FALSE(estadosComodos[1].ligado);
+    TEST_ASSERT_EQUAL_UINT32(2, disparos());
+}
+
+void test_luz_de_um_comodo_so() {
+    const Regra tabela[] = {
+        regra(GATILHO_LUZ, 0, 10, ACAO_COR, 0),
+    };
+    configurar(tabela, 1);
+    aplicarCorComodo(1, 10, 20, 30, 0);
+    avancarMs(20000);
+    regras.servicar(millis());
+    TEST_ASSERT_TRUE(estadosComodos[1].ligado);
+    TEST_ASSERT_EQUAL_UINT32(0, disparos());
+}
+
+void test_zona_publica_e_gesto_bipa() {
+    conectar();
+    const Regra tabela[] = {
+        regra(GATILHO_ZONA, 0, 1, ACAO_PUBLICAR, 0),
+        regra(GATILHO_GESTO, GESTO_DUPLO, 0, ACAO_PADRAO, PADRAO_BEEP_CURTO),
+    };
+    configurar(tabela, 2);
+
+    zonasPresenca(0, true);
+    regras.servicar(millis());
+    publicadorDrenar(mqttClient);
+    TEST_ASSERT_EQUAL_STRING(TOPICO_REGRAS_DISPARO, mqttClient.ultimoTopico);
+    TEST_ASSERT_EQUAL_STRING("0,0,1", (const char*)mqttClient.ultimoPayload);
+    TEST_ASSERT_FALSE(mqttClient.ultimoRetido);
+
+    // Fim da presença: a regra pede valor 1
+    zonasPresenca(0, false);
+    regras.servicar(millis());
+    TEST_ASSERT_EQUAL_UINT32(1, disparos());
+
+    padroesNativeProximoMs = -1;
+    EventoBotao ev = {GESTO_DUPLO, 2, (uint32_t)millis()};
+    tratarGestoBotao(ev);
+    regras.servicar(millis());
+    TEST_ASSERT_EQUAL_INT(0, padroesNativeProximoMs);  // sequenciador acordado
+    TEST_ASSERT_EQUAL_UINT32(2, disparos());
+}
+
+void test_gatilho_sem_regra_nao_ocupa_a_fila() {
+    const Regra tabela[] = {
+        regra(GATILHO_ALARME, 0, ESTADO_ALERTA, ACAO_PADRAO, PADRAO_BEEP_CURTO),
+    };
+    configurar(tabela, 1);
+    uint32_t antes = regras.estatisticas().eventos;
+    for (int i = 0; i < 3 * REGRAS_EVENTOS; ++i) zonasPresenca(0, i & 1);
+    regras.servicar(millis());
+    RegrasStats s = regras.estatisticas();
+    TEST_ASSERT_EQUAL_UINT32(antes, s.eventos);
+    TEST_ASSERT_EQUAL_UINT32(0, s.descartados);
+}
+
+// ---------------- Configuração ----------------
+void test_configurar_grava_responde_e_recusa() {
+    conectar();
+    const Regra tabela[] = {
+        regra(GATILHO_ALARME, 0, ESTADO_ALERTA, ACAO_COR, REGRAS_QUALQUER, 255, 0, 0),
+        regra(GATILHO_ALARME, 0, ESTADO_OK, ACAO_COR, REGRAS_QUALQUER),
+    };
+    uint8_t buf[REGRAS_BYTES_MAX];
+    size_t n = regrasCodificar(tabela, 2, buf, sizeof(buf));
+
+    char topico[] = TOPICO_REGRAS;
+    mqttCallback(topico, buf, (unsigned int)n);
+    publicadorDrenar(mqttClient);
+    TEST_ASSERT_EQUAL_UINT8(2, regras.quantidade());
+    TEST_ASSERT_EQUAL_UINT32(1, regrasNativeGravacoes);
+    TEST_ASSERT_EQUAL_MEMORY(buf, regrasNativeNvs, n);
+    TEST_ASSERT_EQUAL_STRING(TOPICO_REGRAS_ESTADO, mqttClient.ultimoTopico);
+    TEST_ASSERT_EQUAL_STRING("OK,2", (const char*)mqttClient.ultimoPayload);
+    TEST_ASSERT_TRUE(mqttClient.ultimoRetido);
+
+    // A mesma tabela de novo (reconexão, retida): sem gravar
+    mqttCallback(topico, buf, (unsigned int)n);
+    TEST_ASSERT_EQUAL_UINT32(1, regrasNativeGravacoes);
+
+    // Inválida: a anterior continua valendo
+    buf[2 + REGRAS_BYTES_REGRA + 4] = NUM_ACOES;
+    mqttCallback(topico, buf, (unsigned int)n);
+    publicadorDrenar(mqttClient);
+    TEST_ASSERT_EQUAL_STRING("INVALIDA,1", (const char*)mqttClient.ultimoPayload);
+    TEST_ASSERT_EQUAL_UINT8(2, regras.quantidade());
+    TEST_ASSERT_EQUAL_UINT32(1, regras.estatisticas().recusadas);
+
+    alarmeEntrada(ENTRADA_DETECCAO);
+    regras.servicar(millis());
+    for (size_t c = 0; c < NUM_COMODOS; ++c) TEST_ASSERT_EQUAL_UINT8(255, estadosComodos[c].r);
+}
+
+void test_iniciar_restaura_da_nvs() {
+    const Regra tabela[] = {
+        regra(GATILHO_GESTO, REGRAS_QUALQUER, 3, ACAO_PADRAO, PADRAO_BEEP_TRIPLO),
+    };
+    regrasNativeTamanho = regrasCodificar(tabela, 1, regrasNativeNvs, REGRAS_BYTES_MAX);
+    regras.iniciar();
+    TEST_ASSERT_EQUAL_UINT8(1, regras.quantidade());
+    TEST_ASSERT_EQUAL_UINT16(3, regras.regra(0).valor);
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_tabela_codifica_e_valida);
+    RUN_TEST(test_alerta_acende_a_sala_sem_rede);
+    RUN_TEST(test_luz_acesa_apaga_sozinha_uma_vez_por_periodo);
+    RUN_TEST(test_luz_de_um_comodo_so);
+    RUN_TEST(test_zona_publica_e_gesto_bipa);
+    RUN_TEST(test_gatilho_sem_regra_nao_ocupa_a_fila);
+    RUN_TEST(test_configurar_grava_responde_e_recusa);
+    RUN_TEST(test_iniciar_restaura_da_nvs);
+    return UNITY_END();
+}
@@ -0,0 +1,317 @@
+// Testes da gravação de rastros e da reprodução no host (ambiente
+// native). Com REPRODUCAO_ACERVO apontando para um diretório, cada
+// <nome>.grav de lá (quadros de TOPICO_GRAVACAO, ex.:
+//   mosquitto_sub -t projeto/home-security/sensor/gravacao -N > sala.grav)
+// é reproduzido contra os rótulos de <nome>.rotulos e o relatório vai
+// para a saída:
+//   REPRODUCAO_ACERVO=rastros pio test -e native -f test_reproducao -v
+#include <unity.h>
+
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include "hal.h"
+#include "alarme.h"
+#include "comandos.h"
+#include "gravacao.h"
+#include "publicador.h"
+#include "reproducao.h"
+#include "topicos.h"
+
+void setUp() {
+    halNativeRelogioUs = 1000000;
+    mqttClient.conectado = true;
+    publicadorDrenar(mqttClient);
+}
+
+void tearDown() {
+    gravacaoDefinir(false);
+    gravacaoAmostra(0, -1, 0);  // descarta a sobra
+    publicadorDrenar(mqttClient);
+}
+
+// ---------------- Rastro sintético ----------------
+// Um sensor a cada PERIODO_SENSOR_MS com o fundo a 200 cm; o relógio
+// começa perto do fim de micros() para a reprodução passar pela volta
+#define T0_US (UINT32_MAX - 2000000u)
+
+static std::vector<AmostraGravada> rastroFundo(uint32_t duracaoMs) {
+    std::vector<AmostraGravada> a;
+    for (uint32_t t = 0; t < duracaoMs; t += PERIODO_SENSOR_MS) {
+        a.push_back({0, T0_US + t * 1000, gravacaoMm(200.0f)});
+    }
+    return a;
+}
+
+static void objeto(std::vector<AmostraGravada>& a, uint32_t deMs, uint32_t ateMs, float cm) {
+    for (AmostraGravada& x : a) {
+        uint32_t t = (x.ecoUs - T0_US) / 1000;
+        if (t >= deMs && t < ateMs) x.mm = gravacaoMm(cm);
+    }
+}
+
+// Presença rotulada e vista (20 cm), rotulada e não vista, um eco
+// espúrio isolado e um objeto não rotulado parado perto do sensor
+static std::vector<AmostraGravada> rastroPadrao() {
+    std::vector<AmostraGravada> a = rastroFundo(60000);
+    objeto(a, 5000, 8000, 20.0f);
+    objeto(a, 30000, 30000 + PERIODO_SENSOR_MS, 10.0f);
+    objeto(a, 40000, 43000, 25.0f);
+    return a;
+}
+
+static const IntervaloPresenca ROTULOS_PADRAO[] = {
+    {5000, 8000},
+    {20000, 21000},
+};
+
+// ---------------- Quadro ----------------
+void test_quadro_ida_e_volta() {
+    const AmostraGravada a[] = {{0, 123456789, 305}, {1, UINT32_MAX, GRAVACAO_SEM_ECO}};
+    uint8_t buf[GRAVACAO_QUADRO_MAX];
+    size_t n = gravacaoCodificar(a, 2, 7, buf, sizeof(buf));
+    TEST_ASSERT_EQUAL_UINT32(GRAVACAO_CABECALHO + 2 * GRAVACAO_BYTES_AMOSTRA, n);
+
+    AmostraGravada lidas[GRAVACAO_AMOSTRAS];
+    uint8_t quantidade;
+    uint16_t numero;
+    TEST_ASSERT_EQUAL_UINT32(n, gravacaoDecodificar(buf, n, lidas, quantidade, numero));
+    TEST_ASSERT_EQUAL_UINT8(2, quantidade);
+    TEST_ASSERT_EQUAL_UINT16(7, numero);
+    TEST_ASSERT_EQUAL_UINT32(123456789, lidas[0].ecoUs);
+    TEST_ASSERT_EQUAL_UINT16(305, lidas[0].mm);
+    TEST_ASSERT_EQUAL_UINT8(1, lidas[1].sensor);
+    TEST_ASSERT_EQUAL_UINT16(GRAVACAO_SEM_ECO, lidas[1].mm);
+
+    TEST_ASSERT_EQUAL_UINT32(0, gravacaoDecodificar(buf, n - 1, lidas, quantidade, numero));
+    buf[0] = GRAVACAO_VERSAO + 1;
+    TEST_ASSERT_EQUAL_UINT32(0, gravacaoDecodificar(buf, n, lidas, quantidade, numero));
+    TEST_ASSERT_EQUAL_UINT32(0, gravacaoCodificar(a, 2, 7, buf, n - 1));
+}
+
+void test_rastro_conta_quadros_perdidos() {
+    const AmostraGravada a[] = {{0, 1000, 100}, {0, 2000, 200}};
+    uint8_t buf[4 * GRAVACAO_QUADRO_MAX];
+    size_t n = 0;
+    n += gravacaoCodificar(a, 2, 65535, buf + n, sizeof(buf) - n);
+    n += gravacaoCodificar(a, 1, 0, buf + n, sizeof(buf) - n);  // numeração dá a volta
+    n += gravacaoCodificar(a, 2, 3, buf + n, sizeof(buf) - n);  // 1 e 2 perdidos
+    buf[n++] = 0xAA;                                            // lixo no fim
+
+    AmostraGravada lidas[8];
+    uint32_t perdidos;
+    TEST_ASSERT_EQUAL_UINT32(5, reproducaoLerRastro(buf, n, lidas, 8, perdidos));
+    TEST_ASSERT_EQUAL_UINT32(2, perdidos);
+    TEST_ASSERT_EQUAL_UINT16(200, lidas[4].mm);
+    TEST_ASSERT_EQUAL_UINT32(3, reproducaoLerRastro(buf, n, lidas, 3, perdidos));
+}
+
+// O filtro vê na reprodução o mesmo mm que viu no dispositivo
+void test_mm_chega_ao_filtro_igual() {
+    for (uint32_t mm = 0; mm < 6000; ++mm) {
+        float cm = gravacaoCm((uint16_t)mm);
+        TEST_ASSERT_EQUAL_INT32((int32_t)mm, (int32_t)(cm * 10.0f + 0.5f));
+    }
+    TEST_ASSERT_EQUAL_UINT16(1234, gravacaoMm(123.44f));
+    TEST_ASSERT_EQUAL_UINT16(GRAVACAO_SEM_ECO, gravacaoMm(-1.0f));
+    TEST_ASSERT_TRUE(gravacaoCm(GRAVACAO_SEM_ECO) < 0);
+}
+
+// ---------------- Gravação no dispositivo ----------------
+static void enviarComando(const char* payload) {
+    char t[] = TOPICO_CMD;
+    mqttCallback(t, (byte*)payload, (unsigned int)strlen(payload));
+}
+
+void test_gravacao_publica_quadro_cheio() {
+    GravacaoStats antes = gravacaoEstatisticas();
+    gravacaoAmostra(0, 50.0f, 1);  // desligada: nada
+    TEST_ASSERT_EQUAL_UINT32(antes.amostras, gravacaoEstatisticas().amostras);
+
+    enviarComando("GRAVACAO:ON");
+    TEST_ASSERT_TRUE(gravacaoLigada());
+    unsigned long publicacoes = mqttClient.publicacoes;
+    for (uint32_t i = 0; i < GRAVACAO_AMOSTRAS - 1; ++i) gravacaoAmostra(0, 50.0f, i * 100000);
+    publicadorDrenar(mqttClient);
+    TEST_ASSERT_EQUAL_UINT32(publicacoes, mqttClient.publicacoes);
+
+    gravacaoAmostra(0, -1.0f, 999);
+    publicadorDrenar(mqttClient);
+    TEST_ASSERT_EQUAL_STRING(TOPICO_GRAVACAO, mqttClient.ultimoTopico);
+    TEST_ASSERT_EQUAL_UINT32(GRAVACAO_QUADRO_MAX, mqttClient.ultimoTamanho);
+
+    AmostraGravada lidas[GRAVACAO_AMOSTRAS];
+    uint8_t quantidade;
+    uint16_t numero;
+    gravacaoDecodificar(mqttClient.ultimoPayload, mqttClient.ultimoTamanho, lidas, quantidade,
+                        numero);
+    TEST_ASSERT_EQUAL_UINT8(GRAVACAO_AMOSTRAS, quantidade);
+    TEST_ASSERT_EQUAL_UINT16(500, lidas[0].mm);
+    TEST_ASSERT_EQUAL_UINT32(999, lidas[GRAVACAO_AMOSTRAS - 1].ecoUs);
+    TEST_ASSERT_EQUAL_UINT16(GRAVACAO_SEM_ECO, lidas[GRAVACAO_AMOSTRAS - 1].mm);
+    uint16_t primeiro = numero;
+
+    // Sem broker: o quadro é perdido e a numeração segue
+    mqttClient.conectado = false;
+    publicadorDrenar(mqttClient);
+    for (uint32_t i = 0; i < GRAVACAO_AMOSTRAS; ++i) gravacaoAmostra(0, 50.0f, i);
+    mqttClient.conectado = true;
+    publicadorDrenar(mqttClient);
+    TEST_ASSERT_EQUAL_UINT32(antes.perdidos + 1, gravacaoEstatisticas().perdidos);
+
+    // Desligar entrega a sobra na próxima leitura
+    gravacaoAmostra(0, 50.0f, 5);
+    enviarComando("GRAVACAO:OFF");
+    gravacaoAmostra(0, 50.0f, 6);
+    publicadorDrenar(mqttClient);
+    gravacaoDecodificar(mqttClient.ultimoPayload, mqttClient.ultimoTamanho, lidas, quantidade,
+                        numero);
+    TEST_ASSERT_EQUAL_UINT8(1, quantidade);
+    TEST_ASSERT_EQUAL_UINT16((uint16_t)(primeiro + 2), numero);
+
+    GravacaoStats depois = gravacaoEstatisticas();
+    TEST_ASSERT_EQUAL_UINT32(antes.amostras + 2 * GRAVACAO_AMOSTRAS + 1, depois.amostras);
+    TEST_ASSERT_EQUAL_UINT32(antes.quadros + 2, depois.quadros);
+}
+
+// ---------------- Rótulos ----------------
+void test_rotulos() {
+    IntervaloPresenca r[4];
+    const char* texto = "# sala, 18/10\n5000,8000\r\n 20000 , 21000 # perdida\n\n";
+    TEST_ASSERT_EQUAL_INT(2, reproducaoLerRotulos(texto, strlen(texto), r, 4));
+    TEST_ASSERT_EQUAL_UINT32(5000, r[0].inicioMs);
+    TEST_ASSERT_EQUAL_UINT32(21000, r[1].fimMs);
+
+    TEST_ASSERT_EQUAL_INT(1, reproducaoLerRotulos(texto, strlen(texto), r, 1));
+    TEST_ASSERT_EQUAL_INT(-1, reproducaoLerRotulos("5000;8000", 9, r, 4));
+    TEST_ASSERT_EQUAL_INT(-1, reproducaoLerRotulos("9,3", 3, r, 4));
+    TEST_ASSERT_EQUAL_INT(-1, reproducaoLerRotulos("1,2,3", 5, r, 4));
+    TEST_ASSERT_EQUAL_INT(0, reproducaoLerRotulos("", 0, r, 4));
+}
+
+// ---------------- Reprodução ----------------
+void test_reproducao_conta_acertos_e_erros() {
+    std::vector<AmostraGravada> a = rastroPadrao();
+    RelatorioReproducao r = reproduzir(a.data(), a.size(), ROTULOS_PADRAO, 2);
+
+    TEST_ASSERT_EQUAL_UINT32(a.size(), r.amostras);
+    TEST_ASSERT_EQUAL_UINT32(59900, r.duracaoMs);
+    TEST_ASSERT_EQUAL_UINT32(2, r.disparos);
+    TEST_ASSERT_EQUAL_UINT32(1, r.detectadas);
+    TEST_ASSERT_EQUAL_UINT32(1, r.falsosNegativos);
+    TEST_ASSERT_EQUAL_UINT32(1, r.falsosPositivos);  // o eco isolado o filtro segura
+    TEST_ASSERT_EQUAL_UINT32(0, r.redisparos);
+
+    // A latência é a do filtro: algumas amostras depois do início
+    TEST_ASSERT_TRUE(r.latenciaMinMs > 0);
+    TEST_ASSERT_TRUE(r.latenciaMaxMs <= 10 * PERIODO_SENSOR_MS);
+    TEST_ASSERT_EQUAL_UINT32(0, r.latenciaMaxMs % PERIODO_SENSOR_MS);
+    TEST_ASSERT_TRUE(r.amostrasPorSegundo > 0);
+
+    // O alarme volta como estava e a reprodução se repete igual
+    TEST_ASSERT_EQUAL(ESTADO_OK, alarmeEstado());
+    RelatorioReproducao de_novo = reproduzir(a.data(), a.size(), ROTULOS_PADRAO, 2);
+    TEST_ASSERT_EQUAL_UINT32(r.latenciaMaxMs, de_novo.latenciaMaxMs);
+    TEST_ASSERT_EQUAL_UINT32(r.falsosPositivos, de_novo.falsosPositivos);
+}
+
+void test_limite_menor_perde_a_presenca() {
+    std::vector<AmostraGravada> a = rastroPadrao();
+    ConfigReproducao cfg;
+    cfg.limiteCm = 15;
+    RelatorioReproducao r = reproduzir(a.data(), a.size(), ROTULOS_PADRAO, 2, cfg);
+    TEST_ASSERT_EQUAL_UINT32(0, r.disparos);
+    TEST_ASSERT_EQUAL_UINT32(2, r.falsosNegativos);
+    TEST_ASSERT_EQUAL_UINT32(0, r.falsosPositivos);
+}
+
+void test_periodo_maior_atrasa_o_disparo() {
+    std::vector<AmostraGravada> a = rastroPadrao();
+    RelatorioReproducao normal = reproduzir(a.data(), a.size(), ROTULOS_PADRAO, 2);
+    ConfigReproducao cfg;
+    cfg.decimacao = 3;
+    RelatorioReproducao lento = reproduzir(a.data(), a.size(), ROTULOS_PADRAO, 2, cfg);
+    TEST_ASSERT_EQUAL_UINT32((a.size() + 2) / 3, lento.amostras);
+    TEST_ASSERT_EQUAL_UINT32(1, lento.detectadas);
+    TEST_ASSERT_TRUE(lento.latenciaMaxMs > normal.latenciaMaxMs);
+}
+
+void test_sensor_desconhecido_ignorado() {
+    std::vector<AmostraGravada> a = rastroFundo(1000);
+    a[3].sensor = NUM_SENSORES;
+    RelatorioReproducao r = reproduzir(a.data(), a.size(), nullptr, 0);
+    TEST_ASSERT_EQUAL_UINT32(1, r.ignoradas);
+    TEST_ASSERT_EQUAL_UINT32(a.size() - 1, r.amostras);
+}
+
+// ---------------- Acervo ----------------
+static bool lerArquivo(const std::string& caminho, std::vector<uint8_t>& dados) {
+    FILE* f = fopen(caminho.c_str(), "rb");
+    if (f == nullptr) return false;
+    uint8_t buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) dados.insert(dados.end(), buf, buf + n);
+    fclose(f);
+    return true;
+}
+
+void test_acervo() {
+    const char* dir = getenv("REPRODUCAO_ACERVO");
+    if (dir == nullptr) {
+        std::vector<AmostraGravada> a = rastroPadrao();
+        reproducaoImprimir("sintético", reproduzir(a.data(), a.size(), ROTULOS_PADRAO, 2));
+        return;
+    }
+
+    DIR* d = opendir(dir);
+    TEST_ASSERT_NOT_NULL(d);
+    size_t rastros = 0;
+    for (dirent* e = readdir(d); e != nullptr; e = readdir(d)) {
+        std::string nome = e->d_name;
+        if (nome.size() < 6 || nome.compare(nome.size() - 5, 5, ".grav") != 0) continue;
+        std::string base = std::string(dir) + "/" + nome.substr(0, nome.size() - 5);
+
+        std::vector<uint8_t> bruto;
+        TEST_ASSERT_TRUE(lerArquivo(base + ".grav", bruto));
+        std::vector<AmostraGravada> amostras(bruto.size() / GRAVACAO_BYTES_AMOSTRA + 1);
+        uint32_t perdidos;
+        amostras.resize(reproducaoLerRastro(bruto.data(), bruto.size(), amostras.data(),
+                                            amostras.size(), perdidos));
+
+        std::vector<uint8_t> texto;
+        std::vector<IntervaloPresenca> rotulos(1024);
+        int numRotulos = 0;
+        if (lerArquivo(base + ".rotulos", texto)) {
+            numRotulos = reproducaoLerRotulos((const char*)texto.data(), texto.size(),
+                                              rotulos.data(), rotulos.size());
+            TEST_ASSERT_TRUE_MESSAGE(numRotulos >= 0, nome.c_str());
+        }
+
+        reproducaoImprimir(nome.c_str(), reproduzir(amostras.data(), amostras.size(),
+                                                    rotulos.data(), (size_t)numRotulos));
+        if (perdidos > 0) printf("  (%lu quadros perdidos na gravação)\n", (unsigned long)perdidos);
+        rastros++;
+    }
+    closedir(d);
+    printf("%zu rastros em %s\n", rastros, dir);
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_quadro_ida_e_volta);
+    RUN_TEST(test_rastro_conta_quadros_perdidos);
+    RUN_TEST(test_mm_chega_ao_filtro_igual);
+    RUN_TEST(test_gravacao_publica_quadro_cheio);
+    RUN_TEST(test_rotulos);
+    RUN_TEST(test_reproducao_conta_acertos_e_erros);
+    RUN_TEST(test_limite_menor_perde_a_presenca);
+    RUN_TEST(test_periodo_maior_atrasa_o_disparo);
+    RUN_TEST(test_sensor_desconhecido_ignorado);
+    RUN_TEST(test_acervo);
+    return UNITY_END();
+}
@@ -0,0 +1,187 @@
+// Testes da agenda de disparos e do estado por zona (ambiente native):
+//   pio test -e native -f test_sensores
+#include <unity.h>
+
+#include <string.h>
+
+#include "hal.h"
+#include "alarme.h"
+#include "comandos.h"
+#include "publicador.h"
+#include "sensores.h"
+#include "zonas.h"
+
+static const uint32_t PERIODO_US = 100000;
+
+// Porta e corredor longe um do outro: disparam juntos; a sala vê o
+// corredor e fica sozinha
+static const Sensor TABELA[] = {
+    SENSOR("porta",    1, 2, 30, 0, 0),
+    SENSOR("sala",     3, 4, 80, 1, 2),
+    SENSOR("corredor", 5, 6, 50, 1, 0),
+};
+
+void setUp() {
+    halNativeRelogioUs = 1000000;
+    maquinaAlarme.reiniciar();
+    zonasReiniciar();
+    for (uint8_t i = 0; i < NUM_SENSORES; ++i) filtroSensor(i).reiniciar();
+}
+
+void tearDown() {}
+
+// ---------------- Agenda ----------------
+void test_grupos_pela_tabela() {
+    AgendaSensores agenda(TABELA, 3, PERIODO_US);
+    // O grupo 1 não existe: vira o segundo grupo o de número 2
+    TEST_ASSERT_EQUAL_UINT8(2, agenda.grupos());
+    TEST_ASSERT_EQUAL_HEX8(0x05, agenda.mascara(0));
+    TEST_ASSERT_EQUAL_HEX8(0x02, agenda.mascara(1));
+}
+
+void test_proximo_grupo_sai_na_guarda() {
+    AgendaSensores agenda(TABELA, 3, PERIODO_US);
+    uint32_t espera;
+    TEST_ASSERT_EQUAL_UINT8(0, agenda.proximo(0, espera));
+    TEST_ASSERT_EQUAL_UINT32(0, espera);
+
+    // Ecos curtos: o grupo 0 termina em 3 ms e o 1 não espera o timeout
+    agenda.concluido(0, 3000);
+    TEST_ASSERT_EQUAL_UINT8(1, agenda.proximo(3000, espera));
+    TEST_ASSERT_EQUAL_UINT32(SENSORES_GUARDA_US, espera);
+    TEST_ASSERT_EQUAL_UINT8(1, agenda.proximo(3000 + SENSORES_GUARDA_US, espera));
+    TEST_ASSERT_EQUAL_UINT32(0, espera);
+
+    agenda.concluido(3000 + SENSORES_GUARDA_US, 20000);
+    AgendaStats s = agenda.estatisticas();
+    TEST_ASSERT_EQUAL_UINT32(1, s.ciclos);
+    TEST_ASSERT_EQUAL_UINT32(2, s.disparos);
+    TEST_ASSERT_EQUAL_UINT32(20000, s.ocupadoUs);
+    TEST_ASSERT_EQUAL_UINT32(0, s.atrasados);
+}
+
+void test_ciclo_respeita_o_periodo() {
+    AgendaSensores agenda(TABELA, 3, PERIODO_US);
+    uint32_t espera;
+    agenda.concluido(500, 3000);
+    agenda.concluido(13000, 20000);
+
+    // Volta ao grupo 0 só um período depois do início do ciclo
+    TEST_ASSERT_EQUAL_UINT8(0, agenda.proximo(30000, espera));
+    TEST_ASSERT_EQUAL_UINT32(PERIODO_US + 500 - 30000, espera);
+}
+
+void test_ciclo_longo_emenda_no_seguinte() {
+    AgendaSensores agenda(TABELA, 3, PERIODO_US);
+    uint32_t espera;
+    // Dois timeouts de 40 ms mais a guarda passam do período
+    agenda.concluido(0, 40000);
+    agenda.concluido(40000 + SENSORES_GUARDA_US, 95000);
+    TEST_ASSERT_EQUAL_UINT8(0, agenda.proximo(95000, espera));
+    TEST_ASSERT_EQUAL_UINT32(SENSORES_GUARDA_US, espera);
+    TEST_ASSERT_EQUAL_UINT32(1, agenda.estatisticas().atrasados);
+}
+
+void test_rodizio_com_um_grupo_por_sensor() {
+    static const Sensor RODIZIO[] = {
+        SENSOR("a", 1, 2, 30, 0, 0),
+        SENSOR("b", 3, 4, 30, 0, 1),
+        SENSOR("c", 5, 6, 30, 0, 2),
+    };
+    AgendaSensores agenda(RODIZIO, 3, PERIODO_US);
+    TEST_ASSERT_EQUAL_UINT8(3, agenda.grupos());
+    uint32_t espera;
+    uint32_t t = 0;
+    for (uint8_t g = 0; g < 3; ++g) {
+        TEST_ASSERT_EQUAL_UINT8(g, agenda.proximo(t, espera));
+        TEST_ASSERT_EQUAL_HEX8(1u << g, agenda.mascara(g));
+        t += espera;
+        agenda.concluido(t, t + 2000);
+        t += 2000;
+    }
+    TEST_ASSERT_EQUAL_UINT32(1, agenda.estatisticas().ciclos);
+}
+
+void test_agenda_da_tabela_do_firmware() {
+    AgendaSensores agenda(SENSORES, NUM_SENSORES, PERIODO_US);
+    uint8_t todos = 0;
+    for (uint8_t g = 0; g < agenda.grupos(); ++g) {
+        TEST_ASSERT_EQUAL_HEX8(0, todos & agenda.mascara(g));  // cada sensor num grupo só
+        todos |= agenda.mascara(g);
+    }
+    TEST_ASSERT_EQUAL_HEX8((1u << NUM_SENSORES) - 1, todos);
+}
+
+// ---------------- Zonas ----------------
+static void presencaNoSensor(uint8_t sensor) {
+    for (int i = 0; i < 20; ++i) {
+        if (avaliarSensor(sensor, SENSORES[sensor].limiteCm / 2.0f, micros()).detectado) return;
+    }
+}
+
+static void semPresenca(uint8_t sensor) {
+    for (int i = 0; i < 40; ++i) {
+        if (!avaliarSensor(sensor, 400.0f, micros()).detectado) return;
+    }
+}
+
+void test_zona_dispara_e_fica_ate_silenciar() {
+    mqttClient.conectado = true;
+    publicadorDrenar(mqttClient);
+
+    zonasAtualizar();
+    publicadorDrenar(mqttClient);
+    TEST_ASSERT_EQUAL_STRING(ZONAS[0].topicoEstado, mqttClient.ultimoTopico);
+    TEST_ASSERT_EQUAL_STRING("OK,1", (const char*)mqttClient.ultimoPayload);
+    TEST_ASSERT_TRUE(mqttClient.ultimoRetido);
+
+    presencaNoSensor(0);
+    TEST_ASSERT_EQUAL(ESTADO_ALERTA, alarmeEstado());
+    TEST_ASSERT_EQUAL(ESTADO_ALERTA, zonaEstado(SENSORES[0].zona));
+    TEST_ASSERT_TRUE(zonaPresenca(SENSORES[0].zona));
+
+    // A pessoa sai: a zona continua em alerta com o alarme
+    semPresenca(0);
+    TEST_ASSERT_FALSE(zonaPresenca(SENSORES[0].zona));
+    TEST_ASSERT_EQUAL(ESTADO_ALERTA, zonaEstado(SENSORES[0].zona));
+
+    alarmeEntrada(ENTRADA_SILENCIAR);
+    TEST_ASSERT_EQUAL(ESTADO_OK, zonaEstado(SENSORES[0].zona));
+
+    alarmeEntrada(ENTRADA_PAUSAR);
+    TEST_ASSERT_EQUAL(ESTADO_PAUSADO, zonaEstado(SENSORES[0].zona));
+    publicadorDrenar(mqttClient);
+    TEST_ASSERT_EQUAL_STRING("PAUSADO,4", (const char*)mqttClient.ultimoPayload);
+}
+
+void test_pausado_nao_dispara_zona() {
+    alarmeEntrada(ENTRADA_PAUSAR);
+    presencaNoSensor(0);
+    TEST_ASSERT_TRUE(zonaPresenca(SENSORES[0].zona));
+    TEST_ASSERT_EQUAL(ESTADO_PAUSADO, zonaEstado(SENSORES[0].zona));
+
+    // Retomar com a presença ainda lá dispara na próxima amostra
+    alarmeEntrada(ENTRADA_RETOMAR);
+    avaliarSensor(0, SENSORES[0].limiteCm / 2.0f, micros());
+    TEST_ASSERT_EQUAL(ESTADO_ALERTA, zonaEstado(SENSORES[0].zona));
+}
+
+void test_cada_sensor_tem_o_proprio_limite() {
+    for (uint8_t i = 0; i < NUM_SENSORES; ++i) {
+        TEST_ASSERT_EQUAL_UINT16(SENSORES[i].limiteCm * 10, filtroSensor(i).config().limiteMm);
+    }
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_grupos_pela_tabela);
+    RUN_TEST(test_proximo_grupo_sai_na_guarda);
+    RUN_TEST(test_ciclo_respeita_o_periodo);
+    RUN_TEST(test_ciclo_longo_emenda_no_seguinte);
+    RUN_TEST(test_rodizio_com_um_grupo_por_sensor);
+    RUN_TEST(test_agenda_da_tabela_do_firmware);
+    RUN_TEST(test_zona_dispara_e_fica_ate_silenciar);
+    RUN_TEST(test_pausado_nao_dispara_zona);
+    RUN_TEST(test_cada_sensor_tem_o_proprio_limite);
+    return UNITY_END();
+}
@@ -0,0 +1,75 @@
+// Testes das medições de handshake TLS (ambiente native):
+//   pio test -e native -f test_tls
+// O cliente em si (mbedtls + lwIP) só roda na placa.
+#include <unity.h>
+
+#include "tls.h"
+
+void setUp() {}
+void tearDown() {}
+
+void test_medidor_guarda_o_menor_heap_livre() {
+    MedidorHeap m;
+    m.iniciar(200000);
+    m.amostrar(180000);
+    m.amostrar(150000);
+    m.amostrar(190000);  // buffers liberados depois do pico
+    TEST_ASSERT_EQUAL_UINT32(50000, m.pico());
+
+    m.iniciar(100000);
+    m.amostrar(120000);  // heap liberado por outra tarefa não vira pico negativo
+    TEST_ASSERT_EQUAL_UINT32(0, m.pico());
+}
+
+void test_completo_e_retomado_ficam_separados() {
+    MedicoesTls t;
+    t.registrar(false, false, 2400, 42000);
+    t.registrar(true, true, 300, 9000);
+    t.registrar(true, true, 500, 11000);
+
+    TlsStats s = t.estatisticas();
+    TEST_ASSERT_EQUAL_UINT32(1, s.completo.quantidade);
+    TEST_ASSERT_EQUAL_UINT32(2400, s.completo.medioMs);
+    TEST_ASSERT_EQUAL_UINT32(42000, s.completo.maxHeap);
+    TEST_ASSERT_EQUAL_UINT32(2, s.retomado.quantidade);
+    TEST_ASSERT_EQUAL_UINT32(400, s.retomado.medioMs);
+    TEST_ASSERT_EQUAL_UINT32(500, s.retomado.maxMs);
+    TEST_ASSERT_EQUAL_UINT32(500, s.retomado.ultimoMs);
+    TEST_ASSERT_EQUAL_UINT32(11000, s.retomado.ultimoHeap);
+    TEST_ASSERT_EQUAL_UINT32(11000, s.retomado.maxHeap);
+    TEST_ASSERT_TRUE(s.ultimoRetomado);
+    TEST_ASSERT_EQUAL_UINT32(0, s.sessoesRecusadas);
+}
+
+void test_sessao_recusada_conta_como_completo() {
+    MedicoesTls t;
+    t.registrar(true, true, 300, 9000);
+    t.registrar(false, true, 2600, 43000);  // broker reiniciou sem a chave dos tickets
+
+    TlsStats s = t.estatisticas();
+    TEST_ASSERT_EQUAL_UINT32(1, s.sessoesRecusadas);
+    TEST_ASSERT_EQUAL_UINT32(1, s.completo.quantidade);
+    TEST_ASSERT_FALSE(s.ultimoRetomado);
+    TEST_ASSERT_EQUAL_UINT32(300, s.retomado.ultimoMs);  // o retomado anterior continua lá
+}
+
+void test_falhas_de_verificacao() {
+    MedicoesTls t;
+    t.registrarFalha(false);
+    t.registrarFalha(true);
+
+    TlsStats s = t.estatisticas();
+    TEST_ASSERT_EQUAL_UINT32(2, s.falhas);
+    TEST_ASSERT_EQUAL_UINT32(1, s.falhasVerificacao);
+    TEST_ASSERT_EQUAL_UINT32(0, s.completo.quantidade);
+    TEST_ASSERT_EQUAL_UINT32(0, s.completo.medioMs);
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_medidor_guarda_o_menor_heap_livre);
+    RUN_TEST(test_completo_e_retomado_ficam_separados);
+    RUN_TEST(test_sessao_recusada_conta_como_completo);
+    RUN_TEST(test_falhas_de_verificacao);
+    return UNITY_END();
+}
@@ -0,0 +1,268 @@
+// Testes da tabela de gama e do planejamento de fades (ambiente native):
+//   pio test -e native -f test_transicao
+#include <unity.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "hal.h"
+#include "comandos.h"
+#include "comodos.h"
+#include "publicador.h"
+#include "topicos.h"
+#include "transicao.h"
+
+// transicao_native.cpp: último plano pedido por canal e lotes disparados
+extern PlanoFade transicaoNativePlanos[HAL_NATIVE_NUM_CANAIS];
+extern uint32_t transicaoNativeLotes;
+
+static void avancarMs(uint32_t ms) {
+    halNativeRelogioUs += (uint64_t)ms * 1000;
+}
+
+// Deixa acabar qualquer fade de um teste anterior, e os que o
+// pendente dele disparar
+void setUp() {
+    for (int i = 0; i < 2; ++i) {
+        avancarMs(TRANSICAO_MAX_MS + TRANSICAO_FOLGA_MS);
+        comodosServicar(millis());
+    }
+}
+void tearDown() {}
+
+// ---------------- Tabela de gama ----------------
+void test_gama_extremos() {
+    TEST_ASSERT_EQUAL_UINT32(0, gamaDuty(0));
+    TEST_ASSERT_EQUAL_UINT32(TRANSICAO_DUTY_MAX, gamaDuty(255));
+    TEST_ASSERT_EQUAL_UINT32(1, gamaDuty(1));  // aceso nunca vira apagado
+}
+
+void test_gama_confere_com_pow() {
+    // A tabela constexpr tem de bater com pow() de runtime (±1 LSB)
+    for (int v = 1; v < 256; ++v) {
+        double esperado = pow(v / 255.0, 2.2) * TRANSICAO_DUTY_MAX;
+        if (esperado < 1.0) esperado = 1.0;
+        TEST_ASSERT_FLOAT_WITHIN(1.0f, (float)esperado, (float)gamaDuty((uint8_t)v));
+    }
+}
+
+void test_gama_monotonica_e_fina_no_escuro() {
+    // 8 bits lineares teriam degrau de 1/255 em todo lugar; com gama e
+    // LED_PWM_RES bits os primeiros níveis andam bem menos que isso.
+    for (int v = 1; v < 256; ++v) TEST_ASSERT_TRUE(gamaDuty(v) >= gamaDuty(v - 1));
+    TEST_ASSERT_TRUE(gamaDuty(16) * 255 < TRANSICAO_DUTY_MAX * 2);
+}
+
+// ---------------- Planejamento ----------------
+static void verificarPlano(uint32_t atual, uint32_t alvo, uint32_t ms) {
+    PlanoFade p = planejarFade(atual, alvo, ms);
+    char msg[64];
+    snprintf(msg, sizeof(msg), "%u -> %u em %u ms", atual, alvo, ms);
+
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(alvo, p.dutyAlvo, msg);
+    if (p.numPassos == 0) {
+        TEST_ASSERT_EQUAL_UINT32_MESSAGE(alvo, p.dutyInicial, msg);
+        return;
+    }
+
+    // Limites dos registradores do LEDC
+    TEST_ASSERT_TRUE_MESSAGE(p.passo >= 1 && p.passo <= TRANSICAO_MAX_PASSO, msg);
+    TEST_ASSERT_TRUE_MESSAGE(p.ciclosPorPasso >= 1 && p.ciclosPorPasso <= TRANSICAO_MAX_CICLOS, msg);
+    TEST_ASSERT_TRUE_MESSAGE(p.numPassos <= TRANSICAO_MAX_PASSOS, msg);
+
+    // Termina exatamente no alvo, partindo a menos de um passo do atual
+    uint32_t percorrido = (uint32_t)p.numPassos * p.passo;
+    uint32_t fim = alvo > atual ? p.dutyInicial + percorrido : p.dutyInicial - percorrido;
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(alvo, fim, msg);
+    uint32_t salto = p.dutyInicial > atual ? p.dutyInicial - atual : atual - p.dutyInicial;
+    TEST_ASSERT_TRUE_MESSAGE(salto < p.passo, msg);
+
+    // Não passa do pedido e, fora dos limites do hardware, leva ao
+    // menos metade dele (numPassos * floor(ciclos / numPassos))
+    uint32_t ciclos = ms * LED_PWM_FREQ / 1000;
+    bool limitado = p.ciclosPorPasso == TRANSICAO_MAX_CICLOS || p.passo == TRANSICAO_MAX_PASSO ||
+                    p.numPassos > ciclos;
+    if (!limitado) {
+        TEST_ASSERT_TRUE_MESSAGE(p.duracaoRealMs <= ms, msg);
+        TEST_ASSERT_TRUE_MESSAGE(p.duracaoRealMs * 2 + 1 >= ms, msg);
+    }
+}
+
+void test_plano_imediato() {
+    PlanoFade p = planejarFade(100, 100, 500);
+    TEST_ASSERT_EQUAL_UINT16(0, p.numPassos);
+    p = planejarFade(0, TRANSICAO_DUTY_MAX, 0);
+    TEST_ASSERT_EQUAL_UINT16(0, p.numPassos);
+    TEST_ASSERT_EQUAL_UINT32(TRANSICAO_DUTY_MAX, p.dutyInicial);
+}
+
+void test_plano_conhecido() {
+    // 0 -> 4095 em 1 s a 5 kHz: 5000 períodos; 1023 passos no máximo
+    // pedem passo 5, então 819 passos de 6 períodos = 982 ms.
+    PlanoFade p = planejarFade(0, 4095, 1000, 5000);
+    TEST_ASSERT_EQUAL_UINT16(5, p.passo);
+    TEST_ASSERT_EQUAL_UINT16(819, p.numPassos);
+    TEST_ASSERT_EQUAL_UINT16(6, p.ciclosPorPasso);
+    TEST_ASSERT_EQUAL_UINT32(0, p.dutyInicial);
+    TEST_ASSERT_EQUAL_UINT32(982, p.duracaoRealMs);
+
+    // Em 200 ms (1000 períodos) passo 5 só cabe com 1 período por
+    // passo (819); passo 9 dá 455 passos de 2 períodos = 182 ms.
+    p = planejarFade(0, 4095, 200, 5000);
+    TEST_ASSERT_EQUAL_UINT16(9, p.passo);
+    TEST_ASSERT_EQUAL_UINT16(2, p.ciclosPorPasso);
+    TEST_ASSERT_EQUAL_UINT32(182, p.duracaoRealMs);
+    TEST_ASSERT_EQUAL_UINT32(0, p.dutyInicial);
+
+    // Delta pequeno em muito tempo: passo 1, ciclos limitados a 1023
+    p = planejarFade(10, 20, 10000, 5000);
+    TEST_ASSERT_EQUAL_UINT16(1, p.passo);
+    TEST_ASSERT_EQUAL_UINT16(10, p.numPassos);
+    TEST_ASSERT_EQUAL_UINT16(TRANSICAO_MAX_CICLOS, p.ciclosPorPasso);
+}
+
+void test_plano_varredura() {
+    const uint32_t duties[] = {0, 1, 7, 100, 1000, TRANSICAO_DUTY_MAX / 2, TRANSICAO_DUTY_MAX};
+    const uint32_t tempos[] = {0, 1, 5, 50, 200, 1000, TRANSICAO_MAX_MS};
+    for (uint32_t a : duties) {
+        for (uint32_t b : duties) {
+            for (uint32_t ms : tempos) verificarPlano(a, b, ms);
+        }
+    }
+}
+
+// ---------------- Caminho do comando ----------------
+void test_comando_com_transicao() {
+    char topico[] = TOPICO_LED_PREFIXO "sala";
+    const char apaga[] = "0,0,0,0";
+    const char acende[] = "255,128,0,500";
+    mqttCallback(topico, (byte*)apaga, sizeof(apaga) - 1);
+    mqttCallback(topico, (byte*)acende, sizeof(acende) - 1);
+    publicadorDrenar(mqttClient);
+
+    const PlanoFade& r = transicaoNativePlanos[COMODOS[0].canais[0]];
+    TEST_ASSERT_EQUAL_UINT32(gamaDuty(255), r.dutyAlvo);
+    TEST_ASSERT_TRUE(r.numPassos > 0);
+    TEST_ASSERT_TRUE(r.duracaoRealMs <= 500 && r.duracaoRealMs >= 450);
+    TEST_ASSERT_EQUAL_UINT32(gamaDuty(128), transicaoNativePlanos[COMODOS[0].canais[1]].dutyAlvo);
+    TEST_ASSERT_EQUAL_UINT16(0, transicaoNativePlanos[COMODOS[0].canais[2]].numPassos);
+}
+
+static void comandar(const char* comodo, const char* payload) {
+    char topico[64];
+    snprintf(topico, sizeof(topico), TOPICO_LED_PREFIXO "%s", comodo);
+    mqttCallback(topico, (byte*)payload, strlen(payload));
+    publicadorDrenar(mqttClient);
+}
+
+void test_comando_no_meio_do_fade_espera_o_fim_sem_tocar_no_canal() {
+    const uint8_t r = COMODOS[0].canais[0];
+    const uint8_t b = COMODOS[0].canais[2];
+    comandar("sala", "0,0,0,0");
+    comandar("sala", "255,0,0,1000");
+    uint32_t fimMs = transicaoNativePlanos[r].duracaoRealMs;
+    uint32_t lotes = transicaoNativeLotes;
+
+    // No ESP32 ledc_set_duty() aqui esperaria o fade: nada é disparado
+    avancarMs(300);
+    comandar("sala", "0,0,255,400");
+    TEST_ASSERT_EQUAL_UINT32(lotes, transicaoNativeLotes);
+    TEST_ASSERT_EQUAL_UINT32(gamaDuty(255), halNativeLedc[r]);
+    TEST_ASSERT_EQUAL_UINT32(0, halNativeLedc[b]);
+    TEST_ASSERT_EQUAL_UINT32(fimMs - 300 + TRANSICAO_FOLGA_MS, transicaoPrazoMs(millis()));
+
+    comodosServicar(millis());
+    TEST_ASSERT_EQUAL_UINT32(lotes, transicaoNativeLotes);
+
+    // No fim do fade o comando sai inteiro, partindo de onde ele parou
+    avancarMs(transicaoPrazoMs(millis()));
+    comodosServicar(millis());
+    TEST_ASSERT_EQUAL_UINT32(lotes + 1, transicaoNativeLotes);
+    TEST_ASSERT_EQUAL_UINT32(0, halNativeLedc[r]);
+    TEST_ASSERT_EQUAL_UINT32(gamaDuty(255), halNativeLedc[b]);
+    const PlanoFade& p = transicaoNativePlanos[r];
+    TEST_ASSERT_TRUE(p.numPassos > 0);
+    TEST_ASSERT_TRUE(gamaDuty(255) - p.dutyInicial < p.passo);
+    TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, transicaoPrazoMs(millis()));
+}
+
+void test_comando_novo_substitui_o_pendente() {
+    const uint8_t g = COMODOS[0].canais[1];
+    comandar("sala", "0,255,0,1000");
+    avancarMs(100);
+    comandar("sala", "0,10,0,0");
+    comandar("sala", "0,20,0,0");
+    avancarMs(transicaoPrazoMs(millis()));
+    comodosServicar(millis());
+    TEST_ASSERT_EQUAL_UINT32(gamaDuty(20), halNativeLedc[g]);
+}
+
+void test_cena_espera_o_fade_mais_longo_e_muda_junta() {
+    const char cena[] = "sala=0,0,0,0;quarto=0,0,0,0";
+    char topico[] = TOPICO_CENA;
+    comandar("sala", "255,255,255,1000");
+    comandar("quarto", "255,255,255,300");
+    avancarMs(100);
+    uint32_t lotes = transicaoNativeLotes;
+    mqttCallback(topico, (byte*)cena, sizeof(cena) - 1);
+    publicadorDrenar(mqttClient);
+
+    // O fade do quarto acabou, mas a cena espera o da sala
+    avancarMs(300);
+    comodosServicar(millis());
+    TEST_ASSERT_EQUAL_UINT32(lotes, transicaoNativeLotes);
+    TEST_ASSERT_EQUAL_UINT32(gamaDuty(255), halNativeLedc[COMODOS[1].canais[0]]);
+
+    avancarMs(transicaoPrazoMs(millis()));
+    comodosServicar(millis());
+    TEST_ASSERT_EQUAL_UINT32(lotes + 1, transicaoNativeLotes);
+    for (size_t i = 0; i < NUM_COMODOS; ++i) {
+        for (int cor = 0; cor < 3; ++cor) {
+            TEST_ASSERT_EQUAL_UINT32(0, halNativeLedc[COMODOS[i].canais[cor]]);
+        }
+    }
+}
+
+void test_luz_adiada_so_conta_quando_o_lote_dispara() {
+    comandar("quarto", "0,0,0,0");
+    comandar("quarto", "0,0,255,1000");
+    uint32_t acendeuMs = millis();
+    TEST_ASSERT_TRUE(estadosComodos[1].ligado);
+    TEST_ASSERT_EQUAL_UINT32(acendeuMs, estadosComodos[1].ligadoDesde);
+
+    // Apagar no meio do fade: a luz continua acesa até o lote disparar
+    avancarMs(300);
+    comandar("quarto", "0,0,0,0");
+    TEST_ASSERT_TRUE(estadosComodos[1].ligado);
+    TEST_ASSERT_EQUAL_UINT8(255, estadosComodos[1].b);
+    char esperado[32];
+    snprintf(esperado, sizeof(esperado), "ON,%lu", (unsigned long)acendeuMs);
+    TEST_ASSERT_EQUAL_STRING(esperado, (const char*)mqttClient.ultimoPayload);
+
+    avancarMs(transicaoPrazoMs(millis()));
+    comodosServicar(millis());
+    publicadorDrenar(mqttClient);
+    TEST_ASSERT_FALSE(estadosComodos[1].ligado);
+    TEST_ASSERT_EQUAL_UINT8(0, estadosComodos[1].b);
+    snprintf(esperado, sizeof(esperado), "OFF,%lu", (unsigned long)(millis() - acendeuMs));
+    TEST_ASSERT_EQUAL_STRING(COMODOS[1].topicoEstado, mqttClient.ultimoTopico);
+    TEST_ASSERT_EQUAL_STRING(esperado, (const char*)mqttClient.ultimoPayload);
+}
+
+int main(int, char**) {
+    comodosIniciar();
+
+    UNITY_BEGIN();
+    RUN_TEST(test_gama_extremos);
+    RUN_TEST(test_gama_confere_com_pow);
+    RUN_TEST(test_gama_monotonica_e_fina_no_escuro);
+    RUN_TEST(test_plano_imediato);
+    RUN_TEST(test_plano_conhecido);
+    RUN_TEST(test_plano_varredura);
+    RUN_TEST(test_comando_com_transicao);
+    RUN_TEST(test_comando_no_meio_do_fade_espera_o_fim_sem_tocar_no_canal);
+    RUN_TEST(test_comando_novo_substitui_o_pendente);
+    RUN_TEST(test_cena_espera_o_fade_mais_longo_e_muda_junta);
+    RUN_TEST(test_luz_adiada_so_conta_quando_o_lote_dispara);
+    return UNITY_END();
+}
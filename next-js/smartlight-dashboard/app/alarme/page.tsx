@@ -12,6 +12,8 @@ const MQTT_PASS = "Teste@123";
 const TOPICO_DISTANCIA = "projeto/home-security/sensor/medida";
 const TOPICO_ESTADO = "projeto/home-security/sensor/estado";
 const TOPICO_CMD = "projeto/home-security/comandos";
+const TOPICO_EVENTOS = "projeto/home-security/eventos";
+const TOPICO_EVENTOS_ACK = TOPICO_EVENTOS + "/ack";
 
 export default function AlarmePage() {
   const [distancia, setDistancia] = useState<string>("--");
@@ -146,7 +148,7 @@ export default function AlarmePage() {
 
     client.on("connect", () => {
       setConnected(true);
-      client.subscribe([TOPICO_DISTANCIA, TOPICO_ESTADO]);
+      client.subscribe([TOPICO_DISTANCIA, TOPICO_ESTADO, TOPICO_EVENTOS]);
     });
 
     client.on("reconnect", () => setConnected(false));
@@ -154,11 +156,28 @@ export default function AlarmePage() {
 
     client.on("message", (topic, payload) => {
       const msg = payload.toString();
-      if (topic === TOPICO_DISTANCIA) {
+      if (topic === TOPICO_EVENTOS) {
+        // diário do ESP32: <época>,<id>,<tipo>,... Aceita só o próximo id
+        // (repetidos e fora de ordem são ignorados; o ESP32 reenvia) e
+        // confirma o maior recebido sem buracos
+        const [epoca, idTexto] = msg.split(",");
+        const id = parseInt(idTexto, 10);
+        if (!epoca || Number.isNaN(id)) return;
+        const [epocaVista, ultimoTexto] = (localStorage.getItem("diarioUltimo") ?? ",").split(",");
+        // época nova (ou primeira vez): sincroniza no evento que chegou
+        let ultimo = epocaVista === epoca ? parseInt(ultimoTexto, 10) : id - 1;
+        if (id === ultimo + 1) {
+          ultimo = id;
+          localStorage.setItem("diarioUltimo", `${epoca},${ultimo}`);
+          console.log("[DIÁRIO]", msg);
+        }
+        client.publish(TOPICO_EVENTOS_ACK, `${epoca},${ultimo}`);
+      } else if (topic === TOPICO_DISTANCIA) {
         // valor em centímetros vindo do sensor ultrassônico
         setDistancia(msg);
       } else if (topic === TOPICO_ESTADO) {
-        const novoEstado = msg;
+        // payload: <ESTADO>,<seq> (retido, publicado só na transição)
+        const novoEstado = msg.split(",")[0];
         const estadoAnterior = estadoAnteriorRef.current;
         
         setEstado(novoEstado);
@@ -102,7 +102,8 @@ export default function LedsPage() {
     client.on("message", (topic, payload) => {
       const msg = payload.toString();
       if (topic === TOPICO_ESTADO) {
-        setEstado(msg);
+        // payload: <ESTADO>,<seq>
+        setEstado(msg.split(",")[0]);
       } else if (topic === TOPICO_LED_SALA_ESTADO) {
         // payload formats: ON,<ts_ms>  or OFF,<duration_ms>
         const parts = msg.split(",");